@@ -82,7 +82,7 @@ public:
 
         // Pre-Render Update
         static platform::core::Timer timer;
-        float real_time = timer.UpdateTimeSum() / 1000.0f;
+        float real_time = (float)(timer.UpdateTimeSum() / 1000.0);
         ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
         const float clear_color_with_alpha[4] = { clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w };
        // renderPlatform->SetRenderTargets(1, &g_mainRenderTargetView, NULL);
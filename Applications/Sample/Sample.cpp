@@ -426,7 +426,7 @@ public:
 
 		// Pre-Render Update
 		static platform::core::Timer timer;
-		float real_time = timer.UpdateTimeSum() / 1000.0f;
+		float real_time = (float)(timer.UpdateTimeSum() / 1000.0);
 
 		lights[0].direction.x = .05f * sin(real_time * 1.64f);
 		lights[0].direction.y = .02f * sin(real_time * 1.1f);
@@ -475,9 +475,9 @@ public:
 			renderPlatform->SetConstantBuffer(deviceContext,&rayGenConstants);
 
 			auto rayPass			=raytrace_effect->GetTechniqueByIndex(0)->GetPass(0);
-			auto res_scene			=raytrace_effect->GetShaderResource("Scene");
-			auto res_targetTexture	=raytrace_effect->GetShaderResource("RenderTarget");
-			auto res_lights			=raytrace_effect->GetShaderResource("lights");
+			auto res_scene			=raytrace_effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("Scene"));
+			auto res_targetTexture	=raytrace_effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("RenderTarget"));
+			auto res_lights			=raytrace_effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("lights"));
 
 			renderPlatform->ApplyPass(deviceContext,rayPass);
 			renderPlatform->SetStructuredBuffer(deviceContext, &lightsStructuredBuffer, res_lights);
@@ -497,7 +497,7 @@ public:
 			renderPlatform->SetConstantBuffer(deviceContext, &sceneConstants);
 
 			lightsStructuredBuffer.SetData(deviceContext, lights);
-			renderPlatform->SetStructuredBuffer(deviceContext, &lightsStructuredBuffer, effect->GetShaderResource("lights"));
+			renderPlatform->SetStructuredBuffer(deviceContext, &lightsStructuredBuffer, effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("lights")));
 			effect->Apply(deviceContext, "solid", 0);
 			// pass raytraced rtTargetTexture as shadow.
 			meshRenderer->Render(deviceContext, exampleMesh, mat4::translationColumnMajor(vec3(sin(real_time), 0.0f, 2.0f)), diffuseCubemapTexture, specularCubemapTexture, rtTargetTexture);
@@ -644,6 +644,37 @@ bool RewriteOutput(const SfxConfig &sfxConfig
 	return has_errors;
 }
 
+static string ReadWholeFile(const wstring &filename)
+{
+#ifdef _MSC_VER
+	std::ifstream f(filename.c_str(), std::ios_base::binary);
+#else
+	std::ifstream f(WStringToUtf8(filename).c_str(), std::ios_base::binary);
+#endif
+	return string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+// Append a compiled binary, or a generated source, to the combined binary, unless an identical one is already there.
+static void AppendToCombinedBinary(const string &blob,const wstring &filename,const string &sbf
+	,std::ofstream &combinedBinary,BinaryMap &binaryMap,BinaryDeduplication &dedup)
+{
+	auto key=std::make_tuple(std::hash<string>{}(blob),blob.size());
+	auto d=dedup.binaries.find(key);
+	if(d!=dedup.binaries.end()&&binaryMap.find(d->second.sbFilename)!=binaryMap.end()
+		&&ReadWholeFile(Utf8ToWString(d->second.filenameUtf8))==blob)
+	{
+		binaryMap[sbf]=binaryMap[d->second.sbFilename];
+		dedup.binariesShared++;
+		dedup.bytesSaved+=blob.size();
+		return;
+	}
+	std::streampos startp=combinedBinary.tellp();
+	combinedBinary.write(blob.data(),blob.size());
+	binaryMap[sbf]=std::make_tuple(startp,blob.size());
+	if(d==dedup.binaries.end())
+		dedup.binaries[key]={sbf,WStringToUtf8(filename),""};
+}
+
 int Compile(std::shared_ptr<ShaderInstance> shaderInstance
 		,const string &sourceFile
 		,string targetFile
@@ -656,6 +687,7 @@ int Compile(std::shared_ptr<ShaderInstance> shaderInstance
 		,map<int,string> fileList
 		,std::ofstream &combinedBinary
 		,BinaryMap &binaryMap
+		,BinaryDeduplication &dedup
 		,const Declaration* rtState )
 {
 	string filenameOnly = GetFilenameOnly( sourceFile);
@@ -897,6 +929,40 @@ int Compile(std::shared_ptr<ShaderInstance> shaderInstance
 		pixelOutputFormat
 	);
 	ostringstream log;
+	// A source that matches one already compiled, with the same options, needn't be compiled again:
+	// compare them without the shader's own filenames.
+	string strippedSrc=src;
+	size_t tempfPos=strippedSrc.find(tempf);
+	if(tempfPos<strippedSrc.length())
+		strippedSrc.erase(tempfPos,tempf.length());
+	string strippedCommand=WStringToUtf8(compile_command);
+	find_and_replace(strippedCommand,WStringToUtf8(tempFilename),"");
+	find_and_replace(strippedCommand,WStringToUtf8(outputFile),"");
+	find_and_replace(strippedCommand,WStringToUtf8(targetFilename),"");
+	size_t sourceHash=std::hash<string>{}(strippedSrc+"\n"+strippedCommand);
+	if(sfxOptions.wrapOutput)
+	{
+		auto d=dedup.sources.find(sourceHash);
+		if(d!=dedup.sources.end()&&d->second.compileCommand==strippedCommand&&binaryMap.find(d->second.sbFilename)!=binaryMap.end())
+		{
+			string earlier=ReadWholeFile(Utf8ToWString(d->second.filenameUtf8));
+			size_t p=earlier.find(d->second.filenameUtf8);
+			if(p<earlier.length())
+				earlier.erase(p,d->second.filenameUtf8.length());
+			if(earlier==strippedSrc)
+			{
+				binaryMap[sbf]=binaryMap[d->second.sbFilename];
+				dedup.sourcesSkipped++;
+				dedup.bytesSaved+=std::get<1>(binaryMap[sbf]);
+				return 1;
+			}
+		}
+	}
+	auto RecordSource=[&]()
+	{
+		if(sfxOptions.wrapOutput&&binaryMap.find(sbf)!=binaryMap.end()&&dedup.sources.find(sourceHash)==dedup.sources.end())
+			dedup.sources[sourceHash]={sbf,tempf,strippedCommand};
+	};
 	// If no compiler provided, we can return now (perhaps we are only interested in
 	// the shader source)
 	if (compile_command.empty())
@@ -917,17 +983,15 @@ int Compile(std::shared_ptr<ShaderInstance> shaderInstance
 				SFX_BREAK("Failed to load generated shader source");
 				exit(1002);
 			}
-			std::streampos startp = combinedBinary.tellp();
-			combinedBinary << if_c.rdbuf();
-			std::streampos endp = combinedBinary.tellp();
-			size_t sz=endp - startp;
-			if(!sz)
+			string blob((std::istreambuf_iterator<char>(if_c)), std::istreambuf_iterator<char>());
+			if(blob.empty())
 			{
 				SFX_BREAK("Empty output shader ");
 				std::cerr<<"Empty output shader "<<WStringToUtf8(tempFilename)<<"\n";
 				exit(1001);
 			}
-			binaryMap[sbf] = std::make_tuple(startp, sz);
+			AppendToCombinedBinary(blob,tempFilename,sbf,combinedBinary,binaryMap,dedup);
+			RecordSource();
 		}
 		return true;
 	}
@@ -994,18 +1058,17 @@ int Compile(std::shared_ptr<ShaderInstance> shaderInstance
 					exit(1727);
 				}
 				created_output=true;
-				std::streampos startp=combinedBinary.tellp();
-				combinedBinary << if_c.rdbuf();
-				std::streampos endp = combinedBinary.tellp();
-				size_t sz=endp - startp;
-				if(!sz)
+				string blob((std::istreambuf_iterator<char>(if_c)), std::istreambuf_iterator<char>());
+				if(blob.empty())
 				{
 					std::cerr << log.str() << std::endl;
 					std::cerr << "Empty output binary" << WStringToUtf8(outputFile).c_str()<< std::endl;
 					SFX_BREAK("Empty output binary");
 					exit(1626);
 				}
-				binaryMap[sbf] = std::make_tuple(startp, sz);
+				AppendToCombinedBinary(blob,outputFile,sbf,combinedBinary,binaryMap,dedup);
+				if(res)
+					RecordSource();
 			}
 			else
 				break;
@@ -14,4 +14,5 @@ extern int Compile(std::shared_ptr<sfx::ShaderInstance> shader, const std::strin
 					, std::map<int, std::string> fileList
 					, std::ofstream &combinedBinary
 					, BinaryMap &binaryMap
+					, BinaryDeduplication &dedup
 					, const Declaration* rtState = nullptr);
\ No newline at end of file
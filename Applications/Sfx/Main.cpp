@@ -3,6 +3,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 #include <iomanip> // for setw
 #include "Sfx.h"
@@ -49,6 +50,30 @@ const SfxOptions &GetSfxOptions()
 {
     return sfxOptions;
 }
+// Read the lines "effect shader_variant" that name this effect.
+void LoadVariantManifest(const std::string &filename,const std::string &effectName)
+{
+	std::ifstream m(filename);
+	if(!m.good())
+	{
+		std::cerr<<filename<<": warning: can't read variant manifest, compiling all variants."<<std::endl;
+		return;
+	}
+	std::string line;
+	while(std::getline(m,line))
+	{
+		if(!line.length()||line[0]=='#')
+			continue;
+		size_t sp=line.find(' ');
+		if(sp==std::string::npos||line.substr(0,sp)!=effectName)
+			continue;
+		std::string variant=line.substr(sp+1);
+		while(variant.length()&&(variant.back()=='\r'||variant.back()==' '))
+			variant.pop_back();
+		sfxOptions.manifestVariants.insert(variant);
+	}
+	sfxOptions.useVariantManifest=sfxOptions.manifestVariants.size()>0;
+}
 extern bool terminate_command;
 // A ctrl message handler to detect "close" events.
 BOOL WINAPI CtrlHandler(DWORD fdwCtrlType)
@@ -126,7 +151,16 @@ int main(int argc, char** argv)
 		int a=0;
 		for(int i=1;i<argc;i++)
 		{
-			if(strlen(argv[i])>=2&&(argv[i][0]=='-'))
+			if(strncmp(argv[i],"--variant-manifest",18)==0)
+			{
+				const char *m=argv[i]+18;
+				if(*m=='=')
+					m++;
+				else if(*m==0&&i+1<argc)
+					m=argv[++i];
+				sfxOptions.variantManifestFile=StripQuotes(m);
+			}
+			else if(strlen(argv[i])>=2&&(argv[i][0]=='-'))
 			{
 				const char *arg=argv[i]+2;
 				for(int j=0;j<100;j++)
@@ -199,6 +233,8 @@ int main(int argc, char** argv)
 	}
 	std::filesystem::path sourcePath(sourcefile);
 	std::string sourceName=sourcePath.filename().generic_string();
+	if(sfxOptions.variantManifestFile.length())
+		LoadVariantManifest(sfxOptions.variantManifestFile,sourcePath.stem().generic_string());
 	for(auto platformFilename:platformFilenames)
 	{
 		std::ifstream i(platformFilename);
@@ -632,6 +632,18 @@ bool sfxParseEffectFromFile(int effect, const char *file, const std::vector<std:
 		latest_file=file;
 		if (!preprocess(file, config->define, sfxOptions->disableLineWrites))
 			return false;
+		// List the source and include files beside the output, so that the runtime can tell which effects to rebuild when a file changes.
+		{
+			string sfxdFilename=sfxoFilename;
+			find_and_replace(sfxdFilename,".sfxo",".sfxd");
+			mkpath(sfxdFilename);
+			ofstream deps(sfxdFilename);
+			for(const auto &f:GetPreprocessorFilenamesUtf8())
+			{
+				if(f.length())
+					deps<<std::filesystem::absolute(f).generic_string()<<"\n";
+			}
+		}
 		double output_filedatetime=GetFileDate(sfxoFilename);
 		bool recompile=false;
 		if(sfxOptions->force)
@@ -658,6 +670,12 @@ bool sfxParseEffectFromFile(int effect, const char *file, const std::vector<std:
 			if(sfxOptions->verbose)
 				std::cout<<"Newer platform json file: recompiling.\n";
 		}
+		else if(sfxOptions->variantManifestFile.length()&&GetFileDate(sfxOptions->variantManifestFile)>output_filedatetime)
+		{
+			recompile=true;
+			if(sfxOptions->verbose)
+				std::cout<<"Newer variant manifest: recompiling.\n";
+		}
 	// preprocess establishes what the newest source/include file is, so we can check if we need to recompile.if(platformfile_datetime>output_filedatetime)
 		else if(latest_datetime>output_filedatetime)
 		{
@@ -27,6 +27,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
 #include <string>
 #include <map>
 #include <vector>
+#include <set>
 
 #ifdef _MSC_VER
 #define strcasecmp _stricmp
@@ -173,6 +174,12 @@ struct SfxOptions
 	std::string intermediateDirectory;
 	std::string outputFile;
 	int optimizationLevel=-1;
+	//! A manifest of the shader variants used at runtime, as saved by crossplatform::VariantManifest.
+	std::string variantManifestFile;
+	//! If true, only the variants in manifestVariants are compiled, plus the first of each shader as a fallback.
+	//! False when the manifest doesn't mention this effect, so that all its variants are compiled.
+	bool useVariantManifest=false;
+	std::set<std::string> manifestVariants;
 };
 extern const SfxOptions &GetSfxOptions();
 extern std::string ppfile;
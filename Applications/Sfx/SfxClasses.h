@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
 #include <string>
 #include <sstream>
 #include <vector>
+#include <tuple>
 
 int sfxparse();
 int sfxlex();
@@ -37,6 +38,22 @@ int sfxlex();
 namespace sfx
 {
 	typedef std::map<std::string, std::tuple<std::streampos, std::size_t>> BinaryMap;
+	/// Identical generated sources are compiled once, and identical outputs stored once in the combined binary,
+	/// with several BinaryMap entries pointing at the same offset.
+	struct BinaryDeduplication
+	{
+		struct Entry
+		{
+			std::string sbFilename;		// The BinaryMap entry that holds the data.
+			std::string filenameUtf8;	// The intermediate file, to confirm that a hash match is really identical.
+			std::string compileCommand;	// For sources: the compile command, with the shader's own filenames removed.
+		};
+		std::map<std::size_t, Entry> sources;
+		std::map<std::tuple<std::size_t, std::size_t>, Entry> binaries;
+		int sourcesSkipped = 0;
+		int binariesShared = 0;
+		std::size_t bytesSaved = 0;
+	};
 	/// This must track platform::crossplatform::ShaderResourceType
 	enum class ShaderResourceType : unsigned long long
 	{
@@ -693,6 +693,7 @@ unsigned Effect::CompileAllShaders(string sfxoFilename,const string &sharedCode,
 	int res=1;
 	PixelOutputFormat pixelOutputFormat=FMT_UNKNOWN;
 	std::ofstream combinedBinary;
+	BinaryDeduplication dedup;
 	mkpath(std::filesystem::path(sfxoFilename).generic_string());
 	if (sfxOptions.wrapOutput)
 	{
@@ -766,30 +767,30 @@ unsigned Effect::CompileAllShaders(string sfxoFilename,const string &sharedCode,
 				// Just output generic formats that we may use
 				if (!rtFormat)
 				{
-					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_32_ABGR,sharedCode, sLog,sfxConfig,sfxOptions,fileList ,combinedBinary,binaryMap);
-					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_FP16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
-					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNORM16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
-					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_SNORM16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
+					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_32_ABGR,sharedCode, sLog,sfxConfig,sfxOptions,fileList ,combinedBinary,binaryMap,dedup);
+					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_FP16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
+					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNORM16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
+					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_SNORM16_ABGR,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
 				}
 				// We know the output format
 				else
 				{
-					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNKNOWN,sharedCode,sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap,rtFormat);
+					res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNKNOWN,sharedCode,sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup,rtFormat);
 				}
 			}
 			else
 			{
-				res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNKNOWN,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
+				res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,FMT_UNKNOWN,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
 			}
 			if(!res)
 				return 0;
 		}
 		else if(shaderInstance->shaderType==VERTEX_SHADER)
 		{
-			res&=Compile(shaderInstance,Filename(),sfxoFilename,VERTEX_SHADER,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
+			res&=Compile(shaderInstance,Filename(),sfxoFilename,VERTEX_SHADER,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
 			if(!res)
 				return 0;
-			res&=Compile(shaderInstance,Filename(),sfxoFilename,EXPORT_SHADER,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
+			res&=Compile(shaderInstance,Filename(),sfxoFilename,EXPORT_SHADER,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
 			if(!res)
 				return 0;
 		}
@@ -800,11 +801,16 @@ unsigned Effect::CompileAllShaders(string sfxoFilename,const string &sharedCode,
 		}
 		else
 		{
-			res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap);
+			res&=Compile(shaderInstance,Filename(),sfxoFilename,shaderInstance->shaderType,pixelOutputFormat,sharedCode, sLog,sfxConfig,sfxOptions, fileList, combinedBinary, binaryMap, dedup);
 			if(!res)
 				return 0;
 		}
 	}
+	if(dedup.sourcesSkipped||dedup.binariesShared)
+	{
+		std::cout<<sfxoFilename<<": info: "<<dedup.sourcesSkipped<<" identical shader sources not recompiled, "
+			<<dedup.binariesShared<<" identical binaries stored once, saving "<<dedup.bytesSaved<<" bytes.\n";
+	}
 	log=sLog.str();
 	return res;
 }
@@ -1112,6 +1118,9 @@ std::vector<std::string> Effect::GenerateShaderInstanceVariants(const std::strin
 		{
 			variantInstanceName += ")";
 		}
+		// With a manifest, skip the variants that weren't used, but keep the first as a fallback.
+		if(i>0&&sfxOptions.useVariantManifest&&!sfxOptions.manifestVariants.count(variantInstanceName))
+			continue;
 		variantInstance->variantName=variantInstanceName;
 		m_uniqueShaderInstances.insert(variantInstance);
 		m_shaderInstances[variantInstanceName]	=variantInstance;
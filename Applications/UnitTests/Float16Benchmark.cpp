@@ -0,0 +1,47 @@
+#include "UnitTest.h"
+#include "Platform/Math/Float16.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace platform;
+using namespace math;
+
+// Throughput of the bulk float16 conversions against a loop of the single-value functions, which are the scalar code.
+int main(int argc, char **argv)
+{
+	size_t count = argc > 1 ? (size_t)atoll(argv[1]) : (size_t)1 << 22;
+	std::vector<float> floats(count);
+	std::vector<uint16_t> halves(count);
+	for (size_t i = 0; i < count; i++)
+		floats[i] = (float)((i * 2654435761u) % 100000) * 0.01f - 500.0f;
+	std::cout << "Float16Benchmark: " << count << " values, hardware conversion " << (HasHardwareFloat16() ? "available" : "not available") << ".\n";
+	volatile uint16_t sinkHalf = 0;
+	volatile float sinkFloat = 0;
+	auto Report = [count](const char *what, double seconds)
+	{
+		std::cout << "  " << what << ": " << seconds * 1000.0 << " ms, " << count / seconds / 1.0e6 << " Mvalues/s\n";
+	};
+	Report("ToFloat16 single", platform::test::BestTime(5, [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			halves[i] = ToFloat16(floats[i]);
+		sinkHalf = halves[count / 2];
+	}));
+	Report("ToFloat16 bulk  ", platform::test::BestTime(5, [&]()
+	{
+		ToFloat16(floats.data(), halves.data(), count);
+		sinkHalf = halves[count / 2];
+	}));
+	Report("ToFloat32 single", platform::test::BestTime(5, [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			floats[i] = ToFloat32(halves[i]);
+		sinkFloat = floats[count / 2];
+	}));
+	Report("ToFloat32 bulk  ", platform::test::BestTime(5, [&]()
+	{
+		ToFloat32(halves.data(), floats.data(), count);
+		sinkFloat = floats[count / 2];
+	}));
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "UnitTest.h"
+#include "Platform/Math/Float16.h"
+#include <cstring>
+#include <vector>
+
+using namespace platform;
+using namespace math;
+
+// The bulk conversions use F16C or NEON where the CPU has them. The single-value functions are always the scalar code,
+// so comparing the two checks the hardware paths, and the scalar fallback, bit for bit.
+
+static uint32_t Bits(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, 4);
+	return u;
+}
+
+static float FromBits(uint32_t u)
+{
+	float f;
+	memcpy(&f, &u, 4);
+	return f;
+}
+
+static void TestAllHalves()
+{
+	std::vector<uint16_t> halves(65536);
+	for (uint32_t i = 0; i < 65536; i++)
+		halves[i] = (uint16_t)i;
+	std::vector<float> floats(65536);
+	ToFloat32(halves.data(), floats.data(), halves.size());
+	int mismatches = 0;
+	for (uint32_t i = 0; i < 65536; i++)
+	{
+		if (Bits(floats[i]) != Bits(ToFloat32((unsigned short)i)))
+			mismatches++;
+	}
+	PLATFORM_CHECK(mismatches == 0);
+	// Every half converts back to itself, except NaNs, which become the canonical quiet NaN.
+	std::vector<uint16_t> back(65536);
+	ToFloat16(floats.data(), back.data(), floats.size());
+	mismatches = 0;
+	for (uint32_t i = 0; i < 65536; i++)
+	{
+		bool nan = (i & 0x7c00) == 0x7c00 && (i & 0x3ff) != 0;
+		uint16_t expected = nan ? (uint16_t)(0x7e00 | (i & 0x8000)) : (uint16_t)i;
+		if (back[i] != ToFloat16(floats[i]) || (!nan && back[i] != expected))
+			mismatches++;
+	}
+	PLATFORM_CHECK(mismatches == 0);
+}
+
+static void TestFloats()
+{
+	// A sample of every float bit pattern, with a stride that visits every exponent and many mantissas,
+	// plus the edges of rounding and range.
+	std::vector<float> floats;
+	for (uint64_t u = 0; u < 0x100000000ull; u += 65521)
+		floats.push_back(FromBits((uint32_t)u));
+	const uint32_t edges[] = {0x00000000, 0x80000000, 0x7f800000, 0xff800000, 0x7fc00000, 0x7f800001, 0x477fe000, 0x477fefff,
+		0x477ff000, 0x38800000, 0x387fffff, 0x33000000, 0x33000001, 0x32ffffff, 0x3f800000, 0x3f801000, 0x3f803000};
+	for (uint32_t e : edges)
+	{
+		floats.push_back(FromBits(e));
+		floats.push_back(FromBits(e ^ 0x80000000));
+	}
+	std::vector<uint16_t> halves(floats.size());
+	ToFloat16(floats.data(), halves.data(), floats.size());
+	int mismatches = 0;
+	for (size_t i = 0; i < floats.size(); i++)
+	{
+		if (halves[i] != ToFloat16(floats[i]))
+			mismatches++;
+	}
+	PLATFORM_CHECK(mismatches == 0);
+	PLATFORM_CHECK(ToFloat16(1.0f) == 0x3c00);
+	PLATFORM_CHECK(ToFloat16(65504.0f) == 0x7bff);
+	PLATFORM_CHECK(ToFloat16(65520.0f) == 0x7c00);
+	PLATFORM_CHECK(ToFloat32((unsigned short)0xc000) == -2.0f);
+}
+
+static void TestCountsAndAlignment()
+{
+	// The hardware loops work in groups; every count and offset must give the same results as the single-value functions.
+	std::vector<float> floats(64 + 3);
+	for (size_t i = 0; i < floats.size(); i++)
+		floats[i] = (float)i * 0.37f - 7.0f;
+	for (size_t offset = 0; offset < 3; offset++)
+	{
+		for (size_t count = 0; count <= 64; count++)
+		{
+			std::vector<uint16_t> halves(count + 1, 0xabcd);
+			ToFloat16(floats.data() + offset, halves.data(), count);
+			bool ok = halves[count] == 0xabcd;
+			for (size_t i = 0; i < count; i++)
+				ok &= halves[i] == ToFloat16(floats[offset + i]);
+			std::vector<float> back(count + 1, 123.0f);
+			ToFloat32(halves.data(), back.data(), count);
+			ok &= back[count] == 123.0f;
+			for (size_t i = 0; i < count; i++)
+				ok &= Bits(back[i]) == Bits(ToFloat32(halves[i]));
+			PLATFORM_CHECK(ok);
+		}
+	}
+}
+
+int main(int, char **)
+{
+	std::cout << "Float16Test: hardware conversion " << (HasHardwareFloat16() ? "available" : "not available") << ".\n";
+	TestAllHalves();
+	TestFloats();
+	TestCountsAndAlignment();
+	return platform::test::Finish("Float16Test");
+}
@@ -0,0 +1,170 @@
+#include "UnitTest.h"
+#include "Platform/CrossPlatform/ImagePipeline.h"
+#include <initializer_list>
+
+using namespace platform;
+using namespace crossplatform;
+
+// ImagePipeline's channel packing and mip filtering, on small images with known results.
+
+static Image MakeImage(int width, int height, int channels, std::initializer_list<int> values)
+{
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.channels = channels;
+	for (int v : values)
+		image.pixels.push_back((uint8_t)v);
+	PLATFORM_CHECK(image.IsValid());
+	return image;
+}
+
+static bool Equal(const Image &image, int width, int height, int channels, std::initializer_list<int> values)
+{
+	if (image.width != width || image.height != height || image.channels != channels || image.pixels.size() != values.size())
+		return false;
+	size_t i = 0;
+	for (int v : values)
+	{
+		if (image.pixels[i++] != (uint8_t)v)
+			return false;
+	}
+	return true;
+}
+
+static void TestCountNeededChannels()
+{
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 3, {10, 10, 10, 200, 200, 200})) == 1);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 3, {10, 10, 10, 200, 201, 200})) == 3);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 4, {10, 10, 10, 255, 200, 200, 200, 255})) == 1);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 4, {10, 10, 10, 255, 200, 200, 200, 254})) == 2);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 4, {10, 20, 30, 255, 200, 200, 200, 255})) == 3);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 4, {10, 20, 30, 0, 200, 200, 200, 255})) == 4);
+	// One and two channels are already grey.
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 1, {10, 20})) == 1);
+	PLATFORM_CHECK(ImagePipeline::CountNeededChannels(MakeImage(2, 1, 2, {10, 255, 20, 255})) == 2);
+}
+
+static void TestPackChannels()
+{
+	Image rgba = MakeImage(2, 1, 4, {255, 0, 0, 128, 0, 255, 0, 255});
+	Image dst;
+	// Colour to grey takes the luminance, (77 r + 150 g + 29 b) / 256.
+	ImagePipeline::PackChannels(rgba, dst, 1);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 1, {76, 149}));
+	ImagePipeline::PackChannels(rgba, dst, 2);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 2, {76, 128, 149, 255}));
+	ImagePipeline::PackChannels(rgba, dst, 3);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 3, {255, 0, 0, 0, 255, 0}));
+	ImagePipeline::PackChannels(rgba, dst, 4);
+	PLATFORM_CHECK(dst.pixels == rgba.pixels && dst.channels == 4);
+	// Grey to colour copies the grey to red, green and blue; a missing alpha is opaque.
+	ImagePipeline::PackChannels(MakeImage(2, 1, 1, {7, 9}), dst, 4);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 4, {7, 7, 7, 255, 9, 9, 9, 255}));
+	ImagePipeline::PackChannels(MakeImage(2, 1, 2, {7, 1, 9, 2}), dst, 4);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 4, {7, 7, 7, 1, 9, 9, 9, 2}));
+	// In place.
+	ImagePipeline::PackChannels(rgba, rgba, 3);
+	PLATFORM_CHECK(Equal(rgba, 2, 1, 3, {255, 0, 0, 0, 255, 0}));
+}
+
+static void TestMipSizes()
+{
+	PLATFORM_CHECK(ImagePipeline::CountMips(1, 1) == 1);
+	PLATFORM_CHECK(ImagePipeline::CountMips(2, 1) == 2);
+	PLATFORM_CHECK(ImagePipeline::CountMips(256, 256) == 9);
+	PLATFORM_CHECK(ImagePipeline::CountMips(257, 3) == 9);
+	PLATFORM_CHECK(ImagePipeline::CountMips(5, 300) == 9);
+	// Sizes halve and round down, to no less than one.
+	PLATFORM_CHECK(ImagePipeline::MipSize(5, 0) == 5);
+	PLATFORM_CHECK(ImagePipeline::MipSize(5, 1) == 2);
+	PLATFORM_CHECK(ImagePipeline::MipSize(5, 2) == 1);
+	PLATFORM_CHECK(ImagePipeline::MipSize(5, 10) == 1);
+	PLATFORM_CHECK(ImagePipeline::MipSize(1024, 3) == 128);
+	MipChainSettings settings;
+	settings.maxMips = 3;
+	std::vector<Image> mips = ImagePipeline::BuildMipChain(MakeImage(5, 3, 1, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}), settings);
+	PLATFORM_CHECK(mips.size() == 3);
+	if (mips.size() == 3)
+		PLATFORM_CHECK(mips[1].width == 2 && mips[1].height == 1 && mips[2].width == 1 && mips[2].height == 1);
+}
+
+static void TestBoxHalving()
+{
+	MipChainSettings linear;
+	linear.srgb = false;
+	Image dst;
+	// Each texel is the mean of a 2x2 block.
+	ImagePipeline::Downsample(MakeImage(4, 2, 1, {0, 8, 20, 40, 4, 0, 100, 200}), dst, linear);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 1, {3, 90}));
+	// Four channels take the vectorized path.
+	ImagePipeline::Downsample(MakeImage(4, 2, 4, {0, 8, 20, 40, 4, 0, 100, 200, 1, 2, 3, 4, 5, 6, 7, 8,
+												  4, 0, 100, 200, 0, 8, 20, 40, 3, 2, 1, 0, 7, 6, 5, 4}),
+		dst, linear);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 4, {2, 4, 60, 120, 4, 4, 4, 4}));
+}
+
+static void TestOddDownsample()
+{
+	MipChainSettings linear;
+	linear.srgb = false;
+	Image dst;
+	// 3x3 to 1x1 is the mean of all nine.
+	ImagePipeline::Downsample(MakeImage(3, 3, 1, {1, 2, 3, 4, 5, 6, 7, 8, 90}), dst, linear);
+	PLATFORM_CHECK(Equal(dst, 1, 1, 1, {14}));
+	// 5 to 2: each destination texel covers two and a half source texels, so the middle one is split between them.
+	ImagePipeline::Downsample(MakeImage(5, 1, 1, {10, 20, 30, 40, 50}), dst, linear);
+	PLATFORM_CHECK(Equal(dst, 2, 1, 1, {18, 42}));
+}
+
+// Filtering in linear space must give back every sRGB value unchanged where the image is uniform.
+static void TestSRGBRoundTrip()
+{
+	Image ramp;
+	ramp.width = 512;
+	ramp.height = 2;
+	ramp.channels = 4;
+	for (int y = 0; y < 2; y++)
+	{
+		for (int x = 0; x < 512; x++)
+		{
+			for (int k = 0; k < 4; k++)
+				ramp.pixels.push_back((uint8_t)(x / 2));
+		}
+	}
+	Image dst;
+	ImagePipeline::Downsample(ramp, dst, MipChainSettings());
+	bool same = dst.width == 256 && dst.height == 1;
+	for (int x = 0; same && x < 256; x++)
+	{
+		for (int k = 0; k < 4; k++)
+			same &= dst.pixels[x * 4 + k] == x;
+	}
+	PLATFORM_CHECK(same);
+	MipChainSettings kaiser;
+	kaiser.filter = MipFilter::KAISER;
+	for (int v = 0; v < 256; v++)
+	{
+		Image flat;
+		flat.width = flat.height = 8;
+		flat.channels = 3;
+		flat.pixels.assign(8 * 8 * 3, (uint8_t)v);
+		ImagePipeline::Downsample(flat, dst, kaiser);
+		bool flatSame = dst.width == 4 && dst.height == 4;
+		for (uint8_t p : dst.pixels)
+			flatSame &= p == v;
+		if (!PLATFORM_CHECK(flatSame))
+			break;
+	}
+}
+
+int main()
+{
+	TestCountNeededChannels();
+	TestPackChannels();
+	TestMipSizes();
+	TestBoxHalving();
+	TestOddDownsample();
+	TestSRGBRoundTrip();
+	return platform::test::Finish("ImagePipelineTest");
+}
@@ -0,0 +1,58 @@
+#include "UnitTest.h"
+#include "Platform/CrossPlatform/TextInputOutput.h"
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+using namespace platform;
+using namespace crossplatform;
+
+// Keyframe load time from TextFileOutput's text format against its binary format.
+// The argument is the number of keyframes; each has a time, position, rotation and index, which SaveBinary stores as records.
+
+int main(int argc, char **argv)
+{
+	int count = argc > 1 ? atoi(argv[1]) : 100000;
+	TextFileOutput out;
+	TextOutput::Array &keyframes = out.CreateArray("keyframes", count);
+	for (int i = 0; i < count; i++)
+	{
+		keyframes[i]->Set("time", 0.04 * i);
+		keyframes[i]->Set("position", vec3((float)i, 0.5f * i, -1.0f * i));
+		keyframes[i]->Set("rotation", vec4(0.f, 0.f, 0.1f, 1.f));
+		keyframes[i]->Set("index", (uint)i);
+	}
+	std::string text = out.getText();
+	std::ostringstream os(std::ios::binary);
+	out.SaveBinary(os, true);
+	std::string binary = os.str();
+
+	// Read every value back, so that the binary loader's deferred conversions are counted too.
+	double sum = 0.0;
+	auto readAll = [&sum](TextFileInput &in)
+	{
+		for (TextInput *k : in.GetArray("keyframes"))
+		{
+			sum += k->Get("time", 0.0);
+			sum += k->Get("position", vec3(0, 0, 0)).x;
+			sum += k->Get("rotation", vec4(0, 0, 0, 0)).z;
+			sum += k->Get("index", (uint)0);
+		}
+	};
+	double textSeconds = platform::test::BestTime(5, [&]()
+	{
+		TextFileInput in;
+		in.Load(text);
+		readAll(in);
+	});
+	double binarySeconds = platform::test::BestTime(5, [&]()
+	{
+		TextFileInput in;
+		in.LoadBinary(binary.data(), binary.size());
+		readAll(in);
+	});
+	std::cout << "KeyframeLoadBenchmark: " << count << " keyframes, checksum " << sum << ".\n";
+	std::cout << "  Text:   " << text.size() << " bytes, " << textSeconds * 1000.0 << " ms\n";
+	std::cout << "  Binary: " << binary.size() << " bytes, " << binarySeconds * 1000.0 << " ms, " << textSeconds / binarySeconds << "x faster\n";
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include "UnitTest.h"
+#include "Platform/Core/Log.h"
+#include <string>
+#include <vector>
+
+using namespace platform;
+using namespace core;
+
+// The rate limit drops repeated warnings and errors, but never information, and always says how many it dropped.
+
+class CaptureSink : public LogSink
+{
+public:
+	std::vector<LogMessage> messages;
+	void Write(const LogMessage &message) override
+	{
+		messages.push_back(message);
+	}
+};
+
+static void TestInfoIsNotLimited(CaptureSink &sink)
+{
+	sink.messages.clear();
+	for (int i = 0; i < 1000; i++)
+		PLATFORM_LOG(LogSeverity::Info) << "info " << i;
+	FlushLog();
+	PLATFORM_CHECK(sink.messages.size() == 1000);
+	if (sink.messages.size() == 1000)
+		PLATFORM_CHECK(sink.messages[999].text == "info 999" && sink.messages[999].suppressed == 0);
+}
+
+// Every warning is either written or counted as suppressed: with a later message from the same site, or by FlushLog().
+static void TestWarningsAreLimited(CaptureSink &sink)
+{
+	sink.messages.clear();
+	for (int i = 0; i < 1000; i++)
+		PLATFORM_LOG(LogSeverity::Warning) << "warning " << i;
+	FlushLog();
+	size_t written = 0, suppressed = 0, reports = 0;
+	for (const LogMessage &m : sink.messages)
+	{
+		PLATFORM_CHECK(m.severity == LogSeverity::Warning && m.line == sink.messages[0].line);
+		suppressed += m.suppressed;
+		size_t space = m.text.find(' ');
+		if (m.text.substr(space + 1) == "messages suppressed")
+		{
+			suppressed += std::stoul(m.text.substr(0, space));
+			reports++;
+		}
+		else
+			written++;
+	}
+	// At most the burst, and perhaps one or two more if the loop took longer than the interval.
+	PLATFORM_CHECK(written <= 105);
+	PLATFORM_CHECK(written + suppressed == 1000);
+	PLATFORM_CHECK(reports == 1);
+	// Nothing more to report.
+	size_t count = sink.messages.size();
+	FlushLog();
+	PLATFORM_CHECK(sink.messages.size() == count);
+}
+
+int main()
+{
+	CaptureSink sink;
+	SetLogSink(&sink);
+	for (bool asynchronous : {false, true})
+	{
+		SetLogAsynchronous(asynchronous);
+		TestInfoIsNotLimited(sink);
+		TestWarningsAreLimited(sink);
+	}
+	SetLogAsynchronous(false);
+	SetLogSink(nullptr);
+	return platform::test::Finish("LogTest");
+}
@@ -0,0 +1,137 @@
+#include "UnitTest.h"
+#include "Platform/Vulkan/PipelineCache.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace platform;
+using namespace vulkan;
+
+// The pipeline cache file format, checked without a device: PipelineCache::Serialize and Deserialize work on plain memory.
+
+static PipelineCacheIdentity MakeIdentity()
+{
+	PipelineCacheIdentity id;
+	id.vendorID = 0x10de;
+	id.deviceID = 0x2484;
+	id.driverVersion = 0x84c08000;
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+		id.pipelineCacheUUID[i] = (uint8_t)(i * 17 + 3);
+	return id;
+}
+
+// A blob as a driver would return it: the VK_PIPELINE_CACHE_HEADER_VERSION_ONE header, then opaque data.
+static std::vector<uint8_t> MakeDriverBlob(const PipelineCacheIdentity &id, size_t payload)
+{
+	const uint32_t headerSize = 16 + VK_UUID_SIZE;
+	std::vector<uint8_t> blob(headerSize + payload);
+	uint32_t fields[4] = {headerSize, (uint32_t)VK_PIPELINE_CACHE_HEADER_VERSION_ONE, id.vendorID, id.deviceID};
+	memcpy(blob.data(), fields, sizeof(fields));
+	memcpy(blob.data() + 16, id.pipelineCacheUUID, VK_UUID_SIZE);
+	for (size_t i = 0; i < payload; i++)
+		blob[headerSize + i] = (uint8_t)(i * 31 + 7);
+	return blob;
+}
+
+static bool Rejects(const PipelineCacheIdentity &id, const std::vector<uint8_t> &file, const char *expectedReason)
+{
+	std::vector<uint8_t> blob(4, 0xff);
+	std::string reason;
+	bool ok = PipelineCache::Deserialize(id, file.data(), file.size(), blob, &reason);
+	if (!ok && reason != expectedReason)
+		std::cerr << "Rejected for \"" << reason << "\", expected \"" << expectedReason << "\".\n";
+	return !ok && reason == expectedReason && blob.empty();
+}
+
+static void TestRoundTrip()
+{
+	PipelineCacheIdentity id = MakeIdentity();
+	std::vector<uint8_t> driverBlob = MakeDriverBlob(id, 1000);
+	std::vector<uint8_t> file = PipelineCache::Serialize(id, driverBlob.data(), driverBlob.size());
+	PLATFORM_CHECK(file.size() > driverBlob.size());
+	std::vector<uint8_t> blob;
+	std::string reason;
+	PLATFORM_CHECK(PipelineCache::Deserialize(id, file.data(), file.size(), blob, &reason));
+	PLATFORM_CHECK(blob == driverBlob);
+	PLATFORM_CHECK(PipelineCache::Deserialize(id, file.data(), file.size(), blob));
+}
+
+static void TestIdentityMismatch()
+{
+	PipelineCacheIdentity id = MakeIdentity();
+	std::vector<uint8_t> driverBlob = MakeDriverBlob(id, 100);
+	std::vector<uint8_t> file = PipelineCache::Serialize(id, driverBlob.data(), driverBlob.size());
+	PipelineCacheIdentity other = id;
+	other.vendorID++;
+	PLATFORM_CHECK(Rejects(other, file, "written for a different device"));
+	other = id;
+	other.deviceID++;
+	PLATFORM_CHECK(Rejects(other, file, "written for a different device"));
+	other = id;
+	other.driverVersion++;
+	PLATFORM_CHECK(Rejects(other, file, "written by a different driver version"));
+	other = id;
+	other.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 1;
+	PLATFORM_CHECK(Rejects(other, file, "pipeline cache UUID mismatch"));
+	PLATFORM_CHECK(other == other && !(other == id));
+}
+
+static void TestCorruption()
+{
+	PipelineCacheIdentity id = MakeIdentity();
+	std::vector<uint8_t> driverBlob = MakeDriverBlob(id, 100);
+	const std::vector<uint8_t> file = PipelineCache::Serialize(id, driverBlob.data(), driverBlob.size());
+	const size_t headerSize = file.size() - driverBlob.size();
+
+	PLATFORM_CHECK(Rejects(id, std::vector<uint8_t>(), "file is too small"));
+	PLATFORM_CHECK(Rejects(id, std::vector<uint8_t>(file.begin(), file.begin() + headerSize - 1), "file is too small"));
+
+	std::vector<uint8_t> bad = file;
+	bad[0] = 'X';
+	PLATFORM_CHECK(Rejects(id, bad, "not a pipeline cache file"));
+	bad = file;
+	bad[4]++;
+	PLATFORM_CHECK(Rejects(id, bad, "unsupported file version"));
+
+	// Truncated, or with bytes appended.
+	PLATFORM_CHECK(Rejects(id, std::vector<uint8_t>(file.begin(), file.end() - 1), "truncated data"));
+	PLATFORM_CHECK(Rejects(id, std::vector<uint8_t>(file.begin(), file.begin() + headerSize), "truncated data"));
+	bad = file;
+	bad.push_back(0);
+	PLATFORM_CHECK(Rejects(id, bad, "truncated data"));
+
+	// Any changed byte of the driver data fails the checksum.
+	for (size_t i = headerSize; i < file.size(); i += 13)
+	{
+		bad = file;
+		bad[i] ^= 0x40;
+		PLATFORM_CHECK(Rejects(id, bad, "checksum mismatch"));
+	}
+}
+
+static void TestDriverHeader()
+{
+	// The wrapper matches, but the driver's own header doesn't: not every driver rejects such data itself.
+	PipelineCacheIdentity id = MakeIdentity();
+	PipelineCacheIdentity other = id;
+	other.deviceID++;
+	std::vector<uint8_t> foreign = MakeDriverBlob(other, 100);
+	PLATFORM_CHECK(Rejects(id, PipelineCache::Serialize(id, foreign.data(), foreign.size()), "driver data header mismatch"));
+	std::vector<uint8_t> blob = MakeDriverBlob(id, 100);
+	blob[4] = 2;
+	PLATFORM_CHECK(Rejects(id, PipelineCache::Serialize(id, blob.data(), blob.size()), "driver data header mismatch"));
+	blob = MakeDriverBlob(id, 100);
+	blob[0] = 255;
+	PLATFORM_CHECK(Rejects(id, PipelineCache::Serialize(id, blob.data(), blob.size()), "driver data header mismatch"));
+	PLATFORM_CHECK(Rejects(id, PipelineCache::Serialize(id, blob.data(), 8), "driver data is too small"));
+	PLATFORM_CHECK(Rejects(id, PipelineCache::Serialize(id, nullptr, 0), "driver data is too small"));
+}
+
+int main(int, char **)
+{
+	TestRoundTrip();
+	TestIdentityMismatch();
+	TestCorruption();
+	TestDriverHeader();
+	return platform::test::Finish("PipelineCacheTest");
+}
@@ -0,0 +1,316 @@
+#include "UnitTest.h"
+#include "Platform/CrossPlatform/TextInputOutput.h"
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace platform;
+using namespace crossplatform;
+
+// TextFileOutput's text and binary formats read back by TextFileInput, and the json-style input that TextFileInput also accepts.
+
+static void FillProperties(TextOutput &o, int i)
+{
+	o.Set("name", (std::string("node ") + std::to_string(i)).c_str());
+	o.Set("flag", i % 2 == 0);
+	o.Set("int", -1000 * i - 7);
+	o.Set("uint", (uint)(3000000000u + i));
+	o.Set("int64", -(1LL << 40) - i);
+	o.Set("uint64", (1ULL << 63) + i);
+	o.Set("double", 0.1 * i + 1.0 / 3.0);
+	o.Set("float", 1.0f / (i + 3.0f));
+	o.Set("uint2", uint2(1, 2 + i));
+	o.Set("uint3", uint3(3, 4, 5 + i));
+	o.Set("uint4", uint4(6, 7, 8, 9 + i));
+	o.Set("int2", int2(-1, i));
+	o.Set("int3", int3(-2, 0, i));
+	o.Set("int4", int4(-3, 1, 2, i));
+	o.Set("vec2", vec2(0.5f, -0.25f * i));
+	o.Set("vec3", vec3(1.5f, 1e-7f, 3.0e6f + i));
+	o.Set("vec4", vec4(0.1f, 0.2f, 0.3f, 0.4f * i));
+	o.Set("quat", Quaterniond(0.1, 0.2, 0.3 + i, 0.9, false));
+}
+
+static void CheckProperties(TextInput &in, int i)
+{
+	PLATFORM_CHECK(std::string(in.Get("name", "")) == "node " + std::to_string(i));
+	PLATFORM_CHECK(in.Get("flag", i % 2 != 0) == (i % 2 == 0));
+	PLATFORM_CHECK(in.Get("int", 0) == -1000 * i - 7);
+	PLATFORM_CHECK(in.Get("uint", (uint)0) == (uint)(3000000000u + i));
+	PLATFORM_CHECK(in.Get("int64", 0LL) == -(1LL << 40) - i);
+	PLATFORM_CHECK(in.Get("uint64", 0ULL) == (1ULL << 63) + i);
+	// Doubles are written with 16 significant digits, so they may lose their last bit.
+	PLATFORM_CHECK_NEAR(in.Get("double", 0.0), 0.1 * i + 1.0 / 3.0, 1e-14);
+	PLATFORM_CHECK(in.Get("float", 0.0f) == 1.0f / (i + 3.0f));
+	uint2 u2 = in.Get("uint2", uint2(0, 0));
+	PLATFORM_CHECK(u2.x == 1 && u2.y == 2u + i);
+	uint3 u3 = in.Get("uint3", uint3(0, 0, 0));
+	PLATFORM_CHECK(u3.x == 3 && u3.y == 4 && u3.z == 5u + i);
+	uint4 u4 = in.Get("uint4", uint4(0, 0, 0, 0));
+	PLATFORM_CHECK(u4.x == 6 && u4.y == 7 && u4.z == 8 && u4.w == 9u + i);
+	int2 i2 = in.Get("int2", int2(0, 0));
+	PLATFORM_CHECK(i2.x == -1 && i2.y == i);
+	int3 i3 = in.Get("int3", int3(0, 0, 0));
+	PLATFORM_CHECK(i3.x == -2 && i3.y == 0 && i3.z == i);
+	int4 i4 = in.Get("int4", int4(0, 0, 0, 0));
+	PLATFORM_CHECK(i4.x == -3 && i4.y == 1 && i4.z == 2 && i4.w == i);
+	vec2 v2 = in.Get("vec2", vec2(0, 0));
+	PLATFORM_CHECK(v2.x == 0.5f && v2.y == -0.25f * i);
+	vec3 v3 = in.Get("vec3", vec3(0, 0, 0));
+	PLATFORM_CHECK(v3.x == 1.5f && v3.y == 1e-7f && v3.z == 3.0e6f + i);
+	vec4 v4 = in.Get("vec4", vec4(0, 0, 0, 0));
+	PLATFORM_CHECK(v4.x == 0.1f && v4.y == 0.2f && v4.z == 0.3f && v4.w == 0.4f * i);
+	Quaterniond q = in.Get("quat", Quaterniond(0, 0, 0, 1, false));
+	PLATFORM_CHECK_NEAR(q.x, 0.1, 1e-15);
+	PLATFORM_CHECK_NEAR(q.y, 0.2, 1e-15);
+	PLATFORM_CHECK_NEAR(q.z, 0.3 + i, 1e-14);
+	PLATFORM_CHECK_NEAR(q.s, 0.9, 1e-15);
+}
+
+static void TestTextRoundTrip()
+{
+	TextFileOutput out;
+	FillProperties(out, 0);
+	out.Set("spaced", "  a value with spaces, and a comma ");
+	FillProperties(*out.CreateSubElement("sub"), 1);
+	out.CreateSubElement("sub")->CreateSubElement("inner")->Set("depth", 2);
+	TextOutput::Array &records = out.CreateArray("records", 3);
+	for (int i = 0; i < 3; i++)
+		FillProperties(*records[i], 10 + i);
+	// Elements with a single property are written without braces.
+	TextOutput::Array &single = out.CreateArray("single", 2);
+	single[0]->Set("only", 1);
+	single[1]->Set("only", 2);
+	TextOutput::Array &nested = out.CreateArray("nested", 1);
+	nested[0]->CreateArray("leaves", 2);
+	nested[0]->GetArray("leaves")[1]->Set("leaf", "b");
+
+	TextFileInput in;
+	in.Load(out.getText());
+	PLATFORM_CHECK(in.Good());
+	CheckProperties(in, 0);
+	PLATFORM_CHECK(std::string(in.Get("spaced", "")) == "  a value with spaces, and a comma ");
+	TextInput *sub = in.GetSubElement("sub");
+	PLATFORM_CHECK(sub != nullptr);
+	if (sub)
+	{
+		CheckProperties(*sub, 1);
+		TextInput *inner = sub->GetSubElement("inner");
+		PLATFORM_CHECK(inner && inner->Get("depth", 0) == 2);
+	}
+	const TextInput::Array &r = in.GetArray("records");
+	PLATFORM_CHECK(r.size() == 3);
+	for (size_t i = 0; i < r.size(); i++)
+		CheckProperties(*r[i], 10 + (int)i);
+	const TextInput::Array &s = in.GetArray("single");
+	PLATFORM_CHECK(s.size() == 2 && s[0]->Get("only", 0) == 1 && s[1]->Get("only", 0) == 2);
+	const TextInput::Array &n = in.GetArray("nested");
+	PLATFORM_CHECK(n.size() == 1);
+	if (n.size() == 1)
+	{
+		const TextInput::Array &leaves = n[0]->GetArray("leaves");
+		PLATFORM_CHECK(leaves.size() == 2);
+		if (leaves.size() == 2)
+			PLATFORM_CHECK(std::string(leaves[1]->Get("leaf", "")) == "b");
+	}
+	PLATFORM_CHECK(!in.Has("missing") && in.Get("missing", 42) == 42);
+}
+
+static void TestJsonStyle()
+{
+	const char *json =
+		"{\n"
+		"  \"title\": \"json style\",\n"
+		"  \"enabled\": true,\n"
+		"  \"count\": 12,\n"
+		"  \"scale\": -2.5,\n"
+		"  unquoted: a bare value,\n"
+		"  \"object\": {\n"
+		"    \"x\": 1,\n"
+		"    \"y\": \"two\" },\n"
+		"  \"inline\": { \"z\": 3 },\n"
+		"  \"list\": [ { \"e\": 1 }, { \"e\": 2, }, ],\n"
+		"  \"last\": 7 }\n";
+	TextFileInput in;
+	in.Load(std::string(json));
+	PLATFORM_CHECK(std::string(in.Get("title", "")) == "json style");
+	PLATFORM_CHECK(in.Get("enabled", false));
+	PLATFORM_CHECK(std::string(in.Get("enabled", "")) == "true");
+	PLATFORM_CHECK(in.Get("count", 0) == 12);
+	PLATFORM_CHECK(in.Get("scale", 0.0) == -2.5);
+	PLATFORM_CHECK(std::string(in.Get("unquoted", "")) == "a bare value");
+	TextInput *object = in.GetSubElement("object");
+	PLATFORM_CHECK(object && object->Get("x", 0) == 1 && std::string(object->Get("y", "")) == "two");
+	TextInput *inl = in.GetSubElement("inline");
+	PLATFORM_CHECK(inl && inl->Get("z", 0) == 3);
+	const TextInput::Array &list = in.GetArray("list");
+	PLATFORM_CHECK(list.size() == 2);
+	if (list.size() == 2)
+		PLATFORM_CHECK(list[0]->Get("e", 0) == 1 && list[1]->Get("e", 0) == 2);
+	PLATFORM_CHECK(in.Get("last", 0) == 7);
+}
+
+// Keyframes have only typed properties, all the same, so SaveBinary stores them as fixed-size records.
+static void FillKeyframes(TextOutput &o, int count)
+{
+	TextOutput::Array &keyframes = o.CreateArray("keyframes", count);
+	for (int i = 0; i < count; i++)
+	{
+		keyframes[i]->Set("time", 0.04 * i);
+		keyframes[i]->Set("position", vec3((float)i, 0.5f * i, -1.0f * i));
+		keyframes[i]->Set("rotation", vec4(0.f, 0.f, 0.1f * i, 1.f));
+		keyframes[i]->Set("index", (uint)i);
+		keyframes[i]->Set("key", i % 3 == 0);
+	}
+}
+
+static void CheckKeyframes(TextInput &in, int count)
+{
+	const TextInput::Array &keyframes = in.GetArray("keyframes");
+	PLATFORM_CHECK(keyframes.size() == (size_t)count);
+	for (size_t i = 0; i < keyframes.size(); i++)
+	{
+		TextInput &k = *keyframes[i];
+		PLATFORM_CHECK(k.Get("time", -1.0) == 0.04 * i);
+		vec3 p = k.Get("position", vec3(0, 0, 0));
+		PLATFORM_CHECK(p.x == (float)i && p.y == 0.5f * i && p.z == -1.0f * i);
+		vec4 r = k.Get("rotation", vec4(0, 0, 0, 0));
+		PLATFORM_CHECK(r.x == 0.f && r.y == 0.f && r.z == 0.1f * i && r.w == 1.f);
+		PLATFORM_CHECK(k.Get("index", (uint)-1) == (uint)i);
+		PLATFORM_CHECK(k.Get("key", i % 3 != 0) == (i % 3 == 0));
+	}
+}
+
+static std::string SaveBinary(TextFileOutput &out, bool keyTable)
+{
+	std::ostringstream os(std::ios::binary);
+	out.SaveBinary(os, keyTable);
+	return os.str();
+}
+
+static size_t CountOccurrences(const std::string &s, const char *what)
+{
+	size_t n = 0;
+	for (size_t p = s.find(what); p != std::string::npos; p = s.find(what, p + 1))
+		n++;
+	return n;
+}
+
+static void TestBinaryRoundTrip()
+{
+	TextFileOutput out;
+	FillProperties(out, 0);
+	FillProperties(*out.CreateSubElement("sub"), 1);
+	TextOutput::Array &mixed = out.CreateArray("mixed", 2);
+	FillProperties(*mixed[0], 2);
+	mixed[1]->CreateSubElement("child")->Set("z", uint2(7, 8));
+	FillKeyframes(out, 100);
+	for (bool keyTable : {true, false})
+	{
+		std::string data = SaveBinary(out, keyTable);
+		PLATFORM_CHECK(TextFileInput::IsBinary(data.data(), data.size()));
+		TextFileInput in;
+		PLATFORM_CHECK(in.LoadBinary(data.data(), data.size()));
+		CheckProperties(in, 0);
+		TextInput *sub = in.GetSubElement("sub");
+		PLATFORM_CHECK(sub != nullptr);
+		if (sub)
+			CheckProperties(*sub, 1);
+		const TextInput::Array &m = in.GetArray("mixed");
+		PLATFORM_CHECK(m.size() == 2);
+		if (m.size() == 2)
+		{
+			CheckProperties(*m[0], 2);
+			TextInput *child = m[1]->GetSubElement("child");
+			uint2 z = child ? child->Get("z", uint2(0, 0)) : uint2(0, 0);
+			PLATFORM_CHECK(z.x == 7 && z.y == 8);
+		}
+		CheckKeyframes(in, 100);
+		// As records, the field names are written once for the whole array, not once per keyframe.
+		if (!keyTable)
+			PLATFORM_CHECK(CountOccurrences(data, "position") == 1);
+	}
+}
+
+// Typed binary values asked for as text, or as another type, are formatted as TextFileOutput would have written them, then parsed.
+static void TestBinaryAsText()
+{
+	TextFileOutput out;
+	FillProperties(out, 3);
+	FillKeyframes(out, 4);
+	std::string data = SaveBinary(out, true);
+	TextFileInput in;
+	PLATFORM_CHECK(in.LoadBinary(data.data(), data.size()));
+	for (const auto &p : out.properties)
+		PLATFORM_CHECK(p.second == in.Get(p.first.c_str(), ""));
+	PLATFORM_CHECK(in.Get("int", 0.0) == -3007.0);
+	PLATFORM_CHECK(in.Get("float", 0.0) == (double)(1.0f / 6.0f));
+	PLATFORM_CHECK(in.Get("uint", 0LL) == 3000000003LL);
+	vec4 v = in.Get("vec3", vec4(9, 9, 9, 9));
+	PLATFORM_CHECK(v.x == 1.5f && v.y == 1e-7f && v.z == 3.0e6f + 3);
+	const TextInput::Array &keyframes = in.GetArray("keyframes");
+	PLATFORM_CHECK(keyframes.size() == 4);
+	if (keyframes.size() == 4)
+	{
+		PLATFORM_CHECK(std::string(keyframes[3]->Get("index", "")) == "3");
+		PLATFORM_CHECK(keyframes[3]->Get("index", 0.0) == 3.0);
+		PLATFORM_CHECK(std::string(keyframes[3]->Get("key", "")) == "true");
+	}
+}
+
+static void AppendU32(std::string &s, uint32_t u)
+{
+	s.append((const char *)&u, 4);
+}
+
+static void TestBinaryCorrupt()
+{
+	TextFileOutput out;
+	FillProperties(out, 0);
+	FillKeyframes(out, 10);
+	std::string data = SaveBinary(out, true);
+	// Every truncation is rejected.
+	for (size_t n = 0; n < data.size(); n++)
+	{
+		TextFileInput in;
+		PLATFORM_CHECK(!in.LoadBinary(data.data(), n));
+	}
+	// Record arrays with no fields, a zero stride, or more records than there is data for, are rejected before anything is allocated for them.
+	for (uint32_t fields : {0u, 1u})
+	{
+		for (uint32_t stride : {0u, 8u})
+		{
+			std::string bad("PTXB", 4);
+			AppendU32(bad, 1);			// version
+			AppendU32(bad, 0);			// no key table
+			AppendU32(bad, 0);			// properties
+			AppendU32(bad, 0);			// sub-elements
+			AppendU32(bad, 1);			// arrays
+			AppendU32(bad, 1);
+			bad += "a";
+			bad += (char)1;				// records
+			AppendU32(bad, 0xFFFFFFFFu);	// count
+			AppendU32(bad, fields);
+			if (fields)
+			{
+				AppendU32(bad, 1);
+				bad += "b";
+				bad += (char)4;			// UINT64
+			}
+			AppendU32(bad, stride);
+			bad.append(64, '\0');
+			TextFileInput in;
+			PLATFORM_CHECK(!in.LoadBinary(bad.data(), bad.size()));
+		}
+	}
+}
+
+int main()
+{
+	TestTextRoundTrip();
+	TestJsonStyle();
+	TestBinaryRoundTrip();
+	TestBinaryAsText();
+	TestBinaryCorrupt();
+	return platform::test::Finish("TextInputOutputTest");
+}
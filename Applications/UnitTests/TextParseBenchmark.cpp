@@ -0,0 +1,56 @@
+#include "UnitTest.h"
+#include "Platform/CrossPlatform/TextInputOutput.h"
+#include <cstdlib>
+#include <string>
+
+using namespace platform;
+using namespace crossplatform;
+
+// TextFileInput parse throughput, on a generated scene tree saved by TextFileOutput.
+// The argument is the depth of the tree: each level has four children and a sub-element, so 5 gives about 1 MB and 6 about 5 MB.
+
+static void Fill(TextOutput &o, int depth, int &n)
+{
+	o.Set("name", (std::string("node") + std::to_string(n++)).c_str());
+	o.Set("value", 3.25);
+	o.Set("flag", true);
+	o.Set("pos", vec3(1.f, 2.f, 3.f));
+	o.Set("rotation", Quaterniond(0.f, 0.f, 0.f, 1.f));
+	if (depth > 0)
+	{
+		TextOutput::Array &children = o.CreateArray("children", 4);
+		for (TextOutput *c : children)
+			Fill(*c, depth - 1, n);
+		Fill(*o.CreateSubElement("sub"), depth - 1, n);
+	}
+}
+
+static size_t CountElements(const TextFileInput &in)
+{
+	size_t n = 1;
+	for (const auto &s : in.subElements)
+		n += CountElements(s.second);
+	for (const auto &a : in.arrays)
+		for (const TextInput *e : a.second)
+			n += CountElements(*(const TextFileInput *)e);
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	int depth = argc > 1 ? atoi(argv[1]) : 5;
+	TextFileOutput out;
+	int nodes = 0;
+	Fill(out, depth, nodes);
+	std::string text = out.getText();
+	size_t elements = 0;
+	double seconds = platform::test::BestTime(5, [&]()
+	{
+		TextFileInput in;
+		in.Load(text);
+		elements = CountElements(in);
+	});
+	std::cout << "TextParseBenchmark: " << text.size() << " bytes, " << nodes << " nodes, " << elements << " elements loaded.\n";
+	std::cout << "  Load: " << seconds * 1000.0 << " ms, " << text.size() / seconds / 1.0e6 << " MB/s\n";
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include "UnitTest.h"
+#include "Platform/Core/ThreadPool.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace platform;
+using namespace core;
+
+// ParallelFor covers every index exactly once, and an exception in any range reaches the caller instead of hanging it.
+
+static void TestCoverage(ThreadPool &pool)
+{
+	for (size_t count : {(size_t)1, (size_t)7, (size_t)1000, (size_t)100000})
+	{
+		std::vector<std::atomic<int>> hits(count);
+		pool.ParallelFor(count, 16, [&](size_t b, size_t e)
+		{
+			for (size_t i = b; i < e; i++)
+				hits[i]++;
+		});
+		bool once = true;
+		for (auto &h : hits)
+			once &= h.load() == 1;
+		PLATFORM_CHECK(once);
+	}
+}
+
+static void TestException(ThreadPool &pool)
+{
+	// Every range throws, one range throws, and only the range the calling thread takes first throws.
+	for (size_t thrower : {(size_t)-1, (size_t)999, (size_t)0})
+	{
+		bool caught = false;
+		try
+		{
+			pool.ParallelFor(1000, 1, [thrower](size_t b, size_t e)
+			{
+				if (thrower == (size_t)-1 || (b <= thrower && thrower < e))
+					throw std::runtime_error("range " + std::to_string(b));
+			});
+		}
+		catch (const std::runtime_error &)
+		{
+			caught = true;
+		}
+		PLATFORM_CHECK(caught);
+	}
+	// The pool still works afterwards.
+	TestCoverage(pool);
+}
+
+int main()
+{
+	ThreadPool pool(4);
+	TestCoverage(pool);
+	TestException(pool);
+	return platform::test::Finish("ThreadPoolTest");
+}
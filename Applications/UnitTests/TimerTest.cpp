@@ -0,0 +1,66 @@
+#include "UnitTest.h"
+#include "Platform/Core/ProfilingInterface.h"
+#include "Platform/Core/Timer.h"
+
+using namespace platform;
+using namespace core;
+
+// Short intervals must keep their precision however long the process has been running. In float milliseconds since start,
+// a 0.25 ms block reads as zero after a day; in integer ticks it is exact at any uptime.
+
+static const int64_t OneYear = 365ll * 24 * 3600 * Timer::TicksPerSecond;
+static const int64_t QuarterMS = Timer::TicksPerSecond / 4000;
+
+// A profiler that runs on a clock the test sets, instead of the real one.
+class ManualClockProfiler : public DefaultProfiler
+{
+public:
+	int64_t now = 0;
+
+protected:
+	int64_t Ticks() const override
+	{
+		return now;
+	}
+};
+
+static void TestTicksToMS()
+{
+	PLATFORM_CHECK(Timer::TicksToMS(Timer::TicksPerSecond) == 1000.0);
+	for (int64_t uptime : {(int64_t)0, OneYear / 365, OneYear, 10 * OneYear})
+	{
+		int64_t start = uptime;
+		int64_t end = uptime + QuarterMS;
+		PLATFORM_CHECK_NEAR(Timer::TicksToMS(end - start), 0.25, 1e-12);
+	}
+	// The real clock runs forwards.
+	int64_t a = Timer::Ticks();
+	int64_t b = Timer::Ticks();
+	PLATFORM_CHECK(b >= a);
+}
+
+static void TestProfilerAtUptime(int64_t uptime)
+{
+	ManualClockProfiler profiler;
+	profiler.SetMaxLevel(4);
+	profiler.now = uptime;
+	profiler.StartFrame();
+	profiler.Begin("block");
+	profiler.now += QuarterMS;
+	profiler.End();
+	const ProfileData *root = profiler.GetEvent(nullptr, 0);
+	const ProfileData *block = root ? profiler.GetEvent(root, 0) : nullptr;
+	PLATFORM_CHECK(block != nullptr);
+	if (block)
+		PLATFORM_CHECK_NEAR(block->frameTime, 0.25, 1e-6);
+	profiler.EndFrame();
+}
+
+int main()
+{
+	TestTicksToMS();
+	TestProfilerAtUptime(0);
+	TestProfilerAtUptime(OneYear);
+	TestProfilerAtUptime(10 * OneYear);
+	return platform::test::Finish("TimerTest");
+}
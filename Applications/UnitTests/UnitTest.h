@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// A minimal harness for the unit tests and benchmarks: each test is a console program that CTest runs,
+// and that fails by returning non-zero. Failures are written as file(line) so that IDEs can jump to them.
+
+namespace platform
+{
+	namespace test
+	{
+		inline int &FailureCount()
+		{
+			static int failures = 0;
+			return failures;
+		}
+		inline bool Check(bool ok, const char *expr, const char *file, int line)
+		{
+			if (!ok)
+			{
+				std::cerr << file << "(" << line << "): error: check failed: " << expr << "\n";
+				FailureCount()++;
+			}
+			return ok;
+		}
+		//! Report the result, and return the value for main() to return.
+		inline int Finish(const char *name)
+		{
+			if (FailureCount())
+				std::cerr << name << ": " << FailureCount() << " checks failed.\n";
+			else
+				std::cout << name << ": all checks passed.\n";
+			return FailureCount() ? 1 : 0;
+		}
+		//! The fastest of several runs of func, in seconds, so that one-off stalls don't count.
+		template <typename F>
+		double BestTime(int runs, F func)
+		{
+			double best = 1e30;
+			for (int i = 0; i < runs; i++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				func();
+				double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (t < best)
+					best = t;
+			}
+			return best;
+		}
+	}
+}
+
+#define PLATFORM_CHECK(expr) platform::test::Check((expr), #expr, __FILE__, __LINE__)
+#define PLATFORM_CHECK_NEAR(a, b, tolerance) platform::test::Check(std::abs((double)(a) - (double)(b)) <= (tolerance), #a " ~= " #b, __FILE__, __LINE__)
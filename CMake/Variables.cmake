@@ -11,6 +11,14 @@ option( SIMUL_DEBUG_SHADERS "Compile shaders with debug info." OFF )
 option( SIMUL_BUILD_SAMPLES "Deprecated, use PLATFORM_BUILD_SAMPLES instead." ON )
 mark_as_advanced(SIMUL_BUILD_SAMPLES)
 option(PLATFORM_BUILD_SAMPLES "Build executable samples?" ${SIMUL_BUILD_SAMPLES})
+# Tests are on by default only when Platform is the top-level project, not when another project pulls it in.
+get_filename_component(PLATFORM_ROOT_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+if(CMAKE_SOURCE_DIR STREQUAL PLATFORM_ROOT_DIR)
+	set(PLATFORM_BUILD_TESTS_DEFAULT ON)
+else()
+	set(PLATFORM_BUILD_TESTS_DEFAULT OFF)
+endif()
+option(PLATFORM_BUILD_TESTS "Build unit tests and benchmarks?" ${PLATFORM_BUILD_TESTS_DEFAULT})
 option(PLATFORM_WARNINGS_AS_ERRORS "Should Platform treat C++ compile warnings as errors. " ON)
 mark_as_advanced(PLATFORM_WARNINGS_AS_ERRORS)
 set(PLATFORM_WINDOWS_RUNTIME static CACHE STRING "Which runtime to use for Windows compilation, static (/MT) or dyanmic(/MD)")
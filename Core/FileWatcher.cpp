@@ -0,0 +1,196 @@
+#include "Platform/Core/FileWatcher.h"
+#include "Platform/Core/FileLoader.h"
+#include "Platform/Core/RuntimeError.h"
+#include <chrono>
+#include <vector>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace platform;
+using namespace core;
+
+namespace
+{
+	std::string DirectoryOf(const std::string &filename)
+	{
+		size_t slash = filename.find_last_of("/\\");
+		if (slash == std::string::npos)
+			return ".";
+		return filename.substr(0, slash);
+	}
+	double FileDate(const std::string &filename)
+	{
+		FileLoader *fileLoader = FileLoader::GetFileLoader();
+		return fileLoader ? fileLoader->GetFileDate(filename.c_str()) : 0.0;
+	}
+}
+
+FileWatcher::FileWatcher()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+void FileWatcher::Start(Callback c, int interval)
+{
+	Stop();
+	std::lock_guard<std::mutex> lock(mutex);
+	callback = c;
+	pollIntervalMs = interval;
+	running = true;
+#ifdef __linux__
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (inotifyFd < 0 || wakeFd < 0)
+	{
+		SIMUL_CERR << "FileWatcher: inotify is not available, polling instead.\n";
+		if (inotifyFd >= 0)
+			close(inotifyFd);
+		if (wakeFd >= 0)
+			close(wakeFd);
+		inotifyFd = wakeFd = -1;
+	}
+	else
+	{
+		for (const auto &f : files)
+			WatchDirectory(DirectoryOf(f.first));
+		thread = std::thread(&FileWatcher::WatchLoop, this);
+		return;
+	}
+#endif
+	thread = std::thread(&FileWatcher::PollLoop, this);
+}
+
+void FileWatcher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running)
+			return;
+		running = false;
+#ifdef __linux__
+		if (wakeFd >= 0)
+		{
+			uint64_t one = 1;
+			if (write(wakeFd, &one, sizeof(one)) < 0)
+				SIMUL_CERR << "FileWatcher: failed to wake the watch thread.\n";
+		}
+#endif
+	}
+	stopCondition.notify_all();
+	if (thread.joinable())
+		thread.join();
+#ifdef __linux__
+	std::lock_guard<std::mutex> lock(mutex);
+	if (inotifyFd >= 0)
+		close(inotifyFd);
+	if (wakeFd >= 0)
+		close(wakeFd);
+	inotifyFd = wakeFd = -1;
+	directories.clear();
+#endif
+}
+
+void FileWatcher::AddFile(const std::string &filename_utf8)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (files.find(filename_utf8) != files.end())
+		return;
+	files[filename_utf8] = FileDate(filename_utf8);
+	if (running)
+		WatchDirectory(DirectoryOf(filename_utf8));
+}
+
+void FileWatcher::WatchDirectory(const std::string &directory)
+{
+#ifdef __linux__
+	if (inotifyFd < 0)
+		return;
+	for (const auto &d : directories)
+	{
+		if (d.second == directory)
+			return;
+	}
+	// Editors either write the file in place, or write a new file and move it over the old one.
+	int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (wd < 0)
+	{
+		SIMUL_CERR << "FileWatcher: can't watch " << directory << "\n";
+		return;
+	}
+	directories[wd] = directory;
+#endif
+}
+
+void FileWatcher::WatchLoop()
+{
+#ifdef __linux__
+	// Aligned as the events are.
+	alignas(struct inotify_event) char buffer[4096];
+	while (true)
+	{
+		pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+		// Blocks until a directory changes or Stop() is called.
+		if (poll(fds, 2, -1) < 0)
+			continue;
+		if (fds[1].revents & POLLIN)
+			break;
+		std::vector<std::string> changed;
+		ssize_t len;
+		while ((len = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (char *p = buffer; p < buffer + len;)
+			{
+				const struct inotify_event *e = (const struct inotify_event *)p;
+				p += sizeof(struct inotify_event) + e->len;
+				auto d = directories.find(e->wd);
+				if (!e->len || d == directories.end())
+					continue;
+				std::string filename = d->second + "/" + e->name;
+				if (files.find(filename) == files.end())
+					continue;
+				bool already = false;
+				for (const auto &c : changed)
+					already |= (c == filename);
+				if (!already)
+					changed.push_back(filename);
+			}
+		}
+		for (const auto &c : changed)
+			callback(c);
+	}
+#endif
+}
+
+void FileWatcher::PollLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running)
+	{
+		stopCondition.wait_for(lock, std::chrono::milliseconds(pollIntervalMs));
+		if (!running)
+			break;
+		std::vector<std::string> changed;
+		for (auto &f : files)
+		{
+			double date = FileDate(f.first);
+			if (date != f.second)
+			{
+				f.second = date;
+				changed.push_back(f.first);
+			}
+		}
+		lock.unlock();
+		for (const auto &c : changed)
+			callback(c);
+		lock.lock();
+	}
+}
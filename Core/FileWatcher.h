@@ -0,0 +1,64 @@
+#pragma once
+#include "Platform/Core/Export.h"
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace core
+	{
+		//! Watches a set of files, and calls back from its own thread when any of them changes.
+		//! On Linux this uses inotify, so it costs nothing while no file changes, and reports a change as soon as the file is written.
+		//! Elsewhere it compares the files' dates at a fixed interval.
+		class PLATFORM_CORE_EXPORT FileWatcher
+		{
+		public:
+			//! Called on the watcher's thread with the path of a changed file, as it was given to AddFile().
+			typedef std::function<void(const std::string &filename_utf8)> Callback;
+			FileWatcher();
+			~FileWatcher();
+			//! Start watching. The interval is only used when polling.
+			void Start(Callback callback, int pollIntervalMs = 500);
+			//! Stop watching and wait for the thread to finish. The files stay in the watch list for the next Start().
+			void Stop();
+			//! Add a file to watch, given by its full path. Can be called while watching.
+			void AddFile(const std::string &filename_utf8);
+			//! True if changes are found by polling, rather than by notification.
+			bool IsPolling() const
+			{
+				return inotifyFd < 0;
+			}
+
+		private:
+			void WatchLoop();
+			void PollLoop();
+			//! Start notifications for the file's directory, if not already. Call with the mutex locked.
+			void WatchDirectory(const std::string &directory);
+			std::thread thread;
+			mutable std::mutex mutex;
+			std::condition_variable stopCondition;
+			Callback callback;
+			int pollIntervalMs = 500;
+			bool running = false;
+			//! The watched files, with their dates when last checked.
+			std::map<std::string, double> files;
+			//! The directories with inotify watches, by watch descriptor.
+			std::map<int, std::string> directories;
+			int inotifyFd = -1;
+			int wakeFd = -1;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
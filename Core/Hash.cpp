@@ -0,0 +1,28 @@
+#include "Platform/Core/Hash.h"
+#include <cstring>
+
+using namespace platform;
+using namespace core;
+
+// FNV-1a over 64-bit words, so that large files hash quickly.
+uint64_t platform::core::HashBytes(const void *src, size_t size)
+{
+	const uint8_t *data = (const uint8_t *)src;
+	uint64_t h = 0xcbf29ce484222325ULL;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t w;
+		memcpy(&w, data + i, 8);
+		h ^= w;
+		h *= 0x100000001b3ULL;
+	}
+	for (; i < size; i++)
+	{
+		h ^= data[i];
+		h *= 0x100000001b3ULL;
+	}
+	h ^= size;
+	// Zero means "no hash".
+	return h ? h : 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "Platform/Core/Export.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace platform
+{
+	namespace core
+	{
+		//! A fast 64-bit hash of a block of memory, for telling whether file contents have changed: FNV-1a over 64-bit words.
+		//! It is stored in cache files, so it must not change between versions. Never zero, so zero can mean "no hash".
+		extern PLATFORM_CORE_EXPORT uint64_t HashBytes(const void *data, size_t size);
+	}
+}
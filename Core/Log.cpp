@@ -0,0 +1,406 @@
+#include "Platform/Core/Log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace platform;
+using namespace core;
+
+namespace
+{
+	int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint32_t ThreadNumber()
+	{
+		static std::atomic<uint32_t> threadCount{0};
+		thread_local uint32_t thread = ++threadCount;
+		return thread;
+	}
+
+	std::string SuppressedText(uint32_t count)
+	{
+		return std::to_string(count) + " messages suppressed";
+	}
+
+	//! Writes messages as the logging macros always have, so IDEs can still jump to the source line.
+	class DefaultLogSink : public LogSink
+	{
+	public:
+		void Write(const LogMessage &m) override
+		{
+			std::ostream &os = m.severity == LogSeverity::Info ? std::cout : std::cerr;
+			if (m.suppressed)
+				WriteLine(os, m, SuppressedText(m.suppressed));
+			WriteLine(os, m, m.text);
+			if (m.severity == LogSeverity::Info)
+				os.flush();
+		}
+		void Flush() override
+		{
+			std::cout.flush();
+			std::cerr.flush();
+		}
+
+	private:
+		static void WriteLine(std::ostream &os, const LogMessage &m, const std::string &text)
+		{
+			static const char *severities[] = {"info", "warning", "error"};
+			if (m.file)
+				os << m.file << "(" << std::dec << m.line << "): ";
+			os << severities[(int)m.severity] << ": " << text << "\n";
+		}
+	};
+
+	struct LogNode
+	{
+		std::atomic<LogNode *> next{nullptr};
+		LogMessage message;
+	};
+
+	//! A lock-free queue with many producers and one consumer, after Vyukov's intrusive MPSC queue.
+	//! Push() is a single exchange, so logging threads never wait for each other or for the writer.
+	class LogQueue
+	{
+	public:
+		LogQueue()
+			: head(&stub), tail(&stub)
+		{
+		}
+		void Push(LogNode *n)
+		{
+			n->next.store(nullptr, std::memory_order_relaxed);
+			LogNode *prev = head.exchange(n, std::memory_order_acq_rel);
+			prev->next.store(n, std::memory_order_release);
+		}
+		//! Consumer only. Returns null if the queue is empty, or if a push is half-way done; it will be found next time.
+		LogNode *Pop()
+		{
+			LogNode *t = tail;
+			LogNode *next = t->next.load(std::memory_order_acquire);
+			if (t == &stub)
+			{
+				if (!next)
+					return nullptr;
+				tail = next;
+				t = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+			if (next)
+			{
+				tail = next;
+				return t;
+			}
+			if (t != head.load(std::memory_order_acquire))
+				return nullptr;
+			// t is the last node: put the stub behind it so that it can be taken.
+			Push(&stub);
+			next = t->next.load(std::memory_order_acquire);
+			if (next)
+			{
+				tail = next;
+				return t;
+			}
+			return nullptr;
+		}
+
+	private:
+		std::atomic<LogNode *> head;
+		LogNode *tail;
+		LogNode stub;
+	};
+
+	struct LogState
+	{
+		DefaultLogSink defaultSink;
+		LogSink *sink = &defaultSink;
+		//! Serialises calls to the sink.
+		std::mutex sinkMutex;
+		std::atomic<int64_t> interval{100000000};
+		std::atomic<int64_t> burst{100};
+		std::atomic<long long> frame{0};
+
+		std::mutex siteMutex;
+		std::map<std::pair<const void *, LogSeverity>, std::unique_ptr<LogCallSite>> sites;
+		//! Every site that the rate limit has suppressed messages from.
+		std::vector<LogCallSite *> limitedSites;
+
+		LogQueue queue;
+		std::atomic<bool> asynchronous{false};
+		std::thread thread;
+		//! For the writer to sleep on, and for FlushLog() to wait for it.
+		std::mutex threadMutex;
+		std::condition_variable wake;
+		std::condition_variable written;
+		std::atomic<bool> writerWaiting{false};
+		std::atomic<uint64_t> pushedCount{0};
+		uint64_t writtenCount = 0;
+		bool stopping = false;
+
+		void Write(const LogMessage &m)
+		{
+			// A sink that logs would deadlock here, so what it logs goes straight to std::cerr.
+			thread_local bool writing = false;
+			if (writing)
+			{
+				std::cerr << m.text << "\n";
+				return;
+			}
+			writing = true;
+			{
+				std::lock_guard<std::mutex> lock(sinkMutex);
+				sink->Write(m);
+			}
+			writing = false;
+		}
+		//! The writer thread: drain the queue, then sleep until woken, or for a short time in case a wake was missed.
+		void WriterLoop()
+		{
+			while (true)
+			{
+				uint64_t count = 0;
+				while (LogNode *n = queue.Pop())
+				{
+					Write(n->message);
+					delete n;
+					count++;
+				}
+				std::unique_lock<std::mutex> lock(threadMutex);
+				writtenCount += count;
+				if (count)
+				{
+					written.notify_all();
+					continue;
+				}
+				if (stopping && writtenCount == pushedCount.load())
+					break;
+				writerWaiting = true;
+				wake.wait_for(lock, std::chrono::milliseconds(10));
+				writerWaiting = false;
+			}
+			std::lock_guard<std::mutex> lock(sinkMutex);
+			sink->Flush();
+		}
+		void Wake()
+		{
+			if (writerWaiting.load(std::memory_order_relaxed))
+				wake.notify_one();
+		}
+		void Flush()
+		{
+			if (asynchronous)
+			{
+				uint64_t target = pushedCount.load();
+				std::unique_lock<std::mutex> lock(threadMutex);
+				wake.notify_one();
+				written.wait(lock, [this, target]() { return writtenCount >= target || !asynchronous; });
+			}
+			ReportSuppressed();
+			std::lock_guard<std::mutex> lock(sinkMutex);
+			sink->Flush();
+		}
+		//! Messages were suppressed and no later message from the same site has reported them: report them now.
+		void ReportSuppressed()
+		{
+			std::vector<LogCallSite *> limited;
+			{
+				std::lock_guard<std::mutex> lock(siteMutex);
+				limited = limitedSites;
+			}
+			for (LogCallSite *site : limited)
+			{
+				uint32_t count = site->suppressed.exchange(0, std::memory_order_relaxed);
+				if (!count)
+					continue;
+				LogMessage m;
+				m.severity = site->severity;
+				m.file = site->file;
+				m.line = site->line;
+				m.thread = ThreadNumber();
+				m.frame = frame.load(std::memory_order_relaxed);
+				m.text = SuppressedText(count);
+				Write(m);
+			}
+		}
+		void Start()
+		{
+			std::lock_guard<std::mutex> lock(threadMutex);
+			if (asynchronous)
+				return;
+			stopping = false;
+			asynchronous = true;
+			thread = std::thread(&LogState::WriterLoop, this);
+		}
+		void Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(threadMutex);
+				if (!asynchronous)
+					return;
+				stopping = true;
+				wake.notify_one();
+			}
+			if (thread.joinable())
+				thread.join();
+			asynchronous = false;
+			written.notify_all();
+			// Anything pushed while the thread was stopping.
+			while (LogNode *n = queue.Pop())
+			{
+				Write(n->message);
+				delete n;
+			}
+		}
+	};
+
+	//! Never destroyed, so that logging still works from static destructors.
+	LogState &State()
+	{
+		static LogState *state = new LogState;
+		return *state;
+	}
+
+	void StopAtExit()
+	{
+		State().Stop();
+	}
+
+	void FlushAtExit()
+	{
+		State().Flush();
+	}
+
+	//! Add a site to the list that FlushLog() reports from, the first time it has a message suppressed.
+	void ListLimitedSite(LogCallSite &site)
+	{
+		if (site.listed.exchange(true))
+			return;
+		LogState &state = State();
+		std::lock_guard<std::mutex> lock(state.siteMutex);
+		if (state.limitedSites.empty())
+			std::atexit(&FlushAtExit);
+		state.limitedSites.push_back(&site);
+	}
+}
+
+bool LogCallSite::Allow()
+{
+	// Only repeated warnings and errors are limited: information is output the caller asked for, and must all arrive.
+	if (severity == LogSeverity::Info)
+		return true;
+	LogState &state = State();
+	int64_t interval = state.interval.load(std::memory_order_relaxed);
+	if (!interval)
+		return true;
+	// Each message moves the due time on by one interval; a site may run up to a burst's worth of intervals ahead of now.
+	int64_t tolerance = interval * (state.burst.load(std::memory_order_relaxed) - 1);
+	int64_t now = Now();
+	int64_t d = due.load(std::memory_order_relaxed);
+	while (true)
+	{
+		int64_t start = d > now ? d : now;
+		if (start - now > tolerance)
+		{
+			suppressed.fetch_add(1, std::memory_order_relaxed);
+			ListLimitedSite(*this);
+			return false;
+		}
+		if (due.compare_exchange_weak(d, start + interval, std::memory_order_relaxed))
+			return true;
+	}
+}
+
+void core::SetLogSink(LogSink *sink)
+{
+	LogState &state = State();
+	FlushLog();
+	std::lock_guard<std::mutex> lock(state.sinkMutex);
+	state.sink = sink ? sink : &state.defaultSink;
+}
+
+void core::SetLogAsynchronous(bool a)
+{
+	static bool registered = false;
+	if (a)
+	{
+		State().Start();
+		if (!registered)
+			std::atexit(&StopAtExit);
+		registered = true;
+	}
+	else
+		State().Stop();
+}
+
+void core::SetLogRateLimit(int perSecond, int burst)
+{
+	LogState &state = State();
+	state.interval = perSecond > 0 ? 1000000000 / perSecond : 0;
+	state.burst = burst > 1 ? burst : 1;
+}
+
+void core::SetLogFrameNumber(long long frame)
+{
+	State().frame.store(frame, std::memory_order_relaxed);
+}
+
+void core::FlushLog()
+{
+	State().Flush();
+}
+
+namespace
+{
+	void FillMessage(LogMessage &m, LogCallSite &site, std::string &&text)
+	{
+		m.severity = site.severity;
+		m.file = site.file;
+		m.line = site.line;
+		m.thread = ThreadNumber();
+		m.frame = State().frame.load(std::memory_order_relaxed);
+		m.suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+		m.text = std::move(text);
+		while (m.text.size() && (m.text.back() == '\n' || m.text.back() == '\r'))
+			m.text.pop_back();
+	}
+}
+
+void core::Log(LogCallSite &site, std::string &&text)
+{
+	LogState &state = State();
+	if (!state.asynchronous.load(std::memory_order_acquire))
+	{
+		// Synchronous: the message goes straight to the sink from here, so it needn't outlive this call.
+		LogMessage m;
+		FillMessage(m, site, std::move(text));
+		state.Write(m);
+		return;
+	}
+	LogNode *n = new LogNode;
+	FillMessage(n->message, site, std::move(text));
+	state.pushedCount++;
+	state.queue.Push(n);
+	state.Wake();
+	// Errors often come just before a break or a crash, so they must be out before we return.
+	// The writer thread can't wait for itself, so errors logged by the sink are left in the queue.
+	if (site.severity == LogSeverity::Error && std::this_thread::get_id() != state.thread.get_id())
+		state.Flush();
+}
+
+LogCallSite &core::GetLogCallSite(const void *key, LogSeverity severity)
+{
+	LogState &state = State();
+	std::lock_guard<std::mutex> lock(state.siteMutex);
+	std::unique_ptr<LogCallSite> &site = state.sites[{key, severity}];
+	if (!site)
+		site.reset(new LogCallSite(nullptr, 0, severity));
+	return *site;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "Export.h"
+#include <atomic>
+#include <optional>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace core
+	{
+		enum class LogSeverity : uint8_t
+		{
+			Info,
+			Warning,
+			Error
+		};
+		//! A logged message, with the fields a sink may want to record.
+		struct LogMessage
+		{
+			LogSeverity severity = LogSeverity::Info;
+			//! The source file, from __FILE__, or null if unknown.
+			const char *file = nullptr;
+			int line = 0;
+			//! A small number identifying the thread that logged the message, in the order threads first logged.
+			uint32_t thread = 0;
+			//! The frame number given to SetLogFrameNumber() when the message was logged.
+			long long frame = 0;
+			//! How many messages from the same call site the rate limit dropped before this one.
+			uint32_t suppressed = 0;
+			//! The text, without a final newline.
+			std::string text;
+		};
+		//! Receives log messages. When logging is asynchronous, Write() is called on the log thread.
+		//! Calls are never concurrent.
+		class PLATFORM_CORE_EXPORT LogSink
+		{
+		public:
+			virtual ~LogSink() {}
+			virtual void Write(const LogMessage &message) = 0;
+			virtual void Flush() {}
+		};
+		//! A place in the code that logs, holding its rate-limit state. The logging macros make one statically for each use.
+		struct PLATFORM_CORE_EXPORT LogCallSite
+		{
+			LogCallSite(const char *f, int l, LogSeverity s)
+				: file(f), line(l), severity(s)
+			{
+			}
+			//! Is a message allowed now by the rate limit? If not, it's counted as suppressed. Information is always allowed.
+			bool Allow();
+			const char *file;
+			int line;
+			LogSeverity severity;
+			//! The time when the site's burst allowance is next full, in steady clock nanoseconds.
+			std::atomic<int64_t> due{0};
+			std::atomic<uint32_t> suppressed{0};
+			//! Whether the site is in the list that FlushLog() reports suppressed messages from.
+			std::atomic<bool> listed{false};
+		};
+		//! Send messages to the given sink, or to the default if null. The default writes to std::cout and std::cerr as before.
+		//! The sink must stay valid until it's replaced.
+		extern PLATFORM_CORE_EXPORT void SetLogSink(LogSink *sink);
+		//! Write messages on a background thread, so that logging only costs the caller the formatting and a queue push.
+		//! Errors are still written before the call that logs them returns.
+		extern PLATFORM_CORE_EXPORT void SetLogAsynchronous(bool a);
+		//! Allow each warning and error call site a burst of messages, then perSecond messages per second. Zero per second removes
+		//! the limit. The default is a burst of 100, then 10 per second. Information is never limited.
+		//! A site's suppressed messages are reported as a count with its next message, or by FlushLog() and at exit if there is none.
+		extern PLATFORM_CORE_EXPORT void SetLogRateLimit(int perSecond, int burst = 100);
+		//! Set the frame number recorded with each message.
+		extern PLATFORM_CORE_EXPORT void SetLogFrameNumber(long long frame);
+		//! Wait until all queued messages have been written, and report any messages the rate limit has suppressed since.
+		extern PLATFORM_CORE_EXPORT void FlushLog();
+		//! Log a message from a call site, once its Allow() has returned true.
+		extern PLATFORM_CORE_EXPORT void Log(LogCallSite &site, std::string &&text);
+		//! The call site for code that can't make its own, e.g. a function rather than a macro. The key, such as a format string, tells sites apart.
+		extern PLATFORM_CORE_EXPORT LogCallSite &GetLogCallSite(const void *key, LogSeverity severity);
+
+		//! Collects a message with operator<<, and logs it at the end of the statement.
+		//! If the call site's rate limit drops the message, nothing is formatted.
+		class LogStream
+		{
+		public:
+			LogStream(LogCallSite &s)
+				: site(s)
+			{
+				if (site.Allow())
+					stream.emplace();
+			}
+			~LogStream()
+			{
+				if (stream)
+					Log(site, stream->str());
+			}
+			template <typename T>
+			LogStream &operator<<(const T &t)
+			{
+				if (stream)
+					*stream << t;
+				return *this;
+			}
+			//! For std::endl and the like.
+			LogStream &operator<<(std::ostream &(*manipulator)(std::ostream &))
+			{
+				if (stream)
+					manipulator(*stream);
+				return *this;
+			}
+			//! For std::hex and the like.
+			LogStream &operator<<(std::ios_base &(*manipulator)(std::ios_base &))
+			{
+				if (stream)
+					manipulator(*stream);
+				return *this;
+			}
+
+		private:
+			LogCallSite &site;
+			std::optional<std::ostringstream> stream;
+		};
+	}
+}
+
+//! A stream expression that logs with the given severity from this line.
+#define PLATFORM_LOG(severity)\
+	platform::core::LogStream([]() -> platform::core::LogCallSite & { static platform::core::LogCallSite PLATFORM_LOG_site(__FILE__, __LINE__, severity); return PLATFORM_LOG_site; }())
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
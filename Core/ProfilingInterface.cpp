@@ -179,7 +179,7 @@ void platform::core::BaseProfilingInterface::StartFrame()
 void platform::core::DefaultProfiler::Begin(const char *name)
 {
 	// Get time at the beginning, so that we can properly calculate the overhead!
-	float t=timer.AbsoluteTimeMS();
+	int64_t t=Ticks();
 	level++;
 	if(level>max_level)
 		return;
@@ -237,9 +237,9 @@ void platform::core::DefaultProfiler::End()
 	if(profileData)
 	{
 		profileData->overhead		+=overhead;
-		float t						=timer.AbsoluteTimeMS();
-		t							-=profileData->start;
-		profileData->frameTime		+=std::max(0.0f,t);
+		// Subtract in integer ticks, so the delta is exact however long we've been running.
+		int64_t t					=Ticks()-profileData->start;
+		profileData->frameTime		+=(float)Timer::TicksToMS(std::max((int64_t)0,t));
 	}
 }
 
@@ -346,10 +346,20 @@ const char *platform::core::BaseProfilingInterface::GetDebugText(core::TextStyle
 		str+=formatLine(i->second->unqualifiedName.c_str(),1,t,total,style);
 		str += Walk(i->second, 2, i->second->time, style);
 	}
+	for(auto c:counters)
+	{
+		str+=c.first+" "+std::to_string(c.second);
+		str += (style == core::HTML)? "<br/>" : "\n";
+	}
 	str += (style ==core::HTML)? "<br/>" : "\n";
 	return str.c_str();
 }
 
+void platform::core::BaseProfilingInterface::SetCounter(const char *name,int64_t value)
+{
+	counters[name]=value;
+}
+
 const char* platform::core::BaseProfilingInterface::GetDebugTextSimple(core::TextStyle style) const
 {
 	static std::string str;
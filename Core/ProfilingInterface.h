@@ -54,7 +54,7 @@ namespace platform
 				:time(0.0f)
 				,maxTime(0.0f)
 				,frameTime(0.0f)
-				,start(0.0f)
+				,start(0)
 				,overhead(0.0f)
 				,gotResults(false)
 				,QueryStarted(false)
@@ -74,7 +74,7 @@ namespace platform
 			float maxTime;		///< The longest this event has taken in the present process.
 			float frameTime;	///< Time in ms taken by this event, including all the times it occurs in a frame.
 
-			float start;		// The last time it was started
+			int64_t start;		// The last time it was started, in Timer ticks
 			float overhead;		// Overhead, including its children.
 			bool gotResults;
 
@@ -143,7 +143,15 @@ namespace platform
 			void Clear(core::ProfileData *p=nullptr);
 			//! Call this at the start of the frame to reset values.
 			virtual void StartFrame();
+			//! Set a named count, such as the triangles drawn last frame. It keeps its value until set again, and GetDebugText() lists it after the timings.
+			void SetCounter(const char *name,int64_t value);
+			//! All the counters that have been set, by name.
+			const std::map<std::string,int64_t> &GetCounters() const
+			{
+				return counters;
+			}
 		protected:
+			std::map<std::string,int64_t> counters;
 			int max_level;				// Maximum level of nesting.
 			int max_level_this_frame;
 			int level;
@@ -223,6 +231,12 @@ namespace platform
 			bool GetCounter(int i,std::string &str,float &t);
 
 			const ProfileData *GetEvent(const ProfileData *parent,int i) const;
+		protected:
+			//! The clock that blocks are timed with, in Timer ticks. Tests override it to run from a chosen uptime.
+			virtual int64_t Ticks() const
+			{
+				return Timer::Ticks();
+			}
 		};
 	}
 }
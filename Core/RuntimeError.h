@@ -2,6 +2,7 @@
 #define PLATFORM_RUNTIMEERROR_H
 
 #include "Export.h"
+#include "Log.h"
 
 #include <string>
 #include <string.h>
@@ -35,11 +36,14 @@
 #endif
 #include <stdexcept> // for runtime_error
 
+//! Log information, as e.g. SIMUL_COUT<<"Loaded "<<filename<<"\n"; The messages go to the sink given to platform::core::SetLogSink().
 #define SIMUL_COUT\
-	std::cout<<__FILE__<<"("<<std::dec<<__LINE__<<"): info: "
+	PLATFORM_LOG(platform::core::LogSeverity::Info)
 
+//! Log a warning, as e.g. SIMUL_CERR<<"Can't find "<<filename<<"\n"; Each line that logs warnings is rate-limited,
+//! see platform::core::SetLogRateLimit().
 #define SIMUL_CERR\
-	std::cerr<<__FILE__<<"("<<std::dec<<__LINE__<<"): warning: "
+	PLATFORM_LOG(platform::core::LogSeverity::Warning)
 
 namespace platform
 {
@@ -50,23 +54,27 @@ namespace platform
 		extern PLATFORM_CORE_EXPORT bool DebugBreaksEnabled();
 		extern PLATFORM_CORE_EXPORT void EnableDebugBreaks(bool b);
 		extern PLATFORM_CORE_EXPORT bool SimulInternalChecks;
+		//! Log an error, formatted by fmt. Calls are rate-limited by their format string.
 		template <typename... T>
 		void Error(const char *txt, const T &...args)
 		{
-			std::string str = fmt::format(txt, args...);
-			std::cerr << fmt::format("{0} ({1}): error: {2}",__FILE__,__LINE__, str) << "\n";
+			LogCallSite &site = GetLogCallSite(txt, LogSeverity::Error);
+			if (site.Allow())
+				Log(site, fmt::format(txt, args...));
 		}
 		template <typename... T>
 		void Warn(const char *txt, const T &...args)
 		{
-			std::string str = fmt::format(txt, args...);
-			std::cerr << fmt::format("{0} ({1}): warning: {2}", __FILE__, __LINE__, str) << "\n";
+			LogCallSite &site = GetLogCallSite(txt, LogSeverity::Warning);
+			if (site.Allow())
+				Log(site, fmt::format(txt, args...));
 		}
 		template <typename... T>
 		void Info(const char *txt, const T &...args)
 		{
-			std::string str = fmt::format(txt, args...);
-			std::cerr << fmt::format("{0} ({1}): info: {2}", __FILE__, __LINE__, str) << "\n";
+			LogCallSite &site = GetLogCallSite(txt, LogSeverity::Info);
+			if (site.Allow())
+				Log(site, fmt::format(txt, args...));
 		}
 		//! This is a throwable error class derived from std::runtime_error.
 		//! It is used in builds that have C++ exceptions enabled. As it always outputs to std::cerr,
@@ -96,26 +104,26 @@ namespace platform
 
 #define SIMUL_INTERNAL_COUT\
 	if(platform::core::SimulInternalChecks)\
-		std::cout << __FILE__ << "(" << __LINE__ << "): info: "
+		SIMUL_COUT
 
 #define SIMUL_INTERNAL_CERR\
 	if(platform::core::SimulInternalChecks)\
-		std::cerr << __FILE__ << "(" << __LINE__ << "): warning: "
+		SIMUL_CERR
 
 #define SIMUL_CERR_ONCE\
 	static bool SIMUL_CERR_ONCE_done=false;\
-	if(!SIMUL_CERR_ONCE_done)\
-		std::cerr<<__FILE__<<"("<<__LINE__<<"): warning: "<<(SIMUL_CERR_ONCE_done=true)<<": "
+	if(!SIMUL_CERR_ONCE_done&&(SIMUL_CERR_ONCE_done=true))\
+		SIMUL_CERR
 
 #define SIMUL_INTERNAL_CERR_ONCE\
 	static bool SIMUL_CERR_ONCE_done=false;\
-	if(platform::core::SimulInternalChecks&&!SIMUL_CERR_ONCE_done)\
-		std::cerr<<__FILE__<<"("<<__LINE__<<"): warning: "<<(SIMUL_CERR_ONCE_done=true)<<": "
+	if(platform::core::SimulInternalChecks&&!SIMUL_CERR_ONCE_done&&(SIMUL_CERR_ONCE_done=true))\
+		SIMUL_CERR
 
 #define SIMUL_CERR_ONCE_PER(inst)\
 	static std::map<void*,bool> SIMUL_CERR_ONCE_PER_done;\
-	if(SIMUL_CERR_ONCE_PER_done.find(inst)==SIMUL_CERR_ONCE_PER_done.end())\
-			std::cerr<<__FILE__<<"("<<__LINE__<<"): warning: "<<(SIMUL_CERR_ONCE_PER_done[inst]?"":"")
+	if(SIMUL_CERR_ONCE_PER_done.find(inst)==SIMUL_CERR_ONCE_PER_done.end()&&(SIMUL_CERR_ONCE_PER_done[inst]=true))\
+		SIMUL_CERR
 
 #ifdef __EXCEPTIONS
 	#define SIMUL_THROW(err)\
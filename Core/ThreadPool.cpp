@@ -0,0 +1,138 @@
+#include "Platform/Core/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace platform;
+using namespace core;
+
+ThreadPool::ThreadPool(unsigned numThreads)
+{
+	if (!numThreads)
+	{
+		unsigned hw = std::thread::hardware_concurrency();
+		numThreads = std::max(1u, hw > 1 ? hw - 1 : 1u);
+	}
+	workers.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (auto &w : workers)
+		w.join();
+}
+
+ThreadPool &ThreadPool::Get()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::Push(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+size_t ThreadPool::GetQueueLength() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size();
+}
+
+bool ThreadPool::RunOne(std::unique_lock<std::mutex> &lock)
+{
+	if (jobs.empty())
+		return false;
+	std::function<void()> job = std::move(jobs.front());
+	jobs.pop_front();
+	lock.unlock();
+	job();
+	lock.lock();
+	return true;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+		if (stopping && jobs.empty())
+			return;
+		RunOne(lock);
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t minGrain, const std::function<void(size_t, size_t)> &func)
+{
+	if (!count)
+		return;
+	minGrain = std::max<size_t>(1, minGrain);
+	size_t maxChunks = (count + minGrain - 1) / minGrain;
+	size_t numChunks = std::min<size_t>(maxChunks, (size_t)workers.size() + 1);
+	if (numChunks <= 1)
+	{
+		func(0, count);
+		return;
+	}
+	// Chunks are claimed from a shared counter, so the calling thread works too and never waits on an idle queue.
+	struct Shared
+	{
+		std::atomic<size_t> next{0};
+		std::atomic<size_t> done{0};
+		std::mutex mutex;
+		std::condition_variable finished;
+		//! The first exception a chunk threw, under mutex. Once set, the remaining chunks are counted as done without running.
+		std::exception_ptr error;
+		std::atomic<bool> failed{false};
+	};
+	auto shared = std::make_shared<Shared>();
+	size_t chunkSize = (count + numChunks - 1) / numChunks;
+	auto work = [shared, chunkSize, count, numChunks, &func]()
+	{
+		size_t c;
+		while ((c = shared->next.fetch_add(1)) < numChunks)
+		{
+			size_t b = c * chunkSize;
+			size_t e = std::min(count, b + chunkSize);
+			if (b < e && !shared->failed.load())
+			{
+				// A chunk that throws still counts as done, or the caller would wait for it forever.
+				try
+				{
+					func(b, e);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(shared->mutex);
+					if (!shared->error)
+						shared->error = std::current_exception();
+					shared->failed = true;
+				}
+			}
+			if (shared->done.fetch_add(1) + 1 == numChunks)
+			{
+				std::lock_guard<std::mutex> lock(shared->mutex);
+				shared->finished.notify_all();
+			}
+		}
+	};
+	for (size_t i = 1; i < numChunks; i++)
+		Push(work);
+	work();
+	std::unique_lock<std::mutex> lock(shared->mutex);
+	shared->finished.wait(lock, [&]() { return shared->done.load() == numChunks; });
+	if (shared->error)
+		std::rethrow_exception(shared->error);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Platform/Core/Export.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace core
+	{
+		//! A fixed-size pool of worker threads that run queued jobs in FIFO order.
+		class PLATFORM_CORE_EXPORT ThreadPool
+		{
+		public:
+			//! Create a pool with the given number of workers; zero means one per hardware thread, less one for the caller.
+			ThreadPool(unsigned numThreads = 0);
+			~ThreadPool();
+			//! Queue a job to be run on a worker thread.
+			void Push(std::function<void()> job);
+			//! Queue a job and return a future that becomes ready when it has run.
+			template <typename F>
+			auto Submit(F &&f) -> std::future<decltype(f())>
+			{
+				using R = decltype(f());
+				auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+				std::future<R> result = task->get_future();
+				Push([task]() { (*task)(); });
+				return result;
+			}
+			//! Call func(begin,end) over [0,count) split into ranges of at least minGrain items, using the workers and the calling thread.
+			//! Returns when all ranges are complete. If func throws, the ranges not yet started are skipped, and the first exception
+			//! is rethrown on the calling thread.
+			void ParallelFor(size_t count, size_t minGrain, const std::function<void(size_t, size_t)> &func);
+			//! The number of worker threads.
+			unsigned GetThreadCount() const
+			{
+				return (unsigned)workers.size();
+			}
+			//! The number of jobs waiting to start.
+			size_t GetQueueLength() const;
+			//! The pool shared by Platform's CPU-side jobs, created on first use.
+			static ThreadPool &Get();
+
+		private:
+			void WorkerLoop();
+			bool RunOne(std::unique_lock<std::mutex> &lock);
+			std::vector<std::thread> workers;
+			std::deque<std::function<void()>> jobs;
+			mutable std::mutex mutex;
+			std::condition_variable jobAvailable;
+			bool stopping = false;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #define __int64 int64_t
 #endif
+#include <stdint.h>
 #include "Platform/Core/Export.h"
 
 namespace platform
@@ -14,42 +15,46 @@ namespace platform
 			unsigned int LowPart;
 			int HighPart;
 		};
-		//!  \brief A microsecond timer.
-		//!  Provides timing to microsecond accuracy; results are reported in milliseconds.
+		//!  \brief A high-resolution monotonic timer.
+		//!  Times are kept as 64-bit integer ticks of one nanosecond, so they keep full precision however long the process runs.
+		//!  Results are reported in milliseconds, as doubles.
 		class PLATFORM_CORE_EXPORT Timer
 		{
 		private:
-			static __int64 OverheadTicks;			// overhead  in calling timer
-		#if defined(__ORBIS__) | defined(__COMMODORE__)
-			uint64_t iStart,iStop;
-		#endif
-		#ifdef _MSC_VER     
-			Int64 iStart,iStop;
-			int PerfFreqAdjust;			// in case Freq is too big
-			float dPerfFreq;			// ticks per second
-			__int64 Oht;
-			int ReduceMag;
-		#endif
-			void EmptyFunction();
+			int64_t startTicks = 0;
 		public:
-			float Time;
-			float TimeSum;
+			//! Ticks per second: ticks are nanoseconds.
+			static const int64_t TicksPerSecond = 1000000000;
+			//! The monotonic clock, in ticks from an arbitrary start.
+			static int64_t Ticks();
+			//! Convert a difference in ticks to milliseconds.
+			static double TicksToMS(int64_t ticks)
+			{
+				return double(ticks) * 1.0e-6;
+			}
+			//! Milliseconds between the last StartTime() and FinishTime().
+			double Time;
+			//! The sum of all the values of Time so far.
+			double TimeSum;
 			Timer();
 			~Timer();
 			//! Start timing: record the start of an event.
 			void StartTime();
 			//! Stop timing: record the end of an event. The value Time can now be read.
-			float FinishTime();
+			double FinishTime();
 			//! Update the value of Time and continue timing.
-			float UpdateTime()
+			double UpdateTime()
 			{
-				float t=FinishTime();
+				double t=FinishTime();
 				StartTime();
 				return t;
 			}
-			float AbsoluteTimeMS();
+			//! Milliseconds since StartTime().
+			double AbsoluteTimeMS();
+			//! Nanoseconds since StartTime().
+			int64_t ElapsedNs() const;
 			//! Update the value of Time and continue timing.
-			float UpdateTimeSum()
+			double UpdateTimeSum()
 			{
 				FinishTime();
 				StartTime();
@@ -58,4 +63,3 @@ namespace platform
 		};
 	}
 }
-
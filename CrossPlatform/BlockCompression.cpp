@@ -0,0 +1,897 @@
+#include "Platform/CrossPlatform/BlockCompression.h"
+#include "Platform/Core/ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PLATFORM_BLOCKCOMPRESSION_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	// Images with fewer blocks than this are encoded on the calling thread.
+	const size_t kMinParallelBlocks = 1024;
+	// The smallest number of blocks handed to a worker at once.
+	const size_t kBlocksPerJob = 256;
+	// BC7's 4-bit interpolation weights, out of 64.
+	const int kBC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+	// A 4x4 block of texels as floats, one array per channel, so that four texels are processed at once.
+	struct Block
+	{
+		alignas(16) float c[4][16];
+	};
+
+	// Texels past the edge of the image repeat the last row or column.
+	void LoadBlock(const Image &image, int bx, int by, Block &b)
+	{
+		int n = image.channels;
+		for (int y = 0; y < 4; y++)
+		{
+			int sy = std::min(by * 4 + y, image.height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				int sx = std::min(bx * 4 + x, image.width - 1);
+				const uint8_t *p = image.pixels.data() + (size_t(sy) * image.width + sx) * n;
+				for (int k = 0; k < 4; k++)
+					b.c[k][y * 4 + x] = k < n ? float(p[k]) : (k == 3 ? 255.0f : 0.0f);
+			}
+		}
+	}
+
+	int RoundClamp(float v, int hi)
+	{
+		int i = int(floorf(v + 0.5f));
+		return i < 0 ? 0 : (i > hi ? hi : i);
+	}
+
+	// For each texel, the index of the nearest palette entry by weighted squared distance, over the channels that have weight.
+	// Texels with a zero mask are given an index, but add nothing to the returned total error.
+	float FitIndices(const Block &b, const float (*palette)[4], int n, const float weight[4], const float *mask, uint8_t indices[16])
+	{
+		static const float ones[16] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+		if (!mask)
+			mask = ones;
+#if PLATFORM_BLOCKCOMPRESSION_SSE2
+		__m128 total = _mm_setzero_ps();
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128 ch[4];
+			for (int k = 0; k < 4; k++)
+				ch[k] = _mm_load_ps(b.c[k] + i);
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int j = 0; j < n; j++)
+			{
+				__m128 e = _mm_setzero_ps();
+				for (int k = 0; k < 4; k++)
+				{
+					if (weight[k] == 0.0f)
+						continue;
+					__m128 d = _mm_sub_ps(ch[k], _mm_set1_ps(palette[j][k]));
+					e = _mm_add_ps(e, _mm_mul_ps(_mm_mul_ps(d, d), _mm_set1_ps(weight[k])));
+				}
+				__m128i less = _mm_castps_si128(_mm_cmplt_ps(e, best));
+				best = _mm_min_ps(e, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(j)), _mm_andnot_si128(less, bestIndex));
+			}
+			total = _mm_add_ps(total, _mm_mul_ps(best, _mm_loadu_ps(mask + i)));
+			alignas(16) int32_t idx[4];
+			_mm_store_si128((__m128i *)idx, bestIndex);
+			for (int k = 0; k < 4; k++)
+				indices[i + k] = uint8_t(idx[k]);
+		}
+		alignas(16) float t[4];
+		_mm_store_ps(t, total);
+		return t[0] + t[1] + t[2] + t[3];
+#else
+		float total = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float best = FLT_MAX;
+			int bestIndex = 0;
+			for (int j = 0; j < n; j++)
+			{
+				float e = 0.0f;
+				for (int k = 0; k < 4; k++)
+				{
+					float d = b.c[k][i] - palette[j][k];
+					e += d * d * weight[k];
+				}
+				if (e < best)
+				{
+					best = e;
+					bestIndex = j;
+				}
+			}
+			indices[i] = uint8_t(bestIndex);
+			total += best * mask[i];
+		}
+		return total;
+#endif
+	}
+
+	// The mean of the texels, and the direction in which they vary most, by power iteration on their covariance.
+	void PrincipalAxis(const Block &b, int channels, const float *mask, float mean[4], float axis[4])
+	{
+		float count = 0.0f;
+		for (int k = 0; k < 4; k++)
+			mean[k] = axis[k] = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float m = mask ? mask[i] : 1.0f;
+			count += m;
+			for (int k = 0; k < channels; k++)
+				mean[k] += b.c[k][i] * m;
+		}
+		if (count == 0.0f)
+			return;
+		for (int k = 0; k < channels; k++)
+			mean[k] /= count;
+		float cov[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float m = mask ? mask[i] : 1.0f;
+			float d[4] = {};
+			for (int k = 0; k < channels; k++)
+				d[k] = b.c[k][i] - mean[k];
+			for (int j = 0; j < channels; j++)
+			{
+				for (int k = 0; k < channels; k++)
+					cov[j][k] += d[j] * d[k] * m;
+			}
+		}
+		// Start from the channel that varies most.
+		int widest = 0;
+		for (int k = 1; k < channels; k++)
+		{
+			if (cov[k][k] > cov[widest][widest])
+				widest = k;
+		}
+		float v[4] = {};
+		for (int k = 0; k < channels; k++)
+			v[k] = cov[widest][k];
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float w[4] = {};
+			float len = 0.0f;
+			for (int j = 0; j < channels; j++)
+			{
+				for (int k = 0; k < channels; k++)
+					w[j] += cov[j][k] * v[k];
+				len = std::max(len, fabsf(w[j]));
+			}
+			if (len == 0.0f)
+				break;
+			for (int k = 0; k < channels; k++)
+				v[k] = w[k] / len;
+		}
+		float len = 0.0f;
+		for (int k = 0; k < channels; k++)
+			len += v[k] * v[k];
+		len = sqrtf(len);
+		if (len > 0.0f)
+		{
+			for (int k = 0; k < channels; k++)
+				axis[k] = v[k] / len;
+		}
+	}
+
+	// The two ends of the texels' spread along the axis.
+	void AxisExtremes(const Block &b, int channels, const float *mask, const float mean[4], const float axis[4], float e0[4], float e1[4])
+	{
+		float lo = 0.0f, hi = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			if (mask && mask[i] == 0.0f)
+				continue;
+			float t = 0.0f;
+			for (int k = 0; k < channels; k++)
+				t += (b.c[k][i] - mean[k]) * axis[k];
+			lo = std::min(lo, t);
+			hi = std::max(hi, t);
+		}
+		for (int k = 0; k < 4; k++)
+		{
+			e0[k] = k < channels ? mean[k] + lo * axis[k] : 255.0f;
+			e1[k] = k < channels ? mean[k] + hi * axis[k] : 255.0f;
+		}
+	}
+
+	// The endpoints that best fit the texels by least squares, given the indices chosen and each index's position between the endpoints.
+	bool FitEndpoints(const Block &b, int channels, const uint8_t indices[16], const float *position, const float *mask, float e0[4], float e1[4])
+	{
+		double A = 0.0, B = 0.0, C = 0.0;
+		double X0[4] = {}, X1[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			double m = mask ? mask[i] : 1.0;
+			double w = position[indices[i]];
+			double u = 1.0 - w;
+			A += u * u * m;
+			B += u * w * m;
+			C += w * w * m;
+			for (int k = 0; k < channels; k++)
+			{
+				X0[k] += u * b.c[k][i] * m;
+				X1[k] += w * b.c[k][i] * m;
+			}
+		}
+		double det = A * C - B * B;
+		if (fabs(det) < 1e-6)
+			return false;
+		for (int k = 0; k < channels; k++)
+		{
+			e0[k] = float((C * X0[k] - B * X1[k]) / det);
+			e1[k] = float((A * X1[k] - B * X0[k]) / det);
+		}
+		return true;
+	}
+
+	// Writes fields into a little-endian block, from the lowest bit up.
+	struct BitWriter
+	{
+		uint8_t *out;
+		int bit = 0;
+		void Put(uint32_t value, int bits)
+		{
+			for (int i = 0; i < bits; i++, bit++)
+			{
+				if (value & (1u << i))
+					out[bit >> 3] |= uint8_t(1u << (bit & 7));
+			}
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t *in;
+		int bit = 0;
+		uint32_t Get(int bits)
+		{
+			uint32_t value = 0;
+			for (int i = 0; i < bits; i++, bit++)
+				value |= uint32_t((in[bit >> 3] >> (bit & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	// BC1 colour.
+
+	uint16_t To565(const float c[3])
+	{
+		return uint16_t((RoundClamp(c[0] * 31.0f / 255.0f, 31) << 11) | (RoundClamp(c[1] * 63.0f / 255.0f, 63) << 5) | RoundClamp(c[2] * 31.0f / 255.0f, 31));
+	}
+
+	void From565(uint16_t v, int c[3])
+	{
+		int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+		c[0] = (r << 3) | (r >> 2);
+		c[1] = (g << 2) | (g >> 4);
+		c[2] = (b << 3) | (b >> 2);
+	}
+
+	// The colours a BC1 block decodes to. In four-colour mode, indices 2 and 3 are a third and two thirds of the way from c0 to c1;
+	// in three-colour mode, index 2 is half way and index 3 is transparent black.
+	void ColourPalette(uint16_t c0, uint16_t c1, bool fourColour, int palette[4][4])
+	{
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		for (int k = 0; k < 3; k++)
+		{
+			if (fourColour)
+			{
+				palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+				palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+			}
+			else
+			{
+				palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+				palette[3][k] = 0;
+			}
+		}
+		for (int j = 0; j < 4; j++)
+			palette[j][3] = 255;
+		if (!fourColour)
+			palette[3][3] = 0;
+	}
+
+	struct ColourCandidate
+	{
+		uint16_t c0 = 0, c1 = 0;
+		uint8_t indices[16] = {};
+		float error = FLT_MAX;
+	};
+
+	// Quantize the endpoints and choose indices, in four-colour mode (c0>c1) or three-colour mode (c0<=c1).
+	ColourCandidate EvaluateColour(const Block &b, const float e0[4], const float e1[4], bool fourColour, const float *mask)
+	{
+		static const float weight[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+		ColourCandidate c;
+		c.c0 = To565(e0);
+		c.c1 = To565(e1);
+		if ((fourColour && c.c0 < c.c1) || (!fourColour && c.c0 > c.c1))
+			std::swap(c.c0, c.c1);
+		// Equal endpoints decode in three-colour mode, where index 0 still gives c0.
+		bool four = c.c0 > c.c1;
+		int p[4][4];
+		ColourPalette(c.c0, c.c1, four, p);
+		float palette[4][4];
+		for (int j = 0; j < 4; j++)
+		{
+			for (int k = 0; k < 4; k++)
+				palette[j][k] = float(p[j][k]);
+		}
+		c.error = FitIndices(b, palette, four ? 4 : 3, weight, mask, c.indices);
+		return c;
+	}
+
+	void EncodeColour(const Block &b, bool allowTransparent, CompressionQuality quality, uint8_t out[8])
+	{
+		float mask[16];
+		bool transparent = false, opaque = false;
+		for (int i = 0; i < 16; i++)
+		{
+			bool o = !allowTransparent || b.c[3][i] >= 128.0f;
+			mask[i] = o ? 1.0f : 0.0f;
+			transparent |= !o;
+			opaque |= o;
+		}
+		memset(out, 0, 8);
+		if (!opaque)
+		{
+			// c0=c1=0, so three-colour mode, and every index is 3: transparent.
+			memset(out + 4, 0xFF, 4);
+			return;
+		}
+		const float *m = transparent ? mask : nullptr;
+		float mean[4], axis[4], e0[4], e1[4];
+		PrincipalAxis(b, 3, m, mean, axis);
+		AxisExtremes(b, 3, m, mean, axis, e0, e1);
+		int refinements = quality == CompressionQuality::FAST ? 0 : (quality == CompressionQuality::NORMAL ? 1 : 3);
+		auto search = [&](bool fourColour)
+		{
+			static const float fourPositions[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+			static const float threePositions[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+			ColourCandidate best = EvaluateColour(b, e0, e1, fourColour, m);
+			for (int r = 0; r < refinements; r++)
+			{
+				float f0[4], f1[4];
+				bool four = best.c0 > best.c1;
+				if (!FitEndpoints(b, 3, best.indices, four ? fourPositions : threePositions, m, f0, f1))
+					break;
+				ColourCandidate c = EvaluateColour(b, f0, f1, fourColour, m);
+				if (c.error >= best.error)
+					break;
+				best = c;
+			}
+			return best;
+		};
+		ColourCandidate best = search(!transparent);
+		if (allowTransparent && !transparent && quality == CompressionQuality::HIGH)
+		{
+			ColourCandidate three = search(false);
+			if (three.error < best.error)
+				best = three;
+		}
+		out[0] = uint8_t(best.c0);
+		out[1] = uint8_t(best.c0 >> 8);
+		out[2] = uint8_t(best.c1);
+		out[3] = uint8_t(best.c1 >> 8);
+		uint32_t bits = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t index = transparent && mask[i] == 0.0f ? 3 : best.indices[i];
+			bits |= index << (2 * i);
+		}
+		for (int i = 0; i < 4; i++)
+			out[4 + i] = uint8_t(bits >> (8 * i));
+	}
+
+	void DecodeColour(const uint8_t in[8], bool alwaysFourColour, uint8_t texels[16][4])
+	{
+		uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+		uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+		int palette[4][4];
+		ColourPalette(c0, c1, alwaysFourColour || c0 > c1, palette);
+		uint32_t bits = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+		for (int i = 0; i < 16; i++)
+		{
+			const int *p = palette[(bits >> (2 * i)) & 3];
+			for (int k = 0; k < 4; k++)
+				texels[i][k] = uint8_t(p[k]);
+		}
+	}
+
+	// BC4 single channel, as used for BC3 alpha and BC5.
+
+	// The values a BC4 block decodes to: with a0>a1, six steps between them; otherwise four, then 0 and 255.
+	void ChannelPalette(int a0, int a1, int palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int j = 1; j < 7; j++)
+				palette[j + 1] = ((7 - j) * a0 + j * a1 + 3) / 7;
+		}
+		else
+		{
+			for (int j = 1; j < 5; j++)
+				palette[j + 1] = ((5 - j) * a0 + j * a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	struct ChannelCandidate
+	{
+		int a0 = 0, a1 = 0;
+		uint8_t indices[16] = {};
+		int error = INT32_MAX;
+	};
+
+	ChannelCandidate EvaluateChannel(const int v[16], int a0, int a1)
+	{
+		ChannelCandidate c;
+		c.a0 = a0;
+		c.a1 = a1;
+		c.error = 0;
+		int palette[8];
+		ChannelPalette(a0, a1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			int best = INT32_MAX;
+			for (int j = 0; j < 8; j++)
+			{
+				int d = v[i] - palette[j];
+				if (d * d < best)
+				{
+					best = d * d;
+					c.indices[i] = uint8_t(j);
+				}
+			}
+			c.error += best;
+		}
+		return c;
+	}
+
+	void EncodeChannel(const Block &b, int channel, CompressionQuality quality, uint8_t out[8])
+	{
+		int v[16];
+		int lo = 255, hi = 0;
+		// The range without the exact 0 and 255 that six-step mode stores separately.
+		int innerLo = 255, innerHi = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			v[i] = RoundClamp(b.c[channel][i], 255);
+			lo = std::min(lo, v[i]);
+			hi = std::max(hi, v[i]);
+			if (v[i] != 0 && v[i] != 255)
+			{
+				innerLo = std::min(innerLo, v[i]);
+				innerHi = std::max(innerHi, v[i]);
+			}
+		}
+		ChannelCandidate best = EvaluateChannel(v, hi, lo);
+		if (quality != CompressionQuality::FAST && best.error)
+		{
+			if (innerLo <= innerHi)
+			{
+				ChannelCandidate c = EvaluateChannel(v, innerLo, innerHi);
+				if (c.error < best.error)
+					best = c;
+			}
+		}
+		if (quality == CompressionQuality::HIGH && best.error && hi > lo)
+		{
+			// Try nearby endpoints in the mode already chosen.
+			int a0 = best.a0, a1 = best.a1;
+			for (int d0 = -2; d0 <= 2; d0++)
+			{
+				for (int d1 = -2; d1 <= 2; d1++)
+				{
+					int n0 = std::min(255, std::max(0, a0 + d0));
+					int n1 = std::min(255, std::max(0, a1 + d1));
+					if ((n0 > n1) != (a0 > a1))
+						continue;
+					ChannelCandidate c = EvaluateChannel(v, n0, n1);
+					if (c.error < best.error)
+						best = c;
+				}
+			}
+		}
+		memset(out, 0, 8);
+		out[0] = uint8_t(best.a0);
+		out[1] = uint8_t(best.a1);
+		BitWriter w{out};
+		w.bit = 16;
+		for (int i = 0; i < 16; i++)
+			w.Put(best.indices[i], 3);
+	}
+
+	void DecodeChannel(const uint8_t in[8], uint8_t texels[16][4], int channel)
+	{
+		int palette[8];
+		ChannelPalette(in[0], in[1], palette);
+		BitReader r{in};
+		r.bit = 16;
+		for (int i = 0; i < 16; i++)
+			texels[i][channel] = uint8_t(palette[r.Get(3)]);
+	}
+
+	// BC7, mode 6: one subset, RGBA endpoints of seven bits each plus a p-bit per endpoint, and 4-bit indices.
+
+	struct BC7Endpoint
+	{
+		uint8_t q[4];
+		int p;
+		int Value(int k) const
+		{
+			return (q[k] << 1) | p;
+		}
+	};
+
+	BC7Endpoint QuantizeBC7(const float e[4], int p)
+	{
+		BC7Endpoint ep;
+		ep.p = p;
+		for (int k = 0; k < 4; k++)
+			ep.q[k] = uint8_t(RoundClamp((e[k] - float(p)) * 0.5f, 127));
+		return ep;
+	}
+
+	// The p-bit that quantizes the endpoint most closely.
+	BC7Endpoint QuantizeBC7(const float e[4])
+	{
+		BC7Endpoint ep[2] = {QuantizeBC7(e, 0), QuantizeBC7(e, 1)};
+		float err[2] = {0.0f, 0.0f};
+		for (int p = 0; p < 2; p++)
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				float d = e[k] - float(ep[p].Value(k));
+				err[p] += d * d;
+			}
+		}
+		return ep[err[1] < err[0] ? 1 : 0];
+	}
+
+	void BC7Palette(const BC7Endpoint &e0, const BC7Endpoint &e1, int palette[16][4])
+	{
+		for (int j = 0; j < 16; j++)
+		{
+			for (int k = 0; k < 4; k++)
+				palette[j][k] = ((64 - kBC7Weights[j]) * e0.Value(k) + kBC7Weights[j] * e1.Value(k) + 32) >> 6;
+		}
+	}
+
+	struct BC7Candidate
+	{
+		BC7Endpoint e0, e1;
+		uint8_t indices[16] = {};
+		float error = FLT_MAX;
+	};
+
+	BC7Candidate EvaluateBC7(const Block &b, const BC7Endpoint &e0, const BC7Endpoint &e1)
+	{
+		static const float weight[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+		BC7Candidate c;
+		c.e0 = e0;
+		c.e1 = e1;
+		int p[16][4];
+		BC7Palette(e0, e1, p);
+		float palette[16][4];
+		for (int j = 0; j < 16; j++)
+		{
+			for (int k = 0; k < 4; k++)
+				palette[j][k] = float(p[j][k]);
+		}
+		c.error = FitIndices(b, palette, 16, weight, nullptr, c.indices);
+		return c;
+	}
+
+	// Opaque blocks keep both p-bits set, so that their alpha decodes to exactly 255.
+	BC7Candidate SearchBC7(const Block &b, const float e0[4], const float e1[4], bool opaque, CompressionQuality quality)
+	{
+		BC7Candidate best;
+		if (opaque)
+		{
+			best = EvaluateBC7(b, QuantizeBC7(e0, 1), QuantizeBC7(e1, 1));
+		}
+		else if (quality == CompressionQuality::HIGH)
+		{
+			for (int p = 0; p < 4; p++)
+			{
+				BC7Candidate c = EvaluateBC7(b, QuantizeBC7(e0, p & 1), QuantizeBC7(e1, p >> 1));
+				if (c.error < best.error)
+					best = c;
+			}
+		}
+		else
+		{
+			best = EvaluateBC7(b, QuantizeBC7(e0), QuantizeBC7(e1));
+		}
+		return best;
+	}
+
+	void EncodeBC7(const Block &b, CompressionQuality quality, uint8_t out[16])
+	{
+		float positions[16];
+		for (int j = 0; j < 16; j++)
+			positions[j] = float(kBC7Weights[j]) / 64.0f;
+		bool opaque = true;
+		for (int i = 0; i < 16; i++)
+			opaque &= b.c[3][i] == 255.0f;
+		float mean[4], axis[4], e0[4], e1[4];
+		PrincipalAxis(b, 4, nullptr, mean, axis);
+		AxisExtremes(b, 4, nullptr, mean, axis, e0, e1);
+		BC7Candidate best = SearchBC7(b, e0, e1, opaque, quality);
+		int refinements = quality == CompressionQuality::FAST ? 0 : (quality == CompressionQuality::NORMAL ? 1 : 3);
+		for (int r = 0; r < refinements && best.error > 0.0f; r++)
+		{
+			float f0[4], f1[4];
+			if (!FitEndpoints(b, 4, best.indices, positions, nullptr, f0, f1))
+				break;
+			BC7Candidate c = SearchBC7(b, f0, f1, opaque, quality);
+			if (c.error >= best.error)
+				break;
+			best = c;
+		}
+		// The first index is stored without its top bit, so it must be less than 8.
+		if (best.indices[0] & 8)
+		{
+			std::swap(best.e0, best.e1);
+			for (int i = 0; i < 16; i++)
+				best.indices[i] = uint8_t(15 - best.indices[i]);
+		}
+		memset(out, 0, 16);
+		BitWriter w{out};
+		w.Put(1 << 6, 7);
+		for (int k = 0; k < 4; k++)
+		{
+			w.Put(best.e0.q[k], 7);
+			w.Put(best.e1.q[k], 7);
+		}
+		w.Put(uint32_t(best.e0.p), 1);
+		w.Put(uint32_t(best.e1.p), 1);
+		for (int i = 0; i < 16; i++)
+			w.Put(best.indices[i], i == 0 ? 3 : 4);
+	}
+
+	bool DecodeBC7(const uint8_t in[16], uint8_t texels[16][4])
+	{
+		BitReader r{in};
+		if (r.Get(7) != (1 << 6))
+			return false;
+		BC7Endpoint e0, e1;
+		for (int k = 0; k < 4; k++)
+		{
+			e0.q[k] = uint8_t(r.Get(7));
+			e1.q[k] = uint8_t(r.Get(7));
+		}
+		e0.p = int(r.Get(1));
+		e1.p = int(r.Get(1));
+		int palette[16][4];
+		BC7Palette(e0, e1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			const int *p = palette[r.Get(i == 0 ? 3 : 4)];
+			for (int k = 0; k < 4; k++)
+				texels[i][k] = uint8_t(p[k]);
+		}
+		return true;
+	}
+
+	void EncodeBlock(CompressionFormat f, const Block &b, CompressionQuality quality, uint8_t *out)
+	{
+		switch (f)
+		{
+		case CompressionFormat::BC1:
+			EncodeColour(b, true, quality, out);
+			break;
+		case CompressionFormat::BC3:
+			EncodeChannel(b, 3, quality, out);
+			EncodeColour(b, false, quality, out + 8);
+			break;
+		case CompressionFormat::BC4:
+			EncodeChannel(b, 0, quality, out);
+			break;
+		case CompressionFormat::BC5:
+			EncodeChannel(b, 0, quality, out);
+			EncodeChannel(b, 1, quality, out + 8);
+			break;
+		case CompressionFormat::BC7_M6_OPAQUE_ONLY:
+			EncodeBC7(b, quality, out);
+			break;
+		default:
+			break;
+		}
+	}
+
+	bool DecodeBlock(CompressionFormat f, const uint8_t *in, uint8_t texels[16][4])
+	{
+		switch (f)
+		{
+		case CompressionFormat::BC1:
+			DecodeColour(in, false, texels);
+			return true;
+		case CompressionFormat::BC3:
+			DecodeColour(in + 8, true, texels);
+			DecodeChannel(in, texels, 3);
+			return true;
+		case CompressionFormat::BC4:
+			DecodeChannel(in, texels, 0);
+			return true;
+		case CompressionFormat::BC5:
+			DecodeChannel(in, texels, 0);
+			DecodeChannel(in + 8, texels, 1);
+			return true;
+		case CompressionFormat::BC7_M6_OPAQUE_ONLY:
+			return DecodeBC7(in, texels);
+		default:
+			return false;
+		}
+	}
+
+	int BlockCount(int size)
+	{
+		return std::max(1, (size + 3) / 4);
+	}
+}
+
+bool BlockCompression::IsSupported(CompressionFormat f)
+{
+	return GetBlockBytes(f) != 0;
+}
+
+size_t BlockCompression::GetBlockBytes(CompressionFormat f)
+{
+	switch (f)
+	{
+	case CompressionFormat::BC1:
+	case CompressionFormat::BC4:
+		return 8;
+	case CompressionFormat::BC3:
+	case CompressionFormat::BC5:
+	case CompressionFormat::BC7_M6_OPAQUE_ONLY:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t BlockCompression::GetCompressedSize(CompressionFormat f, int width, int height)
+{
+	return GetBlockBytes(f) * BlockCount(width) * BlockCount(height);
+}
+
+int BlockCompression::GetChannels(CompressionFormat f)
+{
+	switch (f)
+	{
+	case CompressionFormat::BC4:
+		return 1;
+	case CompressionFormat::BC5:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+PixelFormat BlockCompression::GetPixelFormat(CompressionFormat f)
+{
+	switch (f)
+	{
+	case CompressionFormat::BC4:
+		return PixelFormat::R_8_UNORM;
+	case CompressionFormat::BC5:
+		return PixelFormat::RG_8_UNORM;
+	default:
+		return PixelFormat::RGBA_8_UNORM;
+	}
+}
+
+CompressionFormat BlockCompression::ChooseFormat(int neededChannels, CompressionQuality quality)
+{
+	bool alpha = neededChannels == 2 || neededChannels == 4;
+	if (quality == CompressionQuality::HIGH)
+		return CompressionFormat::BC7_M6_OPAQUE_ONLY;
+	return alpha ? CompressionFormat::BC3 : CompressionFormat::BC1;
+}
+
+bool BlockCompression::Compress(const Image &image, CompressionFormat f, std::vector<uint8_t> &out, const BlockCompressionSettings &settings)
+{
+	if (!IsSupported(f) || !image.IsValid())
+		return false;
+	// BC4 and BC5 hold data, such as roughness or a normal's x and y, so they take the first one or two channels as they are,
+	// not a luminance. Callers that want grey in them convert with ImagePipeline::PackChannels() first.
+	// The colour formats are given grey as red, green and blue.
+	int channels = GetChannels(f);
+	if (channels == 4 && image.channels != channels)
+	{
+		Image packed;
+		ImagePipeline::PackChannels(image, packed, channels);
+		return Compress(packed, f, out, settings);
+	}
+	size_t blockBytes = GetBlockBytes(f);
+	int blocksX = BlockCount(image.width);
+	int blocksY = BlockCount(image.height);
+	out.assign(blockBytes * blocksX * blocksY, 0);
+	uint8_t *dst = out.data();
+	CompressionQuality quality = settings.quality;
+	auto encodeRows = [&](size_t begin, size_t end)
+	{
+		Block b;
+		for (size_t by = begin; by < end; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				LoadBlock(image, bx, int(by), b);
+				EncodeBlock(f, b, quality, dst + (by * blocksX + bx) * blockBytes);
+			}
+		}
+	};
+	if (settings.multithreaded && size_t(blocksX) * blocksY >= kMinParallelBlocks)
+	{
+		size_t rowsPerJob = std::max<size_t>(1, kBlocksPerJob / blocksX);
+		core::ThreadPool::Get().ParallelFor(blocksY, rowsPerJob, encodeRows);
+	}
+	else
+	{
+		encodeRows(0, blocksY);
+	}
+	return true;
+}
+
+bool BlockCompression::CompressMipChain(const std::vector<Image> &mips, CompressionFormat f, std::vector<std::vector<uint8_t>> &data, const BlockCompressionSettings &settings)
+{
+	for (const auto &m : mips)
+	{
+		std::vector<uint8_t> out;
+		if (!Compress(m, f, out, settings))
+			return false;
+		data.push_back(std::move(out));
+	}
+	return true;
+}
+
+bool BlockCompression::Decompress(CompressionFormat f, const void *src, size_t size, int width, int height, Image &image)
+{
+	if (!IsSupported(f) || width <= 0 || height <= 0 || size < GetCompressedSize(f, width, height))
+		return false;
+	int channels = GetChannels(f);
+	image.width = width;
+	image.height = height;
+	image.channels = channels;
+	image.pixels.resize(size_t(width) * height * channels);
+	size_t blockBytes = GetBlockBytes(f);
+	int blocksX = BlockCount(width);
+	int blocksY = BlockCount(height);
+	const uint8_t *in = (const uint8_t *)src;
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++, in += blockBytes)
+		{
+			uint8_t texels[16][4] = {};
+			if (!DecodeBlock(f, in, texels))
+				return false;
+			for (int y = 0; y < 4 && by * 4 + y < height; y++)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+				{
+					uint8_t *p = image.pixels.data() + (size_t(by * 4 + y) * width + bx * 4 + x) * channels;
+					for (int k = 0; k < channels; k++)
+						p[k] = texels[y * 4 + x][k];
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/ImagePipeline.h"
+#include "Platform/CrossPlatform/Texture.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! How hard the encoder searches for each block's endpoints.
+		enum class CompressionQuality : uint8_t
+		{
+			//! Endpoints from the texels' principal axis only.
+			FAST,
+			//! Endpoints refined by least squares, and for BC4, a choice of both interpolation modes.
+			NORMAL,
+			//! Several refinements, every BC7 p-bit combination, the three-colour BC1 mode, and a local search of BC4 endpoints.
+			HIGH
+		};
+		struct SIMUL_CROSSPLATFORM_EXPORT BlockCompressionSettings
+		{
+			CompressionQuality quality = CompressionQuality::NORMAL;
+			//! Split the rows of blocks across core::ThreadPool::Get().
+			bool multithreaded = true;
+		};
+		//! Encodes 8-bit images to BC1, BC3, BC4, BC5 and BC7 on the CPU, so textures can be compressed at import time
+		//! and uploaded at a quarter or an eighth of their size.
+		//! BC7 blocks are all mode 6, one subset with RGBA endpoints, which CompressionFormat::BC7_M6_OPAQUE_ONLY describes;
+		//! alpha is encoded too.
+		//! Error is measured on the stored 8-bit values, so sRGB images are encoded in their own space.
+		class SIMUL_CROSSPLATFORM_EXPORT BlockCompression
+		{
+		public:
+			//! Whether Compress() can write the format.
+			static bool IsSupported(CompressionFormat f);
+			//! The bytes in a 4x4 block: 8 for BC1 and BC4, 16 for the others; 0 if unsupported.
+			static size_t GetBlockBytes(CompressionFormat f);
+			//! The bytes for a width x height image, in whole blocks.
+			static size_t GetCompressedSize(CompressionFormat f, int width, int height);
+			//! The channels the format stores: four for BC1, BC3 and BC7, one for BC4, and two for BC5.
+			static int GetChannels(CompressionFormat f);
+			//! The pixel format to create a texture with, along with the compression format.
+			static PixelFormat GetPixelFormat(CompressionFormat f);
+			//! A format for an image that needs the given channels, as ImagePipeline::CountNeededChannels() counts them.
+			//! Grey goes in colour formats, so that shaders sample the texture as they would uncompressed RGBA.
+			static CompressionFormat ChooseFormat(int neededChannels, CompressionQuality quality);
+			//! Encode an image. BC4 and BC5 store its first one or two channels, with zero for a missing second channel.
+			//! The colour formats convert it to four channels first, as ImagePipeline::PackChannels() does.
+			static bool Compress(const Image &image, CompressionFormat f, std::vector<uint8_t> &out
+				, const BlockCompressionSettings &settings = BlockCompressionSettings());
+			//! Encode each mip and append it to data, in the order TextureCreate::initialData takes for one layer.
+			static bool CompressMipChain(const std::vector<Image> &mips, CompressionFormat f, std::vector<std::vector<uint8_t>> &data
+				, const BlockCompressionSettings &settings = BlockCompressionSettings());
+			//! Decode blocks to an image with GetChannels(f) channels, for checking the encoder without a GPU.
+			//! For BC7, only mode 6 blocks can be decoded, as Compress() writes.
+			static bool Decompress(CompressionFormat f, const void *src, size_t size, int width, int height, Image &image);
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
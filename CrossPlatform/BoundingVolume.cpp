@@ -0,0 +1,236 @@
+#include "Platform/CrossPlatform/BoundingVolume.h"
+#include "Platform/CrossPlatform/ViewStruct.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PLATFORM_CULLING_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+using namespace platform;
+using namespace crossplatform;
+
+void AABB::Extend(const vec3 &p)
+{
+	minimum = vec3(std::min(minimum.x, p.x), std::min(minimum.y, p.y), std::min(minimum.z, p.z));
+	maximum = vec3(std::max(maximum.x, p.x), std::max(maximum.y, p.y), std::max(maximum.z, p.z));
+}
+
+void AABB::Extend(const AABB &b)
+{
+	if (b.IsEmpty())
+		return;
+	Extend(b.minimum);
+	Extend(b.maximum);
+}
+
+vec3 AABB::GetCentre() const
+{
+	return vec3(0.5f * (minimum.x + maximum.x), 0.5f * (minimum.y + maximum.y), 0.5f * (minimum.z + maximum.z));
+}
+
+vec3 AABB::GetExtents() const
+{
+	return vec3(0.5f * (maximum.x - minimum.x), 0.5f * (maximum.y - minimum.y), 0.5f * (maximum.z - minimum.z));
+}
+
+AABB AABB::Transformed(const math::Matrix4x4 &m) const
+{
+	if (IsEmpty())
+		return *this;
+	// Transform the centre, and take the extent on each new axis as the sum of the absolute projections of the old extents.
+	vec3 c = GetCentre();
+	vec3 e = GetExtents();
+	const float *M = m.Values;
+	vec3 nc, ne;
+	float *pc = (float*)&nc;
+	float *pe = (float*)&ne;
+	for (int i = 0; i < 3; i++)
+	{
+		const float *row = M + i * 4;
+		pc[i] = row[0] * c.x + row[1] * c.y + row[2] * c.z + row[3];
+		pe[i] = fabsf(row[0]) * e.x + fabsf(row[1]) * e.y + fabsf(row[2]) * e.z;
+	}
+	AABB b;
+	b.minimum = vec3(nc.x - ne.x, nc.y - ne.y, nc.z - ne.z);
+	b.maximum = vec3(nc.x + ne.x, nc.y + ne.y, nc.z + ne.z);
+	return b;
+}
+
+BoundingSphere BoundingSphere::Transformed(const math::Matrix4x4 &m) const
+{
+	if (IsEmpty())
+		return *this;
+	const float *M = m.Values;
+	BoundingSphere s;
+	s.centre.x = M[0] * centre.x + M[1] * centre.y + M[2] * centre.z + M[3];
+	s.centre.y = M[4] * centre.x + M[5] * centre.y + M[6] * centre.z + M[7];
+	s.centre.z = M[8] * centre.x + M[9] * centre.y + M[10] * centre.z + M[11];
+	// Scale the radius by the longest transformed axis.
+	float sx = M[0] * M[0] + M[4] * M[4] + M[8] * M[8];
+	float sy = M[1] * M[1] + M[5] * M[5] + M[9] * M[9];
+	float sz = M[2] * M[2] + M[6] * M[6] + M[10] * M[10];
+	s.radius = radius * sqrtf(std::max(sx, std::max(sy, sz)));
+	return s;
+}
+
+FrustumPlanes FrustumPlanes::FromMatrix(const math::Matrix4x4 &m)
+{
+	const float *M = m.Values;
+	vec4 r0(M[0], M[1], M[2], M[3]);
+	vec4 r1(M[4], M[5], M[6], M[7]);
+	vec4 r2(M[8], M[9], M[10], M[11]);
+	vec4 r3(M[12], M[13], M[14], M[15]);
+	FrustumPlanes f;
+	f.planes[LEFT]			= r3 + r0;
+	f.planes[RIGHT]			= r3 - r0;
+	f.planes[BOTTOM]		= r3 + r1;
+	f.planes[TOP]			= r3 - r1;
+	// Clip depth runs from 0 to w; with reversed depth these are the far and near planes respectively.
+	f.planes[NEAR_PLANE]	= r2;
+	f.planes[FAR_PLANE]		= r3 - r2;
+	for (int i = 0; i < COUNT; i++)
+	{
+		vec4 &p = f.planes[i];
+		float l = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+		// An infinite plane has no normal: make it pass everything.
+		if (l < 1e-12f)
+			p = vec4(0, 0, 0, 1.0f);
+		else
+			p = vec4(p.x / l, p.y / l, p.z / l, p.w / l);
+	}
+	return f;
+}
+
+FrustumPlanes FrustumPlanes::FromViewStruct(const ViewStruct &viewStruct)
+{
+	return FromMatrix(viewStruct.viewProj);
+}
+
+bool FrustumPlanes::Intersects(const AABB &box) const
+{
+	if (box.IsEmpty())
+		return false;
+	for (int i = 0; i < COUNT; i++)
+	{
+		const vec4 &p = planes[i];
+		// The corner furthest along the plane normal.
+		float x = p.x >= 0 ? box.maximum.x : box.minimum.x;
+		float y = p.y >= 0 ? box.maximum.y : box.minimum.y;
+		float z = p.z >= 0 ? box.maximum.z : box.minimum.z;
+		if (p.x * x + p.y * y + p.z * z + p.w < 0)
+			return false;
+	}
+	return true;
+}
+
+bool FrustumPlanes::Intersects(const BoundingSphere &sphere) const
+{
+	if (sphere.IsEmpty())
+		return false;
+	for (int i = 0; i < COUNT; i++)
+	{
+		const vec4 &p = planes[i];
+		if (p.x * sphere.centre.x + p.y * sphere.centre.y + p.z * sphere.centre.z + p.w < -sphere.radius)
+			return false;
+	}
+	return true;
+}
+
+void AABBArray::Clear()
+{
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
+
+void AABBArray::Reserve(size_t n)
+{
+	minX.reserve(n);
+	minY.reserve(n);
+	minZ.reserve(n);
+	maxX.reserve(n);
+	maxY.reserve(n);
+	maxZ.reserve(n);
+}
+
+size_t AABBArray::Add(const AABB &box)
+{
+	minX.push_back(box.minimum.x);
+	minY.push_back(box.minimum.y);
+	minZ.push_back(box.minimum.z);
+	maxX.push_back(box.maximum.x);
+	maxY.push_back(box.maximum.y);
+	maxZ.push_back(box.maximum.z);
+	return minX.size() - 1;
+}
+
+size_t platform::crossplatform::CullAABBs(const FrustumPlanes &frustum, const float *minX, const float *minY, const float *minZ
+	, const float *maxX, const float *maxY, const float *maxZ, size_t count, uint8_t *visible)
+{
+	// For each plane, the corner furthest along its normal comes from the same arrays for every box, so choose them once.
+	const float *px[FrustumPlanes::COUNT], *py[FrustumPlanes::COUNT], *pz[FrustumPlanes::COUNT];
+	for (int j = 0; j < FrustumPlanes::COUNT; j++)
+	{
+		const vec4 &p = frustum.planes[j];
+		px[j] = p.x >= 0 ? maxX : minX;
+		py[j] = p.y >= 0 ? maxY : minY;
+		pz[j] = p.z >= 0 ? maxZ : minZ;
+	}
+	size_t numVisible = 0;
+	size_t i = 0;
+#if PLATFORM_CULLING_SSE2
+	__m128 nx[FrustumPlanes::COUNT], ny[FrustumPlanes::COUNT], nz[FrustumPlanes::COUNT], nw[FrustumPlanes::COUNT];
+	for (int j = 0; j < FrustumPlanes::COUNT; j++)
+	{
+		nx[j] = _mm_set1_ps(frustum.planes[j].x);
+		ny[j] = _mm_set1_ps(frustum.planes[j].y);
+		nz[j] = _mm_set1_ps(frustum.planes[j].z);
+		nw[j] = _mm_set1_ps(frustum.planes[j].w);
+	}
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int j = 0; j < FrustumPlanes::COUNT; j++)
+		{
+			__m128 d = _mm_add_ps(_mm_mul_ps(nx[j], _mm_loadu_ps(px[j] + i)), nw[j]);
+			d = _mm_add_ps(d, _mm_mul_ps(ny[j], _mm_loadu_ps(py[j] + i)));
+			d = _mm_add_ps(d, _mm_mul_ps(nz[j], _mm_loadu_ps(pz[j] + i)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+		}
+		int mask = _mm_movemask_ps(inside);
+		visible[i]		= (uint8_t)(mask & 1);
+		visible[i + 1]	= (uint8_t)((mask >> 1) & 1);
+		visible[i + 2]	= (uint8_t)((mask >> 2) & 1);
+		visible[i + 3]	= (uint8_t)((mask >> 3) & 1);
+		numVisible += visible[i] + visible[i + 1] + visible[i + 2] + visible[i + 3];
+	}
+#endif
+	for (; i < count; i++)
+	{
+		uint8_t v = 1;
+		for (int j = 0; j < FrustumPlanes::COUNT && v; j++)
+		{
+			const vec4 &p = frustum.planes[j];
+			if (p.x * px[j][i] + p.y * py[j][i] + p.z * pz[j][i] + p.w < 0)
+				v = 0;
+		}
+		visible[i] = v;
+		numVisible += v;
+	}
+	return numVisible;
+}
+
+size_t platform::crossplatform::CullAABBs(const FrustumPlanes &frustum, const AABBArray &boxes, uint8_t *visible)
+{
+	size_t n = boxes.Size();
+	if (!n)
+		return 0;
+	return CullAABBs(frustum, boxes.minX.data(), boxes.minY.data(), boxes.minZ.data()
+		, boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data(), n, visible);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/Shaders/CppSl.sl"
+#include "Platform/Math/Matrix4x4.h"
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		struct ViewStruct;
+		//! An axis-aligned bounding box. A default-constructed box is empty, and grows as points or boxes are added.
+		struct SIMUL_CROSSPLATFORM_EXPORT AABB
+		{
+			vec3 minimum = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+			vec3 maximum = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			bool IsEmpty() const
+			{
+				return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z;
+			}
+			void Extend(const vec3 &p);
+			void Extend(const AABB &b);
+			vec3 GetCentre() const;
+			//! Half the size of the box on each axis.
+			vec3 GetExtents() const;
+			//! The box enclosing this one after transformation by \a m. Like ViewStruct::model, \a m transforms column vectors,
+			//! with the translation in _14, _24, _34.
+			AABB Transformed(const math::Matrix4x4 &m) const;
+		};
+		//! A bounding sphere. A negative radius means empty.
+		struct SIMUL_CROSSPLATFORM_EXPORT BoundingSphere
+		{
+			vec3 centre = vec3(0, 0, 0);
+			float radius = -1.0f;
+			bool IsEmpty() const
+			{
+				return radius < 0.0f;
+			}
+			//! The sphere enclosing this one after transformation by \a m, which may include a non-uniform scale.
+			BoundingSphere Transformed(const math::Matrix4x4 &m) const;
+		};
+		//! The six planes of a view frustum, each as (nx, ny, nz, d): a point p is inside if dot(n, p) + d >= 0 for all six.
+		//! Planes are in the space that the source matrix transforms from, e.g. worldspace for a viewProj matrix.
+		struct SIMUL_CROSSPLATFORM_EXPORT FrustumPlanes
+		{
+			enum
+			{
+				LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, COUNT
+			};
+			vec4 planes[COUNT];
+			//! Extract the planes from a matrix that transforms column vectors to clip space, with clip depth from 0 to w,
+			//! as all our APIs use. Reversed depth and infinite far planes are handled.
+			static FrustumPlanes FromMatrix(const math::Matrix4x4 &clipFromSpace);
+			//! The worldspace planes of the view's viewProj matrix. ViewStruct::Init() must have been called.
+			static FrustumPlanes FromViewStruct(const ViewStruct &viewStruct);
+			bool Intersects(const AABB &box) const;
+			bool Intersects(const BoundingSphere &sphere) const;
+		};
+		//! Boxes in structure-of-arrays form, so that CullAABBs can test several at once.
+		struct SIMUL_CROSSPLATFORM_EXPORT AABBArray
+		{
+			std::vector<float> minX, minY, minZ;
+			std::vector<float> maxX, maxY, maxZ;
+			void Clear();
+			void Reserve(size_t n);
+			//! Returns the index of the added box.
+			size_t Add(const AABB &box);
+			size_t Size() const
+			{
+				return minX.size();
+			}
+		};
+		//! Test \a count boxes against the frustum, four at a time where SSE2 is available. Sets visible[i] to 1 for boxes that
+		//! intersect or are inside the frustum, 0 for those wholly outside a plane. Returns the number visible.
+		//! Like any plane test, a box that is near a corner of the frustum may be kept although it is outside.
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t CullAABBs(const FrustumPlanes &frustum, const float *minX, const float *minY, const float *minZ
+			, const float *maxX, const float *maxY, const float *maxZ, size_t count, uint8_t *visible);
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t CullAABBs(const FrustumPlanes &frustum, const AABBArray &boxes, uint8_t *visible);
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
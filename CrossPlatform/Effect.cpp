@@ -16,6 +16,9 @@
 #if PLATFORM_STD_FILESYSTEM > 0
 #include <filesystem>
 #endif
+#include <fstream>
+#include <mutex>
+#include <atomic>
 
 using namespace platform;
 using namespace crossplatform;
@@ -249,6 +252,7 @@ void Effect::InvalidateDeviceObjects()
 {
 	shaders.clear();
 	shaderResources.clear();
+	shaderResourceCache.clear();
 	for (auto i = groups.begin(); i != groups.end(); i++)
 	{
 		delete i->second;
@@ -354,9 +358,113 @@ EffectVariantPass *EffectTechnique::GetVariantPass(const char *name)
 }
 
 
+namespace
+{
+	std::atomic<bool> variantManifestRecording(false);
+	std::mutex variantManifestMutex;
+	std::set<std::string> variantManifestLines;
+	EffectPass *Requested(const std::string &variantPassName, EffectPass *p)
+	{
+		if (variantManifestRecording)
+		{
+			Effect *e = p->GetEffect();
+			VariantManifest::Record(e ? e->GetName() : "", variantPassName);
+		}
+		return p;
+	}
+	// The variant asked for is not in the sfxo: with on-demand compiles on, request it and use the fallback meanwhile.
+	EffectPass *Missing(const std::string &passName, EffectPass *fallback, const char *shader1, const char *shader2)
+	{
+		if (!fallback)
+			return nullptr;
+		Effect *e = fallback->GetEffect();
+		RenderPlatform *r = e ? e->GetRenderPlatform() : nullptr;
+		if (!r || !r->IsOnDemandVariantCompileEnabled())
+			return nullptr;
+		std::vector<std::string> variants;
+		for (const char *s : {shader1, shader2})
+		{
+			if (s && strchr(s, '('))
+				variants.push_back(s);
+		}
+		if (variantManifestRecording)
+			VariantManifest::Record(e->GetName(), passName + "." + (shader1 ? shader1 : "") + "." + (shader2 ? shader2 : ""));
+		r->RequestEffectVariants(e, variants);
+		return fallback;
+	}
+}
+
+void VariantManifest::SetRecording(bool r)
+{
+	variantManifestRecording = r;
+}
+
+bool VariantManifest::IsRecording()
+{
+	return variantManifestRecording;
+}
+
+void VariantManifest::Record(const char *effectName, const std::string &variantPassName)
+{
+	// Sfx knows the effect by its source filename, without the path or extension.
+	std::string effect = effectName ? effectName : "";
+	size_t slash = effect.find_last_of("/\\");
+	if (slash != std::string::npos)
+		effect = effect.substr(slash + 1);
+	size_t dot = effect.find('.');
+	if (dot != std::string::npos)
+		effect = effect.substr(0, dot);
+	vector<string> parts = platform::core::split(variantPassName, '.');
+	std::lock_guard<std::mutex> lock(variantManifestMutex);
+	// The first part is the pass, the rest are its shaders.
+	for (size_t i = 1; i < parts.size(); i++)
+	{
+		if (parts[i].find('(') != std::string::npos)
+			variantManifestLines.insert(effect + " " + parts[i]);
+	}
+}
+
+bool VariantManifest::Save(const char *filename_utf8)
+{
+	std::set<std::string> lines;
+	{
+		std::lock_guard<std::mutex> lock(variantManifestMutex);
+		lines = variantManifestLines;
+	}
+	{
+		std::ifstream existing(filename_utf8);
+		std::string line;
+		while (std::getline(existing, line))
+		{
+			if (line.length() && line[0] != '#')
+				lines.insert(line);
+		}
+	}
+	std::ofstream out(filename_utf8);
+	if (!out.good())
+	{
+		SIMUL_CERR << "Can't write variant manifest " << filename_utf8 << std::endl;
+		return false;
+	}
+	out << "# Shader variants used at runtime: effect shader_variant\n";
+	for (const auto &l : lines)
+		out << l << "\n";
+	return out.good();
+}
+
+void VariantManifest::Clear()
+{
+	std::lock_guard<std::mutex> lock(variantManifestMutex);
+	variantManifestLines.clear();
+}
+
 					//if (!crossplatform::LayoutMatches(vertexShader->layout.GetDesc(), meshLayout))
 EffectPass *EffectVariantPass::GetPass(const char *shader1, uint64_t layoutHash, const char *shader2)
 {
+	// If the pixel shader variant is missing, another variant of the same pixel shader can stand in for it.
+	EffectPass *fallback=nullptr;
+	std::string base2=shader2?shader2:"";
+	base2=base2.substr(0,base2.find('('));
 	for(auto i:passes)
 	{
 		auto *vs = i.second->shaders[SHADERTYPE_VERTEX];
@@ -372,23 +480,30 @@ EffectPass *EffectVariantPass::GetPass(const char *shader1, uint64_t layoutHash,
 		if(basename!=shader1)
 			continue;
 		if (!shader2 || (parts.size() >=3&&parts [2] == shader2))
-			return i.second;
+			return Requested(i.first, i.second);
+		if(!fallback&&parts.size()>=3&&parts[2].substr(0,parts[2].find('('))==base2)
+			fallback=i.second;
 	}
-	return nullptr;
+	return Missing(name, fallback, nullptr, shader2);
 }
 
 EffectPass* EffectVariantPass::GetPass(const char *shader1,const char *shader2)
 {
+	EffectPass *fallback=nullptr;
+	std::string base1=shader1;
+	base1=base1.substr(0,base1.find('('));
 	for(auto i:passes)
 	{
 		vector<string> parts=platform::core::split(i.first,'.');
 		if(parts[1]==shader1)
 		{
 			if(!shader2||parts[2]==shader2)
-				return i.second;
+				return Requested(i.first, i.second);
 		}
+		if(!fallback&&parts[1].substr(0,parts[1].find('('))==base1)
+			fallback=i.second;
 	}
-	return nullptr;
+	return Missing(name, fallback, shader1, shader2);
 }
 
 EffectPass *EffectTechnique::GetPass(int i) const
@@ -447,6 +562,16 @@ void Effect::SetUnorderedAccessView(crossplatform::DeviceContext& deviceContext,
 	renderPlatform->SetUnorderedAccessView(deviceContext, res, t, subresource);
 }
 
+void Effect::SetTexture(crossplatform::DeviceContext& deviceContext, const ShaderResourceName &name, crossplatform::Texture* tex, SubresourceRange subresource)
+{
+	renderPlatform->SetTexture(deviceContext, GetShaderResource(name), tex, subresource);
+}
+
+void Effect::SetUnorderedAccessView(crossplatform::DeviceContext& deviceContext, const ShaderResourceName &name, crossplatform::Texture* t, SubresourceLayers subresource)
+{
+	renderPlatform->SetUnorderedAccessView(deviceContext, GetShaderResource(name), t, subresource);
+}
+
 const crossplatform::ShaderResource *Effect::GetShaderResourceAtSlot(int s) 
 {
 	return textureResources[s];
@@ -502,6 +627,19 @@ crossplatform::ShaderResource Effect::GetShaderResource(const char *name)
 	return res;
 }
 
+crossplatform::ShaderResource Effect::GetShaderResource(const ShaderResourceName &name)
+{
+	auto i = shaderResourceCache.find(name.hash);
+	if (i != shaderResourceCache.end())
+	{
+		SIMUL_ASSERT(i->second.name == name.name);
+		return i->second.resource;
+	}
+	ShaderResource res = GetShaderResource(name.name);
+	shaderResourceCache[name.hash] = {name.name, res};
+	return res;
+}
+
 EffectTechnique *Effect::EnsureTechniqueExists(const string &groupname,const string &techname_,const string &passname)
 {
 	EffectTechnique *tech=nullptr;
@@ -999,6 +1137,8 @@ bool Effect::Load(crossplatform::RenderPlatform *r, const char *filename_utf8)
 	}
 	textureDetailsMap.clear();
 	textureCharMap.clear();
+	shaderResourceCache.clear();
+	variantShaderNames.clear();
 	// We will load the .sfxo file, which contains the list of shader binary files, and also the arrangement of textures, buffers etc. in numeric slots.
 	std::vector<std::string> binaryPaths	=renderPlatform->GetShaderBinaryPathsUtf8();
 	std::string filenameUtf8				=filename_utf8;
@@ -1398,6 +1538,12 @@ bool Effect::Load(crossplatform::RenderPlatform *r, const char *filename_utf8)
 				pass_name=line.substr(sp+1,line.length()-sp-1);
 				p=(EffectPass*)tech->AddPass(pass_name.c_str(),passNum);
 				variantPass->passes[pass_name]=p;
+				vector<string> parts=platform::core::split(pass_name,'.');
+				for(size_t k=1;k<parts.size();k++)
+				{
+					if(parts[k].find('(')<parts[k].length())
+						variantShaderNames.insert(parts[k]);
+				}
 				shaderCount=0;
 				layoutCount=0;
 				layoutOffset=0;
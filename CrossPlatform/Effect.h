@@ -15,6 +15,7 @@
 #include <vector>
 #include <set>
 #include <stdint.h>
+#include <type_traits>
 struct ID3DX11Effect;
 struct ID3DX11EffectTechnique;
 struct ID3D11ShaderResourceView;
@@ -25,6 +26,9 @@ struct D3D12_CPU_DESCRIPTOR_HANDLE;
 	#pragma warning(push)
 	#pragma warning(disable:4251)
 #endif
+//! A shader resource name, hashed at compile time, for the Effect functions that take a ShaderResourceName.
+//! e.g. effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),texture);
+#define PLATFORM_SHADER_RESOURCE(name) platform::crossplatform::ShaderResourceName{std::integral_constant<uint64_t,platform::crossplatform::HashShaderResourceName(name)>::value,name}
 namespace platform
 {
 	namespace crossplatform
@@ -262,6 +266,23 @@ namespace platform
 			int					dimensions=-1;
 			bool				valid=false;
 		};
+		//! FNV-1a hash of a shader resource name. Usable at compile time.
+		constexpr uint64_t HashShaderResourceName(const char *name)
+		{
+			uint64_t h=0xcbf29ce484222325ULL;
+			while(*name)
+			{
+				h^=(uint8_t)*name++;
+				h*=0x100000001b3ULL;
+			}
+			return h;
+		}
+		//! A shader resource name with its hash, usually made by PLATFORM_SHADER_RESOURCE.
+		struct ShaderResourceName
+		{
+			uint64_t hash;
+			const char *name;
+		};
 		struct SIMUL_CROSSPLATFORM_EXPORT RaytraceHitGroup
 		{
 			Shader* closestHit=nullptr;
@@ -406,12 +427,28 @@ namespace platform
 			crossplatform::Effect* effect;
 			crossplatform::Topology topology=Topology::UNDEFINED;
 		};
+		//! Records which shader variants the application actually requests from EffectVariantPass::GetPass, so that
+		//! Sfx can be given the saved list with --variant-manifest and compile only those variants.
+		class SIMUL_CROSSPLATFORM_EXPORT VariantManifest
+		{
+		public:
+			//! Start or stop recording. Off by default, when GetPass does no extra work.
+			static void SetRecording(bool r);
+			static bool IsRecording();
+			//! Record the shaders of a variant pass, named as in the sfxo, e.g. "main.vs_main(true).ps_main(1_0)".
+			static void Record(const char *effectName, const std::string &variantPassName);
+			//! Write one "effect shader" line per variant recorded, merged with the lines already in the file.
+			static bool Save(const char *filename_utf8);
+			static void Clear();
+		};
 		class SIMUL_CROSSPLATFORM_EXPORT EffectVariantPass
 		{
 		public:
 			std::string name;
 			std::map<std::string, EffectPass *> passes;
 			//! Get the pass (if it exists) with the specified vertex input layout and named pixel shader.
+			//! With RenderPlatform::SetOnDemandVariantCompile, a missing variant is compiled in the background,
+			//! and meanwhile a pass with the same shaders but another variant is returned.
 			EffectPass *GetPass(const char *shader1, uint64_t layoutHash, const char *pixel_shader);
 			//! Get the pass (if it exists) with the named shaders.
 			EffectPass* GetPass(const char *shader1,const char *shader2=nullptr); 
@@ -538,6 +575,15 @@ namespace platform
 			TextureDetailsMap textureDetailsMap;
 			ShaderResource *textureResources[32]={0};
 			mutable TextureCharMap textureCharMap;
+			struct CachedShaderResource
+			{
+				std::string name;	//!< Kept so that debug builds can check for hash collisions.
+				ShaderResource resource;
+			};
+			//! Resources looked up by ShaderResourceName, including names that were not found. Cleared when the effect loads.
+			phmap::flat_hash_map<uint64_t,CachedShaderResource> shaderResourceCache;
+			//! The shader variants in the sfxo's variant passes.
+			std::set<std::string> variantShaderNames;
 			phmap::flat_hash_map<std::string,crossplatform::SamplerState *> samplerStates;
 			phmap::flat_hash_map<std::string,crossplatform::RenderState *> depthStencilStates;
 			phmap::flat_hash_map<std::string,crossplatform::RenderState *> blendStates;
@@ -580,6 +626,11 @@ namespace platform
 			}
 			virtual void InvalidateDeviceObjects();
 			virtual bool Load(RenderPlatform *renderPlatform,const char *filename_utf8);
+			//! The names of the shader variants that the effect's variant passes use, e.g. "ps_main(1_0)".
+			const std::set<std::string> &GetVariantShaderNames() const
+			{
+				return variantShaderNames;
+			}
 			// Which texture is at this slot. Warning: slow.
 			std::string GetTextureForSlot(int s) const
 			{
@@ -605,6 +656,12 @@ namespace platform
 			virtual void SetUnorderedAccessView(DeviceContext& deviceContext, const char* name, Texture* tex, SubresourceLayers subresource = DefaultSubresourceLayers);
 			//! Obtain the named shader resource in this effect.
 			virtual ShaderResource GetShaderResource(const char* name);
+			//! Obtain the named shader resource, looking the name up only the first time after each load. For per-draw use.
+			ShaderResource GetShaderResource(const ShaderResourceName &name);
+			//! Set the texture by a name from PLATFORM_SHADER_RESOURCE, without a string lookup.
+			void SetTexture(DeviceContext& deviceContext, const ShaderResourceName &name, Texture* tex, SubresourceRange subresource = DefaultSubresourceRange);
+			//! Set the read-write texture by a name from PLATFORM_SHADER_RESOURCE, without a string lookup.
+			void SetUnorderedAccessView(DeviceContext& deviceContext, const ShaderResourceName &name, Texture* tex, SubresourceLayers subresource = DefaultSubresourceLayers);
 			//! Set the texture for this effect.
 			virtual void SetSamplerState(DeviceContext &deviceContext,const ShaderResource &name	,SamplerState *s);
 			//! Activate the shader. Unapply must be called after rendering is done.
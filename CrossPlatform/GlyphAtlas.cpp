@@ -0,0 +1,271 @@
+#include "GlyphAtlas.h"
+#include "Platform/Core/RuntimeError.h"
+#include "Platform/Core/FileLoader.h"
+#include "Platform/CrossPlatform/RenderPlatform.h"
+#include "Platform/CrossPlatform/Texture.h"
+#include "Platform/CrossPlatform/DeviceContext.h"
+#include "Platform/CrossPlatform/Macros.h"
+#include <algorithm>
+#include <cstring>
+#if PLATFORM_USE_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+using namespace platform;
+using namespace crossplatform;
+
+#if PLATFORM_USE_FREETYPE
+static FT_Library glyphAtlasLibrary=nullptr;
+#endif
+
+// One pixel of clear space around each glyph so bilinear lookups don't bleed into neighbours.
+static const int glyphPadding=1;
+static const uint32_t replacementCodepoint=0xFFFD;
+
+GlyphAtlas::GlyphAtlas()
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	InvalidateDeviceObjects();
+#if PLATFORM_USE_FREETYPE
+	if(face)
+		FT_Done_Face((FT_Face)face);
+#endif
+	face=nullptr;
+	if(fontData)
+		core::FileLoader::GetFileLoader()->ReleaseFileContents(fontData);
+	fontData=nullptr;
+}
+
+void GlyphAtlas::RestoreDeviceObjects(RenderPlatform *r,int w,int l)
+{
+	renderPlatform=r;
+	if(w!=width||l!=length)
+	{
+		// A new size invalidates every packed position.
+		width=w;
+		length=l;
+		pixels.assign(size_t(width)*size_t(length)*4,0);
+		glyphs.clear();
+		shelfX=shelfY=shelfHeight=0;
+		full=false;
+	}
+	SAFE_DELETE(texture);
+	texture=renderPlatform->CreateTexture();
+	texture->ensureTexture2DSizeAndFormat(renderPlatform,width,length,1,PixelFormat::RGBA_8_UNORM);
+	dirty=true;
+}
+
+void GlyphAtlas::InvalidateDeviceObjects()
+{
+	SAFE_DELETE(texture);
+	renderPlatform=nullptr;
+}
+
+bool GlyphAtlas::LoadFont(const char *filename_utf8,const std::vector<std::string> &paths,int pixelHeight)
+{
+#if PLATFORM_USE_FREETYPE
+	if(!glyphAtlasLibrary&&FT_Init_FreeType(&glyphAtlasLibrary))
+	{
+		SIMUL_CERR<<"GlyphAtlas: FT_Init_FreeType failed.\n";
+		return false;
+	}
+	core::FileLoader *fileLoader=core::FileLoader::GetFileLoader();
+	std::string filename=fileLoader->FindFileInPathStack(filename_utf8,paths);
+	if(!filename.length())
+		return false;
+	void *data=nullptr;
+	unsigned size=0;
+	fileLoader->AcquireFileContents(data,size,filename.c_str(),false);
+	if(!data)
+		return false;
+	FT_Face newFace=nullptr;
+	FT_Error error=FT_New_Memory_Face(glyphAtlasLibrary,(const FT_Byte*)data,size,0,&newFace);
+	if(error)
+	{
+		SIMUL_CERR<<"GlyphAtlas: error "<<error<<" loading font "<<filename.c_str()<<".\n";
+		fileLoader->ReleaseFileContents(data);
+		return false;
+	}
+	FT_Set_Pixel_Sizes(newFace,0,pixelHeight);
+	if(face)
+		FT_Done_Face((FT_Face)face);
+	if(fontData)
+		fileLoader->ReleaseFileContents(fontData);
+	face=newFace;
+	fontData=data;
+	lineHeight=int(newFace->size->metrics.height>>6);
+	ascender=int(newFace->size->metrics.ascender>>6);
+	// Glyphs from a previous font are no longer valid.
+	glyphs.clear();
+	std::fill(pixels.begin(),pixels.end(),uint8_t(0));
+	shelfX=shelfY=shelfHeight=0;
+	full=false;
+	dirty=true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool GlyphAtlas::HasFont() const
+{
+	return face!=nullptr;
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::GetGlyph(uint32_t codepoint)
+{
+	auto i=glyphs.find(codepoint);
+	if(i!=glyphs.end())
+		return &(i->second);
+	const Glyph *g=Rasterize(codepoint);
+	if(g)
+		return g;
+	if(codepoint!=replacementCodepoint)
+	{
+		g=GetGlyph(replacementCodepoint);
+		if(!g&&codepoint!='?')
+			g=GetGlyph('?');
+	}
+	return g;
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::Rasterize(uint32_t codepoint)
+{
+#if PLATFORM_USE_FREETYPE
+	if(!face||full)
+		return nullptr;
+	FT_Face f=(FT_Face)face;
+	FT_UInt index=FT_Get_Char_Index(f,codepoint);
+	if(!index&&codepoint!=' ')
+		return nullptr;
+	if(FT_Load_Glyph(f,index,FT_LOAD_RENDER))
+		return nullptr;
+	const FT_GlyphSlot slot=f->glyph;
+	const FT_Bitmap &bmp=slot->bitmap;
+	if(bmp.pixel_mode!=FT_PIXEL_MODE_GRAY&&bmp.rows*bmp.width>0)
+		return nullptr;
+	return AddGlyph(codepoint,bmp.buffer,int(bmp.width),int(bmp.rows),bmp.pitch,slot->bitmap_left,slot->bitmap_top,int(slot->advance.x>>6));
+#else
+	return nullptr;
+#endif
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::AddGlyph(uint32_t codepoint,const uint8_t *coverage,int w,int h,int pitch,int bearing_x,int bearing_y,int advance)
+{
+	if(!width||!length)
+		return nullptr;
+	int pw=w+glyphPadding;
+	int ph=h+glyphPadding;
+	if(pw>width||ph>length)
+		return nullptr;
+	// Start a new shelf when this row is exhausted.
+	if(shelfX+pw>width)
+	{
+		shelfY+=shelfHeight;
+		shelfX=0;
+		shelfHeight=0;
+	}
+	if(shelfY+ph>length)
+	{
+		full=true;
+		SIMUL_CERR_ONCE<<"GlyphAtlas is full: "<<glyphs.size()<<" glyphs in "<<width<<"x"<<length<<".\n";
+		return nullptr;
+	}
+	int x=shelfX,y=shelfY;
+	shelfX+=pw;
+	shelfHeight=std::max(shelfHeight,ph);
+	// Store coverage as white with matching alpha, so the atlas can be sampled like the bitmap font.
+	for(int j=0;j<h;j++)
+	{
+		const uint8_t *src=coverage+j*pitch;
+		uint8_t *dst=pixels.data()+(size_t(y+j)*width+x)*4;
+		for(int i=0;i<w;i++)
+		{
+			uint8_t c=src[i];
+			dst[4*i+0]=dst[4*i+1]=dst[4*i+2]=dst[4*i+3]=c;
+		}
+	}
+	Glyph &g=glyphs[codepoint];
+	g.texc=vec4(float(x)/float(width),float(y)/float(length),float(w)/float(width),float(h)/float(length));
+	g.pixel_width=w;
+	g.pixel_height=h;
+	g.bearing_x=bearing_x;
+	g.bearing_y=bearing_y;
+	g.advance=advance;
+	if(w*h>0)
+		dirty=true;
+	return &g;
+}
+
+void GlyphAtlas::Update(DeviceContext &deviceContext)
+{
+	if(!dirty||!texture)
+		return;
+	// setTexels is not guaranteed to honour a sub-range on every API, so the whole atlas goes up.
+	texture->setTexels(deviceContext,pixels.data(),0,width*length);
+	dirty=false;
+}
+
+float GlyphAtlas::GetOccupancy() const
+{
+	if(!length)
+		return 0.0f;
+	return float(std::min(length,shelfY+shelfHeight))/float(length);
+}
+
+uint32_t GlyphAtlas::NextCodepoint(const char *&txt)
+{
+	const uint8_t *s=(const uint8_t*)txt;
+	uint32_t c=s[0];
+	int extra=0;
+	uint32_t minimum=0;
+	if(c<0x80)
+	{
+		txt++;
+		return c;
+	}
+	else if((c&0xE0)==0xC0)
+	{
+		c&=0x1F;
+		extra=1;
+		minimum=0x80;
+	}
+	else if((c&0xF0)==0xE0)
+	{
+		c&=0x0F;
+		extra=2;
+		minimum=0x800;
+	}
+	else if((c&0xF8)==0xF0)
+	{
+		c&=0x07;
+		extra=3;
+		minimum=0x10000;
+	}
+	else
+	{
+		txt++;
+		return replacementCodepoint;
+	}
+	for(int i=1;i<=extra;i++)
+	{
+		// A terminating zero also fails this test, so we never read past the end of the string.
+		if((s[i]&0xC0)!=0x80)
+		{
+			txt++;
+			return replacementCodepoint;
+		}
+		c=(c<<6)|(s[i]&0x3F);
+	}
+	// Reject overlong encodings, surrogates and out-of-range values.
+	if(c<minimum||c>0x10FFFF||(c>=0xD800&&c<=0xDFFF))
+	{
+		txt++;
+		return replacementCodepoint;
+	}
+	txt+=1+extra;
+	return c;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/Shaders/CppSl.sl"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <parallel_hashmap/phmap.h>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		class RenderPlatform;
+		class Texture;
+		struct DeviceContext;
+		//! A dynamically-packed glyph atlas. Glyphs are rasterized on first use and placed into the atlas
+		//! texture by a simple shelf packer; the texture is re-uploaded once per frame when glyphs have been added.
+		//! Rasterization requires FreeType (PLATFORM_USE_FREETYPE); without it, LoadFont() fails and the atlas stays empty.
+		class SIMUL_CROSSPLATFORM_EXPORT GlyphAtlas
+		{
+		public:
+			struct Glyph
+			{
+				vec4 texc;			//!< x,y,w,h of the glyph in normalized atlas coordinates.
+				int pixel_width=0;
+				int pixel_height=0;
+				int bearing_x=0;	//!< Horizontal offset from the pen position to the left of the bitmap.
+				int bearing_y=0;	//!< Vertical offset from the baseline up to the top of the bitmap.
+				int advance=0;		//!< Horizontal pen advance in pixels.
+			};
+			GlyphAtlas();
+			~GlyphAtlas();
+			void RestoreDeviceObjects(RenderPlatform *r,int width=1024,int length=1024);
+			void InvalidateDeviceObjects();
+			//! Load a TrueType/OpenType font from the given path stack and rasterize glyphs at \a pixelHeight. Returns false if no font could be loaded.
+			bool LoadFont(const char *filename_utf8,const std::vector<std::string> &paths,int pixelHeight);
+			bool HasFont() const;
+			//! Get the glyph for a codepoint, rasterizing it into the atlas on first use.
+			//! Returns the replacement glyph if the codepoint is missing from the font, or nullptr if the atlas is full.
+			const Glyph *GetGlyph(uint32_t codepoint);
+			//! Add a glyph from an 8-bit coverage bitmap. Returns nullptr if the atlas has no room left.
+			const Glyph *AddGlyph(uint32_t codepoint,const uint8_t *coverage,int w,int h,int pitch,int bearing_x,int bearing_y,int advance);
+			//! Upload the atlas if glyphs were added since the last call.
+			void Update(DeviceContext &deviceContext);
+			Texture *GetTexture()
+			{
+				return texture;
+			}
+			//! Line height in pixels, and the distance from the top of a line to the baseline.
+			int GetLineHeight() const
+			{
+				return lineHeight;
+			}
+			int GetAscender() const
+			{
+				return ascender;
+			}
+			size_t GetGlyphCount() const
+			{
+				return glyphs.size();
+			}
+			//! Fraction of the atlas rows that have been used so far.
+			float GetOccupancy() const;
+			//! Decode the next UTF-8 codepoint and advance \a txt. Malformed sequences yield U+FFFD and consume one byte.
+			static uint32_t NextCodepoint(const char *&txt);
+		private:
+			const Glyph *Rasterize(uint32_t codepoint);
+			RenderPlatform *renderPlatform=nullptr;
+			Texture *texture=nullptr;
+			std::vector<uint8_t> pixels;
+			int width=0;
+			int length=0;
+			// Shelf packer state.
+			int shelfX=0;
+			int shelfY=0;
+			int shelfHeight=0;
+			bool dirty=false;
+			bool full=false;
+			int lineHeight=16;
+			int ascender=12;
+			phmap::flat_hash_map<uint32_t,Glyph> glyphs;
+			void *face=nullptr;
+			void *fontData=nullptr;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
@@ -304,7 +304,7 @@ void GpuProfiler::WalkEndFrame(crossplatform::DeviceContext &deviceContext,cross
 		return;
 	}
     timer.UpdateTime();
-    queryTime += timer.Time;
+    queryTime += (float)timer.Time;
 
     float time = 0.0f;
     if(disjointData.Disjoint == false)
@@ -312,8 +312,8 @@ void GpuProfiler::WalkEndFrame(crossplatform::DeviceContext &deviceContext,cross
         UINT64 delta = endTime - startTime;
 		if(endTime>startTime)
 		{
-			float frequency = static_cast<float>(disjointData.Frequency);
-			time = (delta / frequency) * 1000.0f;
+			// Timestamps are 64-bit counts that grow with uptime; convert the delta in double precision.
+			time = (float)((double)delta * 1000.0 / (double)disjointData.Frequency);
 		}
 		else
 		{
@@ -96,6 +96,7 @@ void HdrRenderer::LoadShaders()
 	if(!renderPlatform)
 		return;
 	renderPlatform->Destroy(hdr_effect);
+	effectReloadCount			=renderPlatform->GetEffectReloadCount();
 	hdr_effect					=renderPlatform->CreateEffect("hdr");
 
 	exposureGammaTechnique		=hdr_effect->GetTechniqueByName("exposure_gamma");
@@ -123,7 +124,7 @@ void HdrRenderer::Render(GraphicsDeviceContext &deviceContext,crossplatform::Tex
 
 void HdrRenderer::Render(GraphicsDeviceContext &deviceContext,crossplatform::Texture *texture,float offsetX,float Exposure,float Gamma)
 {
-	if(!hdr_effect)
+	if(!hdr_effect||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	SIMUL_COMBINED_PROFILE_START(deviceContext,"HDR")
 	hdrConstants.gamma		=Gamma;
@@ -157,9 +158,9 @@ void HdrRenderer::RenderInfraRed(GraphicsDeviceContext &deviceContext,crossplatf
 	SIMUL_COMBINED_PROFILE_START(deviceContext,"RenderInfraRed")
 	bool msaa=(texture->GetSampleCount()>1);
 	if(msaa)
-		hdr_effect->SetTexture(deviceContext,"imageTextureMS"	,texture);
+		hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTextureMS")	,texture);
 	else
-		hdr_effect->SetTexture(deviceContext,"imageTexture"	,texture);
+		hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture")	,texture);
 	hdrConstants.gamma						=Gamma;
 	hdrConstants.exposure					=Exposure;
 	hdrConstants.infraredIntegrationFactors	=infrared_integration_factors;
@@ -169,8 +170,8 @@ void HdrRenderer::RenderInfraRed(GraphicsDeviceContext &deviceContext,crossplatf
 	hdr_effect->Apply(deviceContext,tech,(msaa?"msaa":"main"));
 	renderPlatform->DrawQuad(deviceContext);
 
-	hdr_effect->SetTexture(deviceContext,"imageTexture",NULL);
-	hdr_effect->SetTexture(deviceContext,"imageTextureMS",NULL);
+	hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),NULL);
+	hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTextureMS"),NULL);
 	hdrConstants.Unbind(deviceContext);
 	imageConstants.Unbind(deviceContext);
 	hdr_effect->Unapply(deviceContext);
@@ -181,8 +182,8 @@ void HdrRenderer::RenderInfraRed(GraphicsDeviceContext &deviceContext,crossplatf
 void HdrRenderer::RenderWithOculusCorrection(GraphicsDeviceContext &deviceContext,crossplatform::Texture *texture
 	,float offsetX,float Exposure,float Gamma)
 {
-hdr_effect->SetTexture(deviceContext,"imageTexture",texture);
-	hdr_effect->SetTexture(deviceContext,"imageTextureMS",texture);
+hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),texture);
+	hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTextureMS"),texture);
 	hdrConstants.gamma				=Gamma;
 	hdrConstants.exposure			=Exposure;
 	
@@ -205,8 +206,8 @@ hdr_effect->SetTexture(deviceContext,"imageTexture",texture);
 	hdr_effect->Apply(deviceContext,warpExposureGamma,0);
 	renderPlatform->DrawQuad(deviceContext);
 	
-	hdr_effect->SetTexture(deviceContext,"imageTexture",NULL);
-	hdr_effect->SetTexture(deviceContext,"imageTextureMS",NULL);
+	hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),NULL);
+	hdr_effect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTextureMS"),NULL);
 	hdrConstants.Unbind(deviceContext);
 	hdr_effect->Unapply(deviceContext);
 }
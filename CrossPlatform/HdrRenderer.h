@@ -41,6 +41,8 @@ namespace platform
 			int Width,Height;
 			//! The HDR tonemapping hlsl effect used to render the hdr buffer to an ldr screen.
 			crossplatform::Effect*				hdr_effect;
+			//! RenderPlatform::GetEffectReloadCount() when the effect was loaded.
+			uint64_t							effectReloadCount=0;
 			crossplatform::EffectTechnique*		exposureGammaTechnique;
 			crossplatform::EffectPass*			exposureGammaMainPass;
 			crossplatform::EffectPass*			exposureGammaMSAAPass;
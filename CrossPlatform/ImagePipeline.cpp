@@ -0,0 +1,478 @@
+#include "Platform/CrossPlatform/ImagePipeline.h"
+#include "Platform/Core/ThreadPool.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PLATFORM_IMAGEPIPELINE_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	// Mips smaller than this are made on the calling thread.
+	const size_t kMinParallelPixels = 64 * 1024;
+	// The smallest number of destination pixels handed to a worker at once.
+	const size_t kPixelsPerJob = 32 * 1024;
+	// The Kaiser filter's half-width in destination texels, and its window parameter.
+	const float kKaiserWidth = 3.0f;
+	const float kKaiserAlpha = 4.0f;
+	const float kPi = 3.14159265358979f;
+
+	float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// Lookup tables for 8-bit channels: to linear floats, and the linear values at which each sRGB byte rounds up to the next.
+	struct ChannelTables
+	{
+		static const int kEncodeSteps = 4096;
+		float srgbToLinear[256];
+		float unormToFloat[256];
+		float srgbThresholds[256];
+		// The sRGB byte for linear values of i/kEncodeSteps. A step is less than one byte wide, so at most one threshold lies inside it.
+		uint8_t linearToSRGB[kEncodeSteps + 1];
+		ChannelTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				srgbToLinear[i] = SRGBToLinear(float(i) / 255.0f);
+				unormToFloat[i] = float(i) / 255.0f;
+			}
+			for (int i = 0; i < 255; i++)
+				srgbThresholds[i] = SRGBToLinear((float(i) + 0.5f) / 255.0f);
+			// Nothing rounds up past 255.
+			srgbThresholds[255] = 2.0f;
+			int b = 0;
+			for (int i = 0; i <= kEncodeSteps; i++)
+			{
+				float v = float(i) / float(kEncodeSteps);
+				while (v > srgbThresholds[b])
+					b++;
+				linearToSRGB[i] = uint8_t(b);
+			}
+		}
+		// Round a linear value to the nearest sRGB byte.
+		uint8_t EncodeSRGB(float v) const
+		{
+			// Written so that NaN becomes zero.
+			v = v >= 0.0f ? (v <= 1.0f ? v : 1.0f) : 0.0f;
+			int b = linearToSRGB[int(v * float(kEncodeSteps))];
+			return uint8_t(b + (v > srgbThresholds[b] ? 1 : 0));
+		}
+	};
+
+	const ChannelTables &Tables()
+	{
+		static ChannelTables tables;
+		return tables;
+	}
+
+	uint8_t EncodeUnorm(float v)
+	{
+		// Written so that NaN becomes zero.
+		v = v >= 0.0f ? (v <= 1.0f ? v : 1.0f) : 0.0f;
+		return uint8_t(v * 255.0f + 0.5f);
+	}
+
+	// Is channel k of an n-channel image sRGB-encoded, if the image is? Alpha, the last of two or four, never is.
+	bool IsColourChannel(int k, int n)
+	{
+		return !((n == 2 || n == 4) && k == n - 1);
+	}
+
+	double BesselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int i = 1; i < 32; i++)
+		{
+			term *= (x * 0.5 / i) * (x * 0.5 / i);
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	double Kaiser(double d)
+	{
+		double x = d / kKaiserWidth;
+		if (x <= -1.0 || x >= 1.0)
+			return 0.0;
+		double sinc = d == 0.0 ? 1.0 : sin(kPi * d) / (kPi * d);
+		return sinc * BesselI0(kKaiserAlpha * sqrt(1.0 - x * x)) / BesselI0(kKaiserAlpha);
+	}
+
+	// The source texels and weights that make each destination texel along one axis, with a fixed number of taps each.
+	// Taps past the edge are clamped to it.
+	struct Contributions
+	{
+		int taps = 0;
+		std::vector<int> index;
+		std::vector<float> weight;
+		// The common case, a box halving an even size: texel x is the mean of 2x and 2x+1.
+		bool halving = false;
+	};
+
+	Contributions MakeContributions(int srcSize, int dstSize, MipFilter filter)
+	{
+		Contributions c;
+		double scale = double(srcSize) / double(dstSize);
+		c.halving = filter == MipFilter::BOX && srcSize == 2 * dstSize;
+		if (filter == MipFilter::BOX)
+			c.taps = int(ceil(scale)) + 1;
+		else
+			c.taps = int(ceil(2.0 * kKaiserWidth * scale)) + 1;
+		c.index.resize(size_t(dstSize) * c.taps);
+		c.weight.resize(size_t(dstSize) * c.taps);
+		for (int x = 0; x < dstSize; x++)
+		{
+			int *index = c.index.data() + size_t(x) * c.taps;
+			float *weight = c.weight.data() + size_t(x) * c.taps;
+			double total = 0.0;
+			int first;
+			if (filter == MipFilter::BOX)
+				first = int(floor(x * scale));
+			else
+				first = int(floor((x + 0.5) * scale - kKaiserWidth * scale));
+			for (int t = 0; t < c.taps; t++)
+			{
+				int i = first + t;
+				double w;
+				if (filter == MipFilter::BOX)
+				{
+					// The overlap of source texel i with the destination texel's footprint.
+					double lo = std::max(double(i), x * scale);
+					double hi = std::min(double(i + 1), (x + 1) * scale);
+					w = std::max(0.0, hi - lo);
+				}
+				else
+				{
+					// Offset between texel centres, in destination texels.
+					w = Kaiser(((i + 0.5) - (x + 0.5) * scale) / scale);
+				}
+				index[t] = std::min(std::max(i, 0), srcSize - 1);
+				weight[t] = float(w);
+				total += w;
+			}
+			for (int t = 0; t < c.taps; t++)
+				weight[t] = float(weight[t] / total);
+		}
+		return c;
+	}
+
+	// Decode a row of 8-bit texels to linear floats.
+	void DecodeRow(const uint8_t *src, float *dst, int width, int channels, bool srgb)
+	{
+		const ChannelTables &tables = Tables();
+		const float *lut[4];
+		for (int k = 0; k < channels; k++)
+			lut[k] = srgb && IsColourChannel(k, channels) ? tables.srgbToLinear : tables.unormToFloat;
+		for (int x = 0; x < width; x++)
+		{
+			for (int k = 0; k < channels; k++)
+				dst[k] = lut[k][src[k]];
+			src += channels;
+			dst += channels;
+		}
+	}
+
+	void EncodeRow(const float *src, uint8_t *dst, int width, int channels, bool srgb)
+	{
+		const ChannelTables &tables = Tables();
+		bool colour[4];
+		for (int k = 0; k < channels; k++)
+			colour[k] = srgb && IsColourChannel(k, channels);
+		for (int x = 0; x < width; x++)
+		{
+			for (int k = 0; k < channels; k++)
+				dst[k] = colour[k] ? tables.EncodeSRGB(src[k]) : EncodeUnorm(src[k]);
+			src += channels;
+			dst += channels;
+		}
+	}
+
+	// Filter a decoded row horizontally, into dstWidth texels.
+	void FilterRow(const float *src, float *dst, int dstWidth, int channels, const Contributions &h)
+	{
+		if (h.halving)
+		{
+			int n = dstWidth * channels;
+			int x = 0;
+			if (channels == 4)
+			{
+#if PLATFORM_IMAGEPIPELINE_SSE2
+				const __m128 half = _mm_set1_ps(0.5f);
+				for (; x + 4 <= n; x += 4)
+					_mm_storeu_ps(dst + x, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + 2 * x), _mm_loadu_ps(src + 2 * x + 4)), half));
+#endif
+				for (; x < n; x++)
+					dst[x] = 0.5f * (src[2 * x - (x & 3)] + src[2 * x - (x & 3) + 4]);
+				return;
+			}
+			for (int i = 0; i < dstWidth; i++)
+			{
+				for (int k = 0; k < channels; k++)
+					dst[i * channels + k] = 0.5f * (src[2 * i * channels + k] + src[(2 * i + 1) * channels + k]);
+			}
+			return;
+		}
+#if PLATFORM_IMAGEPIPELINE_SSE2
+		if (channels == 4)
+		{
+			for (int i = 0; i < dstWidth; i++)
+			{
+				const int *index = h.index.data() + size_t(i) * h.taps;
+				const float *weight = h.weight.data() + size_t(i) * h.taps;
+				__m128 sum = _mm_setzero_ps();
+				for (int t = 0; t < h.taps; t++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + index[t] * 4), _mm_set1_ps(weight[t])));
+				_mm_storeu_ps(dst + i * 4, sum);
+			}
+			return;
+		}
+#endif
+		for (int i = 0; i < dstWidth; i++)
+		{
+			const int *index = h.index.data() + size_t(i) * h.taps;
+			const float *weight = h.weight.data() + size_t(i) * h.taps;
+			float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (int t = 0; t < h.taps; t++)
+			{
+				const float *s = src + index[t] * channels;
+				for (int k = 0; k < channels; k++)
+					sum[k] += weight[t] * s[k];
+			}
+			for (int k = 0; k < channels; k++)
+				dst[i * channels + k] = sum[k];
+		}
+	}
+
+	// acc += w * row, over n floats.
+	void Accumulate(float *acc, const float *row, float w, size_t n)
+	{
+		size_t i = 0;
+#if PLATFORM_IMAGEPIPELINE_SSE2
+		const __m128 ww = _mm_set1_ps(w);
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(row + i), ww)));
+#endif
+		for (; i < n; i++)
+			acc[i] += w * row[i];
+	}
+
+	uint8_t Luminance(const uint8_t *p)
+	{
+		return uint8_t((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+	}
+}
+
+bool ImagePipeline::Decode(const void *src, size_t size, Image &image, int channels)
+{
+	image = Image();
+	if (!src || !size || channels < 0 || channels > 4)
+		return false;
+	int x = 0, y = 0, n = 0;
+	stbi_uc *data = stbi_load_from_memory((const stbi_uc *)src, (int)size, &x, &y, &n, channels);
+	if (!data)
+		return false;
+	image.width = x;
+	image.height = y;
+	image.channels = channels ? channels : n;
+	image.pixels.assign(data, data + size_t(x) * y * image.channels);
+	stbi_image_free(data);
+	return true;
+}
+
+int ImagePipeline::GetFileChannels(const void *src, size_t size)
+{
+	int x = 0, y = 0, n = 0;
+	if (!src || !stbi_info_from_memory((const stbi_uc *)src, (int)size, &x, &y, &n))
+		return 0;
+	return n;
+}
+
+int ImagePipeline::CountNeededChannels(const Image &image)
+{
+	int n = image.channels;
+	if (n != 3 && n != 4)
+		return n;
+	bool grey = true;
+	bool opaque = true;
+	const uint8_t *p = image.pixels.data();
+	size_t count = size_t(image.width) * image.height;
+	for (size_t i = 0; i < count && (grey || opaque); i++, p += n)
+	{
+		grey &= (p[0] == p[1] && p[1] == p[2]);
+		opaque &= (n == 3 || p[3] == 255);
+	}
+	return (grey ? 1 : 3) + (opaque ? 0 : 1);
+}
+
+void ImagePipeline::PackChannels(const Image &src, Image &dst, int channels)
+{
+	int n = src.channels;
+	if (&src == &dst)
+	{
+		Image copy = src;
+		PackChannels(copy, dst, channels);
+		return;
+	}
+	dst.width = src.width;
+	dst.height = src.height;
+	dst.channels = channels;
+	size_t count = size_t(src.width) * src.height;
+	dst.pixels.resize(count * channels);
+	const uint8_t *s = src.pixels.data();
+	uint8_t *d = dst.pixels.data();
+	if (n == channels)
+	{
+		memcpy(d, s, count * n);
+		return;
+	}
+	bool srcColour = n >= 3;
+	bool srcAlpha = n == 2 || n == 4;
+	for (size_t i = 0; i < count; i++, s += n, d += channels)
+	{
+		uint8_t a = srcAlpha ? s[n - 1] : 255;
+		switch (channels)
+		{
+		case 1:
+			d[0] = srcColour ? Luminance(s) : s[0];
+			break;
+		case 2:
+			d[0] = srcColour ? Luminance(s) : s[0];
+			d[1] = a;
+			break;
+		case 3:
+		case 4:
+			d[0] = s[0];
+			d[1] = srcColour ? s[1] : s[0];
+			d[2] = srcColour ? s[2] : s[0];
+			if (channels == 4)
+				d[3] = a;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+int ImagePipeline::CountMips(int width, int height)
+{
+	int m = 1;
+	for (int s = std::max(width, height); s > 1; s >>= 1)
+		m++;
+	return m;
+}
+
+int ImagePipeline::MipSize(int size, int mip)
+{
+	return std::max(1, size >> mip);
+}
+
+void ImagePipeline::Downsample(const Image &src, Image &dst, const MipChainSettings &settings)
+{
+	int c = src.channels;
+	int dw = MipSize(src.width, 1);
+	int dh = MipSize(src.height, 1);
+	dst.width = dw;
+	dst.height = dh;
+	dst.channels = c;
+	dst.pixels.resize(size_t(dw) * dh * c);
+	if (!src.IsValid())
+		return;
+	Contributions h = MakeContributions(src.width, dw, settings.filter);
+	Contributions v = MakeContributions(src.height, dh, settings.filter);
+	const uint8_t *srcPixels = src.pixels.data();
+	uint8_t *dstPixels = dst.pixels.data();
+	int srcWidth = src.width;
+	bool srgb = settings.srgb;
+	// Each destination row is a weighted sum of horizontally-filtered source rows, so rows can be made independently.
+	// Neighbouring rows share source rows when the filter is wider than two texels, so each job keeps the last few it filtered.
+	auto makeRows = [&](size_t begin, size_t end)
+	{
+		size_t rowFloats = size_t(dw) * c;
+		int cacheSize = v.taps + 1;
+		std::vector<float> decoded(size_t(srcWidth) * c);
+		std::vector<float> filtered(rowFloats * cacheSize);
+		std::vector<int> cached(cacheSize, -1);
+		std::vector<float> acc(rowFloats);
+		for (size_t y = begin; y < end; y++)
+		{
+			std::fill(acc.begin(), acc.end(), 0.0f);
+			const int *index = v.index.data() + y * v.taps;
+			const float *weight = v.weight.data() + y * v.taps;
+			for (int t = 0; t < v.taps; t++)
+			{
+				if (weight[t] == 0.0f)
+					continue;
+				int r = index[t];
+				int slot = r % cacheSize;
+				float *row = filtered.data() + slot * rowFloats;
+				if (cached[slot] != r)
+				{
+					DecodeRow(srcPixels + size_t(r) * srcWidth * c, decoded.data(), srcWidth, c, srgb);
+					FilterRow(decoded.data(), row, dw, c, h);
+					cached[slot] = r;
+				}
+				Accumulate(acc.data(), row, weight[t], rowFloats);
+			}
+			EncodeRow(acc.data(), dstPixels + y * rowFloats, dw, c, srgb);
+		}
+	};
+	if (settings.multithreaded && size_t(dw) * dh >= kMinParallelPixels)
+	{
+		size_t rowsPerJob = std::max<size_t>(1, kPixelsPerJob / dw);
+		core::ThreadPool::Get().ParallelFor(dh, rowsPerJob, makeRows);
+	}
+	else
+	{
+		makeRows(0, dh);
+	}
+}
+
+std::vector<Image> ImagePipeline::BuildMipChain(const Image &image, const MipChainSettings &settings)
+{
+	std::vector<Image> mips;
+	if (!image.IsValid())
+		return mips;
+	int count = CountMips(image.width, image.height);
+	if (settings.maxMips > 0)
+		count = std::min(count, settings.maxMips);
+	mips.resize(count);
+	mips[0] = image;
+	// Each mip is made from the one above, which is a quarter of the work of filtering the top level each time.
+	for (int i = 1; i < count; i++)
+		Downsample(mips[i - 1], mips[i], settings);
+	return mips;
+}
+
+void ImagePipeline::AppendInitialData(std::vector<Image> &&mips, std::vector<std::vector<uint8_t>> &data)
+{
+	for (auto &m : mips)
+		data.push_back(std::move(m.pixels));
+	mips.clear();
+}
+
+PixelFormat ImagePipeline::GetPixelFormat(int channels)
+{
+	switch (channels)
+	{
+	case 1:
+		return PixelFormat::R_8_UNORM;
+	case 2:
+		return PixelFormat::RG_8_UNORM;
+	case 3:
+	case 4:
+		return PixelFormat::RGBA_8_UNORM;
+	default:
+		return PixelFormat::UNKNOWN;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/PixelFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! An 8-bit-per-channel image in CPU memory, with tightly-packed rows.
+		struct SIMUL_CROSSPLATFORM_EXPORT Image
+		{
+			int width = 0;
+			int height = 0;
+			int channels = 0;
+			std::vector<uint8_t> pixels;
+			bool IsValid() const
+			{
+				return width > 0 && height > 0 && channels > 0 && channels <= 4 && pixels.size() == size_t(width) * height * channels;
+			}
+		};
+		//! The filter used to make each mip from the one above.
+		enum class MipFilter : uint8_t
+		{
+			//! Each texel is the area-weighted mean of the texels it covers: a 2x2 average for even sizes.
+			BOX,
+			//! A Kaiser-windowed sinc, as NVTT uses: sharper than a box, with a little ringing, which is clamped.
+			KAISER
+		};
+		struct SIMUL_CROSSPLATFORM_EXPORT MipChainSettings
+		{
+			MipFilter filter = MipFilter::BOX;
+			//! The colour channels are sRGB-encoded, so filter them in linear space. Alpha is always linear.
+			//! Turn off for normal maps and other data textures.
+			bool srgb = true;
+			//! The most mips to make, including the top level; zero for the full chain down to 1x1.
+			int maxMips = 0;
+			//! Split the rows of each mip across core::ThreadPool::Get().
+			bool multithreaded = true;
+		};
+		//! CPU-side processing for loaded textures: decode, channel packing, and mip generation.
+		//! Nothing here needs a RenderPlatform, so it can run on any thread and be tested without a GPU.
+		//! The result of BuildMipChain() can be passed as TextureCreate::initialData, to upload all the mips at once
+		//! rather than generating them on the GPU.
+		class SIMUL_CROSSPLATFORM_EXPORT ImagePipeline
+		{
+		public:
+			//! Decode a PNG, JPEG, TGA, BMP etc. file held in memory. Zero channels keeps the number in the file.
+			static bool Decode(const void *src, size_t size, Image &image, int channels = 0);
+			//! The number of channels stored in an encoded file, or zero if it can't be read.
+			static int GetFileChannels(const void *src, size_t size);
+			//! The fewest channels that hold the image without loss, as stb_image counts them: one for grey, two for grey and alpha,
+			//! three for colour, four for colour and alpha. Grey means red, green and blue are equal, and alpha is dropped where it's always 255.
+			static int CountNeededChannels(const Image &image);
+			//! Convert to a different number of channels, as stb_image does: one and two channels are grey and grey-alpha,
+			//! colour becomes grey by its luminance, and a missing alpha is 255.
+			static void PackChannels(const Image &src, Image &dst, int channels);
+			//! The number of mips in a full chain for a width x height image.
+			static int CountMips(int width, int height);
+			//! The size of a mip, as the graphics APIs define it: halved and rounded down, to no less than one.
+			static int MipSize(int size, int mip);
+			//! Make the next mip down from src.
+			static void Downsample(const Image &src, Image &dst, const MipChainSettings &settings = MipChainSettings());
+			//! Make the mip chain of an image, starting with a copy of the image itself.
+			static std::vector<Image> BuildMipChain(const Image &image, const MipChainSettings &settings = MipChainSettings());
+			//! Append each mip's pixels to data, in the order TextureCreate::initialData takes for one layer.
+			static void AppendInitialData(std::vector<Image> &&mips, std::vector<std::vector<uint8_t>> &data);
+			//! The 8-bit unsigned-normalized format for a channel count. There are no three-channel formats, so three gives
+			//! RGBA_8_UNORM and the data must be packed to four first.
+			static PixelFormat GetPixelFormat(int channels);
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
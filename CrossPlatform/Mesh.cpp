@@ -2,6 +2,7 @@
 #include "DeviceContext.h"
 #include "Macros.h"
 #include "Platform/Math/Pi.h"
+#include <algorithm>
 
 using namespace platform;
 using namespace crossplatform;
@@ -107,6 +108,7 @@ bool Mesh::Initialize(crossplatform::RenderPlatform *r,int lPolygonVertexCount,c
 	else
 		init(renderPlatform,numVertices,numIndices,vertices,lIndices);
 	SetSubMesh(0, 0, numIndices, nullptr);
+	CalculateBounds(vertices);
 	delete [] vertices;
 	return true;
 }
@@ -195,6 +197,55 @@ Mesh::SubMesh *Mesh::SetSubMesh(int submesh, int index_start, int num_indices,Ma
 	s->HighestIndex=highest;
 	return s;
 }
+void Mesh::CalculateBounds(const void *vertices)
+{
+	const unsigned char *v = (const unsigned char *)vertices;
+	for (SubMesh *s : mSubMeshes)
+	{
+		s->bounds = AABB();
+		s->sphere = BoundingSphere();
+		if (!v || !stride || s->HighestIndex < s->LowestIndex || s->HighestIndex >= (int)numVertices)
+			continue;
+		for (int i = s->LowestIndex; i <= s->HighestIndex; i++)
+			s->bounds.Extend(*((const vec3 *)(v + (size_t)i * stride)));
+		// Centre the sphere on the box, which is a good fit for most meshes, and take the furthest vertex as its radius.
+		s->sphere.centre = s->bounds.GetCentre();
+		float r2 = 0.0f;
+		for (int i = s->LowestIndex; i <= s->HighestIndex; i++)
+		{
+			vec3 d = *((const vec3 *)(v + (size_t)i * stride)) - s->sphere.centre;
+			r2 = std::max(r2, d.x * d.x + d.y * d.y + d.z * d.z);
+		}
+		s->sphere.radius = sqrtf(r2);
+	}
+	CalculateNodeBounds(rootNode);
+}
+
+void Mesh::CalculateNodeBounds(SubNode &subNode)
+{
+	subNode.bounds = AABB();
+	for (int i : subNode.subMeshes)
+	{
+		const SubMesh *s = GetSubMesh(i);
+		if (s)
+			subNode.bounds.Extend(s->bounds);
+	}
+	for (SubNode &child : subNode.children)
+	{
+		CalculateNodeBounds(child);
+		// The same matrix that MeshRenderer pushes for the child.
+		auto mat = child.orientation.GetMatrix();
+		mat.Transpose();
+		subNode.bounds.Extend(child.bounds.Transformed(mat));
+	}
+	subNode.sphere = BoundingSphere();
+	if (!subNode.bounds.IsEmpty())
+	{
+		subNode.sphere.centre = subNode.bounds.GetCentre();
+		subNode.sphere.radius = length(subNode.bounds.GetExtents());
+	}
+}
+
 int crossplatform::Mesh::GetSubMeshCount() const
 {
 	return (int)mSubMeshes.size();
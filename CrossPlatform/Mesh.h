@@ -9,9 +9,11 @@
 #include "Platform/CrossPlatform/Buffer.h"
 #include "Platform/CrossPlatform/Topology.h"
 #include "Platform/CrossPlatform/AxesStandard.h"
+#include "Platform/CrossPlatform/BoundingVolume.h"
 #include "Platform/CrossPlatform/Shaders/CppSl.sl"
 #include "Platform/CrossPlatform/Shaders/solid_constants.sl"
 #include "Platform/Math/Orientation.h"
+#include <algorithm>
 
 #ifdef _MSC_VER
 	#pragma warning(push)
@@ -25,6 +27,9 @@ namespace platform
 	{
 		struct DeviceContext;
 		class RenderPlatform;
+		struct MeshCacheContents;
+		struct MeshCacheMaterial;
+		struct MeshOptimizationSettings;
 		// Save mesh vertices, normals, UVs and indices in GPU with OpenGL Vertex Buffer Objects
 		class SIMUL_CROSSPLATFORM_EXPORT Mesh
 		{
@@ -36,7 +41,13 @@ namespace platform
 			Mesh(crossplatform::RenderPlatform* r);
 			virtual ~Mesh();
 			void InvalidateDeviceObjects();
+			//! Load a mesh file. The converted mesh is cached in a binary file beside it, which later loads use instead of the importer
+			//! for as long as the source file and the import settings are unchanged.
 			void Load(const char *filename,float scale=1.0f, AxesStandard fromStandard=AxesStandard::Engineering);
+			//! Turn the binary cache used by Load() on or off for all meshes. On by default.
+			static void SetMeshCacheEnabled(bool e);
+			//! Set the optimisations that Load() applies to newly-imported meshes, for all meshes. None by default.
+			static void SetImportOptimization(const MeshOptimizationSettings &s);
 			void Initialize(crossplatform::RenderPlatform *renderPlatform,crossplatform::MeshType m);
 			bool Initialize(crossplatform::RenderPlatform *renderPlatform
 				,int lPolygonVertexCount,const float *lVertices,const float *lNormals,const float *lUVs
@@ -73,12 +84,46 @@ namespace platform
 				enum DrawAs { AS_TRIANGLES, AS_TRISTRIP };
 				DrawAs drawAs;
 				Material* material;
+				//! Bounds of the submesh's vertices, in mesh space.
+				AABB bounds;
+				BoundingSphere sphere;
+				//! Levels of detail, including the submesh itself as level zero.
+				static const int MAX_LODS = 8;
+				//! A simplified version of the submesh, in the same index buffer, using the same vertex range.
+				struct Lod
+				{
+					int IndexOffset=0;
+					int TriangleCount=0;
+					float error=0.0f;	//!< How far the surface moved, relative to the size of the submesh.
+				};
+				//! Levels 1 and up, each with fewer triangles than the last.
+				std::vector<Lod> lods;
+				int GetLodCount() const
+				{
+					return 1+(int)lods.size();
+				}
+				//! The index range to draw for a level, clamped to the levels there are.
+				void GetLodRange(int lod,int &indexOffset,int &triangleCount) const
+				{
+					if(lod<=0||lods.empty())
+					{
+						indexOffset=IndexOffset;
+						triangleCount=TriangleCount;
+						return;
+					}
+					const Lod &l=lods[std::min(lod,(int)lods.size())-1];
+					indexOffset=l.IndexOffset;
+					triangleCount=l.TriangleCount;
+				}
 			};
 			struct SubNode
 			{
 				std::vector<int> subMeshes;
 				platform::math::SimulOrientation orientation;
 				std::vector<SubNode> children;
+				//! Bounds of this node's submeshes and all its children, in the node's own space, i.e. before its orientation is applied.
+				AABB bounds;
+				BoundingSphere sphere;
 			};
 			SubMesh *SetSubMesh(int submesh,int index_start,int num_indices,Material *m,int lowest=-1,int highest=-1);
 			
@@ -117,7 +162,20 @@ namespace platform
 			{
 			return layout;
 			}
+			//! Bounds of the whole hierarchy under the root node, in mesh space.
+			const AABB &GetBounds() const
+			{
+				return rootNode.bounds;
+			}
 		protected:
+			//! Calculate the bounds of every submesh and node, given the vertex data, with positions as the first three floats of each vertex.
+			void CalculateBounds(const void *vertices);
+			void CalculateNodeBounds(SubNode &subNode);
+			//! Create the materials, and start loading their textures, with texture paths relative to the mesh file.
+			std::vector<Material*> CreateMaterials(const char *filenameUtf8,const std::vector<MeshCacheMaterial> &materials);
+			//! Create the buffers, submeshes and nodes from imported or cached data, using materials from CreateMaterials().
+			void CreateFromContents(const char *filenameUtf8,const MeshCacheContents &contents,const std::vector<Material*> &materials);
+			void CreateNode(const MeshCacheContents &contents,SubNode &subNode,uint32_t &node);
 			void DrawSubNode(GraphicsDeviceContext& deviceContext, const SubNode& subNode) const;
 			SubNode rootNode;
 			void releaseBuffers();
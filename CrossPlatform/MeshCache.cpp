@@ -0,0 +1,319 @@
+#include "Platform/CrossPlatform/MeshCache.h"
+#include "Platform/Core/FileLoader.h"
+#include "Platform/Core/Hash.h"
+#include "Platform/Core/RuntimeError.h"
+#include <cstring>
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	const char meshCacheMagic[4] = {'S', 'M', 'C', 'F'};
+	// Increment when the file layout, MeshVertex or the way the importer fills the data changes.
+	const uint32_t meshCacheFileVersion = 3;
+	const size_t meshCacheAlignment = 16;
+	// All fields are little-endian, as written by every platform we support.
+	struct MeshCacheFileHeader
+	{
+		char		magic[4];
+		uint32_t	fileVersion;
+		uint64_t	sourceHash;
+		uint64_t	optimizeFlags;
+		uint32_t	importFlags;
+		float		scale;
+		uint32_t	axesStandard;
+		uint32_t	vertexFormat;
+		uint32_t	vertexSize;
+		uint32_t	numVertices;
+		uint32_t	numIndices;
+		uint32_t	numSubMeshes;
+		uint32_t	numNodes;
+		uint32_t	numNodeSubMeshes;
+		uint32_t	numMaterials;
+		uint32_t	numLods;
+		uint64_t	vertexOffset;
+		uint64_t	indexOffset;
+		uint64_t	subMeshOffset;
+		uint64_t	nodeOffset;
+		uint64_t	nodeSubMeshOffset;
+		uint64_t	lodOffset;
+		uint64_t	materialOffset;
+		uint64_t	stringOffset;
+		uint64_t	stringSize;
+	};
+	static_assert(sizeof(MeshCacheFileHeader) == 144, "MeshCacheFileHeader must have no implicit padding.");
+	static_assert(sizeof(MeshVertex) == 56, "MeshVertex must match the layout that Mesh creates.");
+	static_assert(sizeof(MeshVertexQuantized) == 28, "MeshVertexQuantized must match the layout that Mesh creates.");
+	static_assert(sizeof(MeshCacheNode) == 80, "MeshCacheNode must have no implicit padding.");
+	static_assert(sizeof(MeshCacheLod) == 16, "MeshCacheLod must have no implicit padding.");
+	// A material, with its strings as offsets into the string table.
+	struct MeshCacheMaterialRecord
+	{
+		uint32_t	nameOffset;
+		uint32_t	nameLength;
+		float		albedo[3];
+		float		emissive[3];
+		float		metal;
+		float		roughness;
+		float		ambientOcclusion;
+		uint32_t	mipFlags;
+		uint32_t	textureOffset[MeshCacheMaterial::NUM_TEXTURES];
+		uint32_t	textureLength[MeshCacheMaterial::NUM_TEXTURES];
+	};
+	size_t Align(size_t o)
+	{
+		return (o + meshCacheAlignment - 1) & ~(meshCacheAlignment - 1);
+	}
+}
+
+size_t platform::crossplatform::GetMeshVertexSize(MeshVertexFormat f)
+{
+	return f == MeshVertexFormat::QUANTIZED ? sizeof(MeshVertexQuantized) : sizeof(MeshVertex);
+}
+
+MeshCache::MeshCache()
+{
+}
+
+MeshCache::~MeshCache()
+{
+	Close();
+}
+
+std::string MeshCache::GetCacheFilename(const char *source_filename_utf8)
+{
+	return std::string(source_filename_utf8) + ".meshcache";
+}
+
+uint64_t MeshCache::HashFile(const char *filename_utf8)
+{
+	core::FileLoader *fileLoader = core::FileLoader::GetFileLoader();
+	if (!fileLoader->FileExists(filename_utf8))
+		return 0;
+	void *ptr = nullptr;
+	unsigned bytes = 0;
+	fileLoader->AcquireFileContents(ptr, bytes, filename_utf8, false);
+	if (!ptr)
+		return 0;
+	uint64_t h = core::HashBytes(ptr, bytes);
+	fileLoader->ReleaseFileContents(ptr);
+	return h;
+}
+
+bool MeshCache::Write(const char *filename_utf8, const MeshCacheKey &key, const MeshCacheContents &c)
+{
+	std::string strings;
+	std::vector<MeshCacheMaterialRecord> materials(c.materials.size());
+	auto AddString = [&strings](const std::string &s, uint32_t &offset, uint32_t &length)
+	{
+		offset = (uint32_t)strings.size();
+		length = (uint32_t)s.length();
+		strings += s;
+	};
+	for (size_t i = 0; i < c.materials.size(); i++)
+	{
+		const MeshCacheMaterial &m = c.materials[i];
+		MeshCacheMaterialRecord &r = materials[i];
+		memset(&r, 0, sizeof(r));
+		AddString(m.name, r.nameOffset, r.nameLength);
+		memcpy(r.albedo, &m.albedo, sizeof(r.albedo));
+		memcpy(r.emissive, &m.emissive, sizeof(r.emissive));
+		r.metal = m.metal;
+		r.roughness = m.roughness;
+		r.ambientOcclusion = m.ambientOcclusion;
+		r.mipFlags = m.mipFlags;
+		for (int t = 0; t < MeshCacheMaterial::NUM_TEXTURES; t++)
+			AddString(m.textures[t], r.textureOffset[t], r.textureLength[t]);
+	}
+	MeshCacheFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, meshCacheMagic, 4);
+	header.fileVersion = meshCacheFileVersion;
+	header.sourceHash = key.sourceHash;
+	header.importFlags = key.importFlags;
+	header.scale = key.scale;
+	header.axesStandard = key.axesStandard;
+	header.optimizeFlags = key.optimizeFlags;
+	header.vertexFormat = (uint32_t)c.vertexFormat;
+	const size_t vertexSize = GetMeshVertexSize(c.vertexFormat);
+	header.vertexSize = (uint32_t)vertexSize;
+	header.numVertices = c.numVertices;
+	header.numIndices = c.numIndices;
+	header.numSubMeshes = c.numSubMeshes;
+	header.numNodes = c.numNodes;
+	header.numNodeSubMeshes = c.numNodeSubMeshes;
+	header.numMaterials = (uint32_t)materials.size();
+	header.numLods = c.numLods;
+	size_t o = Align(sizeof(header));
+	header.vertexOffset = o;
+	o = Align(o + vertexSize * c.numVertices);
+	header.indexOffset = o;
+	o = Align(o + sizeof(uint32_t) * c.numIndices);
+	header.subMeshOffset = o;
+	o = Align(o + sizeof(MeshCacheSubMesh) * c.numSubMeshes);
+	header.nodeOffset = o;
+	o = Align(o + sizeof(MeshCacheNode) * c.numNodes);
+	header.nodeSubMeshOffset = o;
+	o = Align(o + sizeof(uint32_t) * c.numNodeSubMeshes);
+	header.lodOffset = o;
+	o = Align(o + sizeof(MeshCacheLod) * c.numLods);
+	header.materialOffset = o;
+	o = Align(o + sizeof(MeshCacheMaterialRecord) * materials.size());
+	header.stringOffset = o;
+	header.stringSize = strings.size();
+	o += strings.size();
+	if (o > 0xFFFFFFFFull)
+	{
+		SIMUL_CERR << "MeshCache: " << filename_utf8 << " would be too large to save.\n";
+		return false;
+	}
+	std::vector<uint8_t> file(o, 0);
+	auto Copy = [&file](uint64_t offset, const void *src, size_t size)
+	{
+		if (size)
+			memcpy(file.data() + offset, src, size);
+	};
+	Copy(0, &header, sizeof(header));
+	Copy(header.vertexOffset, c.vertices, vertexSize * c.numVertices);
+	Copy(header.indexOffset, c.indices, sizeof(uint32_t) * c.numIndices);
+	Copy(header.subMeshOffset, c.subMeshes, sizeof(MeshCacheSubMesh) * c.numSubMeshes);
+	Copy(header.nodeOffset, c.nodes, sizeof(MeshCacheNode) * c.numNodes);
+	Copy(header.nodeSubMeshOffset, c.nodeSubMeshes, sizeof(uint32_t) * c.numNodeSubMeshes);
+	Copy(header.lodOffset, c.lods, sizeof(MeshCacheLod) * c.numLods);
+	Copy(header.materialOffset, materials.data(), sizeof(MeshCacheMaterialRecord) * materials.size());
+	Copy(header.stringOffset, strings.data(), strings.size());
+	return core::FileLoader::GetFileLoader()->Save(file.data(), (unsigned)file.size(), filename_utf8, false);
+}
+
+bool MeshCache::Open(const char *filename_utf8, const MeshCacheKey &key, std::string *reason)
+{
+	auto Fail = [this, reason](const char *r)
+	{
+		Close();
+		if (reason)
+			*reason = r;
+		return false;
+	};
+	Close();
+	core::FileLoader *fileLoader = core::FileLoader::GetFileLoader();
+	if (!fileLoader->FileExists(filename_utf8))
+		return Fail("no cache file");
+	fileLoader->AcquireFileContents(fileData, fileSize, filename_utf8, false);
+	if (!fileData || fileSize < sizeof(MeshCacheFileHeader))
+		return Fail("file is too small");
+	MeshCacheFileHeader header;
+	memcpy(&header, fileData, sizeof(header));
+	if (memcmp(header.magic, meshCacheMagic, 4) != 0)
+		return Fail("not a mesh cache file");
+	if (header.fileVersion != meshCacheFileVersion || header.vertexFormat > (uint32_t)MeshVertexFormat::QUANTIZED
+		|| header.vertexSize != GetMeshVertexSize((MeshVertexFormat)header.vertexFormat))
+		return Fail("unsupported file version");
+	if (header.sourceHash != key.sourceHash)
+		return Fail("the source file has changed");
+	if (header.importFlags != key.importFlags || header.scale != key.scale || header.axesStandard != key.axesStandard
+		|| header.optimizeFlags != key.optimizeFlags)
+		return Fail("different import settings");
+	// Every array must lie within the file.
+	auto InFile = [this](uint64_t offset, uint64_t size)
+	{
+		return offset % meshCacheAlignment == 0 && offset <= fileSize && size <= fileSize - offset;
+	};
+	if (!InFile(header.vertexOffset, (uint64_t)header.vertexSize * header.numVertices)
+		|| !InFile(header.indexOffset, sizeof(uint32_t) * (uint64_t)header.numIndices)
+		|| !InFile(header.subMeshOffset, sizeof(MeshCacheSubMesh) * (uint64_t)header.numSubMeshes)
+		|| !InFile(header.nodeOffset, sizeof(MeshCacheNode) * (uint64_t)header.numNodes)
+		|| !InFile(header.nodeSubMeshOffset, sizeof(uint32_t) * (uint64_t)header.numNodeSubMeshes)
+		|| !InFile(header.lodOffset, sizeof(MeshCacheLod) * (uint64_t)header.numLods)
+		|| !InFile(header.materialOffset, sizeof(MeshCacheMaterialRecord) * (uint64_t)header.numMaterials)
+		|| header.stringOffset > fileSize || header.stringSize > fileSize - header.stringOffset)
+		return Fail("truncated data");
+	const uint8_t *data = (const uint8_t *)fileData;
+	contents.vertices = data + header.vertexOffset;
+	contents.vertexFormat = (MeshVertexFormat)header.vertexFormat;
+	contents.numVertices = header.numVertices;
+	contents.indices = (const uint32_t *)(data + header.indexOffset);
+	contents.numIndices = header.numIndices;
+	contents.subMeshes = (const MeshCacheSubMesh *)(data + header.subMeshOffset);
+	contents.numSubMeshes = header.numSubMeshes;
+	contents.nodes = (const MeshCacheNode *)(data + header.nodeOffset);
+	contents.numNodes = header.numNodes;
+	contents.nodeSubMeshes = (const uint32_t *)(data + header.nodeSubMeshOffset);
+	contents.numNodeSubMeshes = header.numNodeSubMeshes;
+	contents.lods = (const MeshCacheLod *)(data + header.lodOffset);
+	contents.numLods = header.numLods;
+	const char *strings = (const char *)(data + header.stringOffset);
+	auto GetString = [strings, &header](uint32_t offset, uint32_t length, std::string &s)
+	{
+		if ((uint64_t)offset + length > header.stringSize)
+			return false;
+		s.assign(strings + offset, length);
+		return true;
+	};
+	const MeshCacheMaterialRecord *records = (const MeshCacheMaterialRecord *)(data + header.materialOffset);
+	contents.materials.resize(header.numMaterials);
+	for (uint32_t i = 0; i < header.numMaterials; i++)
+	{
+		MeshCacheMaterialRecord r;
+		memcpy(&r, records + i, sizeof(r));
+		MeshCacheMaterial &m = contents.materials[i];
+		if (!GetString(r.nameOffset, r.nameLength, m.name))
+			return Fail("bad material name");
+		m.albedo = vec3(r.albedo[0], r.albedo[1], r.albedo[2]);
+		m.emissive = vec3(r.emissive[0], r.emissive[1], r.emissive[2]);
+		m.metal = r.metal;
+		m.roughness = r.roughness;
+		m.ambientOcclusion = r.ambientOcclusion;
+		m.mipFlags = r.mipFlags;
+		for (int t = 0; t < MeshCacheMaterial::NUM_TEXTURES; t++)
+		{
+			if (!GetString(r.textureOffset[t], r.textureLength[t], m.textures[t]))
+				return Fail("bad texture name");
+		}
+	}
+	// Check the references between arrays, so that a corrupt file can't index out of range.
+	for (uint32_t i = 0; i < contents.numSubMeshes; i++)
+	{
+		const MeshCacheSubMesh &s = contents.subMeshes[i];
+		if (s.indexOffset < 0 || s.triangleCount < 0 || (uint64_t)s.indexOffset + 3 * (uint64_t)s.triangleCount > contents.numIndices
+			|| s.material < -1 || s.material >= (int32_t)header.numMaterials)
+			return Fail("bad submesh");
+	}
+	uint64_t children = 0;
+	for (uint32_t i = 0; i < contents.numNodes; i++)
+	{
+		const MeshCacheNode &n = contents.nodes[i];
+		if ((uint64_t)n.firstSubMesh + n.numSubMeshes > contents.numNodeSubMeshes)
+			return Fail("bad node");
+		children += n.numChildren;
+	}
+	if (contents.numNodes && children != contents.numNodes - 1)
+		return Fail("bad node hierarchy");
+	for (uint32_t i = 0; i < contents.numNodeSubMeshes; i++)
+	{
+		if (contents.nodeSubMeshes[i] >= contents.numSubMeshes)
+			return Fail("bad node submesh");
+	}
+	for (uint32_t i = 0; i < contents.numLods; i++)
+	{
+		const MeshCacheLod &l = contents.lods[i];
+		if (l.subMesh < 0 || l.subMesh >= (int32_t)contents.numSubMeshes || (i && l.subMesh < contents.lods[i - 1].subMesh)
+			|| l.indexOffset < 0 || l.triangleCount < 0 || (uint64_t)l.indexOffset + 3 * (uint64_t)l.triangleCount > contents.numIndices)
+			return Fail("bad LOD");
+	}
+	for (uint32_t i = 0; i < contents.numIndices; i++)
+	{
+		if (contents.indices[i] >= contents.numVertices)
+			return Fail("bad index");
+	}
+	return true;
+}
+
+void MeshCache::Close()
+{
+	if (fileData)
+		core::FileLoader::GetFileLoader()->ReleaseFileContents(fileData);
+	fileData = nullptr;
+	fileSize = 0;
+	contents = MeshCacheContents();
+}
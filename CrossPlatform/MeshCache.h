@@ -0,0 +1,142 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/Shaders/CppSl.sl"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! A vertex as Mesh::Load() stores it.
+		struct MeshVertex
+		{
+			vec3 pos;
+			vec3 normal;
+			vec4 tangent;
+			vec2 texc0;
+			vec2 texc1;
+		};
+		//! A compact vertex with the same attributes: normals and tangents as 8-bit SNORM, texture coordinates as half-floats.
+		//! The GPU expands these on fetch, so shaders read it exactly as they read MeshVertex.
+		struct MeshVertexQuantized
+		{
+			vec3 pos;
+			int8_t normal[4];
+			int8_t tangent[4];
+			uint16_t texc0[2];
+			uint16_t texc1[2];
+		};
+		enum class MeshVertexFormat : uint32_t
+		{
+			FULL = 0,		//!< MeshVertex
+			QUANTIZED = 1	//!< MeshVertexQuantized
+		};
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t GetMeshVertexSize(MeshVertexFormat f);
+		//! What a cache was made from. A cache is only used if every field matches.
+		struct MeshCacheKey
+		{
+			uint64_t sourceHash = 0;
+			uint32_t importFlags = 0;
+			float scale = 1.0f;
+			uint32_t axesStandard = 0;
+			uint64_t optimizeFlags = 0;	//!< From MeshOptimizationSettings::GetFlags().
+		};
+		struct MeshCacheSubMesh
+		{
+			int32_t indexOffset;
+			int32_t triangleCount;
+			int32_t lowestIndex;
+			int32_t highestIndex;
+			int32_t material;		//!< Index into the materials, or -1.
+		};
+		//! A simplified version of a submesh, drawn in its place at a distance. The submesh itself is level zero; the levels
+		//! after it are stored in order, each with fewer triangles, using the same vertices.
+		struct MeshCacheLod
+		{
+			int32_t subMesh;
+			int32_t indexOffset;
+			int32_t triangleCount;
+			float error;			//!< How far the surface moved, relative to the size of the submesh.
+		};
+		//! One node of the hierarchy. Nodes are stored depth-first: each is followed by the subtrees of its children.
+		struct MeshCacheNode
+		{
+			float transform[16];	//!< As passed to SimulOrientation::Define().
+			uint32_t firstSubMesh;	//!< Index into the node submesh list.
+			uint32_t numSubMeshes;
+			uint32_t numChildren;
+			uint32_t pad;
+		};
+		//! A material as imported: enough to recreate it without the source file.
+		struct MeshCacheMaterial
+		{
+			enum
+			{
+				ALBEDO = 0, NORMAL, METAL, AMBIENT_OCCLUSION, EMISSIVE, NUM_TEXTURES
+			};
+			std::string name;
+			vec3 albedo = vec3(1.0f, 1.0f, 1.0f);
+			vec3 emissive = vec3(0, 0, 0);
+			float metal = 0.0f;
+			float roughness = 1.0f;
+			float ambientOcclusion = 1.0f;
+			std::string textures[NUM_TEXTURES];
+			uint32_t mipFlags = 0;	//!< Bit i set if textures[i] should have mips generated.
+		};
+		//! A view of a mesh's data, in a cache file or in the importer's arrays.
+		struct MeshCacheContents
+		{
+			const void *vertices = nullptr;	//!< MeshVertex or MeshVertexQuantized, according to the vertexFormat.
+			MeshVertexFormat vertexFormat = MeshVertexFormat::FULL;
+			uint32_t numVertices = 0;
+			const uint32_t *indices = nullptr;
+			uint32_t numIndices = 0;
+			const MeshCacheSubMesh *subMeshes = nullptr;
+			uint32_t numSubMeshes = 0;
+			const MeshCacheNode *nodes = nullptr;
+			uint32_t numNodes = 0;
+			const uint32_t *nodeSubMeshes = nullptr;
+			uint32_t numNodeSubMeshes = 0;
+			const MeshCacheLod *lods = nullptr;	//!< Sorted by submesh, then by level.
+			uint32_t numLods = 0;
+			std::vector<MeshCacheMaterial> materials;
+		};
+		//! A binary file holding an imported mesh, so that later loads can skip the importer.
+		//! The file is a header followed by the vertex, index, submesh, node and LOD arrays, each 16-byte aligned, so
+		//! that they are used in place: Open() reads the file once and the contents point into it.
+		class SIMUL_CROSSPLATFORM_EXPORT MeshCache
+		{
+		public:
+			MeshCache();
+			~MeshCache();
+			//! The cache for a source file is written next to it.
+			static std::string GetCacheFilename(const char *source_filename_utf8);
+			//! core::HashBytes() of the file's contents, or zero if it can't be read.
+			static uint64_t HashFile(const char *filename_utf8);
+			static bool Write(const char *filename_utf8, const MeshCacheKey &key, const MeshCacheContents &contents);
+			//! Read the file, and check that it was made with the same key. On failure, \a reason says why.
+			//! The contents stay valid until Close().
+			bool Open(const char *filename_utf8, const MeshCacheKey &key, std::string *reason = nullptr);
+			void Close();
+			const MeshCacheContents &GetContents() const
+			{
+				return contents;
+			}
+		private:
+			void *fileData = nullptr;
+			unsigned fileSize = 0;
+			MeshCacheContents contents;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
@@ -2,10 +2,63 @@
 #include "Macros.h"
 #include "Platform/CrossPlatform/Material.h"
 #include "Platform/CrossPlatform/AxesStandard.h"
+#include "Platform/CrossPlatform/MeshCache.h"
+#include "Platform/CrossPlatform/MeshOptimize.h"
 #include "Platform/Core/StringFunctions.h"
+#include "Platform/Core/FileLoader.h"
+#include "Platform/Core/ThreadPool.h"
+#include "Platform/Core/Timer.h"
+#include <cstring>
+#include <functional>
+#include <sstream>
 using namespace platform;
 using namespace crossplatform;
 
+namespace
+{
+	// The importer's post-processing steps: CalcTangentSpace | JoinIdenticalVertices | Triangulate | SortByPType.
+	// Part of the cache key, so defined here for builds without the importer, which can still read caches.
+	const uint32_t meshImportFlags=0x800B;
+	bool meshCacheEnabled=true;
+	MeshOptimizationSettings meshOptimizationSettings;
+	// A mesh as converted from the importer's scene, before it is put into the cache and into a Mesh.
+	struct ImportedMesh
+	{
+		std::vector<MeshVertex>			vertices;
+		std::vector<MeshVertexQuantized>	quantizedVertices;
+		std::vector<uint32_t>			indices;
+		std::vector<MeshCacheSubMesh>	subMeshes;
+		std::vector<MeshCacheNode>		nodes;
+		std::vector<uint32_t>			nodeSubMeshes;
+		std::vector<MeshCacheLod>		lods;
+		std::vector<MeshCacheMaterial>	materials;
+		MeshCacheContents GetContents() const
+		{
+			MeshCacheContents c;
+			if(quantizedVertices.size())
+			{
+				c.vertices=quantizedVertices.data();
+				c.vertexFormat=MeshVertexFormat::QUANTIZED;
+			}
+			else
+				c.vertices=vertices.data();
+			c.numVertices=(uint32_t)vertices.size();
+			c.indices=indices.data();
+			c.numIndices=(uint32_t)indices.size();
+			c.subMeshes=subMeshes.data();
+			c.numSubMeshes=(uint32_t)subMeshes.size();
+			c.nodes=nodes.data();
+			c.numNodes=(uint32_t)nodes.size();
+			c.nodeSubMeshes=nodeSubMeshes.data();
+			c.numNodeSubMeshes=(uint32_t)nodeSubMeshes.size();
+			c.lods=lods.data();
+			c.numLods=(uint32_t)lods.size();
+			c.materials=materials;
+			return c;
+		}
+	};
+}
+
 #if PLATFORM_USE_ASSIMP
 #include <assimp/Importer.hpp>      // C++ importer interface
 #include <assimp/scene.h>           // Output data structure
@@ -21,37 +74,36 @@ using namespace crossplatform;
 #endif
 using namespace Assimp;
 
-void CopyNodesWithMeshes(Mesh *mesh,aiNode &node, Mesh::SubNode &subNode,float scale, AxesStandard fromStandard,AxesStandard toStandard,size_t &numNodes)
+static void CopyNodesWithMeshes(aiNode &node,ImportedMesh &imported,float scale, AxesStandard fromStandard,AxesStandard toStandard)
 {
-	static aiMatrix4x4 identity(1.0f, 0.0f, 0.0f, 0.0f,
-		0.0f, 1.0f, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		0.0f, 0.0f, 0.0f, 1.0f);
-	numNodes++;
+	// Nodes are stored depth-first, so the children follow their parent.
+	MeshCacheNode n;
+	memset(&n,0,sizeof(n));
+	n.firstSubMesh=(uint32_t)imported.nodeSubMeshes.size();
+	n.numSubMeshes=node.mNumMeshes;
+	n.numChildren=node.mNumChildren;
 	// copy the meshes
-	subNode.subMeshes.resize(node.mNumMeshes);
 	for(unsigned i=0;i<node.mNumMeshes;i++)
 	{
-		subNode.subMeshes[i]=node.mMeshes[i];
+		imported.nodeSubMeshes.push_back(node.mMeshes[i]);
 	}
 	// the new object is the parent for all child nodes
 	mat4 transform= *((mat4*)&node.mTransformation);
-	transform=ConvertMatrix(fromStandard, AxesStandard::Engineering, transform);
-	vec4 sc= { 1.f,1.f,1.f,scale };
+	transform=ConvertMatrix(fromStandard, toStandard, transform);
 	transform._m03*=scale;
 	transform._m13*=scale;
 	transform._m23*=scale;
 	transform.transpose();
-	subNode.orientation.Define(*((const math::Matrix4x4*)&transform));
-	subNode.children.resize(node.mNumChildren);
+	memcpy(n.transform,&transform,sizeof(n.transform));
+	imported.nodes.push_back(n);
 	// continue for all child nodes
 	for(unsigned i=0;i<node.mNumChildren;i++)
 	{
-		CopyNodesWithMeshes(mesh,*node.mChildren[i], subNode.children[i], scale, fromStandard, toStandard,numNodes);
+		CopyNodesWithMeshes(*node.mChildren[i], imported, scale, fromStandard, toStandard);
 	}
 }
 
-static void ConvertMaterial(RenderPlatform *renderPlatform,Material* M, const aiMaterial *m)
+static void ReadMaterial(MeshCacheMaterial &M, const aiMaterial *m)
 {
 	auto Colour4 = [&, m](const char* name,vec4 dflt= {1.f, 1.f, 1.f, 1.f})
 	{
@@ -85,13 +137,14 @@ static void ConvertMaterial(RenderPlatform *renderPlatform,Material* M, const ai
 	};
 #if PLATFORM_DEBUG_MATERIAL_LOAD
 	SIMUL_COUT<<"\n"<<String("?mat.name").c_str()<<std::endl;
-	std::cout<<std::setw(5)<<std::setprecision(4)<<std::fixed;
 #endif
 	for(unsigned i=0;i<m->mNumProperties;i++)
 	{
 		const aiMaterialProperty *p= m->mProperties[i];
 #if PLATFORM_DEBUG_MATERIAL_LOAD
-		SIMUL_COUT<<p->mKey.C_Str()<<", type "<<p->mType<<", index "<<p->mIndex<<":";
+		std::ostringstream line;
+		line<<std::setw(5)<<std::setprecision(4)<<std::fixed;
+		line<<p->mKey.C_Str()<<", type "<<p->mType<<", index "<<p->mIndex<<":";
 #endif
 		if(p->mType==aiPTI_Float)
 		{
@@ -99,26 +152,26 @@ static void ConvertMaterial(RenderPlatform *renderPlatform,Material* M, const ai
 			{
 				float result=Float(p->mKey.C_Str(),0.0f);
 #if PLATFORM_DEBUG_MATERIAL_LOAD
-				std::cout<<" "<<result;
+				line<<" "<<result;
 #endif
 			}
 			if(p->mDataLength==12)
 			{
 				vec4 result=Colour3(p->mKey.C_Str());
 #if PLATFORM_DEBUG_MATERIAL_LOAD
-				std::cout<<" "<<result.x<<"," << result.y << "," << result.z;
+				line<<" "<<result.x<<"," << result.y << "," << result.z;
 #endif
 			}
 			if(p->mDataLength==16)
 			{
 				vec4 result=Colour4(p->mKey.C_Str());
 #if PLATFORM_DEBUG_MATERIAL_LOAD
-				std::cout<<" "<<result.x<<"," << result.y << "," << result.z << "," << result.w;
+				line<<" "<<result.x<<"," << result.y << "," << result.z << "," << result.w;
 #endif
 			}
 		}
 #if PLATFORM_DEBUG_MATERIAL_LOAD
-		std::cout<<std::endl;
+		SIMUL_COUT<<line.str()<<std::endl;
 #endif
 	}
 	aiTextureMapping mapping;
@@ -140,76 +193,103 @@ static void ConvertMaterial(RenderPlatform *renderPlatform,Material* M, const ai
 #endif
 		}
 	}
-	M->albedo.value= Colour3("$clr.diffuse")+ Colour3("$clr.ambient") + Colour3("$clr.specular");
-	M->emissive.value = Colour3("$clr.emissive");
+	M.albedo= Colour3("$clr.diffuse")+ Colour3("$clr.ambient") + Colour3("$clr.specular");
+	M.emissive = Colour3("$clr.emissive");
 	//m->Get(AI_MATKEY_COLOR_DIFFUSE, aiColour);
-	m->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLIC_FACTOR, M->metal.value);
-	m->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_ROUGHNESS_FACTOR, M->roughness.value);
+	m->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLIC_FACTOR, M.metal);
+	m->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_ROUGHNESS_FACTOR, M.roughness);
 
 	// Seems to be always 1.0
-	M->ambientOcclusion.value=1.0f;
+	M.ambientOcclusion=1.0f;
 	
 //$mat.twosided, type 5, index 0
 //$mat.shininess, type 1, index 0
+	// Texture names are resolved when the material is created, relative to the mesh's folder; empty means a default.
 	aiString texturePath;
 	if(aiReturn_SUCCESS==m->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		Texture *T=renderPlatform->GetOrCreateTexture(texturePath.C_Str(),true);
-		M->albedo.texture=T;
-	}
-	else
-	{
-		M->albedo.texture = renderPlatform->GetOrCreateTexture("white");
+		M.textures[MeshCacheMaterial::ALBEDO]=texturePath.C_Str();
+		M.mipFlags|=1<<MeshCacheMaterial::ALBEDO;
 	}
 	if (aiReturn_SUCCESS == m->GetTexture(aiTextureType_NORMALS, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		Texture* T = renderPlatform->GetOrCreateTexture(texturePath.C_Str(),true);
-		M->normal.texture = T;
-	}
-	else
-	{
-		M->normal.texture = renderPlatform->GetOrCreateTexture("blue");
+		M.textures[MeshCacheMaterial::NORMAL]=texturePath.C_Str();
+		M.mipFlags|=1<<MeshCacheMaterial::NORMAL;
 	}
 	if (aiReturn_SUCCESS == m->GetTexture(aiTextureType_METALNESS, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		Texture* T = renderPlatform->GetOrCreateTexture(texturePath.C_Str());
-		M->metal.texture = T;
-	}
-	else
-	{
-		M->metal.texture = renderPlatform->GetOrCreateTexture("black");
+		M.textures[MeshCacheMaterial::METAL]=texturePath.C_Str();
 	}
 	if (aiReturn_SUCCESS == m->GetTexture(aiTextureType_AMBIENT_OCCLUSION, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		Texture* T = renderPlatform->GetOrCreateTexture(texturePath.C_Str());
-		M->ambientOcclusion.texture = T;
+		M.textures[MeshCacheMaterial::AMBIENT_OCCLUSION]=texturePath.C_Str();
 	}
 	else if(aiReturn_SUCCESS == m->GetTexture(aiTextureType_LIGHTMAP, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		Texture* T = renderPlatform->GetOrCreateTexture(texturePath.C_Str());
-		M->ambientOcclusion.texture = T;
+		M.textures[MeshCacheMaterial::AMBIENT_OCCLUSION]=texturePath.C_Str();
 	}
-	else
+	if (aiReturn_SUCCESS == m->GetTexture(aiTextureType_EMISSIVE, 0, &texturePath, &mapping, &uvindex, &blend))
 	{
-		M->ambientOcclusion.texture = renderPlatform->GetOrCreateTexture("white");
+		M.textures[MeshCacheMaterial::EMISSIVE]=texturePath.C_Str();
 	}
-	if (aiReturn_SUCCESS == m->GetTexture(aiTextureType_EMISSIVE, 0, &texturePath, &mapping, &uvindex, &blend))
+	M.roughness = 1.0f-Float("$mat.shininess",1.0f);
+}
+
+static_assert(meshImportFlags==(aiProcess_CalcTangentSpace|aiProcess_Triangulate|aiProcess_JoinIdenticalVertices|aiProcess_SortByPType)
+	,"meshImportFlags must match the flags passed to the importer.");
+
+// Convert one aiMesh into its place in the shared arrays. Meshes don't share any output, so they can be converted on different threads.
+static void ConvertMesh(const aiMesh &mesh,float scale,AxesStandard fromStandard,MeshVertex *vertices,uint32_t *indices,uint32_t firstVertex,MeshCacheSubMesh &subMesh)
+{
+	for(unsigned j=0;j<mesh.mNumVertices;j++)
 	{
-		Texture* T = renderPlatform->GetOrCreateTexture(texturePath.C_Str());
-		M->emissive.texture = T;
+		MeshVertex &v=vertices[j];
+		v.pos=scale*ConvertPosition(fromStandard,AxesStandard::Engineering,(*((vec3*)&(mesh.mVertices[j]))));
+		if(mesh.mNormals)
+		{
+			v.normal= ConvertPosition(fromStandard, AxesStandard::Engineering, *((vec3*)&(mesh.mNormals[j])));
+		}
+		if (mesh.mTangents)
+		{
+			v.tangent = ConvertPosition(fromStandard, AxesStandard::Engineering, *((vec3*)&(mesh.mTangents[j])));
+		}
+		// Textures converted from GL-style to D3D
+		if(mesh.mTextureCoords[0])
+		{
+			v.texc0.x=mesh.mTextureCoords[0][j].x;
+			v.texc0.y=1.0f- mesh.mTextureCoords[0][j].y;
+		}
+		if(mesh.mTextureCoords[1])
+		{
+			v.texc1.x = mesh.mTextureCoords[1][j].x;
+			v.texc1.y = 1.0f - mesh.mTextureCoords[1][j].y;
+		}
 	}
-	else
+	uint2 range={INT_MAX,0};
+	unsigned index=0;
+	for (unsigned j = 0; j < mesh.mNumFaces; j++)
 	{
-		M->emissive.texture = renderPlatform->GetOrCreateTexture("black");
+		const aiFace &face=mesh.mFaces[j];
+		// The space was reserved for triangles: anything else is written as a degenerate triangle.
+		if(face.mNumIndices!=3)
+			SIMUL_CERR<<"Num indices is "<< face.mNumIndices<<std::endl;
+		for(unsigned k=0;k<3;k++)
+		{
+			unsigned int vertex_index=firstVertex+(face.mNumIndices?face.mIndices[std::min(k,face.mNumIndices-1)]:0);
+			indices[index++] = vertex_index;
+			range.x=std::min(range.x,vertex_index);
+			range.y=std::max(range.y,vertex_index);
+		}
 	}
-	M->roughness.value = 1.0f-Float("$mat.shininess",1.0f);
-
-	
+	subMesh.lowestIndex=range.x;
+	subMesh.highestIndex=range.y;
 }
-#include "Platform/Core/StringFunctions.h"
-void Mesh::Load(const char* filenameUtf8,float scale,AxesStandard fromStandard)
+
+static bool Import(const char* filenameUtf8,float scale,AxesStandard fromStandard,ImportedMesh &imported
+	,const std::function<void(const ImportedMesh &)> &whileConverting)
 {
-	InvalidateDeviceObjects();
+	core::Timer timer;
+	timer.StartTime();
 	// Create an instance of the Importer class
 	Importer importer;
 
@@ -220,20 +300,17 @@ void Mesh::Load(const char* filenameUtf8,float scale,AxesStandard fromStandard)
 	// And have it read the given file with some example postprocessing
 	// Usually - if speed is not the most important aspect for you - you'll
 	// probably to request more postprocessing than we do in this example.
-	const aiScene* scene = importer.ReadFile(filenameUtf8,
-		aiProcess_CalcTangentSpace |
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_SortByPType);
+	const aiScene* scene = importer.ReadFile(filenameUtf8,meshImportFlags);
 	errno=0;
 	if(!scene)
-		return;
+	{
+		DefaultLogger::kill();
+		SIMUL_CERR_ONCE<<"Failed to load "<<filenameUtf8<<std::endl;
+		return false;
+	}
 	std::string short_filename=scene->GetShortFilename(filenameUtf8);
-	std::vector< Material*> materials;
-	std::string file;
-	std::vector<std::string>pathsplit=platform::core::SplitPath(filenameUtf8);
-	if(pathsplit.size())
-		renderPlatform->PushTexturePath(pathsplit[0].c_str());
+	float parseTime=(float)timer.UpdateTime();
+	imported.materials.resize(scene->mNumMaterials);
 	for(unsigned i=0;i<scene->mNumMaterials;i++)
 	{
 		const aiMaterial *m=scene->mMaterials[i];
@@ -243,136 +320,242 @@ void Mesh::Load(const char* filenameUtf8,float scale,AxesStandard fromStandard)
 		{
 			name=platform::core::QuickFormat("%s %d",short_filename.c_str(),i);
 		}
-		Material *M=renderPlatform->GetOrCreateMaterial(platform::core::QuickFormat("%s", name.C_Str()));
-		materials.push_back(M);
-		ConvertMaterial(renderPlatform,M,m);
+		imported.materials[i].name=name.C_Str();
+		ReadMaterial(imported.materials[i],m);
 	}
-	if (pathsplit.size())
-		renderPlatform->PopTexturePath();
-
-	numVertices = 0;
-	numIndices = 0;
-	struct Vertex
-	{
-		vec3 pos;
-		vec3 normal;
-		vec4 tangent;
-		vec2 texc0;
-		vec2 texc1;
-	};
-	// Vertex declaration
-	crossplatform::LayoutDesc layoutDesc[] =
-	{
-		{ "POSITION", 0, crossplatform::RGB_32_FLOAT, 0, 0, false, 0 },
-		{ "NORMAL", 0, crossplatform::RGB_32_FLOAT, 0, 12, false, 0 },
-		{ "TANGENT", 0, crossplatform::RGBA_32_FLOAT, 0, 24, false, 0 },
-		{ "TEXCOORD", 0, crossplatform::RG_32_FLOAT, 0, 40, false, 0 },
-		{ "TEXCOORD", 1, crossplatform::RG_32_FLOAT, 0, 48, false, 0 },
-	};
-	stride = sizeof(Vertex);
-	SAFE_DELETE(layout);
-	layout = renderPlatform->CreateLayout(5, layoutDesc, true);
-
+	float materialTime=(float)timer.UpdateTime();
+	// Exclusive prefix sums give each mesh its own range of the vertex and index arrays.
+	std::vector<uint32_t> firstVertex(scene->mNumMeshes+1,0);
+	std::vector<uint32_t> firstIndex(scene->mNumMeshes+1,0);
 	for(unsigned i=0;i<scene->mNumMeshes;i++)
 	{
 		const aiMesh* mesh = scene->mMeshes[i];
-		numVertices+=mesh->mNumVertices;
-		numIndices+=mesh->mNumFaces*3;
+		firstVertex[i+1]=firstVertex[i]+mesh->mNumVertices;
+		firstIndex[i+1]=firstIndex[i]+mesh->mNumFaces*3;
 	}
-	unsigned vertex = 0;
-	unsigned index= 0;
-	std::vector<Vertex> vertices(numVertices);
-	std::vector<unsigned> indices(numIndices);
-	vec3 min_pos={FLT_MAX,FLT_MAX,FLT_MAX};
-	vec3 max_pos=-min_pos;
-	std::vector<uint2> vertex_ranges;
-	vertex_ranges.resize(scene->mNumMeshes);
+	imported.vertices.resize(firstVertex[scene->mNumMeshes]);
+	imported.indices.resize(firstIndex[scene->mNumMeshes]);
+	imported.subMeshes.resize(scene->mNumMeshes);
 	for (unsigned i = 0; i < scene->mNumMeshes; i++)
 	{
 		const aiMesh* mesh = scene->mMeshes[i];
-		int meshVertex=vertex;
-		for(unsigned j=0;j<mesh->mNumVertices;j++)
-		{
-			Vertex &v=vertices[vertex++];
-			v.pos=scale*ConvertPosition(fromStandard,AxesStandard::Engineering,(*((vec3*)&(mesh->mVertices[j]))));
-			max_pos=std::max(max_pos,v.pos);
-			min_pos=std::min(min_pos,v.pos);
-			if(mesh->mNormals)
-			{
-				v.normal= ConvertPosition(fromStandard, AxesStandard::Engineering, *((vec3*)&(mesh->mNormals[j])));
-			}
-			if (mesh->mTangents)
-			{
-				v.tangent = ConvertPosition(fromStandard, AxesStandard::Engineering, *((vec3*)&(mesh->mTangents[j])));
-			}
-			if(mesh->mTextureCoords)
-			{
-			// Textures converted from GL-style to D3D
-				if(mesh->mTextureCoords[0])
-				{
-					v.texc0.x=mesh->mTextureCoords[0][j].x;
-					v.texc0.y=1.0f- mesh->mTextureCoords[0][j].y;
-				}
-				if(mesh->mTextureCoords[1])
-				{
-					v.texc1.x = mesh->mTextureCoords[1][j].x;
-					v.texc1.y = 1.0f - mesh->mTextureCoords[1][j].y;
-				}
-			}
-		}
-		uint2 &range=vertex_ranges[i];
-		range={INT_MAX,0};
-		for (unsigned j = 0; j < mesh->mNumFaces; j++)
+		MeshCacheSubMesh &subMesh=imported.subMeshes[i];
+		subMesh.indexOffset=firstIndex[i];
+		subMesh.triangleCount=mesh->mNumFaces;
+		subMesh.material=mesh->mMaterialIndex<scene->mNumMaterials?(int32_t)mesh->mMaterialIndex:-1;
+	}
+	auto convertMeshes=[&](size_t begin,size_t end)
+	{
+		for(size_t i=begin;i<end;i++)
 		{
-			for(unsigned k=0;k< mesh->mFaces[j].mNumIndices;k++)
-			{
-				if(mesh->mFaces[j].mNumIndices!=3)
-				{
-					SIMUL_CERR<<"Num indices is "<< mesh->mFaces[j].mNumIndices<<std::endl;
-				}
-				unsigned int vertex_index=meshVertex+mesh->mFaces[j].mIndices[k];
-				indices[index++] = vertex_index;
-				range.x=std::min(range.x,vertex_index);
-				range.y=std::max(range.y,vertex_index);
-			}
+			ConvertMesh(*scene->mMeshes[i],scale,fromStandard,imported.vertices.data()+firstVertex[i],imported.indices.data()+firstIndex[i]
+				,firstVertex[i],imported.subMeshes[i]);
 		}
-	}
-	SIMUL_COUT<<"Width: "<< max_pos.x-min_pos.x<<std::endl;
-	SIMUL_COUT<<"Length: "<< max_pos.y-min_pos.y<<std::endl;
-	SIMUL_COUT<<"Height: "<< max_pos.z-min_pos.z<<std::endl;
-	init(renderPlatform, numVertices, numIndices, vertices.data(), indices.data());
-	vertex = 0;
-	index = 0;
-	for (unsigned i = 0; i < scene->mNumMeshes; i++)
+	};
+	// The meshes are converted on the workers while the caller uses the materials, e.g. to start loading textures.
+	core::ThreadPool &pool=core::ThreadPool::Get();
+	std::future<void> conversion=pool.Submit([&]()
 	{
-		const aiMesh* mesh = scene->mMeshes[i];
-		
-		SubMesh *subMesh=SetSubMesh(i, index, mesh->mNumFaces * 3, nullptr,vertex_ranges[i].x,vertex_ranges[i].y);
-		
-	//	subMesh->orientation.Define(mat);
-		vertex += mesh->mNumVertices;
-		index += mesh->mNumFaces * 3;
-		if (mesh->mMaterialIndex >= 0)
-			subMesh->material=materials[mesh->mMaterialIndex];
-	}
-	numNodes=1;
+		pool.ParallelFor(scene->mNumMeshes,1,convertMeshes);
+	});
+	if(whileConverting)
+		whileConverting(imported);
+	float overlapTime=(float)timer.UpdateTime();
+	conversion.wait();
+	float conversionTime=overlapTime+(float)timer.UpdateTime();
 	if(scene->mRootNode)
-		CopyNodesWithMeshes(this, *scene->mRootNode, rootNode, scale, fromStandard, AxesStandard::Engineering,numNodes);
+		CopyNodesWithMeshes(*scene->mRootNode, imported, scale, fromStandard, AxesStandard::Engineering);
+	float hierarchyTime=(float)timer.UpdateTime();
 	// Kill it after the work is done
 	DefaultLogger::kill();
 	errno = 0;
-	// If the import failed, report it
-	if (!scene)
+	if(meshOptimizationSettings.Any())
 	{
-		SIMUL_CERR_ONCE<<"Failed to load "<<filenameUtf8<<std::endl;
-		return;
+		MeshOptimizationStats stats=OptimizeMesh(meshOptimizationSettings,imported.vertices,imported.indices,imported.subMeshes,imported.quantizedVertices,imported.lods);
+		std::ostringstream line;
+		line<<"Optimized "<<short_filename.c_str()<<": ACMR "<<stats.acmrBefore<<" -> "<<stats.acmrAfter
+			<<", bytes per vertex "<<stats.bytesPerVertexBefore<<" -> "<<stats.bytesPerVertexAfter;
+		if(meshOptimizationSettings.vertexCache&&meshOptimizationSettings.overdraw)
+			line<<", "<<stats.overdrawClusters<<" overdraw clusters";
+		if(stats.lodTriangles.size())
+		{
+			line<<", triangles per LOD";
+			for(uint32_t t:stats.lodTriangles)
+				line<<" "<<t;
+		}
+		SIMUL_COUT<<line.str()<<std::endl;
 	}
+	float optimizationTime=(float)timer.UpdateTime();
+	SIMUL_COUT<<"Imported "<<short_filename.c_str()<<" in "<<(parseTime+materialTime+conversionTime+hierarchyTime+optimizationTime)<<" ms: parse "<<parseTime
+		<<", materials "<<materialTime<<", conversion "<<conversionTime<<" ("<<overlapTime<<" overlapped with texture loads), nodes "<<hierarchyTime
+		<<", optimisation "<<optimizationTime<<std::endl;
+	return true;
 }
-
 #else
-void Mesh::Load(const char* filenameUtf8, float scale, AxesStandard fromStandard)
+static bool Import(const char* filenameUtf8,float ,AxesStandard ,ImportedMesh &,const std::function<void(const ImportedMesh &)> &)
 {
 	SIMUL_CERR_ONCE << "Can't load " << filenameUtf8 <<" - no importer enabled."<< std::endl;
+	return false;
 }
 #endif
 
+void Mesh::SetMeshCacheEnabled(bool e)
+{
+	meshCacheEnabled=e;
+}
+
+void Mesh::SetImportOptimization(const MeshOptimizationSettings &s)
+{
+	meshOptimizationSettings=s;
+}
+
+void Mesh::Load(const char* filenameUtf8,float scale,AxesStandard fromStandard)
+{
+	InvalidateDeviceObjects();
+	MeshCacheKey key;
+	key.sourceHash=meshCacheEnabled?MeshCache::HashFile(filenameUtf8):0;
+	key.importFlags=meshImportFlags;
+	key.scale=scale;
+	key.axesStandard=(uint32_t)fromStandard;
+	key.optimizeFlags=meshOptimizationSettings.GetFlags();
+	std::string cacheFilename=MeshCache::GetCacheFilename(filenameUtf8);
+	if(key.sourceHash)
+	{
+		MeshCache cache;
+		std::string reason;
+		if(cache.Open(cacheFilename.c_str(),key,&reason))
+		{
+			const MeshCacheContents &contents=cache.GetContents();
+			CreateFromContents(filenameUtf8,contents,CreateMaterials(filenameUtf8,contents.materials));
+			return;
+		}
+		if(core::FileLoader::GetFileLoader()->FileExists(cacheFilename.c_str()))
+			SIMUL_COUT<<"Not using mesh cache "<<cacheFilename.c_str()<<": "<<reason.c_str()<<".\n";
+	}
+	ImportedMesh imported;
+	std::vector<Material*> materials;
+	// Textures load on this thread, as the render platform requires, while the geometry converts on the workers.
+	auto createMaterials=[this,filenameUtf8,&materials](const ImportedMesh &m)
+	{
+		materials=CreateMaterials(filenameUtf8,m.materials);
+	};
+	if(!Import(filenameUtf8,scale,fromStandard,imported,createMaterials))
+		return;
+	MeshCacheContents contents=imported.GetContents();
+	CreateFromContents(filenameUtf8,contents,materials);
+	if(key.sourceHash&&!MeshCache::Write(cacheFilename.c_str(),key,contents))
+		SIMUL_COUT<<"Can't write mesh cache "<<cacheFilename.c_str()<<".\n";
+}
+
+static void CreateMaterial(RenderPlatform *renderPlatform,Material *M,const MeshCacheMaterial &m)
+{
+	static const char *defaultTextures[MeshCacheMaterial::NUM_TEXTURES]={"white","blue","black","white","black"};
+	Texture *textures[MeshCacheMaterial::NUM_TEXTURES];
+	for(int t=0;t<MeshCacheMaterial::NUM_TEXTURES;t++)
+	{
+		if(m.textures[t].length())
+			textures[t]=renderPlatform->GetOrCreateTexture(m.textures[t].c_str(),(m.mipFlags&(1<<t))!=0);
+		else
+			textures[t]=renderPlatform->GetOrCreateTexture(defaultTextures[t]);
+	}
+	M->albedo.value=m.albedo;
+	M->albedo.texture=textures[MeshCacheMaterial::ALBEDO];
+	M->normal.texture=textures[MeshCacheMaterial::NORMAL];
+	M->metal.value=m.metal;
+	M->metal.texture=textures[MeshCacheMaterial::METAL];
+	M->ambientOcclusion.value=m.ambientOcclusion;
+	M->ambientOcclusion.texture=textures[MeshCacheMaterial::AMBIENT_OCCLUSION];
+	M->emissive.value=m.emissive;
+	M->emissive.texture=textures[MeshCacheMaterial::EMISSIVE];
+	M->roughness.value=m.roughness;
+}
+
+void Mesh::CreateNode(const MeshCacheContents &contents,SubNode &subNode,uint32_t &node)
+{
+	if(node>=contents.numNodes)
+		return;
+	const MeshCacheNode &n=contents.nodes[node++];
+	numNodes++;
+	subNode.subMeshes.resize(n.numSubMeshes);
+	for(uint32_t i=0;i<n.numSubMeshes;i++)
+		subNode.subMeshes[i]=contents.nodeSubMeshes[n.firstSubMesh+i];
+	subNode.orientation.Define(*((const math::Matrix4x4*)n.transform));
+	subNode.children.resize(n.numChildren);
+	for(uint32_t i=0;i<n.numChildren;i++)
+		CreateNode(contents,subNode.children[i],node);
+}
+
+std::vector<Material*> Mesh::CreateMaterials(const char *filenameUtf8,const std::vector<MeshCacheMaterial> &meshMaterials)
+{
+	std::vector< Material*> materials;
+	std::vector<std::string>pathsplit=platform::core::SplitPath(filenameUtf8);
+	if(pathsplit.size())
+		renderPlatform->PushTexturePath(pathsplit[0].c_str());
+	for(const MeshCacheMaterial &m:meshMaterials)
+	{
+		Material *M=renderPlatform->GetOrCreateMaterial(m.name.c_str());
+		materials.push_back(M);
+		CreateMaterial(renderPlatform,M,m);
+	}
+	if (pathsplit.size())
+		renderPlatform->PopTexturePath();
+	return materials;
+}
+
+void Mesh::CreateFromContents(const char *filenameUtf8,const MeshCacheContents &contents,const std::vector<Material*> &materials)
+{
+	// Vertex declaration
+	crossplatform::LayoutDesc layoutDesc[] =
+	{
+		{ "POSITION", 0, crossplatform::RGB_32_FLOAT, 0, 0, false, 0 },
+		{ "NORMAL", 0, crossplatform::RGB_32_FLOAT, 0, 12, false, 0 },
+		{ "TANGENT", 0, crossplatform::RGBA_32_FLOAT, 0, 24, false, 0 },
+		{ "TEXCOORD", 0, crossplatform::RG_32_FLOAT, 0, 40, false, 0 },
+		{ "TEXCOORD", 1, crossplatform::RG_32_FLOAT, 0, 48, false, 0 },
+	};
+	// The same attributes, expanded to float by the input assembler.
+	crossplatform::LayoutDesc quantizedLayoutDesc[] =
+	{
+		{ "POSITION", 0, crossplatform::RGB_32_FLOAT, 0, 0, false, 0 },
+		{ "NORMAL", 0, crossplatform::RGBA_8_SNORM, 0, 12, false, 0 },
+		{ "TANGENT", 0, crossplatform::RGBA_8_SNORM, 0, 16, false, 0 },
+		{ "TEXCOORD", 0, crossplatform::RG_16_FLOAT, 0, 20, false, 0 },
+		{ "TEXCOORD", 1, crossplatform::RG_16_FLOAT, 0, 24, false, 0 },
+	};
+	bool quantized=contents.vertexFormat==MeshVertexFormat::QUANTIZED;
+	SAFE_DELETE(layout);
+	layout = renderPlatform->CreateLayout(5, quantized?quantizedLayoutDesc:layoutDesc, true);
+	// The arrays go straight to the GPU buffers: from a cache, they are used where they were loaded.
+	if(quantized)
+		init(renderPlatform, (int)contents.numVertices, (int)contents.numIndices, (const MeshVertexQuantized*)contents.vertices, contents.indices);
+	else
+		init(renderPlatform, (int)contents.numVertices, (int)contents.numIndices, (const MeshVertex*)contents.vertices, contents.indices);
+	for (uint32_t i = 0; i < contents.numSubMeshes; i++)
+	{
+		const MeshCacheSubMesh &s=contents.subMeshes[i];
+		SubMesh *subMesh=SetSubMesh(i, s.indexOffset, s.triangleCount * 3, nullptr,s.lowestIndex,s.highestIndex);
+		if (s.material >= 0 && s.material < (int32_t)materials.size())
+			subMesh->material=materials[s.material];
+		subMesh->lods.clear();
+	}
+	for (uint32_t i = 0; i < contents.numLods; i++)
+	{
+		const MeshCacheLod &l=contents.lods[i];
+		SubMesh *subMesh=GetSubMesh(l.subMesh);
+		if(subMesh&&subMesh->lods.size()<SubMesh::MAX_LODS-1)
+			subMesh->lods.push_back({l.indexOffset,l.triangleCount,l.error});
+	}
+	numNodes=0;
+	uint32_t node=0;
+	CreateNode(contents,rootNode,node);
+	if(!numNodes)
+		numNodes=1;
+	CalculateBounds(contents.vertices);
+	if(!rootNode.bounds.IsEmpty())
+	{
+		vec3 size=2.0f*rootNode.bounds.GetExtents();
+		SIMUL_COUT<<"Width: "<< size.x<<std::endl;
+		SIMUL_COUT<<"Length: "<< size.y<<std::endl;
+		SIMUL_COUT<<"Height: "<< size.z<<std::endl;
+	}
+}
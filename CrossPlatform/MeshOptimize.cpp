@@ -0,0 +1,456 @@
+#include "Platform/CrossPlatform/MeshOptimize.h"
+#include "Platform/CrossPlatform/MeshSimplify.h"
+#include "Platform/Math/Float16.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	// A FIFO cache of vertex indices, as the post-transform cache of most GPUs behaves.
+	struct FifoCache
+	{
+		std::vector<uint32_t> timestamps;
+		uint32_t time;
+		unsigned size;
+		FifoCache(size_t numVertices, unsigned cacheSize)
+			: timestamps(numVertices, 0), time(cacheSize + 1), size(cacheSize)
+		{
+		}
+		// Returns true on a miss.
+		bool Access(uint32_t v)
+		{
+			if (time - timestamps[v] > size)
+			{
+				timestamps[v] = time++;
+				return true;
+			}
+			return false;
+		}
+		void Flush()
+		{
+			time += size + 1;
+		}
+	};
+	size_t MaxIndex(const uint32_t *indices, size_t numIndices)
+	{
+		uint32_t m = 0;
+		for (size_t i = 0; i < numIndices; i++)
+			m = std::max(m, indices[i]);
+		return numIndices ? (size_t)m + 1 : 0;
+	}
+	int8_t ToSnorm8(float f)
+	{
+		f = std::min(1.0f, std::max(-1.0f, f));
+		return (int8_t)lrintf(f * 127.0f);
+	}
+}
+
+uint64_t MeshOptimizationSettings::GetFlags() const
+{
+	uint64_t f = 0;
+	if (vertexCache)
+		f |= 1;
+	if (vertexCache && overdraw)
+		f |= 2;
+	if (vertexFetch)
+		f |= 4;
+	if (quantize)
+		f |= 8;
+	if (vertexCache)
+		f |= (cacheSize & 0xFF) << 8;
+	if (vertexCache && overdraw)
+		f |= ((uint64_t)lrintf(overdrawThreshold * 100.0f) & 0xFFFF) << 16;
+	if (lodCount)
+	{
+		f |= (uint64_t)(std::min(lodCount, 7u)) << 32;
+		f |= ((uint64_t)lrintf(lodReduction * 100.0f) & 0xFF) << 36;
+		f |= ((uint64_t)lrintf(lodMaxError * 10000.0f) & 0xFFFF) << 44;
+	}
+	return f;
+}
+
+float platform::crossplatform::CalculateACMR(const uint32_t *indices, size_t numIndices, unsigned cacheSize)
+{
+	if (numIndices < 3)
+		return 0.0f;
+	FifoCache cache(MaxIndex(indices, numIndices), cacheSize);
+	size_t misses = 0;
+	for (size_t i = 0; i < numIndices; i++)
+		misses += cache.Access(indices[i]) ? 1 : 0;
+	return float(misses) / float(numIndices / 3);
+}
+
+void platform::crossplatform::OptimizeVertexCache(uint32_t *indices, size_t numIndices, size_t numVertices, unsigned cacheSize, std::vector<uint32_t> *clusters)
+{
+	size_t numTriangles = numIndices / 3;
+	if (clusters)
+		clusters->clear();
+	if (!numTriangles || !numVertices)
+		return;
+	// Vertex-triangle adjacency, as offsets into one array.
+	std::vector<uint32_t> live(numVertices, 0);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+		live[indices[i]]++;
+	std::vector<uint32_t> offsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<uint32_t> adjacency(offsets[numVertices]);
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+		}
+	}
+	std::vector<uint32_t> cacheTime(numVertices, 0);
+	std::vector<uint8_t> emitted(numTriangles, 0);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(numTriangles * 3);
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 1;
+	// Start with the first vertex that is used at all.
+	int64_t fanning = -1;
+	for (size_t v = 0; v < numVertices && fanning < 0; v++)
+	{
+		if (live[v])
+			fanning = (int64_t)v;
+	}
+	if (clusters)
+		clusters->push_back(0);
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		uint32_t f = (uint32_t)fanning;
+		for (uint32_t a = offsets[f]; a < offsets[f + 1]; a++)
+		{
+			uint32_t t = adjacency[a];
+			if (emitted[t])
+				continue;
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+		// The next fanning vertex: the candidate that will still be in the cache after its remaining triangles are emitted,
+		// and has been in it longest.
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (!live[v])
+				continue;
+			int64_t priority = 0;
+			if ((int64_t)time - cacheTime[v] + 2 * (int64_t)live[v] <= (int64_t)cacheSize)
+				priority = (int64_t)time - cacheTime[v];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = v;
+			}
+		}
+		if (best < 0)
+		{
+			// Dead end: try the most recently used vertices, then scan for any vertex with triangles left.
+			while (deadEnd.size() && best < 0)
+			{
+				uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[v])
+					best = v;
+			}
+			if (best < 0)
+			{
+				while (cursor < numVertices && !live[cursor])
+					cursor++;
+				if (cursor < numVertices)
+				{
+					best = (int64_t)cursor;
+					// Nothing here is in the cache: a natural place to start a new cluster.
+					if (clusters && output.size() < numTriangles * 3)
+						clusters->push_back((uint32_t)output.size());
+				}
+			}
+		}
+		fanning = best;
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t platform::crossplatform::OptimizeOverdraw(uint32_t *indices, size_t numIndices, const void *vertices, size_t vertexSize
+	, const std::vector<uint32_t> &hardClusters, unsigned cacheSize, float threshold)
+{
+	size_t numTriangles = numIndices / 3;
+	if (!numTriangles)
+		return 0;
+	size_t numVertices = MaxIndex(indices, numIndices);
+	// Split each hard cluster wherever its running ACMR falls to within the threshold of the whole cluster's,
+	// so that reordering costs little cache efficiency.
+	std::vector<uint32_t> clusters;
+	{
+		FifoCache cache(numVertices, cacheSize);
+		for (size_t h = 0; h < hardClusters.size(); h++)
+		{
+			size_t start = hardClusters[h];
+			size_t end = h + 1 < hardClusters.size() ? hardClusters[h + 1] : numTriangles * 3;
+			cache.Flush();
+			size_t misses = 0;
+			for (size_t i = start; i < end; i++)
+				misses += cache.Access(indices[i]) ? 1 : 0;
+			float target = threshold * float(misses) / float(std::max<size_t>(1, (end - start) / 3));
+			clusters.push_back((uint32_t)start);
+			cache.Flush();
+			size_t clusterStart = start;
+			misses = 0;
+			for (size_t i = start; i + 3 <= end; i += 3)
+			{
+				for (int k = 0; k < 3; k++)
+					misses += cache.Access(indices[i + k]) ? 1 : 0;
+				size_t triangles = (i + 3 - clusterStart) / 3;
+				if (i + 3 < end && triangles >= cacheSize && float(misses) / float(triangles) <= target)
+				{
+					clusterStart = i + 3;
+					clusters.push_back((uint32_t)clusterStart);
+					cache.Flush();
+					misses = 0;
+				}
+			}
+		}
+	}
+	auto Position = [vertices, vertexSize](uint32_t v)
+	{
+		const float *p = (const float *)((const uint8_t *)vertices + (size_t)v * vertexSize);
+		return vec3(p[0], p[1], p[2]);
+	};
+	// The area-weighted centroid of the whole mesh.
+	struct Cluster
+	{
+		vec3 centroid;
+		vec3 normal;
+		float area;
+		float sortKey;
+		uint32_t start, end;
+	};
+	std::vector<Cluster> info(clusters.size());
+	vec3 meshCentroid(0, 0, 0);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		Cluster &cl = info[c];
+		cl.start = clusters[c];
+		cl.end = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)(numTriangles * 3);
+		cl.centroid = vec3(0, 0, 0);
+		cl.normal = vec3(0, 0, 0);
+		cl.area = 0.0f;
+		for (uint32_t i = cl.start; i + 3 <= cl.end; i += 3)
+		{
+			vec3 a = Position(indices[i]), b = Position(indices[i + 1]), d = Position(indices[i + 2]);
+			vec3 n = cross(b - a, d - a);
+			float area = length(n);
+			cl.normal += n;
+			cl.centroid += (a + b + d) * (area / 3.0f);
+			cl.area += area;
+		}
+		meshCentroid += cl.centroid;
+		meshArea += cl.area;
+		if (cl.area > 0.0f)
+			cl.centroid /= cl.area;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+	// Clusters that face away from the centre are most likely to occlude the rest, so draw them first.
+	for (Cluster &cl : info)
+	{
+		float l = length(cl.normal);
+		cl.sortKey = l > 0.0f ? dot(cl.centroid - meshCentroid, cl.normal / l) : 0.0f;
+	}
+	std::vector<uint32_t> order(info.size());
+	for (size_t c = 0; c < order.size(); c++)
+		order[c] = (uint32_t)c;
+	std::stable_sort(order.begin(), order.end(), [&info](uint32_t a, uint32_t b)
+	{
+		return info[a].sortKey > info[b].sortKey;
+	});
+	std::vector<uint32_t> sorted;
+	sorted.reserve(numTriangles * 3);
+	for (uint32_t c : order)
+		sorted.insert(sorted.end(), indices + info[c].start, indices + info[c].end);
+	memcpy(indices, sorted.data(), sorted.size() * sizeof(uint32_t));
+	return info.size();
+}
+
+size_t platform::crossplatform::OptimizeVertexFetch(void *vertices, size_t vertexSize, size_t numVertices, uint32_t *indices, size_t numIndices)
+{
+	const uint32_t unused = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(numVertices, unused);
+	uint32_t next = 0;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		uint32_t &r = remap[indices[i]];
+		if (r == unused)
+			r = next++;
+		indices[i] = r;
+	}
+	size_t used = next;
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		if (remap[v] == unused)
+			remap[v] = next++;
+	}
+	std::vector<uint8_t> copy((const uint8_t *)vertices, (const uint8_t *)vertices + numVertices * vertexSize);
+	for (size_t v = 0; v < numVertices; v++)
+		memcpy((uint8_t *)vertices + (size_t)remap[v] * vertexSize, copy.data() + v * vertexSize, vertexSize);
+	return used;
+}
+
+void platform::crossplatform::QuantizeVertices(const MeshVertex *src, MeshVertexQuantized *dst, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const MeshVertex &s = src[i];
+		MeshVertexQuantized &d = dst[i];
+		d.pos = s.pos;
+		d.normal[0] = ToSnorm8(s.normal.x);
+		d.normal[1] = ToSnorm8(s.normal.y);
+		d.normal[2] = ToSnorm8(s.normal.z);
+		d.normal[3] = 0;
+		d.tangent[0] = ToSnorm8(s.tangent.x);
+		d.tangent[1] = ToSnorm8(s.tangent.y);
+		d.tangent[2] = ToSnorm8(s.tangent.z);
+		d.tangent[3] = ToSnorm8(s.tangent.w);
+		d.texc0[0] = math::ToFloat16(s.texc0.x);
+		d.texc0[1] = math::ToFloat16(s.texc0.y);
+		d.texc1[0] = math::ToFloat16(s.texc1.x);
+		d.texc1[1] = math::ToFloat16(s.texc1.y);
+	}
+}
+
+MeshOptimizationStats platform::crossplatform::OptimizeMesh(const MeshOptimizationSettings &settings
+	, std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, std::vector<MeshCacheSubMesh> &subMeshes
+	, std::vector<MeshVertexQuantized> &quantized, std::vector<MeshCacheLod> &lods)
+{
+	MeshOptimizationStats stats;
+	lods.clear();
+	stats.acmrBefore = CalculateACMR(indices.data(), indices.size(), settings.cacheSize);
+	stats.bytesPerVertexBefore = sizeof(MeshVertex);
+	if (settings.vertexCache)
+	{
+		// Each submesh is optimised on its own, with its vertices renumbered from zero, so the working arrays stay small.
+		std::vector<uint32_t> local;
+		std::vector<uint32_t> clusters;
+		for (const MeshCacheSubMesh &s : subMeshes)
+		{
+			size_t n = (size_t)s.triangleCount * 3;
+			if (!n || s.highestIndex < s.lowestIndex)
+				continue;
+			uint32_t *ind = indices.data() + s.indexOffset;
+			local.assign(ind, ind + n);
+			for (uint32_t &i : local)
+				i -= s.lowestIndex;
+			size_t numLocal = (size_t)(s.highestIndex - s.lowestIndex) + 1;
+			OptimizeVertexCache(local.data(), n, numLocal, settings.cacheSize, settings.overdraw ? &clusters : nullptr);
+			if (settings.overdraw)
+			{
+				stats.overdrawClusters += (uint32_t)OptimizeOverdraw(local.data(), n, vertices.data() + s.lowestIndex, sizeof(MeshVertex)
+					, clusters, settings.cacheSize, settings.overdrawThreshold);
+			}
+			for (size_t i = 0; i < n; i++)
+				ind[i] = local[i] + s.lowestIndex;
+		}
+	}
+	const size_t baseIndexCount = indices.size();
+	if (settings.lodCount)
+	{
+		// Each level simplifies the one before it, and is cache-optimised on its own.
+		const unsigned lodCount = std::min(settings.lodCount, 7u);
+		stats.lodTriangles.assign(1, (uint32_t)(baseIndexCount / 3));
+		std::vector<uint32_t> local;
+		std::vector<uint32_t> previous;
+		for (size_t m = 0; m < subMeshes.size(); m++)
+		{
+			const MeshCacheSubMesh &s = subMeshes[m];
+			size_t n = (size_t)s.triangleCount * 3;
+			if (!n || s.highestIndex < s.lowestIndex)
+				continue;
+			const uint32_t *ind = indices.data() + s.indexOffset;
+			previous.assign(ind, ind + n);
+			for (uint32_t &i : previous)
+				i -= s.lowestIndex;
+			size_t numLocal = (size_t)(s.highestIndex - s.lowestIndex) + 1;
+			// Errors add up from level to level, as each is measured against the one before.
+			float totalError = 0.0f;
+			for (unsigned level = 1; level <= lodCount; level++)
+			{
+				size_t target = ((size_t)(previous.size() / 3 * settings.lodReduction)) * 3;
+				float allowedError = settings.lodMaxError - totalError;
+				if (target < 3 || allowedError <= 0.0f)
+					break;
+				local.resize(previous.size());
+				float error = 0.0f;
+				size_t count = SimplifyMesh(local.data(), previous.data(), previous.size(), vertices.data() + s.lowestIndex, numLocal
+					, sizeof(MeshVertex), target, allowedError, &error);
+				// Stop when simplification stalls: a level that saves little isn't worth drawing.
+				if (count == 0 || count > previous.size() * 9 / 10)
+					break;
+				local.resize(count);
+				if (settings.vertexCache)
+					OptimizeVertexCache(local.data(), count, numLocal, settings.cacheSize);
+				MeshCacheLod lod;
+				lod.subMesh = (int32_t)m;
+				lod.indexOffset = (int32_t)indices.size();
+				lod.triangleCount = (int32_t)(count / 3);
+				totalError += error;
+				lod.error = totalError;
+				lods.push_back(lod);
+				for (uint32_t i : local)
+					indices.push_back(i + s.lowestIndex);
+				if (stats.lodTriangles.size() <= level)
+					stats.lodTriangles.resize(level + 1, 0);
+				stats.lodTriangles[level] += lod.triangleCount;
+				previous.swap(local);
+			}
+		}
+	}
+	if (settings.vertexFetch)
+	{
+		OptimizeVertexFetch(vertices.data(), sizeof(MeshVertex), vertices.size(), indices.data(), indices.size());
+		// Vertices now follow the order of the submeshes that use them.
+		for (MeshCacheSubMesh &s : subMeshes)
+		{
+			size_t n = (size_t)s.triangleCount * 3;
+			if (!n)
+				continue;
+			const uint32_t *ind = indices.data() + s.indexOffset;
+			uint32_t lo = ind[0], hi = ind[0];
+			for (size_t i = 1; i < n; i++)
+			{
+				lo = std::min(lo, ind[i]);
+				hi = std::max(hi, ind[i]);
+			}
+			s.lowestIndex = lo;
+			s.highestIndex = hi;
+		}
+	}
+	stats.acmrAfter = CalculateACMR(indices.data(), baseIndexCount, settings.cacheSize);
+	stats.bytesPerVertexAfter = sizeof(MeshVertex);
+	if (settings.quantize)
+	{
+		quantized.resize(vertices.size());
+		QuantizeVertices(vertices.data(), quantized.data(), vertices.size());
+		stats.bytesPerVertexAfter = sizeof(MeshVertexQuantized);
+	}
+	return stats;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/MeshCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! Which optimisations Mesh::Load() applies to imported meshes. All are off by default.
+		struct SIMUL_CROSSPLATFORM_EXPORT MeshOptimizationSettings
+		{
+			//! Reorder triangles so that vertices are reused while still in the post-transform cache.
+			bool vertexCache = false;
+			//! Then reorder clusters of triangles so that outward-facing ones draw first. Needs vertexCache.
+			bool overdraw = false;
+			//! Reorder vertices into the order the triangles first use them.
+			bool vertexFetch = false;
+			//! Store vertices as MeshVertexQuantized, half the size of MeshVertex.
+			bool quantize = false;
+			//! The post-transform cache size to optimise for.
+			unsigned cacheSize = 16;
+			//! How much worse than the cache-optimised order overdraw clusters may make the ACMR.
+			float overdrawThreshold = 1.05f;
+			//! The number of simplified levels of detail to generate for each submesh, after the submesh itself. At most 7.
+			unsigned lodCount = 0;
+			//! The fraction of the previous level's triangles that each level aims for.
+			float lodReduction = 0.5f;
+			//! The largest error allowed in any level, relative to the size of the submesh, counting the error of the levels
+			//! before it. A level that can't get meaningfully smaller within this error is not generated, nor are the levels after it.
+			float lodMaxError = 0.05f;
+			bool Any() const
+			{
+				return vertexCache || vertexFetch || quantize || lodCount > 0;
+			}
+			//! The settings that affect the result, for the mesh cache key.
+			uint64_t GetFlags() const;
+		};
+		//! Before and after measures from OptimizeMesh().
+		struct MeshOptimizationStats
+		{
+			float acmrBefore = 0.0f;	//!< Average cache miss ratio: vertices transformed per triangle, for a FIFO cache.
+			float acmrAfter = 0.0f;
+			uint32_t bytesPerVertexBefore = 0;
+			uint32_t bytesPerVertexAfter = 0;
+			uint32_t overdrawClusters = 0;
+			//! Triangles in each level of detail, over all submeshes: [0] is the original mesh.
+			std::vector<uint32_t> lodTriangles;
+		};
+		//! The average cache miss ratio of the triangle list, for a FIFO cache of \a cacheSize vertices.
+		//! 0.5 is ideal for a regular grid, 3.0 the worst.
+		extern SIMUL_CROSSPLATFORM_EXPORT float CalculateACMR(const uint32_t *indices, size_t numIndices, unsigned cacheSize = 16);
+		//! Reorder the triangles for post-transform cache reuse, using Tipsify (Sander, Nehab and Barczak 2007), which is linear in the
+		//! triangle count. Indices must be less than \a numVertices. If \a clusters is given, it receives the index offsets
+		//! where the cache was effectively flushed, for OptimizeOverdraw().
+		extern SIMUL_CROSSPLATFORM_EXPORT void OptimizeVertexCache(uint32_t *indices, size_t numIndices, size_t numVertices, unsigned cacheSize
+			, std::vector<uint32_t> *clusters = nullptr);
+		//! Reorder the clusters found by OptimizeVertexCache() so that those facing out from the centre of the mesh come first,
+		//! and occlude the rest. Clusters are first split as finely as \a threshold allows. Positions are the first three floats
+		//! of each vertex. Returns the number of clusters.
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t OptimizeOverdraw(uint32_t *indices, size_t numIndices, const void *vertices, size_t vertexSize
+			, const std::vector<uint32_t> &clusters, unsigned cacheSize, float threshold);
+		//! Reorder the vertices into the order the indices first use them, and update the indices to match.
+		//! Unused vertices are moved to the end. Returns the number of vertices used.
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t OptimizeVertexFetch(void *vertices, size_t vertexSize, size_t numVertices, uint32_t *indices, size_t numIndices);
+		extern SIMUL_CROSSPLATFORM_EXPORT void QuantizeVertices(const MeshVertex *src, MeshVertexQuantized *dst, size_t count);
+		//! Apply the settings to a mesh whose submeshes are consecutive ranges of the index buffer. Triangles are only reordered
+		//! within a submesh, and each submesh's vertex range is updated. If quantize is set, \a quantized receives the vertices.
+		//! If lodCount is set, the simplified levels are appended to the index buffer and described in \a lods.
+		extern SIMUL_CROSSPLATFORM_EXPORT MeshOptimizationStats OptimizeMesh(const MeshOptimizationSettings &settings
+			, std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, std::vector<MeshCacheSubMesh> &subMeshes
+			, std::vector<MeshVertexQuantized> &quantized, std::vector<MeshCacheLod> &lods);
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
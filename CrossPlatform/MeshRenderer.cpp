@@ -1,5 +1,9 @@
 #include "MeshRenderer.h"
 #include "Material.h"
+#include "Platform/Core/RuntimeError.h"
+#include "Platform/CrossPlatform/GpuProfiler.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace platform;
 using namespace crossplatform;
@@ -21,23 +25,47 @@ void MeshRenderer::RestoreDeviceObjects(RenderPlatform *r)
 	renderPlatform = r;
 	cameraConstants.RestoreDeviceObjects(r);
 	solidConstants.RestoreDeviceObjects(r);
+	perObjectConstants.RestoreDeviceObjects(r);
+	instanceCapacity = 0;
 }
 
 void MeshRenderer::LoadShaders()
 {
-	delete effect;
+	// Draws recorded earlier in the frame may still use the old effect.
+	renderPlatform->Destroy(effect);
+	effectReloadCount = renderPlatform->GetEffectReloadCount();
 	effect = renderPlatform->CreateEffect("solid");
+	instancedPasses[0] = instancedPasses[1] = nullptr;
+	if (!effect)
+		return;
+	diffuseTextureResource			= effect->GetShaderResource("diffuseTexture");
+	normalTextureResource			= effect->GetShaderResource("normalTexture");
+	metalTextureResource			= effect->GetShaderResource("metalTexture");
+	ambientOcclusionTextureResource	= effect->GetShaderResource("ambientOcclusionTexture");
+	emissiveTextureResource			= effect->GetShaderResource("emissiveTexture");
+	meshInstancesResource			= effect->GetShaderResource("meshInstances");
+	EffectTechnique *solid			= effect->GetTechniqueByName("solid_instanced");
+	EffectTechnique *transparent	= effect->GetTechniqueByName("transparent_instanced");
+	instancedPasses[(int)MeshRenderPass::OPAQUE_PASS]		= solid ? solid->GetPass(0) : nullptr;
+	instancedPasses[(int)MeshRenderPass::TRANSPARENT_PASS]	= transparent ? transparent->GetPass(0) : nullptr;
 }
 
 void MeshRenderer::InvalidateDeviceObjects()
 {
 	cameraConstants.InvalidateDeviceObjects();
 	solidConstants.InvalidateDeviceObjects();
+	perObjectConstants.InvalidateDeviceObjects();
+	instanceBuffer.InvalidateDeviceObjects();
+	instanceCapacity = 0;
+	renderQueue.clear();
+	queuedInstances.clear();
+	queuedBounds.Clear();
 	delete effect;
 	effect = nullptr;
+	instancedPasses[0] = instancedPasses[1] = nullptr;
 }
 
-void MeshRenderer::DrawSubMesh(GraphicsDeviceContext& deviceContext, Mesh* mesh, int index)
+void MeshRenderer::DrawSubMesh(GraphicsDeviceContext& deviceContext, Mesh* mesh, int index, int lod)
 {
 //	perNodeConstants.model = deviceContext.viewStruct.model;
 	cameraConstants.viewProj = deviceContext.viewStruct.viewProj;
@@ -51,11 +79,24 @@ void MeshRenderer::DrawSubMesh(GraphicsDeviceContext& deviceContext, Mesh* mesh,
 	Mesh::SubMesh* subMesh = mesh->GetSubMesh(index);
 	
 	Material* mat = subMesh->material;
+	if (frustumCulling && !subMesh->bounds.IsEmpty())
+	{
+		if (!frustumPlanes.Intersects(subMesh->bounds.Transformed(deviceContext.viewStruct.model)))
+		{
+			frameStats.culledSubMeshes++;
+			return;
+		}
+	}
+	frameStats.visibleSubMeshes++;
 	ApplyMaterial(deviceContext, mat);
 	auto *vb= mesh->GetVertexBuffer();
 	renderPlatform->SetVertexBuffers(deviceContext, 0, 1, &vb, mesh->GetLayout());
 	renderPlatform->SetIndexBuffer(deviceContext, mesh->GetIndexBuffer());
-	renderPlatform->DrawIndexed(deviceContext, subMesh->TriangleCount * 3, subMesh->IndexOffset, 0);
+	lod = std::min(lod, subMesh->GetLodCount() - 1);
+	int indexOffset, triangleCount;
+	subMesh->GetLodRange(lod, indexOffset, triangleCount);
+	renderPlatform->DrawIndexed(deviceContext, triangleCount * 3, indexOffset, 0);
+	CountTriangles(lod, triangleCount, 1);
 }
 
 void MeshRenderer::DrawSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh, const Mesh::SubNode& subNode)
@@ -63,8 +104,14 @@ void MeshRenderer::DrawSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh,
 	auto mat = subNode.orientation.GetMatrix();
 	mat.Transpose();
 	deviceContext.viewStruct.PushModelMatrix(mat);
+	if (!IsNodeVisible(deviceContext, subNode))
+	{
+		deviceContext.viewStruct.PopModelMatrix();
+		return;
+	}
+	int lod = SelectLod(deviceContext, subNode);
 	for (int i = 0; i < subNode.subMeshes.size(); i++)
-		DrawSubMesh(deviceContext, mesh,subNode.subMeshes[i]);
+		DrawSubMesh(deviceContext, mesh,subNode.subMeshes[i], lod);
 	for (int i = 0; i < subNode.children.size(); i++)
 		DrawSubNode(deviceContext, mesh, subNode.children[i]);
 	deviceContext.viewStruct.PopModelMatrix();
@@ -72,14 +119,16 @@ void MeshRenderer::DrawSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh,
 
 void MeshRenderer::Render(GraphicsDeviceContext &deviceContext, Mesh *mesh, mat4 model, Texture *diffuseCubemap,Texture *specularCubemap,Texture *screenspaceShadowTexture)
 {
-	if (!effect)
+	if (!effect || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	if (!effect)
 		return;
+	UpdateStatsFrame(deviceContext);
+	frustumPlanes = FrustumPlanes::FromViewStruct(deviceContext.viewStruct);
 	deviceContext.viewStruct.PushModelMatrix(*((math::Matrix4x4*)&model));
-	effect->SetTexture(deviceContext, "diffuseCubemap", diffuseCubemap);
-	effect->SetTexture(deviceContext, "specularCubemap", specularCubemap);
-	effect->SetTexture(deviceContext, "screenspaceShadowTexture", screenspaceShadowTexture);
+	effect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("diffuseCubemap"), diffuseCubemap);
+	effect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("specularCubemap"), specularCubemap);
+	effect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("screenspaceShadowTexture"), screenspaceShadowTexture);
 	mesh->BeginDraw(deviceContext, platform::crossplatform::ShadingMode::SHADING_MODE_SHADED);
 	mat4 w;
 	mat4 tw =*( (mat4*)&(mesh->orientation.GetMatrix()));
@@ -106,11 +155,11 @@ void MeshRenderer::ApplyMaterial(DeviceContext &deviceContext, Material *materia
 	vec2 vec2_unit(1.0f,1.0f);
 	vec4 vec4_unit(1.0f, 1.0f, 1.0f, 1.0f);
 	vec3 vec3_unit={1.0f, 1.0f,1.0f};
-	renderPlatform->SetTexture(deviceContext,effect->GetShaderResource("diffuseTexture"),material->albedo.texture);
-	renderPlatform->SetTexture(deviceContext, effect->GetShaderResource("normalTexture"), material->normal.texture);
-	renderPlatform->SetTexture(deviceContext, effect->GetShaderResource("metalTexture"), material->metal.texture);
-	renderPlatform->SetTexture(deviceContext, effect->GetShaderResource("ambientOcclusionTexture"), material->ambientOcclusion.texture);
-	renderPlatform->SetTexture(deviceContext, effect->GetShaderResource("emissiveTexture"), material->emissive.texture);
+	renderPlatform->SetTexture(deviceContext, diffuseTextureResource, material->albedo.texture);
+	renderPlatform->SetTexture(deviceContext, normalTextureResource, material->normal.texture);
+	renderPlatform->SetTexture(deviceContext, metalTextureResource, material->metal.texture);
+	renderPlatform->SetTexture(deviceContext, ambientOcclusionTextureResource, material->ambientOcclusion.texture);
+	renderPlatform->SetTexture(deviceContext, emissiveTextureResource, material->emissive.texture);
 	solidConstants.diffuseOutputScalar						=vec4(material->albedo.value,1.0f);
 	solidConstants.diffuseTexCoordsScalar_R					=vec2_unit;
 	solidConstants.diffuseTexCoordsScalar_G					=vec2_unit;
@@ -143,4 +192,307 @@ void MeshRenderer::ApplyMaterial(DeviceContext &deviceContext, Material *materia
 	solidConstants.u_EmissiveTexCoordIndex=3;
 
 	renderPlatform->SetConstantBuffer(deviceContext, &solidConstants);
-}
\ No newline at end of file
+}
+
+void MeshRenderer::UpdateStatsFrame(DeviceContext &deviceContext)
+{
+	long long frameNumber = renderPlatform ? renderPlatform->GetFrameNumber() : 0;
+	if (frameNumber == statsFrame)
+		return;
+	if (statsFrame >= 0)
+	{
+		lastFrameStats = frameStats;
+		PublishStats(deviceContext);
+	}
+	frameStats = MeshRenderStats();
+	statsFrame = frameNumber;
+}
+
+void MeshRenderer::PublishStats(DeviceContext &deviceContext) const
+{
+	GpuProfilingInterface *profiler = GetGpuProfilingInterface(deviceContext);
+	if (!profiler)
+		return;
+	profiler->SetCounter("Mesh triangles", lastFrameStats.triangles);
+	for (int i = 0; i < Mesh::SubMesh::MAX_LODS; i++)
+	{
+		std::string name = "Mesh LOD " + std::to_string(i);
+		// Skip levels that have never been drawn, but keep the ones that have up to date, so they drop to zero rather than going stale.
+		if (!lastFrameStats.lodSubMeshes[i] && !profiler->GetCounters().count(name + " instances"))
+			continue;
+		profiler->SetCounter((name + " triangles").c_str(), lastFrameStats.lodTriangles[i]);
+		profiler->SetCounter((name + " instances").c_str(), lastFrameStats.lodSubMeshes[i]);
+	}
+}
+
+bool MeshRenderer::IsNodeVisible(const GraphicsDeviceContext &deviceContext, const Mesh::SubNode &subNode)
+{
+	// Nodes without bounds are always drawn.
+	if (!frustumCulling || subNode.bounds.IsEmpty())
+		return true;
+	if (frustumPlanes.Intersects(subNode.bounds.Transformed(deviceContext.viewStruct.model)))
+		return true;
+	frameStats.culledNodes++;
+	return false;
+}
+
+int MeshRenderer::SelectLod(const GraphicsDeviceContext &deviceContext, const Mesh::SubNode &subNode) const
+{
+	if (lodThresholds.empty() || subNode.sphere.IsEmpty())
+		return 0;
+	BoundingSphere s = subNode.sphere.Transformed(deviceContext.viewStruct.model);
+	// The projected radius is the radius times the clip-space y scale, divided by w.
+	const float *M = deviceContext.viewStruct.viewProj.Values;
+	float yScale = sqrtf(M[4] * M[4] + M[5] * M[5] + M[6] * M[6]);
+	float w = M[12] * s.centre.x + M[13] * s.centre.y + M[14] * s.centre.z + M[15];
+	// Inside the sphere, or nearly so: full detail.
+	if (w <= s.radius)
+		return 0;
+	float size = s.radius * yScale / w;
+	int lod = 0;
+	while (lod < (int)lodThresholds.size() && lod < Mesh::SubMesh::MAX_LODS - 1 && size < lodThresholds[lod])
+		lod++;
+	return lod;
+}
+
+void MeshRenderer::CountTriangles(int lod, uint32_t triangles, uint32_t instances)
+{
+	frameStats.triangles += triangles * instances;
+	frameStats.lodSubMeshes[lod] += instances;
+	frameStats.lodTriangles[lod] += triangles * instances;
+}
+
+uint32_t MeshRenderer::GetSortId(phmap::flat_hash_map<const void *, uint32_t> &ids, const void *p)
+{
+	auto i = ids.find(p);
+	if (i != ids.end())
+		return i->second;
+	uint32_t id = (uint32_t)ids.size();
+	ids[p] = id;
+	return id;
+}
+
+void MeshRenderer::Submit(GraphicsDeviceContext &deviceContext, Mesh *mesh, mat4 model, MeshRenderPass pass)
+{
+	// The same traversal as Render(), so queued and immediate drawing place meshes identically.
+	UpdateStatsFrame(deviceContext);
+	frustumPlanes = FrustumPlanes::FromViewStruct(deviceContext.viewStruct);
+	deviceContext.viewStruct.PushModelMatrix(*((math::Matrix4x4*)&model));
+	mat4 w;
+	mat4 tw = *((mat4*)&(mesh->orientation.GetMatrix()));
+	tw.transpose();
+	mat4::mul(w, tw, model);
+	for (auto c : mesh->children)
+		Submit(deviceContext, c, w, pass);
+	SubmitSubNode(deviceContext, mesh, mesh->GetRootNode(), pass);
+	deviceContext.viewStruct.PopModelMatrix();
+}
+
+void MeshRenderer::SubmitSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh, const Mesh::SubNode& subNode, MeshRenderPass pass)
+{
+	auto mat = subNode.orientation.GetMatrix();
+	mat.Transpose();
+	deviceContext.viewStruct.PushModelMatrix(mat);
+	if (!IsNodeVisible(deviceContext, subNode))
+	{
+		deviceContext.viewStruct.PopModelMatrix();
+		return;
+	}
+	const math::Matrix4x4 &m = deviceContext.viewStruct.model;
+	// Distance from the camera to the node's origin, as a 16-bit key: the top bits of a positive float sort as its value does.
+	vec3 d = vec3(m._14, m._24, m._34) - vec3(deviceContext.viewStruct.cam_pos);
+	float dist = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+	uint32_t distBits;
+	memcpy(&distBits, &dist, sizeof(distBits));
+	uint64_t depthKey = uint64_t(distBits >> 16) & 0xFFFF;
+	int lod = SelectLod(deviceContext, subNode);
+	for (int i = 0; i < subNode.subMeshes.size(); i++)
+	{
+		Mesh::SubMesh *subMesh = mesh->GetSubMesh(subNode.subMeshes[i]);
+		if (!subMesh || !subMesh->material)
+			continue;
+		RenderQueueItem item;
+		item.mesh = mesh;
+		item.material = subMesh->material;
+		item.subMesh = subNode.subMeshes[i];
+		item.instance = (uint32_t)queuedInstances.size();
+		item.pass = pass;
+		item.lod = (uint8_t)std::min(lod, subMesh->GetLodCount() - 1);
+		uint64_t materialKey = GetSortId(materialIds, subMesh->material) & 0xFFFFF;
+		// Mesh, submesh and level of detail, so that instances that can share a draw are adjacent.
+		uint64_t meshKey = ((uint64_t(GetSortId(meshIds, mesh)) << 11) | ((uint64_t(item.subMesh) & 0xFF) << 3) | (uint64_t(item.lod) & 0x7)) & 0xFFFFFF;
+		uint64_t passKey = uint64_t(pass) & 0xF;
+		// Opaque: pass, material, mesh, then front-to-back. Transparent: pass, then back-to-front.
+		if (pass == MeshRenderPass::TRANSPARENT_PASS)
+			item.sortKey = (passKey << 60) | ((0xFFFF - depthKey) << 44) | (materialKey << 24) | (meshKey & 0xFFFFFF);
+		else
+			item.sortKey = (passKey << 60) | (materialKey << 40) | (meshKey << 16) | depthKey;
+		renderQueue.push_back(item);
+		// The model matrix is in column-vector form, translation in _14, _24, _34. The shaders take matrices in
+		// row-vector form, as cameraConstants.view and proj are, so transpose it for upload.
+		math::Matrix4x4 transform;
+		m.Transpose(transform);
+		MeshInstance instance;
+		instance.transform = *((const mat4*)&transform);
+		queuedInstances.push_back(instance);
+		if (subMesh->bounds.IsEmpty())
+		{
+			// No bounds: a box that every plane test passes.
+			AABB all;
+			all.minimum = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			all.maximum = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+			queuedBounds.Add(all);
+		}
+		else
+			queuedBounds.Add(subMesh->bounds.Transformed(m));
+	}
+	for (int i = 0; i < subNode.children.size(); i++)
+		SubmitSubNode(deviceContext, mesh, subNode.children[i], pass);
+	deviceContext.viewStruct.PopModelMatrix();
+}
+
+void MeshRenderer::Flush(GraphicsDeviceContext &deviceContext, Texture *diffuseCubemap, Texture *specularCubemap, Texture *screenspaceShadowTexture)
+{
+	UpdateStatsFrame(deviceContext);
+	if (!renderQueue.size())
+		return;
+	if (!effect || effectReloadCount != renderPlatform->GetEffectReloadCount())
+		LoadShaders();
+	if (!effect || !instancedPasses[0] || !instancedPasses[1])
+	{
+		SIMUL_CERR_ONCE << "MeshRenderer: the solid effect has no instanced techniques, so queued meshes can't be drawn.\n";
+		renderQueue.clear();
+		queuedInstances.clear();
+		queuedBounds.Clear();
+		return;
+	}
+	// Test all the queued submeshes against the frustum at once, and drop the ones outside.
+	if (frustumCulling)
+	{
+		frustumPlanes = FrustumPlanes::FromViewStruct(deviceContext.viewStruct);
+		queuedVisible.resize(queuedBounds.Size());
+		size_t numVisible = CullAABBs(frustumPlanes, queuedBounds, queuedVisible.data());
+		if (numVisible < renderQueue.size())
+		{
+			size_t n = 0;
+			for (size_t i = 0; i < renderQueue.size(); i++)
+			{
+				if (queuedVisible[renderQueue[i].instance])
+					renderQueue[n++] = renderQueue[i];
+			}
+			frameStats.culledSubMeshes += (uint32_t)(renderQueue.size() - n);
+			renderQueue.resize(n);
+		}
+	}
+	frameStats.visibleSubMeshes += (uint32_t)renderQueue.size();
+	queuedBounds.Clear();
+	if (!renderQueue.size())
+	{
+		queuedInstances.clear();
+		return;
+	}
+	std::sort(renderQueue.begin(), renderQueue.end(), [](const RenderQueueItem &a, const RenderQueueItem &b)
+	{
+		return a.sortKey < b.sortKey;
+	});
+	// Instance data goes up once, in draw order, so each batch is a contiguous range.
+	int count = (int)renderQueue.size();
+	if (count > instanceCapacity)
+	{
+		instanceCapacity = std::max(64, instanceCapacity);
+		while (instanceCapacity < count)
+			instanceCapacity *= 2;
+		instanceBuffer.RestoreDeviceObjects(renderPlatform, instanceCapacity, false, false, nullptr, "MeshRenderer instances");
+	}
+	instanceData.resize(instanceCapacity);
+	for (int i = 0; i < count; i++)
+		instanceData[i] = queuedInstances[renderQueue[i].instance];
+	instanceBuffer.SetData(deviceContext, instanceData.data());
+
+	cameraConstants.viewProj = deviceContext.viewStruct.viewProj;
+	cameraConstants.view = deviceContext.viewStruct.view;
+	cameraConstants.proj = deviceContext.viewStruct.proj;
+	cameraConstants.viewPosition = deviceContext.viewStruct.cam_pos;
+
+	EffectPass *currentPass = nullptr;
+	Material *currentMaterial = nullptr;
+	Mesh *currentMesh = nullptr;
+	for (int i = 0; i < count;)
+	{
+		const RenderQueueItem &item = renderQueue[i];
+		// Extend the batch over every following item with the same pass, mesh, submesh, level of detail and material.
+		int n = 1;
+		while (i + n < count)
+		{
+			const RenderQueueItem &next = renderQueue[i + n];
+			if (next.pass != item.pass || next.mesh != item.mesh || next.subMesh != item.subMesh || next.lod != item.lod
+				|| next.material != item.material)
+				break;
+			n++;
+		}
+		EffectPass *pass = instancedPasses[(int)item.pass];
+		if (pass != currentPass)
+		{
+			if (currentPass)
+				renderPlatform->UnapplyPass(deviceContext);
+			renderPlatform->ApplyPass(deviceContext, pass);
+			renderPlatform->SetTexture(deviceContext, effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("diffuseCubemap")), diffuseCubemap);
+			renderPlatform->SetTexture(deviceContext, effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("specularCubemap")), specularCubemap);
+			renderPlatform->SetTexture(deviceContext, effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("screenspaceShadowTexture")), screenspaceShadowTexture);
+			renderPlatform->SetStructuredBuffer(deviceContext, &instanceBuffer, meshInstancesResource);
+			renderPlatform->SetConstantBuffer(deviceContext, &cameraConstants);
+			currentPass = pass;
+			frameStats.passChanges++;
+		}
+		if (item.material != currentMaterial)
+		{
+			ApplyMaterial(deviceContext, item.material);
+			currentMaterial = item.material;
+			frameStats.materialChanges++;
+		}
+		if (item.mesh != currentMesh)
+		{
+			if (currentMesh)
+				currentMesh->EndDraw(deviceContext);
+			item.mesh->BeginDraw(deviceContext, ShadingMode::SHADING_MODE_SHADED);
+			auto *vb = item.mesh->GetVertexBuffer();
+			renderPlatform->SetVertexBuffers(deviceContext, 0, 1, &vb, item.mesh->GetLayout());
+			renderPlatform->SetIndexBuffer(deviceContext, item.mesh->GetIndexBuffer());
+			currentMesh = item.mesh;
+			frameStats.meshChanges++;
+		}
+		const Mesh::SubMesh *subMesh = item.mesh->GetSubMesh(item.subMesh);
+		int indexOffset, triangleCount;
+		subMesh->GetLodRange(item.lod, indexOffset, triangleCount);
+		CountTriangles(item.lod, triangleCount, n);
+		perObjectConstants.model = instanceData[i].transform;
+		perObjectConstants.firstInstance = i;
+		renderPlatform->SetConstantBuffer(deviceContext, &perObjectConstants);
+		if (renderPlatform->HasInstancedDraws())
+		{
+			// A false return means the draw state couldn't be applied, which drawing each instance wouldn't fix.
+			if (renderPlatform->DrawIndexedInstanced(deviceContext, triangleCount * 3, n, indexOffset, 0))
+				frameStats.draws++;
+		}
+		else
+		{
+			// No instanced draws on this API: draw each instance, pointing the shader at its transform.
+			for (int j = 0; j < n; j++)
+			{
+				perObjectConstants.model = instanceData[i + j].transform;
+				perObjectConstants.firstInstance = i + j;
+				renderPlatform->SetConstantBuffer(deviceContext, &perObjectConstants);
+				renderPlatform->DrawIndexed(deviceContext, triangleCount * 3, indexOffset, 0);
+				frameStats.draws++;
+			}
+		}
+		frameStats.items += n;
+		i += n;
+	}
+	if (currentMesh)
+		currentMesh->EndDraw(deviceContext);
+	if (currentPass)
+		renderPlatform->UnapplyPass(deviceContext);
+	renderQueue.clear();
+	queuedInstances.clear();
+}
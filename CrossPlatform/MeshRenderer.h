@@ -4,6 +4,8 @@
 #include "Platform/CrossPlatform/Shaders/solid_constants.sl"
 #include "Platform/CrossPlatform/Mesh.h"
 #include "Export.h"
+#include <parallel_hashmap/phmap.h>
+#include <vector>
 
 #ifdef _MSC_VER
 	#pragma warning(push)  
@@ -14,6 +16,27 @@ namespace platform
 {
 	namespace crossplatform
 	{
+		//! Which of the MeshRenderer's queued passes a mesh is drawn in. Opaque items are sorted by state, transparent ones back-to-front.
+		enum class MeshRenderPass : uint8_t
+		{
+			OPAQUE_PASS=0,
+			TRANSPARENT_PASS=1
+		};
+		//! Counts for the last frame's queued mesh rendering.
+		struct MeshRenderStats
+		{
+			uint32_t items=0;				//!< Submeshes submitted.
+			uint32_t draws=0;				//!< Draw calls, after merging identical mesh/material pairs.
+			uint32_t passChanges=0;
+			uint32_t materialChanges=0;
+			uint32_t meshChanges=0;			//!< Vertex and index buffer rebinds.
+			uint32_t culledNodes=0;			//!< Nodes whose whole subtree was outside the frustum.
+			uint32_t culledSubMeshes=0;		//!< Submeshes outside the frustum, in nodes that were not culled.
+			uint32_t visibleSubMeshes=0;	//!< Submeshes that passed the frustum test, in both queued and immediate rendering.
+			uint32_t triangles=0;			//!< Triangles drawn, over all instances.
+			uint32_t lodSubMeshes[Mesh::SubMesh::MAX_LODS]={};	//!< Submesh instances drawn at each level of detail.
+			uint32_t lodTriangles[Mesh::SubMesh::MAX_LODS]={};	//!< Triangles drawn at each level of detail.
+		};
 		class SIMUL_CROSSPLATFORM_EXPORT MeshRenderer
 		{
 		public:
@@ -28,13 +51,91 @@ namespace platform
 			void Render(GraphicsDeviceContext &deviceContext, Mesh *mesh,mat4 model
 						,Texture *diffuseCubemap,Texture *specularCubemap,Texture *screenspaceShadow);
 			void ApplyMaterial(DeviceContext &deviceContext, Material *material);
+			//! Queue the mesh for drawing in the next Flush(), rather than drawing it now.
+			void Submit(GraphicsDeviceContext &deviceContext, Mesh *mesh, mat4 model, MeshRenderPass pass = MeshRenderPass::OPAQUE_PASS);
+			//! Sort and draw everything submitted since the last Flush(). Submeshes with the same mesh and material are drawn as one instanced draw.
+			void Flush(GraphicsDeviceContext &deviceContext, Texture *diffuseCubemap, Texture *specularCubemap, Texture *screenspaceShadow);
+			//! Stats for the last complete frame of rendering. The triangle counts, total and per level of detail, are also set as counters on the GPU profiler.
+			const MeshRenderStats &GetStats() const
+			{
+				return lastFrameStats;
+			}
+			//! Skip nodes and submeshes whose bounds are outside the view frustum. On by default.
+			void SetFrustumCulling(bool c)
+			{
+				frustumCulling = c;
+			}
+			bool GetFrustumCulling() const
+			{
+				return frustumCulling;
+			}
+			//! Screen sizes at which nodes switch to simpler levels of detail. The size is the radius of the node's bounding sphere on
+			//! screen, as a fraction of half the viewport height: below thresholds[i], level i+1 is drawn, if the submesh has it.
+			//! Thresholds should decrease. Empty means always draw level zero.
+			void SetLodThresholds(const std::vector<float> &t)
+			{
+				lodThresholds = t;
+			}
+			const std::vector<float> &GetLodThresholds() const
+			{
+				return lodThresholds;
+			}
 		protected:
-			void DrawSubMesh(GraphicsDeviceContext& deviceContext, Mesh* mesh, int);
+			void DrawSubMesh(GraphicsDeviceContext& deviceContext, Mesh* mesh, int, int lod = 0);
 			void DrawSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh, const Mesh::SubNode& subNode);
+			void SubmitSubNode(GraphicsDeviceContext& deviceContext, Mesh* mesh, const Mesh::SubNode& subNode, MeshRenderPass pass);
+			uint32_t GetSortId(phmap::flat_hash_map<const void *, uint32_t> &ids, const void *p);
+			void UpdateStatsFrame(DeviceContext &deviceContext);
+			//! Copy the last frame's triangle and instance counts to the GPU profiler's counters, for overlays.
+			void PublishStats(DeviceContext &deviceContext) const;
+			//! Returns false, and counts the node as culled, if it is outside the frustum. The node's matrix must already be pushed.
+			bool IsNodeVisible(const GraphicsDeviceContext &deviceContext, const Mesh::SubNode &subNode);
+			//! The level of detail for the node's submeshes, from its projected size. The node's matrix must already be pushed.
+			int SelectLod(const GraphicsDeviceContext &deviceContext, const Mesh::SubNode &subNode) const;
+			void CountTriangles(int lod, uint32_t triangles, uint32_t instances);
 			ConstantBuffer<CameraConstants> cameraConstants;
 			RenderPlatform *renderPlatform;
 			Effect *effect;
+			//! RenderPlatform::GetEffectReloadCount() when the effect was loaded.
+			uint64_t effectReloadCount = 0;
 			crossplatform::ConstantBuffer<SolidConstants> solidConstants;
+			crossplatform::ConstantBuffer<PerObjectConstants> perObjectConstants;
+			// Looked up once in LoadShaders().
+			ShaderResource diffuseTextureResource;
+			ShaderResource normalTextureResource;
+			ShaderResource metalTextureResource;
+			ShaderResource ambientOcclusionTextureResource;
+			ShaderResource emissiveTextureResource;
+			ShaderResource meshInstancesResource;
+			EffectPass *instancedPasses[2] = { nullptr, nullptr };
+			//! A compact record of one queued submesh; its transform is in queuedInstances.
+			struct RenderQueueItem
+			{
+				uint64_t sortKey;
+				Mesh *mesh;
+				Material *material;
+				int subMesh;
+				uint32_t instance;
+				MeshRenderPass pass;
+				uint8_t lod;
+			};
+			std::vector<RenderQueueItem> renderQueue;
+			std::vector<MeshInstance> queuedInstances;
+			std::vector<MeshInstance> instanceData;
+			crossplatform::StructuredBuffer<MeshInstance> instanceBuffer;
+			int instanceCapacity = 0;
+			// Small, stable ids for the sort key.
+			phmap::flat_hash_map<const void *, uint32_t> materialIds;
+			phmap::flat_hash_map<const void *, uint32_t> meshIds;
+			bool frustumCulling = true;
+			std::vector<float> lodThresholds = { 0.25f, 0.125f, 0.0625f, 0.03125f, 0.015625f, 0.0078125f, 0.00390625f };
+			FrustumPlanes frustumPlanes;
+			// Worldspace bounds of the queued submeshes, indexed like queuedInstances, culled as a batch in Flush().
+			AABBArray queuedBounds;
+			std::vector<uint8_t> queuedVisible;
+			MeshRenderStats frameStats;
+			MeshRenderStats lastFrameStats;
+			long long statsFrame = -1;
 		};
 	}
 }
@@ -0,0 +1,296 @@
+#include "Platform/CrossPlatform/MeshSimplify.h"
+#include <parallel_hashmap/phmap.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+	// The sum of squared distances to a set of planes, weighted by triangle area.
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+		void AddPlane(double nx, double ny, double nz, double d, double w)
+		{
+			a00 += w * nx * nx;
+			a01 += w * nx * ny;
+			a02 += w * nx * nz;
+			a11 += w * ny * ny;
+			a12 += w * ny * nz;
+			a22 += w * nz * nz;
+			b0 += w * nx * d;
+			b1 += w * ny * d;
+			b2 += w * nz * d;
+			c += w * d * d;
+			weight += w;
+		}
+		void Add(const Quadric &q)
+		{
+			a00 += q.a00;
+			a01 += q.a01;
+			a02 += q.a02;
+			a11 += q.a11;
+			a12 += q.a12;
+			a22 += q.a22;
+			b0 += q.b0;
+			b1 += q.b1;
+			b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+		// The mean squared distance from p to the planes.
+		double Error(const Position &p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = x * (a00 * x + a01 * y + a02 * z) + y * (a01 * x + a11 * y + a12 * z) + z * (a02 * x + a12 * y + a22 * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0 ? std::max(0.0, e) / weight : 0.0;
+		}
+	};
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+	void Cross(const Position &a, const Position &b, const Position &c, double n[3])
+	{
+		double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+		double vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+		n[0] = uy * vz - uz * vy;
+		n[1] = uz * vx - ux * vz;
+		n[2] = ux * vy - uy * vx;
+	}
+}
+
+size_t platform::crossplatform::SimplifyMesh(uint32_t *destination, const uint32_t *indices, size_t numIndices
+	, const void *vertices, size_t numVertices, size_t vertexSize, size_t targetIndexCount, float targetError, float *resultError)
+{
+	if (resultError)
+		*resultError = 0.0f;
+	std::vector<uint32_t> result(indices, indices + (numIndices / 3) * 3);
+	if (!numVertices || result.size() <= targetIndexCount)
+	{
+		memmove(destination, result.data(), result.size() * sizeof(uint32_t));
+		return result.size();
+	}
+	std::vector<Position> positions(numVertices);
+	for (size_t v = 0; v < numVertices; v++)
+		memcpy(&positions[v], (const uint8_t *)vertices + v * vertexSize, sizeof(Position));
+	Position lo = positions[result[0]], hi = lo;
+	for (uint32_t i : result)
+	{
+		const Position &p = positions[i];
+		lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+		hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+	}
+	double extent = std::max(double(hi.x - lo.x), std::max(double(hi.y - lo.y), double(hi.z - lo.z)));
+	if (extent <= 0.0)
+		extent = 1.0;
+	// Vertices that share a position are one point of the surface: find one representative for each.
+	std::vector<uint32_t> representative(numVertices);
+	std::vector<uint32_t> sharing(numVertices, 0);
+	{
+		struct PositionHash
+		{
+			size_t operator()(const Position &p) const
+			{
+				uint32_t h[3];
+				memcpy(h, &p, sizeof(h));
+				return (size_t)(h[0] * 73856093u ^ h[1] * 19349663u ^ h[2] * 83492791u);
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()(const Position &a, const Position &b) const
+			{
+				return memcmp(&a, &b, sizeof(Position)) == 0;
+			}
+		};
+		phmap::flat_hash_map<Position, uint32_t, PositionHash, PositionEqual> first;
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			auto r = first.insert({positions[v], (uint32_t)v});
+			representative[v] = r.first->second;
+			sharing[r.first->second]++;
+		}
+	}
+	// A vertex may be removed only if it is the sole vertex at its position, and not on an open or non-manifold edge.
+	std::vector<uint8_t> removable(numVertices, 0);
+	for (size_t v = 0; v < numVertices; v++)
+		removable[v] = sharing[representative[v]] == 1 ? 1 : 0;
+	{
+		phmap::flat_hash_map<uint64_t, uint32_t> edgeCount;
+		for (size_t t = 0; t < result.size(); t += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t a = representative[result[t + k]], b = representative[result[t + (k + 1) % 3]];
+				uint64_t key = a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+				edgeCount[key]++;
+			}
+		}
+		for (const auto &e : edgeCount)
+		{
+			if (e.second != 2)
+			{
+				uint32_t a = (uint32_t)(e.first >> 32), b = (uint32_t)(e.first & 0xFFFFFFFF);
+				removable[a] = 0;
+				removable[b] = 0;
+			}
+		}
+		// Vertices at a locked position are locked too.
+		for (size_t v = 0; v < numVertices; v++)
+			removable[v] = removable[v] && removable[representative[v]];
+	}
+	std::vector<Quadric> quadrics(numVertices);
+	for (size_t t = 0; t < result.size(); t += 3)
+	{
+		const Position &a = positions[result[t]], &b = positions[result[t + 1]], &c = positions[result[t + 2]];
+		double n[3];
+		Cross(a, b, c, n);
+		double l = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l <= 0.0)
+			continue;
+		double area = 0.5 * l;
+		n[0] /= l;
+		n[1] /= l;
+		n[2] /= l;
+		double d = -(n[0] * a.x + n[1] * a.y + n[2] * a.z);
+		for (int k = 0; k < 3; k++)
+			quadrics[representative[result[t + k]]].AddPlane(n[0], n[1], n[2], d, area);
+	}
+	const double maxCost = (double)targetError * extent * (double)targetError * extent;
+	double worstCost = 0.0;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(numVertices);
+	std::vector<uint8_t> touched(numVertices);
+	std::vector<uint32_t> adjacencyOffsets(numVertices + 1);
+	std::vector<uint32_t> adjacency;
+	// Each pass collapses a set of edges that don't share any triangle, so that decisions made in the pass stay valid.
+	for (int pass = 0; pass < 100 && result.size() > targetIndexCount; pass++)
+	{
+		collapses.clear();
+		for (size_t t = 0; t < result.size(); t += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t a = result[t + k], b = result[t + (k + 1) % 3];
+				Quadric q;
+				if (removable[a])
+				{
+					q = quadrics[a];
+					q.Add(quadrics[representative[b]]);
+					collapses.push_back({a, b, q.Error(positions[b])});
+				}
+				if (removable[b])
+				{
+					q = quadrics[b];
+					q.Add(quadrics[representative[a]]);
+					collapses.push_back({b, a, q.Error(positions[a])});
+				}
+			}
+		}
+		if (collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y)
+		{
+			return x.cost < y.cost;
+		});
+		// Vertex to triangle adjacency, for the flip test.
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t i : result)
+			adjacencyOffsets[i + 1]++;
+		for (size_t v = 0; v < numVertices; v++)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+				adjacency[fill[result[i]]++] = (uint32_t)(i / 3);
+		}
+		for (size_t v = 0; v < numVertices; v++)
+			remap[v] = (uint32_t)v;
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t trianglesLeft = result.size() / 3;
+		size_t targetTriangles = targetIndexCount / 3;
+		size_t made = 0;
+		for (const Collapse &c : collapses)
+		{
+			if (c.cost > maxCost || trianglesLeft <= targetTriangles)
+				break;
+			if (touched[c.from] || touched[c.to])
+				continue;
+			// Reject the collapse if it would flip any triangle that survives it.
+			bool flips = false;
+			size_t removed = 0;
+			for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1] && !flips; a++)
+			{
+				const uint32_t *tri = &result[adjacency[a] * 3];
+				if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+				{
+					removed++;
+					continue;
+				}
+				Position p[3], q[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = positions[tri[k]];
+					q[k] = tri[k] == c.from ? positions[c.to] : p[k];
+				}
+				double n0[3], n1[3];
+				Cross(p[0], p[1], p[2], n0);
+				Cross(q[0], q[1], q[2], n1);
+				if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0)
+					flips = true;
+			}
+			if (flips)
+				continue;
+			remap[c.from] = c.to;
+			quadrics[representative[c.to]].Add(quadrics[c.from]);
+			worstCost = std::max(worstCost, c.cost);
+			trianglesLeft -= std::min(trianglesLeft, removed);
+			made++;
+			for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; a++)
+			{
+				const uint32_t *tri = &result[adjacency[a] * 3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+			}
+			touched[c.to] = 1;
+		}
+		if (!made)
+			break;
+		size_t n = 0;
+		for (size_t t = 0; t < result.size(); t += 3)
+		{
+			uint32_t a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			result[n++] = a;
+			result[n++] = b;
+			result[n++] = c;
+		}
+		result.resize(n);
+		// Removed vertices can't be collapsed again.
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			if (remap[v] != v)
+				removable[v] = 0;
+		}
+	}
+	if (resultError)
+		*resultError = (float)(sqrt(worstCost) / extent);
+	memmove(destination, result.data(), result.size() * sizeof(uint32_t));
+	return result.size();
+}
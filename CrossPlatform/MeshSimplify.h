@@ -0,0 +1,22 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! Simplify a triangle list by edge collapses ordered by quadric error (Garland and Heckbert 1997).
+		//! Each vertex collapses onto a neighbour, so the result uses a subset of the original vertices and needs
+		//! only a new index list. Vertices on open borders, and vertices that share a position with another
+		//! (attribute seams), are never removed, so the outline and the seams are kept intact.
+		//!
+		//! Positions are the first three floats of each vertex. Stops at \a targetIndexCount indices, or when the next
+		//! collapse would move the surface by more than \a targetError, relative to the size of the mesh.
+		//! Writes at most \a numIndices indices to \a destination, which may equal \a indices, and returns the number written.
+		//! If \a resultError is given, it receives the largest relative error of the collapses made.
+		extern SIMUL_CROSSPLATFORM_EXPORT size_t SimplifyMesh(uint32_t *destination, const uint32_t *indices, size_t numIndices
+			, const void *vertices, size_t numVertices, size_t vertexSize, size_t targetIndexCount, float targetError, float *resultError = nullptr);
+	}
+}
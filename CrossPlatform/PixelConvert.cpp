@@ -0,0 +1,466 @@
+#include "Platform/CrossPlatform/PixelConvert.h"
+#include "Platform/Core/ThreadPool.h"
+#include "Platform/Math/Float16.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PLATFORM_PIXELCONVERT_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	// Images smaller than this are converted on the calling thread.
+	const size_t kMinParallelPixels = 64 * 1024;
+	// The smallest number of pixels handed to a worker at once.
+	const size_t kPixelsPerJob = 16 * 1024;
+
+	PixelLayout MakeLayout(ComponentType type, uint8_t channels, bool normalized, bool bgra = false, bool srgb = false)
+	{
+		PixelLayout l;
+		l.type = type;
+		l.channels = channels;
+		l.normalized = normalized;
+		l.bgra = bgra;
+		l.srgb = srgb;
+		return l;
+	}
+
+	bool SameLayout(const PixelLayout &a, const PixelLayout &b)
+	{
+		return a.type == b.type && a.channels == b.channels && a.bgra == b.bgra && a.srgb == b.srgb
+			&& (a.normalized == b.normalized || a.type == ComponentType::FLOAT32 || a.type == ComponentType::FLOAT16);
+	}
+
+	// Like std::clamp, but NaN maps to lo so the integer casts below stay defined.
+	template <typename F>
+	F Saturate(F x, F lo, F hi)
+	{
+		return x >= lo ? (x <= hi ? x : hi) : lo;
+	}
+
+	float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float c)
+	{
+		c = Saturate(c, 0.0f, 1.0f);
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	struct SRGBTable
+	{
+		float toLinear[256];
+		SRGBTable()
+		{
+			for (int i = 0; i < 256; i++)
+				toLinear[i] = SRGBToLinear(float(i) / 255.0f);
+		}
+	};
+
+	template <typename T>
+	void DecodeNormalized(const T *src, float *dst, size_t n, float scale, bool isSigned)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = float(src[i]) * scale;
+		if (isSigned)
+			for (size_t i = 0; i < n; i++)
+				dst[i] = std::max(dst[i], -1.0f);
+	}
+
+	template <typename T>
+	void DecodeInteger(const T *src, float *dst, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = float(src[i]);
+	}
+
+	template <typename T>
+	void EncodeNormalized(const float *src, T *dst, size_t n, float lo, float scale)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = T(floorf(Saturate(src[i], lo, 1.0f) * scale + 0.5f));
+	}
+
+	// 32-bit normalized values need double precision to hit every integer.
+	template <typename T>
+	void EncodeNormalized32(const float *src, T *dst, size_t n, double lo, double scale)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = T(floor(Saturate((double)src[i], lo, 1.0) * scale + 0.5));
+	}
+
+	template <typename T>
+	void EncodeInteger(const float *src, T *dst, size_t n, double lo, double hi)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = T(Saturate(floor((double)src[i] + 0.5), lo, hi));
+	}
+
+	void DecodeUnorm8(const uint8_t *src, float *dst, size_t n)
+	{
+		const float scale = 1.0f / 255.0f;
+		size_t i = 0;
+#if PLATFORM_PIXELCONVERT_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 s = _mm_set1_ps(scale);
+		for (; i + 16 <= n; i += 16)
+		{
+			__m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), s));
+			_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s));
+			_mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s));
+			_mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s));
+		}
+#endif
+		for (; i < n; i++)
+			dst[i] = float(src[i]) * scale;
+	}
+
+	void EncodeUnorm8(const float *src, uint8_t *dst, size_t n)
+	{
+		size_t i = 0;
+#if PLATFORM_PIXELCONVERT_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 16 <= n; i += 16)
+		{
+			__m128i v[4];
+			for (int j = 0; j < 4; j++)
+			{
+				// max(x,0) also maps NaN to zero, as the scalar clamp below does.
+				__m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4 * j), zero), one);
+				v[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, scale), half));
+			}
+			__m128i w0 = _mm_packs_epi32(v[0], v[1]);
+			__m128i w1 = _mm_packs_epi32(v[2], v[3]);
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(w0, w1));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			dst[i] = uint8_t(Saturate(src[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+	// Decode n components of the given layout into floats.
+	void DecodeComponents(const PixelLayout &l, const void *src, float *dst, size_t n)
+	{
+		switch (l.type)
+		{
+		case ComponentType::FLOAT32:
+			memcpy(dst, src, n * sizeof(float));
+			break;
+		case ComponentType::FLOAT16:
+			math::ToFloat32((const uint16_t *)src, dst, n);
+			break;
+		case ComponentType::UINT8:
+			if (l.normalized)
+				DecodeUnorm8((const uint8_t *)src, dst, n);
+			else
+				DecodeInteger((const uint8_t *)src, dst, n);
+			break;
+		case ComponentType::SINT8:
+			if (l.normalized)
+				DecodeNormalized((const int8_t *)src, dst, n, 1.0f / 127.0f, true);
+			else
+				DecodeInteger((const int8_t *)src, dst, n);
+			break;
+		case ComponentType::UINT16:
+			if (l.normalized)
+				DecodeNormalized((const uint16_t *)src, dst, n, 1.0f / 65535.0f, false);
+			else
+				DecodeInteger((const uint16_t *)src, dst, n);
+			break;
+		case ComponentType::SINT16:
+			if (l.normalized)
+				DecodeNormalized((const int16_t *)src, dst, n, 1.0f / 32767.0f, true);
+			else
+				DecodeInteger((const int16_t *)src, dst, n);
+			break;
+		case ComponentType::UINT32:
+			if (l.normalized)
+				for (size_t i = 0; i < n; i++)
+					dst[i] = float(((const uint32_t *)src)[i] / 4294967295.0);
+			else
+				DecodeInteger((const uint32_t *)src, dst, n);
+			break;
+		case ComponentType::SINT32:
+			if (l.normalized)
+				for (size_t i = 0; i < n; i++)
+					dst[i] = std::max(-1.0f, float(((const int32_t *)src)[i] / 2147483647.0));
+			else
+				DecodeInteger((const int32_t *)src, dst, n);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Encode n floats as components of the given layout.
+	void EncodeComponents(const PixelLayout &l, const float *src, void *dst, size_t n)
+	{
+		switch (l.type)
+		{
+		case ComponentType::FLOAT32:
+			memcpy(dst, src, n * sizeof(float));
+			break;
+		case ComponentType::FLOAT16:
+			math::ToFloat16(src, (uint16_t *)dst, n);
+			break;
+		case ComponentType::UINT8:
+			if (l.normalized)
+				EncodeUnorm8(src, (uint8_t *)dst, n);
+			else
+				EncodeInteger(src, (uint8_t *)dst, n, 0.0, 255.0);
+			break;
+		case ComponentType::SINT8:
+			if (l.normalized)
+				EncodeNormalized(src, (int8_t *)dst, n, -1.0f, 127.0f);
+			else
+				EncodeInteger(src, (int8_t *)dst, n, -128.0, 127.0);
+			break;
+		case ComponentType::UINT16:
+			if (l.normalized)
+				EncodeNormalized(src, (uint16_t *)dst, n, 0.0f, 65535.0f);
+			else
+				EncodeInteger(src, (uint16_t *)dst, n, 0.0, 65535.0);
+			break;
+		case ComponentType::SINT16:
+			if (l.normalized)
+				EncodeNormalized(src, (int16_t *)dst, n, -1.0f, 32767.0f);
+			else
+				EncodeInteger(src, (int16_t *)dst, n, -32768.0, 32767.0);
+			break;
+		case ComponentType::UINT32:
+			if (l.normalized)
+				EncodeNormalized32(src, (uint32_t *)dst, n, 0.0, 4294967295.0);
+			else
+				EncodeInteger(src, (uint32_t *)dst, n, 0.0, 4294967295.0);
+			break;
+		case ComponentType::SINT32:
+			if (l.normalized)
+				EncodeNormalized32(src, (int32_t *)dst, n, -1.0, 2147483647.0);
+			else
+				EncodeInteger(src, (int32_t *)dst, n, -2147483648.0, 2147483647.0);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Spread packed channels out to RGBA, filling in defaults and undoing BGR ordering.
+	void ExpandToRGBA(const float *src, float *rgba, size_t width, const PixelLayout &l)
+	{
+		const size_t c = l.channels;
+		const int r = l.bgra && c >= 3 ? 2 : 0;
+		const int b = l.bgra && c >= 3 ? 0 : 2;
+		for (size_t i = 0; i < width; i++, src += c, rgba += 4)
+		{
+			rgba[0] = src[r];
+			rgba[1] = c > 1 ? src[1] : 0.0f;
+			rgba[2] = c > 2 ? src[b] : 0.0f;
+			rgba[3] = c > 3 ? src[3] : 1.0f;
+		}
+	}
+
+	void PackFromRGBA(const float *rgba, float *dst, size_t width, const PixelLayout &l)
+	{
+		const size_t c = l.channels;
+		const int r = l.bgra && c >= 3 ? 2 : 0;
+		const int b = l.bgra && c >= 3 ? 0 : 2;
+		for (size_t i = 0; i < width; i++, dst += c, rgba += 4)
+		{
+			dst[r] = rgba[0];
+			if (c > 1)
+				dst[1] = rgba[1];
+			if (c > 2)
+				dst[b] = rgba[2];
+			if (c > 3)
+				dst[3] = rgba[3];
+		}
+	}
+}
+
+size_t PixelLayout::ComponentSize() const
+{
+	switch (type)
+	{
+	case ComponentType::FLOAT32:
+	case ComponentType::UINT32:
+	case ComponentType::SINT32:
+		return 4;
+	case ComponentType::FLOAT16:
+	case ComponentType::UINT16:
+	case ComponentType::SINT16:
+		return 2;
+	case ComponentType::UINT8:
+	case ComponentType::SINT8:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+PixelLayout PixelConvert::GetLayout(PixelFormat f)
+{
+	using C = ComponentType;
+	switch (f)
+	{
+	case RGBA_32_FLOAT:			return MakeLayout(C::FLOAT32, 4, false);
+	case RGBA_32_UINT:			return MakeLayout(C::UINT32, 4, false);
+	case RGBA_32_INT:			return MakeLayout(C::SINT32, 4, false);
+	case RGBA_16_FLOAT:			return MakeLayout(C::FLOAT16, 4, false);
+	case RGBA_16_UINT:			return MakeLayout(C::UINT16, 4, false);
+	case RGBA_16_INT:			return MakeLayout(C::SINT16, 4, false);
+	case RGBA_16_SNORM:			return MakeLayout(C::SINT16, 4, true);
+	case RGBA_16_UNORM:			return MakeLayout(C::UINT16, 4, true);
+	case RGBA_8_UINT:			return MakeLayout(C::UINT8, 4, false);
+	case RGBA_8_INT:			return MakeLayout(C::SINT8, 4, false);
+	case RGBA_8_SNORM:			return MakeLayout(C::SINT8, 4, true);
+	case RGBA_8_UNORM:			return MakeLayout(C::UINT8, 4, true);
+	case RGBA_8_UNORM_SRGB:		return MakeLayout(C::UINT8, 4, true, false, true);
+	case BGRA_8_UNORM:			return MakeLayout(C::UINT8, 4, true, true);
+	case RGB_32_FLOAT:			return MakeLayout(C::FLOAT32, 3, false);
+	case RGB_32_UINT:			return MakeLayout(C::UINT32, 3, false);
+	case RGB_16_FLOAT:			return MakeLayout(C::FLOAT16, 3, false);
+	case RGB_8_UNORM:			return MakeLayout(C::UINT8, 3, true);
+	case RGB_8_SNORM:			return MakeLayout(C::SINT8, 3, true);
+	case RG_32_FLOAT:			return MakeLayout(C::FLOAT32, 2, false);
+	case RG_32_UINT:			return MakeLayout(C::UINT32, 2, false);
+	case RG_16_FLOAT:			return MakeLayout(C::FLOAT16, 2, false);
+	case RG_16_UINT:			return MakeLayout(C::UINT16, 2, false);
+	case RG_16_INT:				return MakeLayout(C::SINT16, 2, false);
+	case RG_8_UNORM:			return MakeLayout(C::UINT8, 2, true);
+	case RG_8_SNORM:			return MakeLayout(C::SINT8, 2, true);
+	case R_32_FLOAT:
+	case LUM_32_FLOAT:
+	case INT_32_FLOAT:
+	case D_32_FLOAT:			return MakeLayout(C::FLOAT32, 1, false);
+	case R_32_UINT:
+	case D_32_UINT:				return MakeLayout(C::UINT32, 1, false);
+	case R_32_INT:				return MakeLayout(C::SINT32, 1, false);
+	case D_16_UNORM:			return MakeLayout(C::UINT16, 1, true);
+	case R_16_FLOAT:			return MakeLayout(C::FLOAT16, 1, false);
+	case R_8_UNORM:				return MakeLayout(C::UINT8, 1, true);
+	case R_8_SNORM:				return MakeLayout(C::SINT8, 1, true);
+	default:
+		return PixelLayout();
+	}
+}
+
+bool PixelConvert::IsSupported(PixelFormat src, PixelFormat dst)
+{
+	return GetLayout(src).IsValid() && GetLayout(dst).IsValid();
+}
+
+void PixelConvert::ConvertRow(const PixelLayout &srcLayout, const void *src, const PixelLayout &dstLayout, void *dst, size_t width)
+{
+	if (SameLayout(srcLayout, dstLayout))
+	{
+		memcpy(dst, src, width * srcLayout.PixelSize());
+		return;
+	}
+	thread_local std::vector<float> components;
+	thread_local std::vector<float> rgba;
+	static const SRGBTable srgbTable;
+
+	float *rgbaRow = nullptr;
+	const bool directRGBA = srcLayout.channels == 4 && !srcLayout.bgra;
+	if (directRGBA)
+	{
+		rgba.resize(width * 4);
+		rgbaRow = rgba.data();
+		if (srcLayout.srgb && srcLayout.type == ComponentType::UINT8 && !dstLayout.srgb)
+		{
+			const uint8_t *s = (const uint8_t *)src;
+			for (size_t i = 0; i < width * 4; i += 4)
+			{
+				rgbaRow[i] = srgbTable.toLinear[s[i]];
+				rgbaRow[i + 1] = srgbTable.toLinear[s[i + 1]];
+				rgbaRow[i + 2] = srgbTable.toLinear[s[i + 2]];
+				rgbaRow[i + 3] = float(s[i + 3]) / 255.0f;
+			}
+		}
+		else
+			DecodeComponents(srcLayout, src, rgbaRow, width * 4);
+	}
+	else
+	{
+		components.resize(width * srcLayout.channels);
+		rgba.resize(width * 4);
+		rgbaRow = rgba.data();
+		DecodeComponents(srcLayout, src, components.data(), components.size());
+		ExpandToRGBA(components.data(), rgbaRow, width, srcLayout);
+	}
+	// sRGB to sRGB needs no transfer; otherwise decode or encode the colour channels.
+	const bool decodedSRGB = directRGBA && srcLayout.srgb && srcLayout.type == ComponentType::UINT8;
+	if (srcLayout.srgb && !dstLayout.srgb && !decodedSRGB)
+	{
+		for (size_t i = 0; i < width * 4; i += 4)
+			for (int c = 0; c < 3; c++)
+				rgbaRow[i + c] = SRGBToLinear(rgbaRow[i + c]);
+	}
+	else if (dstLayout.srgb && !srcLayout.srgb)
+	{
+		for (size_t i = 0; i < width * 4; i += 4)
+			for (int c = 0; c < 3; c++)
+				rgbaRow[i + c] = LinearToSRGB(rgbaRow[i + c]);
+	}
+	if (dstLayout.channels == 4 && !dstLayout.bgra)
+	{
+		EncodeComponents(dstLayout, rgbaRow, dst, width * 4);
+	}
+	else
+	{
+		components.resize(width * dstLayout.channels);
+		PackFromRGBA(rgbaRow, components.data(), width, dstLayout);
+		EncodeComponents(dstLayout, components.data(), dst, components.size());
+	}
+}
+
+bool PixelConvert::Convert(const PixelLayout &srcLayout, const void *src, size_t srcRowPitch
+	, const PixelLayout &dstLayout, void *dst, size_t dstRowPitch
+	, size_t width, size_t height, bool multithreaded)
+{
+	if (!srcLayout.IsValid() || !dstLayout.IsValid() || !src || !dst)
+		return false;
+	if (!srcRowPitch)
+		srcRowPitch = width * srcLayout.PixelSize();
+	if (!dstRowPitch)
+		dstRowPitch = width * dstLayout.PixelSize();
+	auto convertRows = [&](size_t begin, size_t end)
+	{
+		for (size_t y = begin; y < end; y++)
+			ConvertRow(srcLayout, (const uint8_t *)src + y * srcRowPitch, dstLayout, (uint8_t *)dst + y * dstRowPitch, width);
+	};
+	if (multithreaded && width * height >= kMinParallelPixels)
+	{
+		size_t rowsPerJob = std::max<size_t>(1, kPixelsPerJob / std::max<size_t>(1, width));
+		core::ThreadPool::Get().ParallelFor(height, rowsPerJob, convertRows);
+	}
+	else
+	{
+		convertRows(0, height);
+	}
+	return true;
+}
+
+bool PixelConvert::Convert(PixelFormat srcFormat, const void *src, size_t srcRowPitch
+	, PixelFormat dstFormat, void *dst, size_t dstRowPitch
+	, size_t width, size_t height, bool multithreaded)
+{
+	return Convert(GetLayout(srcFormat), src, srcRowPitch, GetLayout(dstFormat), dst, dstRowPitch, width, height, multithreaded);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/PixelFormat.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! The storage type of one channel of a pixel.
+		enum class ComponentType : uint8_t
+		{
+			UNKNOWN = 0,
+			FLOAT32,
+			FLOAT16,
+			UINT8,
+			SINT8,
+			UINT16,
+			SINT16,
+			UINT32,
+			SINT32
+		};
+		//! How a pixel is laid out in memory: component type, channel count and ordering.
+		//! Integer components are either normalized (UNORM/SNORM), or converted as plain integer values.
+		struct SIMUL_CROSSPLATFORM_EXPORT PixelLayout
+		{
+			ComponentType type = ComponentType::UNKNOWN;
+			uint8_t channels = 0;
+			bool normalized = false;
+			//! Red and blue are swapped in memory.
+			bool bgra = false;
+			//! Colour channels are sRGB-encoded; alpha is always linear.
+			bool srgb = false;
+			bool IsValid() const
+			{
+				return type != ComponentType::UNKNOWN && channels > 0 && channels <= 4;
+			}
+			size_t ComponentSize() const;
+			size_t PixelSize() const
+			{
+				return ComponentSize() * channels;
+			}
+		};
+		//! Converts images and rows of pixels between any two uncompressed, non-packed PixelFormats.
+		//! Pixels go through a float RGBA intermediate; missing colour channels become 0 and missing alpha becomes 1.
+		//! Floats are clamped when written to normalized or integer formats, with round-to-nearest.
+		class SIMUL_CROSSPLATFORM_EXPORT PixelConvert
+		{
+		public:
+			//! Describe a PixelFormat. Returns an invalid layout for compressed, packed and depth-stencil formats.
+			static PixelLayout GetLayout(PixelFormat f);
+			//! Whether Convert() can read src and write dst.
+			static bool IsSupported(PixelFormat src, PixelFormat dst);
+			//! Convert a single row of width pixels.
+			static void ConvertRow(const PixelLayout &srcLayout, const void *src, const PixelLayout &dstLayout, void *dst, size_t width);
+			//! Convert a width x height image. Pitches of zero mean tightly-packed rows. If multithreaded is set,
+			//! large images are split by rows across core::ThreadPool::Get().
+			static bool Convert(const PixelLayout &srcLayout, const void *src, size_t srcRowPitch
+				, const PixelLayout &dstLayout, void *dst, size_t dstRowPitch
+				, size_t width, size_t height, bool multithreaded = true);
+			static bool Convert(PixelFormat srcFormat, const void *src, size_t srcRowPitch
+				, PixelFormat dstFormat, void *dst, size_t dstRowPitch
+				, size_t width, size_t height, bool multithreaded = true);
+		};
+	}
+}
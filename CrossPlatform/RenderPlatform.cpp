@@ -17,6 +17,9 @@
 #include "Platform/CrossPlatform/BottomLevelAccelerationStructure.h"
 #include "Platform/CrossPlatform/AccelerationStructureManager.h"
 #include "Platform/CrossPlatform/ShaderBindingTable.h"
+#include "Platform/CrossPlatform/PixelConvert.h"
+#include "Platform/CrossPlatform/TextureCapture.h"
+#include "Platform/Core/FileWatcher.h"
 #include "Effect.h"
 
 #if PLATFORM_STD_FILESYSTEM==0
@@ -29,8 +32,16 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <fstream>
 #include <fmt/core.h>
 
+// Platforms that can run Sfx to rebuild effects at runtime.
+#if (defined(WIN32) && !defined(_GAMING_XBOX)) || (defined(UNIX) && PLATFORM_STD_FILESYSTEM==1)
+#define PLATFORM_RUNTIME_EFFECT_COMPILE 1
+#else
+#define PLATFORM_RUNTIME_EFFECT_COMPILE 0
+#endif
+
 using namespace std::literals;
 using namespace std::string_literals;
 using namespace std::literals::string_literals;
@@ -81,7 +92,7 @@ RenderPlatform::RenderPlatform(platform::core::MemoryInterface *m)
 {
 	immediateContext.renderPlatform=this;
 	computeContext.renderPlatform=this;
-#if defined(WIN32) && !defined(_GAMING_XBOX)
+#if PLATFORM_RUNTIME_EFFECT_COMPILE
 	effectCompileThread = std::thread(&RenderPlatform::recompileAsync,this);
 #endif
 	numPlatforms++;
@@ -96,11 +107,20 @@ RenderPlatform::RenderPlatform(platform::core::MemoryInterface *m)
 RenderPlatform::~RenderPlatform()
 {
 	numPlatforms--;
-	recompileThreadActive=false;
-	effectCompileThread.join();
+	// Stop the compile thread before anything it uses is destroyed: a compile that finishes now still reaches its callback.
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		recompileThreadActive=false;
+	}
+	effectCompileCondition.notify_all();
+	if(effectCompileThread.joinable())
+		effectCompileThread.join();
+	delete shaderWatcher;
+	shaderWatcher=nullptr;
 	allocator.Shutdown();
 	InvalidateDeviceObjects();
 	delete gpuProfiler;
+	delete textureCapture;
 
 	for (auto i = materials.begin(); i != materials.end(); i++)
 	{
@@ -114,38 +134,241 @@ void RenderPlatform::recompileAsync()
 {
 	while(recompileThreadActive)
 	{
-		if(!effectsToCompile.size())
+		EffectRecompile r;
 		{
-			std::this_thread::sleep_for(1000ms);
-			std::this_thread::yield();
-			continue;
+			std::unique_lock<std::mutex> lock(effectCompileMutex);
+			effectCompileCondition.wait(lock,[this]{return !recompileThreadActive||effectsToCompile.size()>0;});
+			if(!recompileThreadActive)
+				break;
+			// The request stays in the queue while it compiles, so that it counts towards the queue depth.
+			r=effectsToCompile[0];
 		}
-		std::string effect_name=effectsToCompile[0].effect_name;
-		auto callback=effectsToCompile[0].callback;
-		effectsToCompile.erase(effectsToCompile.begin());
-		if(!effect_name.length())
-			continue;
+		bool result=false;
 		// Do next shader compile.
-		if(RecompileEffect(effect_name))
+		if(r.effect_name.length())
+			result=RecompileEffect(r.effect_name,r.variants,r.reload);
 		{
-			if(recompileThreadActive)
+			std::lock_guard<std::mutex> lock(effectCompileMutex);
+			effectsToCompile.erase(effectsToCompile.begin());
+			if(r.effect_name.length())
 			{
-				if(callback)
-					callback();
+				EffectCompileStats &s=effectCompileStats;
+				double ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-r.queued).count();
+				if(result)
+					s.completed++;
+				else
+					s.failed++;
+				size_t n=s.completed+s.failed;
+				s.lastLatencyMs=ms;
+				s.meanLatencyMs+=(ms-s.meanLatencyMs)/double(n);
+				s.maxLatencyMs=std::max(s.maxLatencyMs,ms);
+				if(result&&r.reload)
+					effectsToReload.insert(r.effect_name);
 			}
 		}
+		if(result&&recompileThreadActive)
+		{
+			if(r.callback)
+				r.callback();
+		}
 	}
 }
 static std::string recompiling_effect_name;
 
 float RenderPlatform::GetRecompileStatus(std::string &txt)
 {
+	std::lock_guard<std::mutex> lock(effectCompileMutex);
 	if(!effectsToCompile.size())
 		return 0.0f;
 	txt=recompiling_effect_name;
 	return (float)effectsToCompile.size();
 }
 
+RenderPlatform::EffectCompileStats RenderPlatform::GetEffectCompileStats()
+{
+	std::lock_guard<std::mutex> lock(effectCompileMutex);
+	EffectCompileStats s=effectCompileStats;
+	s.queueDepth=effectsToCompile.size();
+	return s;
+}
+
+void RenderPlatform::SetOnDemandVariantCompile(bool on)
+{
+	onDemandVariantCompile=on;
+}
+
+bool RenderPlatform::IsOnDemandVariantCompileEnabled() const
+{
+	return onDemandVariantCompile&&PLATFORM_RUNTIME_EFFECT_COMPILE;
+}
+
+void RenderPlatform::RequestEffectVariants(Effect *e,const std::vector<std::string> &variants)
+{
+	if(!e||!IsOnDemandVariantCompileEnabled())
+		return;
+	EffectRecompile r;
+	r.effect_name=e->GetName();
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		bool added=false;
+		for(const auto &v:variants)
+			added|=requestedVariants.insert(r.effect_name+" "s+v).second;
+		if(!added)
+			return;
+		// Keep the variants already in the effect, and any requested earlier that may still be compiling.
+		std::string prefix=r.effect_name+" "s;
+		for(const auto &v:requestedVariants)
+		{
+			if(v.compare(0,prefix.length(),prefix)==0)
+				r.variants.push_back(v.substr(prefix.length()));
+		}
+	}
+	const auto &existing=e->GetVariantShaderNames();
+	r.variants.insert(r.variants.end(),existing.begin(),existing.end());
+	r.reload=true;
+	queueEffectCompile(std::move(r));
+}
+
+void RenderPlatform::SetShaderHotReload(bool on)
+{
+	if(on==(shaderWatcher!=nullptr))
+		return;
+	if(!on||!PLATFORM_RUNTIME_EFFECT_COMPILE)
+	{
+		delete shaderWatcher;
+		shaderWatcher=nullptr;
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		shaderSourceDependents.clear();
+		return;
+	}
+	shaderWatcher=new platform::core::FileWatcher;
+	for(const auto &e:effects)
+		WatchEffectSources(e.first);
+	shaderWatcher->Start(std::bind(&RenderPlatform::OnShaderSourceChanged,this,std::placeholders::_1));
+}
+
+bool RenderPlatform::IsShaderHotReloadEnabled() const
+{
+	return shaderWatcher!=nullptr;
+}
+
+void RenderPlatform::SetCpuTextureMips(bool on,const MipChainSettings &settings)
+{
+	cpuTextureMips=on;
+	cpuTextureMipSettings=settings;
+}
+
+bool RenderPlatform::IsCpuTextureMipsEnabled() const
+{
+	return cpuTextureMips;
+}
+
+const MipChainSettings &RenderPlatform::GetCpuTextureMipSettings() const
+{
+	return cpuTextureMipSettings;
+}
+
+void RenderPlatform::SetCpuTextureCompression(bool on,const BlockCompressionSettings &settings,bool diskCache)
+{
+	cpuTextureCompression=on;
+	cpuTextureCompressionSettings=settings;
+	textureCache=diskCache;
+}
+
+bool RenderPlatform::IsCpuTextureCompressionEnabled() const
+{
+	return cpuTextureCompression;
+}
+
+const BlockCompressionSettings &RenderPlatform::GetCpuTextureCompressionSettings() const
+{
+	return cpuTextureCompressionSettings;
+}
+
+bool RenderPlatform::IsTextureCacheEnabled() const
+{
+	return textureCache;
+}
+
+void RenderPlatform::WatchEffectSources(const std::string &effect_name)
+{
+	if(!shaderWatcher)
+		return;
+	auto *fileLoader=platform::core::FileLoader::GetFileLoader();
+	std::vector<std::string> sources;
+	// Sfx lists the effect's source and include files in a .sfxd file beside the .sfxo.
+	std::string sfxd=effect_name+".sfxd";
+	int index=fileLoader->FindIndexInPathStack(sfxd.c_str(),GetShaderBinaryPathsUtf8());
+	if(index>=0&&index<(int)GetShaderBinaryPathsUtf8().size())
+	{
+		void *ptr=nullptr;
+		unsigned int bytes=0;
+		fileLoader->AcquireFileContents(ptr,bytes,(GetShaderBinaryPathsUtf8()[index]+"/"s+sfxd).c_str(),true);
+		if(ptr)
+		{
+			std::string list((const char*)ptr,bytes);
+			fileLoader->ReleaseFileContents(ptr);
+			for(const auto &l:platform::core::split(list,'\n'))
+			{
+				if(l.length()&&l!="\r")
+					sources.push_back(l.back()=='\r'?l.substr(0,l.length()-1):l);
+			}
+		}
+	}
+	// Without the list, watch the main source file only.
+	if(!sources.size())
+	{
+		std::string sfx=effect_name+".sfx";
+		index=fileLoader->FindIndexInPathStack(sfx.c_str(),GetShaderPathsUtf8());
+		if(index>=0&&index<(int)GetShaderPathsUtf8().size())
+			sources.push_back(GetShaderPathsUtf8()[index]+"/"s+sfx);
+	}
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		for(const auto &f:sources)
+			shaderSourceDependents[f].insert(effect_name);
+	}
+	for(const auto &f:sources)
+		shaderWatcher->AddFile(f);
+}
+
+void RenderPlatform::OnShaderSourceChanged(const std::string &filename_utf8)
+{
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		auto d=shaderSourceDependents.find(filename_utf8);
+		if(d==shaderSourceDependents.end())
+			return;
+		for(const auto &n:d->second)
+		{
+			// Skip effects already waiting to build; the compile in progress may have read the file before it changed.
+			bool waiting=false;
+			for(size_t i=1;i<effectsToCompile.size();i++)
+				waiting|=(effectsToCompile[i].effect_name==n&&effectsToCompile[i].reload);
+			if(!waiting)
+				names.push_back(n);
+		}
+	}
+	for(const auto &n:names)
+	{
+		EffectRecompile r;
+		r.effect_name=n;
+		r.reload=true;
+		queueEffectCompile(std::move(r));
+	}
+}
+
+void RenderPlatform::queueEffectCompile(EffectRecompile &&r)
+{
+	r.queued=std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		effectsToCompile.push_back(std::move(r));
+	}
+	effectCompileCondition.notify_one();
+}
+
 static bool RewriteOutput(std::string str)
 {
 	std::cerr<<str.c_str();
@@ -153,9 +376,9 @@ static bool RewriteOutput(std::string str)
 }
 
 
-bool RenderPlatform::RecompileEffect(std::string effect_filename)
+bool RenderPlatform::RecompileEffect(std::string effect_filename,const std::vector<std::string> &variants,bool requested)
 {
-#if defined(WIN32) && !defined(_GAMING_XBOX)
+#if PLATFORM_RUNTIME_EFFECT_COMPILE
 	recompiling_effect_name=effect_filename;
 	std::string filename_fx=effect_filename;
 	size_t dot_pos=filename_fx.find(".");
@@ -163,7 +386,8 @@ bool RenderPlatform::RecompileEffect(std::string effect_filename)
 	if(dot_pos>=len)
 		filename_fx+=".sfx";
 	auto buildMode = GetShaderBuildMode();
-	if ((buildMode & crossplatform::BUILD_IF_CHANGED) == 0)
+	// Variants requested on demand, and hot reloads, are built whatever the build mode, as the application asked for them.
+	if ((buildMode & crossplatform::BUILD_IF_CHANGED) == 0 && !requested)
 		return false;
 	int index= platform::core::FileLoader::GetFileLoader()->FindIndexInPathStack(filename_fx.c_str(),GetShaderPathsUtf8());
 	std::string filenameInUseUtf8=filename_fx;
@@ -201,7 +425,20 @@ bool RenderPlatform::RecompileEffect(std::string effect_filename)
 												,fmt::arg("shaderbin", shaderbin)
 												,fmt::arg("json_file", json_file));
 	command+= std::string(" -EPLATFORM=") + PLATFORM;
-	if ((buildMode & crossplatform::ALWAYS_BUILD) != 0)
+	if (variants.size())
+	{
+		// Build only the variants listed, by way of a manifest as written by VariantManifest.
+		std::string effect_stem=std::filesystem::path(filename_fx).stem().generic_string();
+		std::string manifest=shaderbin+"/intermediate/"s+effect_stem+".variants"s;
+		std::filesystem::create_directories(std::filesystem::path(manifest).parent_path());
+		std::ofstream m(manifest);
+		m<<"# Variants compiled on demand\n";
+		for(const auto &v:variants)
+			m<<effect_stem<<" "<<v<<"\n";
+		m.close();
+		command+=" --variant-manifest \""s+manifest+"\" -F"s;
+	}
+	else if ((buildMode & crossplatform::ALWAYS_BUILD) != 0)
 		command+=" -F";
 	if (platform::core::SimulInternalChecks)
 		command += " -V";
@@ -223,13 +460,16 @@ void RenderPlatform::ScheduleRecompileEffects(std::vector<std::string> effect_na
 	if(!effect_names.size())
 		return;
 	for(size_t i=0;i<effect_names.size()-1;i++)
-		effectsToCompile.push_back({effect_names[i],nullptr});
-	effectsToCompile.push_back({effect_names.back(),f});
+		ScheduleRecompileEffect(effect_names[i],nullptr);
+	ScheduleRecompileEffect(effect_names.back(),f);
 }
 
 void RenderPlatform::ScheduleRecompileEffect(std::string effect_name,std::function <void()> f) 
 {
-	effectsToCompile.push_back({effect_name,f});
+	EffectRecompile r;
+	r.effect_name=effect_name;
+	r.callback=f;
+	queueEffectCompile(std::move(r));
 }
 
 bool RenderPlatform::HasRenderingFeatures(RenderingFeatures r) const
@@ -421,6 +661,8 @@ void RenderPlatform::RestoreDeviceObjects(void*)
 
 void RenderPlatform::InvalidateDeviceObjects()
 {
+	if(textureCapture)
+		textureCapture->Clear();
 	if(gpuProfiler)
 		gpuProfiler->InvalidateDeviceObjects();
 	for (auto e : destroyEffects)
@@ -457,6 +699,7 @@ void RenderPlatform::InvalidateDeviceObjects()
 		debugVertexBuffer->InvalidateDeviceObjects();
 	}
 	debugVertexBuffers.clear();
+	debugDrawBatches.clear();
 	/*for(auto s:shaders)
 	{
 		s.second->Release();
@@ -519,6 +762,8 @@ void RenderPlatform::LoadShaders()
 		imageTexture			=debugEffect->GetShaderResource("imageTexture");
 		debugEffect_cubeTexture	=debugEffect->GetShaderResource("cubeTexture");
 	}
+	for (auto i = materials.begin(); i != materials.end(); i++)
+		i->second->SetEffect(solidEffect);
 }
 
 void RenderPlatform::PushTexturePath(const char *path_utf8)
@@ -573,8 +818,8 @@ void RenderPlatform::PopRenderTargets(GraphicsDeviceContext &deviceContext)
 
 void RenderPlatform::LatLongTextureToCubemap(DeviceContext &deviceContext,Texture *destination,Texture *source)
 {
-	debugEffect->SetTexture(deviceContext,"imageTexture",source);
-	debugEffect->SetUnorderedAccessView(deviceContext,"FastClearTarget2DArray",destination);
+	debugEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),source);
+	debugEffect->SetUnorderedAccessView(deviceContext,PLATFORM_SHADER_RESOURCE("FastClearTarget2DArray"),destination);
 	debugEffect->Apply(deviceContext,"lat_long_to_cubemap",0);
 	int D=6;
 	int W=(destination->width+3)/4;
@@ -695,12 +940,36 @@ void RenderPlatform::BeginFrame()
 		SIMUL_BREAK("BeginFrame(): frame had already started.");
 	}
 	frameNumber++;
+	core::SetLogFrameNumber(frameNumber);
 	frame_started = true;
+	bool reload=false;
+	{
+		std::lock_guard<std::mutex> lock(effectCompileMutex);
+		reload=effectsToReload.size()>0;
+		effectsToReload.clear();
+	}
+	// Rebuilt effects are created afresh by their owners, rather than loaded over the live ones that their handles point into.
+	if(reload)
+	{
+		effectReloadCount++;
+		recompiled=true;
+	}
 	if(recompiled)
 	{
 		LoadShaders();
 		recompiled=false;
 	}
+	if(textureCapture)
+		textureCapture->Update();
+	lastDebugDrawStats=debugDrawStats;
+	debugDrawStats=DebugDrawStats();
+}
+
+TextureCapture *RenderPlatform::GetTextureCapture()
+{
+	if(!textureCapture)
+		textureCapture=new TextureCapture;
+	return textureCapture;
 }
 
 bool RenderPlatform::FrameStarted() const
@@ -740,6 +1009,7 @@ void RenderPlatform::BeginFrame(long long f)
 	}
 	BeginFrame();
 	frameNumber = f;
+	core::SetLogFrameNumber(frameNumber);
 }
 
 void RenderPlatform::Clear(GraphicsDeviceContext &deviceContext,vec4 colour_rgba)
@@ -793,7 +1063,7 @@ void RenderPlatform::GenerateMips(GraphicsDeviceContext &deviceContext,Texture *
 {
 	if(!t||!t->IsValid())
 		return;
-	auto _imageTexture=mipEffect->GetShaderResource("inputTexture");
+	auto _imageTexture=mipEffect->GetShaderResource(PLATFORM_SHADER_RESOURCE("inputTexture"));
 	auto pass=mipEffect->GetTechniqueByName("mip")->GetPass("mip");
 	ApplyPass(deviceContext,pass);
 	vec4 white(1.0, 1.0, 1.0, 1.0);
@@ -822,8 +1092,8 @@ vec4 RenderPlatform::TexelQuery(DeviceContext &deviceContext,int query_id,uint2
 	}
 	debugConstants.queryPos=pos;
 	SetConstantBuffer(deviceContext,&debugConstants);
-	textureQueryResult.ApplyAsUnorderedAccessView(deviceContext,debugEffect,debugEffect->GetShaderResource("textureQueryResults"));
-	debugEffect->SetTexture(deviceContext,"imageTexture",texture);
+	textureQueryResult.ApplyAsUnorderedAccessView(deviceContext,debugEffect,debugEffect->GetShaderResource(PLATFORM_SHADER_RESOURCE("textureQueryResults")));
+	debugEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),texture);
 	debugEffect->Apply(deviceContext,"texel_query",0);
 	DispatchCompute(deviceContext,textureQueryResult.count,1,1);
 	debugEffect->Unapply(deviceContext);
@@ -871,7 +1141,7 @@ void RenderPlatform::HeightMapToNormalMap(GraphicsDeviceContext &deviceContext,T
 		return;
 	if(!normalMap||!normalMap->IsValid())
 		return;
-	auto _imageTexture=debugEffect->GetShaderResource("imageTexture");
+	auto _imageTexture=debugEffect->GetShaderResource(PLATFORM_SHADER_RESOURCE("imageTexture"));
 	auto pass=debugEffect->GetTechniqueByName("height_to_normal")->GetPass(0);
 	debugConstants.texSize=uint4(heightMap->width,heightMap->length,1,1);
 	debugConstants.multiplier=vec4(scale,scale,scale,scale);
@@ -995,84 +1265,25 @@ uint32_t RenderPlatform::GetViewMaskFromRenderTargets(const GraphicsDeviceContex
 
 bool RenderPlatform::SaveTextureDataToDisk(const char* filename, int width, int height, PixelFormat format, const void* data)
 {
-	crossplatform::PixelFormatType type = GetElementType(format);
-	uint64_t elementCount = static_cast<uint64_t>(GetElementCount(format));
-	uint64_t elementSize = static_cast<uint64_t>(GetElementSize(format));
-	uint64_t texelCount = static_cast<uint64_t>(width * height); //Assume 2D texture only.
-	uint64_t texelSize = elementCount * elementSize;
-	uint64_t size = texelCount * texelSize;
-
-	std::vector<uint8_t> imageData;
-	imageData.reserve(texelCount * elementCount);
-
-	if (data)
+	PixelLayout srcLayout = PixelConvert::GetLayout(format);
+	if (!srcLayout.IsValid())
 	{
-		for (uint64_t i = 0; i < size; i += elementSize)
-		{
-			uint8_t u8value = 0;
-			void* _ptr = (void*)((uint64_t)data + i);
-			switch (type)
-			{
-				using namespace crossplatform;
-				case PixelFormatType::DOUBLE:
-				{
-					double value = std::clamp<double>(*(double*)_ptr, 0.0, 1.0);
-					u8value = static_cast<uint8_t>(value * UINT8_MAX);
-					break;
-				}
-				case PixelFormatType::FLOAT:
-				{
-					float value = std::clamp<float>(*(float*)_ptr, 0.0f, 1.0f);
-					u8value = static_cast<uint8_t>(value * UINT8_MAX);
-					break;
-				}
-				case PixelFormatType::HALF:
-				{
-					float value = std::clamp<float>(math::ToFloat32(*(uint16_t*)_ptr), 0.0f, 1.0f);
-					u8value = static_cast<uint8_t>(value * UINT8_MAX);
-					break;
-				}
-				case PixelFormatType::UINT:
-				{
-					uint32_t value = std::clamp<uint32_t>(*(uint32_t*)_ptr, 0, UINT32_MAX);
-					u8value = static_cast<uint8_t>(static_cast<float>(value) / static_cast<float>(UINT32_MAX));
-					break;
-				}
-				case PixelFormatType::USHORT:
-				{
-					uint16_t value = std::clamp<uint16_t>(*(uint16_t*)_ptr, 0, UINT16_MAX);
-					u8value = static_cast<uint8_t>(static_cast<float>(value) / static_cast<float>(UINT16_MAX));
-					break;
-				}
-				case PixelFormatType::UCHAR:
-				{
-					u8value = std::clamp<uint8_t>(*(uint8_t*)_ptr, 0, UINT8_MAX);
-					break;
-				}
-				case PixelFormatType::INT:
-				{
-					int32_t value = std::clamp<int32_t>(*(int32_t*)_ptr, 0, INT32_MAX);
-					u8value = static_cast<uint8_t>(static_cast<float>(value) / static_cast<float>(INT32_MAX));
-
-					break;
-				}
-				case PixelFormatType::SHORT:
-				{
-					int16_t value = std::clamp<int16_t>(*(int16_t*)_ptr, 0, INT16_MAX);
-					u8value = static_cast<uint8_t>(static_cast<float>(value) / static_cast<float>(INT16_MAX));
-					break;
-				}
-				case PixelFormatType::CHAR:
-				{
-					u8value = std::clamp<int8_t>(*(int8_t*)_ptr, 0, INT8_MAX);
-					break;
-				}
-			}
-			imageData.push_back(u8value);
-		}
+		SIMUL_CERR << "Can't save texture data to " << filename << ": unsupported pixel format " << (int)format << ".\n";
+		return false;
 	}
+	// Integer textures are saved as a fraction of their range.
+	srcLayout.normalized = true;
+	PixelLayout dstLayout;
+	dstLayout.type = ComponentType::UINT8;
+	dstLayout.channels = srcLayout.channels;
+	dstLayout.normalized = true;
+	dstLayout.srgb = srcLayout.srgb;
+
+	std::vector<uint8_t> imageData((size_t)width * (size_t)height * dstLayout.channels);
+	if (data)
+		PixelConvert::Convert(srcLayout, data, 0, dstLayout, imageData.data(), 0, width, height);
 
-	int res = stbi_write_png(filename, width, height, (int)elementCount, imageData.data(), (int)(elementCount * width));
+	int res = stbi_write_png(filename, width, height, (int)dstLayout.channels, imageData.data(), (int)(dstLayout.channels * width));
 	if (res != 1)
 	{
 		SIMUL_BREAK_ONCE("Failed to save screenshot data to disk.");
@@ -1083,6 +1294,12 @@ bool RenderPlatform::SaveTextureDataToDisk(const char* filename, int width, int
 
 void RenderPlatform::DrawLine(GraphicsDeviceContext &deviceContext,vec3 startp, vec3 endp, vec4 colour,float width)
 {
+	if (debugDrawBatching)
+	{
+		PosColourVertex v[2]={{startp,colour},{endp,colour}};
+		RecordDebugLines(deviceContext,v,2,false,false,false);
+		return;
+	}
 	debugConstants.line_start=startp;
 	debugConstants.line_end=endp;
 	debugConstants.debugColour=colour;
@@ -1101,22 +1318,18 @@ void RenderPlatform::DrawLine(GraphicsDeviceContext &deviceContext,vec3 startp,
 		posColourLayout->Unapply(deviceContext);
 }
 
-void RenderPlatform::DrawLines(GraphicsDeviceContext &deviceContext,PosColourVertex * lines,int count,bool strip,bool test_depth,bool view_centred)
+Buffer *RenderPlatform::GetDebugVertexBuffer(DeviceContext &deviceContext,int count)
 {
-	static uint64_t previousFrameNumber = 0;
-	uint64_t currentFrameNumber = deviceContext.renderPlatform->GetFrameNumber();
-
-	static uint64_t vertexBufferIdx = 0; //Get new vertex buffer each DrawLines render.
-
-	if (currentFrameNumber != previousFrameNumber)
+	// Each draw within a frame gets its own buffer, so earlier draws are not overwritten before they execute.
+	if (debugVertexBufferFrame != GetFrameNumber())
 	{
-		previousFrameNumber = currentFrameNumber;
-		vertexBufferIdx = 0;
+		debugVertexBufferFrame = GetFrameNumber();
+		debugVertexBufferIndex = 0;
 	}
-	if (!(vertexBufferIdx < debugVertexBuffers.size()))
-		debugVertexBuffers.resize(vertexBufferIdx + 1);
+	if (!(debugVertexBufferIndex < debugVertexBuffers.size()))
+		debugVertexBuffers.resize(debugVertexBufferIndex + 1);
 
-	std::shared_ptr<Buffer> &debugVertexBuffer = debugVertexBuffers[vertexBufferIdx++];
+	std::shared_ptr<Buffer> &debugVertexBuffer = debugVertexBuffers[debugVertexBufferIndex++];
 	if (!debugVertexBuffer)
 	{
 		debugVertexBuffer.reset(CreateBuffer());
@@ -1135,12 +1348,23 @@ void RenderPlatform::DrawLines(GraphicsDeviceContext &deviceContext,PosColourVer
 		}
 		debugVertexBuffer->EnsureVertexBuffer(this, 2*count, posColourLayout.get(), nullptr,true);
 	}
+	return debugVertexBuffer.get();
+}
+
+void RenderPlatform::DrawLines(GraphicsDeviceContext &deviceContext,PosColourVertex * lines,int count,bool strip,bool test_depth,bool view_centred)
+{
+	if (debugDrawBatching)
+	{
+		RecordDebugLines(deviceContext, lines, count, strip, test_depth, view_centred);
+		return;
+	}
+	Buffer *debugVertexBuffer = GetDebugVertexBuffer(deviceContext, count);
 	// Upload vertex/index data into a single contiguous GPU buffer
 	PosColourVertex* vtx_dst= (PosColourVertex*)debugVertexBuffer->Map(deviceContext);
 	if (!vtx_dst)
 	{
 	// Force recreate to find error.
-		debugVertexBuffer.reset();
+		debugVertexBuffers[debugVertexBufferIndex-1].reset();
 		return;
 	}
 	memcpy(vtx_dst,lines,count*sizeof(PosColourVertex));
@@ -1153,11 +1377,17 @@ void RenderPlatform::DrawLines(GraphicsDeviceContext &deviceContext,PosColourVer
 		crossplatform::MakeViewProjMatrix((float*)&wvp,deviceContext.viewStruct.view,deviceContext.viewStruct.proj);
 	debugConstants.debugWorldViewProj=wvp;//deviceContext.viewStruct.viewProj;
 	debugConstants.debugWorldViewProj.transpose();
-	auto *b=debugVertexBuffer.get();
-	SetVertexBuffers(deviceContext,0,1,&b,posColourLayout.get());
+	SetVertexBuffers(deviceContext,0,1,&debugVertexBuffer,posColourLayout.get());
 	SetConstantBuffer(deviceContext,&debugConstants);
 	SetLayout(deviceContext,posColourLayout.get());
-	debugEffect->Apply(deviceContext,"lines_3d","lines3d_nodepth");
+	// The same passes as the batched path, so that batching doesn't change which lines are hidden.
+	const char *pass="lines3d_nodepth";
+	if(test_depth)
+	{
+		crossplatform::Frustum frustum=crossplatform::GetFrustumFromProjectionMatrix((const float*)deviceContext.viewStruct.proj);
+		pass=frustum.reverseDepth?"lines3d_reversedepth":"lines3d_forwarddepth";
+	}
+	debugEffect->Apply(deviceContext,"lines_3d",pass);
 	SetTopology(deviceContext, strip?Topology::LINESTRIP:Topology::LINELIST);
 	Draw(deviceContext, count, 0);
 	SetVertexBuffers(deviceContext,0,0,nullptr,nullptr);
@@ -1165,6 +1395,98 @@ void RenderPlatform::DrawLines(GraphicsDeviceContext &deviceContext,PosColourVer
 	posColourLayout->Unapply(deviceContext);
 }
 
+void RenderPlatform::RecordDebugLines(GraphicsDeviceContext &deviceContext,const PosColourVertex *lines,int count,bool strip,bool test_depth,bool view_centred)
+{
+	if(count<2)
+		return;
+	DebugDrawBatch &batch=debugDrawBatches[deviceContext.platform_context];
+	if(batch.frame!=GetFrameNumber())
+	{
+		if(batch.vertexCount)
+		{
+			SIMUL_CERR_ONCE<<"Debug lines were recorded but never flushed; call RenderPlatform::FlushDebugDraw once per frame.\n";
+			for(auto &b:batch.buckets)
+				b.clear();
+			batch.vertexCount=0;
+		}
+		batch.frame=GetFrameNumber();
+	}
+	// Strips are expanded to lists so that every bucket can be drawn with one call.
+	uint32_t n=strip?uint32_t(2*(count-1)):uint32_t(count&~1);
+	if(batch.vertexCount+n>debugDrawVertexLimit)
+	{
+		debugDrawStats.dropped++;
+		return;
+	}
+	std::vector<PosColourVertex> &bucket=batch.buckets[(test_depth?1:0)+(view_centred?2:0)];
+	if(strip)
+	{
+		for(int i=1;i<count;i++)
+		{
+			bucket.push_back(lines[i-1]);
+			bucket.push_back(lines[i]);
+		}
+	}
+	else
+		bucket.insert(bucket.end(),lines,lines+n);
+	batch.vertexCount+=n;
+	debugDrawStats.primitives++;
+}
+
+void RenderPlatform::FlushDebugDraw(GraphicsDeviceContext &deviceContext)
+{
+	auto b=debugDrawBatches.find(deviceContext.platform_context);
+	if(b==debugDrawBatches.end()||!b->second.vertexCount)
+		return;
+	DebugDrawBatch &batch=b->second;
+	Buffer *debugVertexBuffer = GetDebugVertexBuffer(deviceContext, (int)batch.vertexCount);
+	PosColourVertex* vtx_dst= (PosColourVertex*)debugVertexBuffer->Map(deviceContext);
+	if (!vtx_dst)
+	{
+		debugVertexBuffers[debugVertexBufferIndex-1].reset();
+		return;
+	}
+	int offsets[4];
+	int offset=0;
+	for(int i=0;i<4;i++)
+	{
+		offsets[i]=offset;
+		const std::vector<PosColourVertex> &bucket=batch.buckets[i];
+		memcpy(vtx_dst+offset,bucket.data(),bucket.size()*sizeof(PosColourVertex));
+		offset+=(int)bucket.size();
+	}
+	debugVertexBuffer->Unmap(deviceContext);
+
+	crossplatform::Frustum frustum = crossplatform::GetFrustumFromProjectionMatrix((const float*)deviceContext.viewStruct.proj);
+	const char *depthPass=frustum.reverseDepth?"lines3d_reversedepth":"lines3d_forwarddepth";
+	SetVertexBuffers(deviceContext,0,1,&debugVertexBuffer,posColourLayout.get());
+	SetLayout(deviceContext,posColourLayout.get());
+	SetTopology(deviceContext,Topology::LINELIST);
+	for(int i=0;i<4;i++)
+	{
+		std::vector<PosColourVertex> &bucket=batch.buckets[i];
+		if(!bucket.size())
+			continue;
+		mat4 wvp;
+		if (i&2)
+			crossplatform::MakeCentredViewProjMatrix((float *)&wvp, deviceContext.viewStruct.view, deviceContext.viewStruct.proj);
+		else
+			crossplatform::MakeViewProjMatrix((float*)&wvp,deviceContext.viewStruct.view,deviceContext.viewStruct.proj);
+		debugConstants.debugWorldViewProj=wvp;
+		debugConstants.debugWorldViewProj.transpose();
+		SetConstantBuffer(deviceContext,&debugConstants);
+		debugEffect->Apply(deviceContext,"lines_3d",(i&1)?depthPass:"lines3d_nodepth");
+		Draw(deviceContext,(int)bucket.size(),offsets[i]);
+		debugEffect->Unapply(deviceContext);
+		debugDrawStats.draws++;
+		debugDrawStats.vertices+=(uint32_t)bucket.size();
+		bucket.clear();
+	}
+	SetVertexBuffers(deviceContext,0,0,nullptr,nullptr);
+	posColourLayout->Unapply(deviceContext);
+	batch.vertexCount=0;
+}
+
 
 static float length(const vec3 &u)
 {
@@ -1436,6 +1758,23 @@ void RenderPlatform::DrawCubemap(GraphicsDeviceContext &deviceContext,Texture *c
 
 void RenderPlatform::DrawAxes(GraphicsDeviceContext &deviceContext,const mat4 &m,float size)
 {
+	if (debugDrawBatching)
+	{
+		// The same axes and colours as the "axes" technique, transformed on the CPU.
+		static const vec4 colours[]={vec4(1.0f,0.2f,0.2f,1.0f),vec4(0,1.0f,0,1.0f),vec4(0,0.4f,1.0f,1.0f)};
+		vec4 o=m*vec4(0,0,0,1.0f);
+		PosColourVertex v[6];
+		for(int i=0;i<3;i++)
+		{
+			vec4 a(0,0,0,1.0f);
+			((float*)&a)[i]=size;
+			vec4 e=m*a;
+			v[2*i]={vec3(o.x,o.y,o.z),colours[i]};
+			v[2*i+1]={vec3(e.x,e.y,e.z),colours[i]};
+		}
+		RecordDebugLines(deviceContext,v,6,false,false,false);
+		return;
+	}
 	mat4 wvp;
 	crossplatform::MakeWorldViewProjMatrix((float*)&wvp,m,deviceContext.viewStruct.view,deviceContext.viewStruct.proj);
 	debugConstants.debugWorldViewProj=wvp;
@@ -1604,7 +1943,7 @@ int2 RenderPlatform::DrawTexture(GraphicsDeviceContext &deviceContext, int x1, i
 		if(tex->arraySize>1)
 		{
 			tech=debugEffect->GetTechniqueByName("show_cubemap_array");
-			debugEffect->SetTexture(deviceContext, "cubeTextureArray", tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0, (uint8_t)-1});
+			debugEffect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("cubeTextureArray"), tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0, (uint8_t)-1});
 			if(debug)
 			{
 				static char c=0;
@@ -1621,14 +1960,14 @@ int2 RenderPlatform::DrawTexture(GraphicsDeviceContext &deviceContext, int x1, i
 		else
 		{
 			tech=debugEffect->GetTechniqueByName("show_cubemap");
-			debugEffect->SetTexture(deviceContext, "cubeTexture", tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0, (uint8_t)-1});
+			debugEffect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("cubeTexture"), tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0, (uint8_t)-1});
 			debugConstants.displayLevel=0;
 		}
 	}
 	else if(tex&&tex->arraySize>1)
 	{
 		tech = debugEffect->GetTechniqueByName("show_texture_array");
-		debugEffect->SetTexture(deviceContext, "imageTextureArray", tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0,(uint8_t)-1});
+		debugEffect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("imageTextureArray"), tex, {TextureAspectFlags::COLOUR, (uint8_t)displayLod, 1, 0,(uint8_t)-1});
 		{
 			static char c = 0;
 			static char cc = 20;
@@ -1708,16 +2047,16 @@ int2 RenderPlatform::DrawDepth(GraphicsDeviceContext &deviceContext, int x1, int
 	if(tex&&tex->GetSampleCount()>0)
 	{
 		tech=debugEffect->GetTechniqueByName("show_depth_ms");
-		debugEffect->SetTexture(deviceContext,"imageTextureMS",tex);
+		debugEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTextureMS"),tex);
 	}
 	else if(tex&&tex->IsCubemap())
 	{
 		tech=debugEffect->GetTechniqueByName("show_depth_cube");
-		debugEffect->SetTexture(deviceContext,"cubeTexture",tex);
+		debugEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("cubeTexture"),tex);
 	}
 	else
 	{
-		debugEffect->SetTexture(deviceContext,"imageTexture",tex);
+		debugEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("imageTexture"),tex);
 	}
 	if(!proj)
 		proj=deviceContext.viewStruct.proj;
@@ -1772,12 +2111,24 @@ int RenderPlatform::Print(GraphicsDeviceContext& deviceContext, int x, int y, co
 	int lines=0;
 	if(*text!=0)
 	{
-		lines+=textRenderer->Render(deviceContext,(float)x,(float)y,(float)viewport.w,(float)viewport.h,text,colr,bkg,mirrorYText);
+		if(textBatching)
+			lines+=textRenderer->Queue(deviceContext,(float)x,(float)y,(float)viewport.w,(float)viewport.h,text,colr,bkg,mirrorYText);
+		else
+			lines+=textRenderer->Render(deviceContext,(float)x,(float)y,(float)viewport.w,(float)viewport.h,text,colr,bkg,mirrorYText);
 	}
 	SIMUL_COMBINED_PROFILE_END(deviceContext)
 	return lines;
 }
 
+void RenderPlatform::FlushText(GraphicsDeviceContext &deviceContext)
+{
+	if(!textRenderer)
+		return;
+	SIMUL_COMBINED_PROFILE_START(deviceContext, "text")
+	textRenderer->Flush(deviceContext);
+	SIMUL_COMBINED_PROFILE_END(deviceContext)
+}
+
 int RenderPlatform::Print(MultiviewGraphicsDeviceContext& deviceContext, float* xs, float* ys, const char* text, const float* colr, const float* bkg)
 {
 	SIMUL_COMBINED_PROFILE_START(deviceContext, "text")
@@ -1931,6 +2282,7 @@ crossplatform::Effect *RenderPlatform::CreateEffect(const char *filename_utf8)
 	crossplatform::Effect *e=CreateEffect();
 	effects[fn] = e;
 	e->SetName(filename_utf8);
+	WatchEffectSources(fn);
 	bool success = e->Load(this,filename_utf8);
 	if (!success)
 	{
@@ -5,12 +5,17 @@
 #include <string>
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <functional>
 #include <atomic>
 #include "Export.h"
 #include "Platform/Core/MemoryInterface.h"
 #include "Platform/CrossPlatform/BaseRenderer.h"
 #include "Platform/CrossPlatform/PixelFormat.h"
+#include "Platform/CrossPlatform/BlockCompression.h"
+#include "Platform/CrossPlatform/ImagePipeline.h"
 #include "Platform/CrossPlatform/DeviceContext.h"
 #include "Platform/CrossPlatform/Topology.h"
 #include "Platform/CrossPlatform/Shaders/CppSl.sl"
@@ -51,6 +56,10 @@ namespace vk
 }
 namespace platform
 {
+	namespace core
+	{
+		class FileWatcher;
+	}
 	/// The namespace and library for cross-platform base classes, which abstract rendering functionality.
 	namespace crossplatform
 	{
@@ -59,6 +68,8 @@ namespace platform
 		class Effect;
 		class EffectTechnique;
 		class TextRenderer;
+		class TextureCapture;
+		struct TextureReadback;
 		struct Viewport;
 		class Light;
 		class Texture;
@@ -133,6 +144,14 @@ namespace platform
 			vec3 pos;
 			vec4 colour;
 		};
+		//! Per-frame counters for batched debug drawing, see RenderPlatform::SetDebugDrawBatching.
+		struct DebugDrawStats
+		{
+			uint32_t primitives=0;	//!< Number of DrawLines-type calls recorded.
+			uint32_t vertices=0;	//!< Line-list vertices drawn.
+			uint32_t draws=0;		//!< Draw calls issued by FlushDebugDraw.
+			uint32_t dropped=0;		//!< Primitives discarded because the vertex limit was reached.
+		};
 		struct SIMUL_CROSSPLATFORM_EXPORT Fence
 		{
 			virtual ~Fence() = default;
@@ -297,6 +316,17 @@ namespace platform
 			virtual void Draw				(GraphicsDeviceContext &deviceContext,int num_verts,int start_vert)=0;
 			//! Draw the specified number of vertices using the bound index arrays.
 			virtual void DrawIndexed		(GraphicsDeviceContext &deviceContext,int num_indices,int start_index=0,int base_vertex=0)=0;
+			//! Whether DrawIndexedInstanced() is implemented. Where it isn't, draw each instance with DrawIndexed().
+			virtual bool HasInstancedDraws() const
+			{
+				return false;
+			}
+			//! Draw num_instances instances of the bound indexed geometry. Returns false if nothing was drawn: always where HasInstancedDraws()
+			//! is false, and otherwise if the draw state couldn't be applied.
+			virtual bool DrawIndexedInstanced(GraphicsDeviceContext &deviceContext,int num_indices,int num_instances,int start_index=0,int base_vertex=0)
+			{
+				return false;
+			}
 			virtual void DrawLine			(GraphicsDeviceContext &deviceContext,vec3 pGlobalBasePosition, vec3 pGlobalEndPosition,vec4 colour,float width);
 		
 			virtual void DrawLineLoop		(GraphicsDeviceContext &,const double *,int ,const double *,const float [4]){}
@@ -314,7 +344,39 @@ namespace platform
 			virtual int Print				(MultiviewGraphicsDeviceContext &deviceContext,float* xs,float* ys,const char *text,const float* colr=NULL,const float* bkg=NULL);
 			//! Print diagnostics, starting from the top, and going down the screen one line each time as the frame progresses, then restarting next frame.
 			void LinePrint					(GraphicsDeviceContext &deviceContext,const char *text,const float* colr=NULL,const float* bkg=NULL);
+			//! When enabled, single-view Print, LinePrint and PrintAt3dPos calls are queued and drawn together by FlushText(). Off by default.
+			void SetTextBatching(bool b)
+			{
+				textBatching=b;
+			}
+			bool IsTextBatching() const
+			{
+				return textBatching;
+			}
+			//! Draw all text queued on this context in one draw call. Call once per frame, with the same targets bound as the text was printed for.
+			void FlushText					(GraphicsDeviceContext &deviceContext);
 			void DrawLines					(GraphicsDeviceContext &,PosColourVertex * /*lines*/,int /*count*/,bool /*strip*/=false,bool /*test_depth*/=false,bool /*view_centred*/=false);
+			//! When enabled, DrawLine, DrawLines, DrawCircle and DrawAxes record into a per-frame buffer that FlushDebugDraw() draws with one call per state. Off by default.
+			void SetDebugDrawBatching(bool b)
+			{
+				debugDrawBatching=b;
+			}
+			bool IsDebugDrawBatching() const
+			{
+				return debugDrawBatching;
+			}
+			//! The maximum number of line-list vertices recorded per context between flushes; later primitives are dropped and counted.
+			void SetDebugDrawVertexLimit(uint32_t v)
+			{
+				debugDrawVertexLimit=v;
+			}
+			//! Draw all debug primitives recorded on this context, using its current view and projection.
+			void FlushDebugDraw				(GraphicsDeviceContext &deviceContext);
+			//! Counters for the last complete frame.
+			const DebugDrawStats &GetDebugDrawStats() const
+			{
+				return lastDebugDrawStats;
+			}
 			void Draw2dLine					(GraphicsDeviceContext &deviceContext,vec2 pos1,vec2 pos2,vec4 colour);
 			virtual void Draw2dLines		(GraphicsDeviceContext &/*deviceContext*/,PosColourVertex * /*lines*/,int /*vertex_count*/,bool /*strip*/){}
 			/// Draw a circle facing the viewer at the specified direction and angular size.
@@ -365,6 +427,49 @@ namespace platform
 			/// Asynchronously recompile the effects; the callback is called when the last one is complete.
 			void ScheduleRecompileEffects			(std::vector<std::string> effect_names,std::function <void()> f);
 			float GetRecompileStatus(std::string &txt);
+			/// Statistics of the background effect compiles.
+			struct EffectCompileStats
+			{
+				size_t queueDepth=0;		///< Compiles waiting, including the one in progress.
+				size_t completed=0;
+				size_t failed=0;
+				double lastLatencyMs=0.0;	///< From request to completion, for the most recent compile.
+				double meanLatencyMs=0.0;
+				double maxLatencyMs=0.0;
+			};
+			EffectCompileStats GetEffectCompileStats();
+			/// When a variant pass is asked for a variant its effect doesn't have, compile the effect with that variant added in the background,
+			/// and reload it at the start of a frame when it's ready. Meanwhile the pass returns another variant of the same shader.
+			/// Off by default. The effect is reloaded as described for GetEffectReloadCount().
+			void SetOnDemandVariantCompile(bool on);
+			bool IsOnDemandVariantCompileEnabled() const;
+			/// Queue a background compile of the effect with the named shader variants added. Each variant is only requested once.
+			void RequestEffectVariants(Effect *e,const std::vector<std::string> &variants);
+			/// Watch the source and include files of the effects created by name, using the .sfxd lists that Sfx writes beside the .sfxo files.
+			/// When a file changes, the effects that use it are rebuilt in the background and reloaded at the start of a frame.
+			/// Off by default. As with on-demand variants, the effect is reloaded as described for GetEffectReloadCount().
+			void SetShaderHotReload(bool on);
+			bool IsShaderHotReloadEnabled() const;
+			/// Goes up at the start of a frame when effects rebuilt in the background are ready. A live effect is never reloaded in place,
+			/// because its techniques, passes and shader resources are cached by whoever created it. Instead, the platform's own effects
+			/// are recreated by LoadShaders(), and each renderer that owns effects calls its LoadShaders() when this differs from the value
+			/// it saw when it last loaded them. Effects replaced this way are destroyed with Destroy(), so draws already recorded stay valid.
+			uint64_t GetEffectReloadCount() const
+			{
+				return effectReloadCount;
+			}
+			/// Decode texture files and make their mips on the CPU with the ImagePipeline, in parallel, then upload the whole chain at once
+			/// instead of generating mips on the GPU. Off by default. Backends that can't create textures from initial data ignore it.
+			void SetCpuTextureMips(bool on,const MipChainSettings &settings=MipChainSettings());
+			bool IsCpuTextureMipsEnabled() const;
+			const MipChainSettings &GetCpuTextureMipSettings() const;
+			/// With CPU texture mips on, also encode the mips with BlockCompression: BC1 for opaque textures, BC3 for those with alpha,
+			/// or BC7 at high quality. If \a diskCache is true, the blocks are saved next to each source file by the TextureCache and reused
+			/// while the file and the settings are unchanged. Off by default. Textures fall back to RGBA8 where the GPU can't sample the format.
+			void SetCpuTextureCompression(bool on,const BlockCompressionSettings &settings=BlockCompressionSettings(),bool diskCache=true);
+			bool IsCpuTextureCompressionEnabled() const;
+			const BlockCompressionSettings &GetCpuTextureCompressionSettings() const;
+			bool IsTextureCacheEnabled() const;
 			/// Get the effect named, or return null if it's not been created.
 			Effect							*GetEffect						(const char *name_utf8);
 			/// Create a platform-specific constant buffer instance. This is not usually used directly, instead, create a
@@ -460,6 +565,10 @@ namespace platform
 			void							LatLongTextureToCubemap			(DeviceContext &deviceContext,Texture *destination,Texture *source);
 			//! Save a texture to disk.
 			virtual void					SaveTexture						(GraphicsDeviceContext &, Texture *,const char *){}
+			//! Start an asynchronous copy of the texture's top mip to CPU memory. Returns nullptr if the API doesn't support this.
+			virtual std::shared_ptr<TextureReadback> CreateTextureReadback	(GraphicsDeviceContext &, Texture *){return nullptr;}
+			//! The queue used to save textures to disk without stalling rendering.
+			TextureCapture					*GetTextureCapture();
 			/// Clear the contents of the given texture to the specified colour
 			virtual void					ClearTexture					(crossplatform::DeviceContext &deviceContext,crossplatform::Texture *texture,const vec4& colour);
 
@@ -522,14 +631,35 @@ namespace platform
 			{
 				std::string effect_name;
 				std::function <void()> callback;
+				//! If not empty, compile only these shader variants.
+				std::vector<std::string> variants;
+				//! Have the effect reloaded at the start of a frame when the compile succeeds, and compile whatever the build mode.
+				bool reload=false;
+				std::chrono::steady_clock::time_point queued;
 			};
 			std::thread effectCompileThread;
+			std::mutex effectCompileMutex;
+			std::condition_variable effectCompileCondition;
 			std::vector<EffectRecompile> effectsToCompile;
-			bool recompileThreadActive=true;
+			EffectCompileStats effectCompileStats;
+			bool onDemandVariantCompile=false;
+			//! "effect variant" for each variant requested on demand.
+			std::set<std::string> requestedVariants;
+			//! Effects recompiled on demand, to reload at the start of the next frame.
+			std::set<std::string> effectsToReload;
+			platform::core::FileWatcher *shaderWatcher=nullptr;
+			//! For each watched source file, the effects that use it.
+			std::map<std::string,std::set<std::string>> shaderSourceDependents;
+			void WatchEffectSources(const std::string &effect_name);
+			void OnShaderSourceChanged(const std::string &filename_utf8);
+			//! Read by the compile thread outside effectCompileMutex. It is only set under the mutex, so that the thread can't miss the wake.
+			std::atomic<bool> recompileThreadActive{true};
 			bool recompiled=false;
+			uint64_t effectReloadCount=0;
 			static std::atomic<int> numPlatforms;
 			void recompileAsync();
-			bool RecompileEffect(std::string effect_filename);
+			void queueEffectCompile(EffectRecompile &&r);
+			bool RecompileEffect(std::string effect_filename,const std::vector<std::string> &variants=std::vector<std::string>(),bool requested=false);
 			void NotifyEffectRecompiled();
 			void EnsureContextFrameHasBegun(DeviceContext& deviceContext);
 			// to be called as soon as possible in the frame, for the first available GraphicsDeviceContext.
@@ -539,6 +669,11 @@ namespace platform
 			void FinishGeneratingTextureMips(DeviceContext& deviceContext);
 			std::set<Texture*> unfinishedTextures;
 			std::set<Texture*> unMippedTextures;
+			bool cpuTextureMips=false;
+			MipChainSettings cpuTextureMipSettings;
+			bool cpuTextureCompression=false;
+			BlockCompressionSettings cpuTextureCompressionSettings;
+			bool textureCache=true;
 			/// Create a platform-specific texture instance. Textures created with this function are owned by the caller.
 			virtual Texture* createTexture() = 0;
 			platform::core::MemoryInterface *memoryInterface;
@@ -582,10 +717,28 @@ namespace platform
 			phmap::flat_hash_map<const void *,ContextState *> contextState;
 			crossplatform::GpuProfiler		*GetGpuProfiler();
 			TextRenderer					*textRenderer;
+			bool							textBatching=false;
+			TextureCapture					*textureCapture=nullptr;
 			std::map<StandardRenderState,RenderState*> standardRenderStates;
 			bool initializedDefaultShaderPaths = false;
 			std::vector<std::shared_ptr<Buffer>> debugVertexBuffers;
+			size_t debugVertexBufferIndex=0;
+			long long debugVertexBufferFrame=-1;
+			Buffer *GetDebugVertexBuffer(DeviceContext &deviceContext,int count);
 			std::shared_ptr<Layout> posColourLayout;
+			// Debug-draw buckets, indexed by (test_depth?1:0)+(view_centred?2:0).
+			struct DebugDrawBatch
+			{
+				std::vector<PosColourVertex> buckets[4];
+				uint32_t vertexCount=0;
+				long long frame=-1;
+			};
+			void RecordDebugLines(GraphicsDeviceContext &deviceContext,const PosColourVertex *lines,int count,bool strip,bool test_depth,bool view_centred);
+			std::map<const void*,DebugDrawBatch> debugDrawBatches;
+			bool debugDrawBatching=false;
+			uint32_t debugDrawVertexLimit=1<<20;
+			DebugDrawStats debugDrawStats;
+			DebugDrawStats lastDebugDrawStats;
 		};
 
 		/// Draw a horizontal grid in 3D.
@@ -44,13 +44,14 @@ void SphereRenderer::RecompileShaders()
 void SphereRenderer::LoadShaders()
 {
 	reload_shaders = false;
-	delete effect;
+	renderPlatform->Destroy(effect);
+	effectReloadCount = renderPlatform->GetEffectReloadCount();
 	effect=renderPlatform->CreateEffect("sphere");
 }
 
 void SphereRenderer::DrawCrossSection(GraphicsDeviceContext &deviceContext,crossplatform::Effect *effect, crossplatform::Texture *t, vec3 texcOffset, vec3 origin, vec4 orient_quat, float qsize, float sph_rad, vec4 colour, int pass)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view = deviceContext.viewStruct.view;
@@ -68,7 +69,7 @@ void SphereRenderer::DrawCrossSection(GraphicsDeviceContext &deviceContext,cross
 	math::Vector3 cam_pos;
 	crossplatform::GetCameraPosVector(deviceContext.viewStruct.view, (float*)&cam_pos, (float*)&view_dir);
 	crossplatform::EffectTechnique *tech = effect->GetTechniqueByName("draw_cross_section_on_sphere");
-	effect->SetTexture(deviceContext, "cloudVolume", t);
+	effect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("cloudVolume"), t);
 	sphereConstants.quaternion = orient_quat;
 	sphereConstants.radius = sph_rad;
 	sphereConstants.sideview = qsize * 0.5f;
@@ -86,7 +87,7 @@ void SphereRenderer::DrawCrossSection(GraphicsDeviceContext &deviceContext,cross
 
 void SphereRenderer::DrawMultipleCrossSections(GraphicsDeviceContext& deviceContext, crossplatform::Effect* effect, crossplatform::Texture* t, vec3 texcOffset, vec3 origin, vec4 orient_quat, float qsize, float sph_rad, vec4 colour, int slices)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view = deviceContext.viewStruct.view;
@@ -104,7 +105,7 @@ void SphereRenderer::DrawMultipleCrossSections(GraphicsDeviceContext& deviceCont
 	math::Vector3 cam_pos;
 	crossplatform::GetCameraPosVector(deviceContext.viewStruct.view, (float*)&cam_pos, (float*)&view_dir);
 	crossplatform::EffectTechnique* tech = effect->GetTechniqueByName("draw_multiple_cross_sections_on_sphere");
-	effect->SetTexture(deviceContext, "cloudVolume", t);
+	effect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("cloudVolume"), t);
 	sphereConstants.quaternion = orient_quat;
 	sphereConstants.radius = sph_rad;
 	sphereConstants.sideview = qsize * 0.5f;
@@ -122,7 +123,7 @@ void SphereRenderer::DrawMultipleCrossSections(GraphicsDeviceContext& deviceCont
 
 void SphereRenderer::DrawLatLongSphere(GraphicsDeviceContext &deviceContext,int lat, int longt,vec3 origin,float radius,vec4 colour)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 &view=deviceContext.viewStruct.view;
@@ -163,7 +164,7 @@ void SphereRenderer::DrawLatLongSphere(GraphicsDeviceContext &deviceContext,int
 
 void SphereRenderer::DrawQuad(GraphicsDeviceContext &deviceContext, vec3 origin, vec4 orient_quat, float qsize, float sph_rad, vec4 colour, vec4 fill_colour, bool cheq)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
@@ -208,7 +209,7 @@ void SphereRenderer::DrawQuad(GraphicsDeviceContext &deviceContext, vec3 origin,
 
 void SphereRenderer::DrawColouredSphere(GraphicsDeviceContext &deviceContext, vec3 origin, float sph_rad, vec4 clr)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view = deviceContext.viewStruct.view;
@@ -243,7 +244,7 @@ void SphereRenderer::DrawColouredSphere(GraphicsDeviceContext &deviceContext, ve
 
 void SphereRenderer::DrawTexturedSphere(GraphicsDeviceContext &deviceContext,vec3 origin,float sph_rad,crossplatform::Texture *texture,vec4 clr)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
@@ -262,7 +263,7 @@ void SphereRenderer::DrawTexturedSphere(GraphicsDeviceContext &deviceContext,vec
 	math::Vector3 cam_pos;
 	crossplatform::GetCameraPosVector(deviceContext.viewStruct.view,(float*)&cam_pos,(float*)&view_dir);
 	crossplatform::EffectTechnique*		tech		=effect->GetTechniqueByName("draw_textured_sphere");
-	auto imageTexture=effect->GetShaderResource("imageTexture");
+	auto imageTexture=effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("imageTexture"));
 	renderPlatform->SetTexture(deviceContext, imageTexture, texture);
 	//sphereConstants.quaternion		=orient_quat;
 	sphereConstants.radius			=sph_rad;
@@ -280,7 +281,7 @@ void SphereRenderer::DrawTexturedSphere(GraphicsDeviceContext &deviceContext,vec
 
 void SphereRenderer::DrawTexture(GraphicsDeviceContext &deviceContext,crossplatform::Texture *t,vec3 origin,vec4 orient_quat,float qsize,float sph_rad,vec4 colour)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
@@ -298,7 +299,7 @@ void SphereRenderer::DrawTexture(GraphicsDeviceContext &deviceContext,crossplatf
 	math::Vector3 cam_pos;
 	crossplatform::GetCameraPosVector(deviceContext.viewStruct.view,(float*)&cam_pos,(float*)&view_dir);
 	crossplatform::EffectTechnique*		tech		=effect->GetTechniqueByName("draw_texture_on_sphere");
-	auto imageTexture=effect->GetShaderResource("imageTexture");
+	auto imageTexture=effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("imageTexture"));
 	renderPlatform->SetTexture(deviceContext, imageTexture, t);
 	sphereConstants.quaternion		=orient_quat;
 	sphereConstants.radius			=sph_rad;
@@ -316,7 +317,7 @@ void SphereRenderer::DrawTexture(GraphicsDeviceContext &deviceContext,crossplatf
 
 void SphereRenderer::DrawCurvedTexture(GraphicsDeviceContext& deviceContext, crossplatform::Texture* t, vec3 origin, vec4 orient_quat, float qsize, float sph_rad, vec4 colour)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view = deviceContext.viewStruct.view;
@@ -334,7 +335,7 @@ void SphereRenderer::DrawCurvedTexture(GraphicsDeviceContext& deviceContext, cro
 	math::Vector3 cam_pos;
 	crossplatform::GetCameraPosVector(deviceContext.viewStruct.view, (float*)&cam_pos, (float*)&view_dir);
 	crossplatform::EffectTechnique* tech = effect->GetTechniqueByName("draw_curved_texture_on_sphere");
-	auto imageTexture = effect->GetShaderResource("imageTexture");
+	auto imageTexture = effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("imageTexture"));
 	renderPlatform->SetTexture(deviceContext, imageTexture, t);
 	sphereConstants.quaternion = orient_quat;
 	sphereConstants.radius = sph_rad;
@@ -352,7 +353,7 @@ void SphereRenderer::DrawCurvedTexture(GraphicsDeviceContext& deviceContext, cro
 
 void SphereRenderer::DrawCircle(GraphicsDeviceContext &deviceContext, vec3 origin, vec4 orient_quat, float rad,float sph_rad, vec4 colour, vec4 fill_colour)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
@@ -394,7 +395,7 @@ void SphereRenderer::DrawCircle(GraphicsDeviceContext &deviceContext, vec3 origi
 
 void SphereRenderer::DrawArc(GraphicsDeviceContext &deviceContext, vec3 origin, vec4 q1, vec4 q2, float sph_rad, vec4 colour)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
@@ -429,7 +430,7 @@ void SphereRenderer::DrawArc(GraphicsDeviceContext &deviceContext, vec3 origin,
 
 void SphereRenderer::DrawAxes(GraphicsDeviceContext &deviceContext,vec4 orient_quat,vec3 pos, float size)
 {
-	if (reload_shaders)
+	if (reload_shaders || effectReloadCount != renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	
 	math::Matrix4x4 view=deviceContext.viewStruct.view;
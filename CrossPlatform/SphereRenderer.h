@@ -43,6 +43,8 @@ namespace platform
 			crossplatform::ConstantBuffer<SphereConstants> sphereConstants;
 			crossplatform::Effect *effect = nullptr;
 			bool reload_shaders = true;
+			//! RenderPlatform::GetEffectReloadCount() when the effect was loaded.
+			uint64_t effectReloadCount = 0;
 		};
 	}
 }
@@ -57,6 +57,7 @@ void SphericalHarmonics::LoadShaders()
 		return;
 	SAFE_DESTROY(renderPlatform, sphericalHarmonicsEffect);
 	SAFE_DESTROY(renderPlatform, lightProbesEffect);
+	effectReloadCount			=renderPlatform->GetEffectReloadCount();
 	sphericalHarmonicsEffect	=renderPlatform->CreateEffect("spherical_harmonics");
 	jitter							=sphericalHarmonicsEffect->GetTechniqueByName("jitter");
 	encode							=sphericalHarmonicsEffect->GetTechniqueByName("encode");
@@ -111,7 +112,7 @@ void SphericalHarmonics::RenderMipsByRoughness(GraphicsDeviceContext &deviceCont
 
 void SphericalHarmonics::CopyMip(GraphicsDeviceContext &deviceContext,Texture *tex,int face,int src_mip,float blend)
 {
-	if (!lightProbesEffect)
+	if (!lightProbesEffect||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 	{
 		LoadShaders();
 	}
@@ -135,7 +136,7 @@ void SphericalHarmonics::CopyMip(GraphicsDeviceContext &deviceContext,Texture *t
 	}
 	const char *passname = (lightProbeConstants.roughness < 0.01f) ? "smooth" : (lightProbeConstants.roughness < 0.99f ? "general" : "rough");
 	// The source is the i'th mip of the faceIndex face of the cubemap texture.
-	lightProbesEffect->SetTexture(deviceContext, "sourceCubemap", tex, {TextureAspectFlags::COLOUR, 0, 1, 0, (uint8_t)-1});
+	lightProbesEffect->SetTexture(deviceContext, PLATFORM_SHADER_RESOURCE("sourceCubemap"), tex, {TextureAspectFlags::COLOUR, 0, 1, 0, (uint8_t)-1});
 	// The target is the (i+1)'th mip of the faceIndex face.
 	tex->activateRenderTarget(deviceContext,MakeTextureView(tex->GetShaderResourceTypeForRTVAndDSV(), 
 		TextureAspectFlags::COLOUR, src_mip + 1, 1, face, 1));
@@ -157,12 +158,12 @@ bool SphericalHarmonics::Probe(crossplatform::DeviceContext &deviceContext
 {
 	crossplatform::EffectTechnique *tech=sphericalHarmonicsEffect->GetTechniqueByName("probe_query");
 
-	sphericalHarmonicsEffect->SetTexture(deviceContext,"cubemapAsTexture2DArray",buffer_texture);
+	sphericalHarmonicsEffect->SetTexture(deviceContext,PLATFORM_SHADER_RESOURCE("cubemapAsTexture2DArray"),buffer_texture);
 	if(size.x*size.y>(unsigned)probeResultsRW.count)
 	{
 		probeResultsRW.RestoreDeviceObjects(renderPlatform,size.x*size.y*2,true,false,nullptr,"probeResultsRW");
 	}
-	probeResultsRW.ApplyAsUnorderedAccessView(deviceContext, sphericalHarmonicsEffect,sphericalHarmonicsEffect->GetShaderResource("targetBuffer"));
+	probeResultsRW.ApplyAsUnorderedAccessView(deviceContext, sphericalHarmonicsEffect,_targetBuffer);
 
 	sphericalHarmonicsConstants.lookupOffset=uint3(pos.x,pos.y,face_index);
 	sphericalHarmonicsConstants.lookupSize=size;
@@ -203,7 +204,7 @@ void SphericalHarmonics::CalcSphericalHarmonics(crossplatform::DeviceContext &de
 		sphericalHarmonics.RestoreDeviceObjects(renderPlatform,num_coefficients,true,true,nullptr,"spherical Harmonics");
 		sphericalSamples.RestoreDeviceObjects(renderPlatform,sqrt_jitter_samples*sqrt_jitter_samples,true,true,nullptr,"sphericalSamples");
 	}
-	if(!sphericalHarmonicsEffect)
+	if(!sphericalHarmonicsEffect||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	SIMUL_COMBINED_PROFILE_START(deviceContext,"clear")
 	sphericalHarmonicsConstants.num_bands			=bands;
@@ -293,7 +294,7 @@ void SphericalHarmonics::RenderEnvmap(GraphicsDeviceContext &deviceContext,cross
 {
 	if (!target_texture)
 		return;
-	if (!lightProbesEffect)
+	if (!lightProbesEffect||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 	{
 		LoadShaders();
 	}
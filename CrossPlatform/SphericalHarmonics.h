@@ -72,6 +72,8 @@ namespace platform
 			Effect										*sphericalHarmonicsEffect;
 			int											shSeed;
 			crossplatform::Effect						*lightProbesEffect;
+			//! RenderPlatform::GetEffectReloadCount() when the effects were loaded.
+			uint64_t									effectReloadCount=0;
 			crossplatform::EffectTechnique				*mip_from_roughness_blend;
 			crossplatform::EffectTechnique				*mip_from_roughness_no_blend;
 			crossplatform::EffectTechnique				*jitter;
@@ -242,7 +242,8 @@ void Text3DRenderer::RecompileShaders()
 void Text3DRenderer::LoadShaders()
 {
 	recompile = false;
-	SAFE_DELETE(effect);
+	renderPlatform->Destroy(effect);
+	effectReloadCount=renderPlatform->GetEffectReloadCount();
 	ERRNO_BREAK
 	effect = renderPlatform->CreateEffect("font");
 	ERRNO_BREAK
@@ -261,7 +262,7 @@ int Text3DRenderer::Render(GraphicsDeviceContext &deviceContext,float x0,float y
 	bool supportShaderViewID = renderPlatform->GetType() == crossplatform::RenderPlatformType::D3D11 ? false : true;
 	int passIndex = supportShaderViewID ? 0 : 1;
 
-	if (recompile)
+	if (recompile||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	float transp[]={0.f,0.f,0.f,0.f};
 	float white[]={1.f,1.f,1.f,1.f};
@@ -371,7 +372,7 @@ int Text3DRenderer::Render(MultiviewGraphicsDeviceContext& deviceContext, float*
 	int passIndex = supportShaderViewID ? 0 : 1;
 	SIMUL_ASSERT_WARN(supportShaderViewID, "Graphics API doesn't support SV_ViewID/gl_ViewIndex in the shader. Falling back to single view rendering.");
 
-	if (recompile)
+	if (recompile||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 		LoadShaders();
 	float transp[] = { 0.f,0.f,0.f,0.f };
 	float white[] = { 1.f,1.f,1.f,1.f };
@@ -54,6 +54,8 @@ namespace platform
 			crossplatform::Texture*			font_texture=nullptr;
 			crossplatform::RenderPlatform *renderPlatform=nullptr;
 			bool recompile=true;
+			//! RenderPlatform::GetEffectReloadCount() when the effect was loaded.
+			uint64_t effectReloadCount=0;
 			int fontWidth = 0;
 			FontIndex * fontIndices = nullptr;
 			int defaultTextHeight=20;
@@ -44,168 +44,555 @@ TextFileInput::~TextFileInput()
 	}
 }
 
-static string StripOuterWhitespace(string str)
+namespace
 {
-	string ret=str;
-	char c=0;
-	while(ret.size()>0&&c==0)
+	bool IsSpace(char c)
 	{
-		c=ret.c_str()[0];
-		if(!c)		//no ascii for this character!
-			break;
-		if(c==' '||c=='\t'||c=='\r'||c=='\n')
+		return c==' '||c=='\t'||c=='\r'||c=='\n';
+	}
+
+	std::string_view StripOuterWhitespace(std::string_view str)
+	{
+		size_t b=0,e=str.size();
+		while(b<e&&IsSpace(str[b]))
+			b++;
+		while(e>b&&IsSpace(str[e-1]))
+			e--;
+		return str.substr(b,e-b);
+	}
+
+	//! Strip whitespace, then one pair of outer quotes, double or single. A missing closing quote is allowed.
+	std::string_view StripOuterQuotes(std::string_view str)
+	{
+		str=StripOuterWhitespace(str);
+		if(str.size()&&(str[0]=='\"'||str[0]=='\''))
 		{
-			ret=ret.substr(1,ret.length()-1);
-			c=0;
+			char q=str[0];
+			str.remove_prefix(1);
+			if(str.size()&&str.back()==q)
+				str.remove_suffix(1);
 		}
+		return str;
 	}
-	c=0;
-	while(ret.size()>0&&c==0)
+
+	//! Skip whitespace, and the commas that json-style files put between members.
+	size_t SkipSeparators(std::string_view text,size_t pos)
+	{
+		while(pos<text.size()&&(IsSpace(text[pos])||text[pos]==','))
+			pos++;
+		return pos;
+	}
+
+	//! Skip a bracketed block that we can't interpret, returning the position after its close.
+	size_t SkipBlock(std::string_view text,size_t pos)
 	{
-		c=ret.c_str()[ret.length()-1];
-		if(!c)		//no ascii for this character!
-			break;
-		if(c==' '||c=='\t'||c=='\r'||c=='\n')
+		int depth=0;
+		for(;pos<text.size();pos++)
 		{
-			ret=ret.substr(0,ret.length()-1);
-			c=0;
+			char c=text[pos];
+			if(c=='{'||c=='[')
+				depth++;
+			else if((c=='}'||c==']')&&--depth<=0)
+				return pos+1;
 		}
+		return pos;
 	}
-	return ret;
-}
 
-static string StripOuterQuotes(const string &str)
-{
-	string ret=StripOuterWhitespace(str);
-	if(ret.size()==0)
-		return str;
-	if(ret[0]=='\"')
+	const char binaryMagic[4]={'P','T','X','B'};
+	const uint32_t binaryVersion=1;
+	const uint32_t BINARY_KEY_TABLE=1;
+	//! How an array is stored: as a list of elements, or as fixed-size records that share one set of typed properties.
+	enum class ArrayLayout : uint8_t
 	{
-		if(ret.length()>1)
-			ret=ret.substr(1,ret.length()-1);
-		else
-			ret.clear();
-		if(ret.length())
-			if(ret[ret.length()-1]=='\"')
-				ret=ret.substr(0,ret.length()-1);
+		ELEMENTS=0,RECORDS
+	};
+
+	//! The size of one component of a binary property, which is also its alignment in a record.
+	size_t ComponentSize(PropertyType t)
+	{
+		switch(t)
+		{
+		case PropertyType::BOOL:
+			return 1;
+		case PropertyType::INT64:
+		case PropertyType::UINT64:
+		case PropertyType::DOUBLE:
+		case PropertyType::QUATERNIOND:
+			return 8;
+		case PropertyType::STRING:
+			return 0;
+		default:
+			return 4;
+		}
 	}
-	if(ret[0]=='\'')
+
+	size_t ValueSize(PropertyType t)
 	{
-		if(ret.length()>1)
-			ret=ret.substr(1,ret.length()-1);
-		else
-			ret.clear();
-		if(ret.length())
-			if(ret[ret.length()-1]=='\'')
-				ret=ret.substr(0,ret.length()-1);
+		switch(t)
+		{
+		case PropertyType::UINT2:
+		case PropertyType::INT2:
+		case PropertyType::VEC2:
+			return 2*ComponentSize(t);
+		case PropertyType::UINT3:
+		case PropertyType::INT3:
+		case PropertyType::VEC3:
+			return 3*ComponentSize(t);
+		case PropertyType::UINT4:
+		case PropertyType::INT4:
+		case PropertyType::VEC4:
+		case PropertyType::QUATERNIOND:
+			return 4*ComponentSize(t);
+		case PropertyType::BOOL:
+		case PropertyType::INT:
+		case PropertyType::UINT:
+		case PropertyType::INT64:
+		case PropertyType::UINT64:
+		case PropertyType::DOUBLE:
+		case PropertyType::FLOAT:
+			return ComponentSize(t);
+		default:
+			return 0;
+		}
 	}
-	return ret;
-}
 
-static int findMatching(const std::string &text,int open_brace_pos,const char *open,const char *close)
-{
-	int brace=1;
-	size_t pos=open_brace_pos;
-	while(pos<text.length())
+	//! The text for a binary property, exactly as TextFileOutput formats it.
+	std::string FormatValue(const PropertyValue &v)
 	{
-		size_t next_open=text.find(open,pos+1);
-		size_t next_close=text.find(close,pos+1);
-		if(next_open<next_close)
+		uint32_t u[4];
+		int32_t i[4];
+		float f[4];
+		double d[4];
+		switch(v.type)
 		{
-			brace++;
-			pos=next_open;
+		case PropertyType::BOOL:
+			return ((const uint8_t*)v.data)[0]?"true":"false";
+		case PropertyType::INT:
+			memcpy(i,v.data,4);
+			return core::stringFormat("%d",i[0]);
+		case PropertyType::UINT:
+			memcpy(u,v.data,4);
+			return core::stringFormat("%u",u[0]);
+		case PropertyType::INT64:
+			{
+				int64_t l;
+				memcpy(&l,v.data,8);
+				return core::stringFormat("%lld",(long long)l);
+			}
+		case PropertyType::UINT64:
+			{
+				uint64_t l;
+				memcpy(&l,v.data,8);
+				return core::stringFormat("%llu",(unsigned long long)l);
+			}
+		case PropertyType::DOUBLE:
+			return core::stringFormat("%16.16g",v.data[0]);
+		case PropertyType::FLOAT:
+			memcpy(f,v.data,4);
+			return core::stringFormat("%16.16g",f[0]);
+		case PropertyType::UINT2:
+			memcpy(u,v.data,8);
+			return core::stringFormat("%u,%u",u[0],u[1]);
+		case PropertyType::UINT3:
+			memcpy(u,v.data,12);
+			return core::stringFormat("%u,%u,%u",u[0],u[1],u[2]);
+		case PropertyType::UINT4:
+			memcpy(u,v.data,16);
+			return core::stringFormat("%u,%u,%u,%u",u[0],u[1],u[2],u[3]);
+		case PropertyType::INT2:
+			memcpy(i,v.data,8);
+			return core::stringFormat("%d,%d",i[0],i[1]);
+		case PropertyType::INT3:
+			memcpy(i,v.data,12);
+			return core::stringFormat("%d,%d,%d",i[0],i[1],i[2]);
+		case PropertyType::INT4:
+			memcpy(i,v.data,16);
+			return core::stringFormat("%d,%d,%d,%d",i[0],i[1],i[2],i[3]);
+		case PropertyType::VEC2:
+			memcpy(f,v.data,8);
+			return core::stringFormat("%16.16g,%16.16g",f[0],f[1]);
+		case PropertyType::VEC3:
+			memcpy(f,v.data,12);
+			return core::stringFormat("%16.16g,%16.16g,%16.16g",f[0],f[1],f[2]);
+		case PropertyType::VEC4:
+			memcpy(f,v.data,16);
+			return core::stringFormat("%16.16g,%16.16g,%16.16g,%16.16g",f[0],f[1],f[2],f[3]);
+		case PropertyType::QUATERNIOND:
+			memcpy(d,v.data,32);
+			return core::stringFormat("%16.16g,%16.16g,%16.16g,%16.16g",d[0],d[1],d[2],d[3]);
+		default:
+			return "";
 		}
-		else if(next_close<next_open)
+	}
+
+	//! The offsets of typed properties in a record, each aligned to its component size. Returns the record size, a multiple of 8.
+	size_t RecordLayout(const std::vector<PropertyType> &types,std::vector<size_t> &offsets)
+	{
+		size_t offset=0;
+		offsets.clear();
+		for(PropertyType t:types)
 		{
-			brace--;
-			pos=next_close;
-			if(!brace)
-				return (int)pos;
+			size_t a=ComponentSize(t);
+			offset=(offset+a-1)/a*a;
+			offsets.push_back(offset);
+			offset+=ValueSize(t);
 		}
-		else
-			pos=text.length();
+		return (offset+7)&~(size_t)7;
 	}
-	return (int)pos;
-}
 
-static int findMatchingSq(const std::string &text,int open_brace_pos)
-{
-	return findMatching(text,open_brace_pos,"[","]");
+	struct BinaryWriter
+	{
+		std::ostream &os;
+		//! Bytes written so far, for alignment relative to the start of the data.
+		size_t offset=0;
+		bool keyTable=false;
+		std::map<std::string,uint32_t> keys;
+		std::vector<const std::string*> keyList;
+		BinaryWriter(std::ostream &o):os(o)
+		{
+		}
+		void Write(const void *d,size_t n)
+		{
+			os.write((const char*)d,n);
+			offset+=n;
+		}
+		void U8(uint8_t u)
+		{
+			Write(&u,1);
+		}
+		void U32(uint32_t u)
+		{
+			Write(&u,4);
+		}
+		void String(const std::string &s)
+		{
+			U32((uint32_t)s.size());
+			Write(s.data(),s.size());
+		}
+		void Key(const std::string &s)
+		{
+			if(keyTable)
+				U32(keys[s]);
+			else
+				String(s);
+		}
+		void AddKey(const std::string &s)
+		{
+			auto k=keys.insert({s,(uint32_t)keyList.size()});
+			if(k.second)
+				keyList.push_back(&k.first->first);
+		}
+		void Align(size_t a)
+		{
+			static const char zeros[8]={0};
+			Write(zeros,(a-offset%a)%a);
+		}
+	};
+
+	void CollectKeys(BinaryWriter &w,const TextFileOutput &o)
+	{
+		for(const auto &p:o.properties)
+			w.AddKey(p.first);
+		for(const auto &s:o.subElements)
+		{
+			w.AddKey(s.first);
+			CollectKeys(w,s.second);
+		}
+		for(const auto &a:o.arrays)
+		{
+			w.AddKey(a.first);
+			for(const TextOutput *e:a.second)
+				CollectKeys(w,*(const TextFileOutput*)e);
+		}
+	}
+
+	//! Can the array be stored as records? Its elements must all have the same typed properties, and nothing else.
+	bool IsRecordArray(const TextOutput::Array &array)
+	{
+		if(array.size()<2)
+			return false;
+		const TextFileOutput *first=(const TextFileOutput*)array[0];
+		for(const TextOutput *a:array)
+		{
+			const TextFileOutput *e=(const TextFileOutput*)a;
+			if(e->subElements.size()||e->arrays.size()||e->values.empty()||e->properties.size()!=e->values.size()||e->values.size()!=first->values.size())
+				return false;
+			auto j=first->values.begin();
+			for(const auto &v:e->values)
+			{
+				if(v.first!=j->first||v.second.type!=j->second.type)
+					return false;
+				j++;
+			}
+		}
+		return true;
+	}
+
+	void WriteElement(BinaryWriter &w,const TextFileOutput &o)
+	{
+		w.U32((uint32_t)o.properties.size());
+		for(const auto &p:o.properties)
+		{
+			w.Key(p.first);
+			auto v=o.values.find(p.first);
+			if(v==o.values.end())
+			{
+				w.U8((uint8_t)PropertyType::STRING);
+				w.String(p.second);
+			}
+			else
+			{
+				w.U8((uint8_t)v->second.type);
+				w.Write(v->second.data,ValueSize(v->second.type));
+			}
+		}
+		w.U32((uint32_t)o.subElements.size());
+		for(const auto &s:o.subElements)
+		{
+			w.Key(s.first);
+			WriteElement(w,s.second);
+		}
+		w.U32((uint32_t)o.arrays.size());
+		for(const auto &a:o.arrays)
+		{
+			w.Key(a.first);
+			const TextOutput::Array &array=a.second;
+			if(!IsRecordArray(array))
+			{
+				w.U8((uint8_t)ArrayLayout::ELEMENTS);
+				w.U32((uint32_t)array.size());
+				for(const TextOutput *e:array)
+					WriteElement(w,*(const TextFileOutput*)e);
+				continue;
+			}
+			// The fields are named once, then each element is a record that can be read in place.
+			w.U8((uint8_t)ArrayLayout::RECORDS);
+			w.U32((uint32_t)array.size());
+			const TextFileOutput *first=(const TextFileOutput*)array[0];
+			std::vector<PropertyType> types;
+			w.U32((uint32_t)first->values.size());
+			for(const auto &v:first->values)
+			{
+				w.Key(v.first);
+				w.U8((uint8_t)v.second.type);
+				types.push_back(v.second.type);
+			}
+			std::vector<size_t> offsets;
+			size_t stride=RecordLayout(types,offsets);
+			w.U32((uint32_t)stride);
+			w.Align(8);
+			std::vector<uint8_t> record(stride);
+			for(const TextOutput *a:array)
+			{
+				std::fill(record.begin(),record.end(),(uint8_t)0);
+				size_t k=0;
+				for(const auto &v:((const TextFileOutput*)a)->values)
+				{
+					memcpy(record.data()+offsets[k],v.second.data,ValueSize(v.second.type));
+					k++;
+				}
+				w.Write(record.data(),stride);
+			}
+		}
+	}
 }
 
-static int findMatchingBrace(const std::string &text,int open_brace_pos)
+namespace platform
 {
-	return findMatching(text,open_brace_pos,"{","}");
+	namespace crossplatform
+	{
+		//! Reads the binary format from memory, with the names as views into it.
+		struct BinaryReader
+		{
+			const uint8_t *data=nullptr;
+			size_t size=0;
+			size_t pos=0;
+			bool good=true;
+			bool keyTable=false;
+			std::vector<std::string_view> keys;
+			bool Read(void *dst,size_t n)
+			{
+				if(!good||n>size-pos)
+				{
+					good=false;
+					return false;
+				}
+				memcpy(dst,data+pos,n);
+				pos+=n;
+				return true;
+			}
+			uint8_t U8()
+			{
+				uint8_t u=0;
+				Read(&u,1);
+				return u;
+			}
+			uint32_t U32()
+			{
+				uint32_t u=0;
+				Read(&u,4);
+				return u;
+			}
+			std::string_view String()
+			{
+				uint32_t n=U32();
+				if(!good||n>size-pos)
+				{
+					good=false;
+					return std::string_view();
+				}
+				std::string_view s((const char*)data+pos,n);
+				pos+=n;
+				return s;
+			}
+			std::string_view Key()
+			{
+				if(!keyTable)
+					return String();
+				uint32_t k=U32();
+				if(k>=keys.size())
+				{
+					good=false;
+					return std::string_view();
+				}
+				return keys[k];
+			}
+			void Align(size_t a)
+			{
+				pos=(pos+a-1)/a*a;
+				if(pos>size)
+				{
+					pos=size;
+					good=false;
+				}
+			}
+		};
+	}
 }
 
-static void LoadArray(TextInput::Array &array,const string &text,platform::core::MemoryInterface *m)
+size_t TextFileInput::ParseArray(Array &array,std::string_view text,size_t pos)
 {
-	size_t pos=0;
-	while(pos<text.length())
-	{
-		size_t start_pos	=pos;
-		size_t brace_pos	=text.find("{",pos);
-		size_t colon_pos	=text.find(":",pos);
-		size_t end_pos		=text.find("\n",colon_pos);
-		if(brace_pos<text.length())
-		{	
-			start_pos=brace_pos;
-			 end_pos=(size_t)findMatchingBrace(text,(int)brace_pos);
-		}
-		if(brace_pos>=text.length()&&colon_pos>=text.length())
-			break;
-		std::string sub=text.substr(start_pos,end_pos+1-start_pos);
-		TextFileInput *e=::new(m) TextFileInput;
+	while(true)
+	{
+		pos=SkipSeparators(text,pos);
+		if(pos>=text.size())
+			return pos;
+		if(text[pos]==']')
+			return pos+1;
+		// An unbalanced close brace ends the enclosing element too.
+		if(text[pos]=='}')
+			return pos;
+		TextFileInput *e=::new(memoryInterface) TextFileInput;
 		array.push_back(e);
-		e->Load(sub);
-		pos=end_pos;
+		// Elements with a single property are saved without braces.
+		if(text[pos]=='{')
+			pos=e->Parse(text,pos+1,'}');
+		else
+			pos=e->ParseMember(text,pos);
 	}
 }
 
-void TextFileInput::Load(const std::string &text)
+size_t TextFileInput::ParseMember(std::string_view text,size_t pos)
 {
-	// if there are multiple elements we expect to see { and } at the start and end.
-	size_t open_pos=text.find("{");
-	std::string line;
-	//if(open_pos>=text.length())
-		open_pos=0;
-	size_t pos=open_pos;
-	while(pos<text.length())
-	{
-		size_t colon_pos=text.find(":",pos+1);
-		if(colon_pos>=text.length())
-			break;
-		std::string name=text.substr(pos+1,colon_pos-1-pos);
-		name=StripOuterQuotes(name);
-		size_t next_colon	=text.find(":",colon_pos+1);
-		size_t brace_pos	=text.find("{",colon_pos+1);
-		size_t sq_pos		=text.find("[",colon_pos+1);
-		size_t next_ret		=text.find("\n",colon_pos+1);
-		if(sq_pos<next_colon&&sq_pos<brace_pos)
-		{
-			size_t end_sq_pos=(size_t)findMatchingSq(text,(int)std::min(sq_pos,brace_pos));
-			std::string sub=text.substr(sq_pos,end_sq_pos+1-sq_pos);
-			Array &array=arrays[name];
-			LoadArray(array,sub,memoryInterface);
-			pos=end_sq_pos;
-		}
-		else if(brace_pos>=colon_pos&&brace_pos<next_colon)
-		{
-			size_t end_brace_pos=(size_t)findMatchingBrace(text,(int)brace_pos);
-			std::string sub=text.substr(brace_pos,end_brace_pos+1-brace_pos);
-			subElements[name].Load(sub);
-			pos=end_brace_pos;
-		}
-		else if(next_ret<text.length())
-		{
-			std::string value=text.substr(colon_pos+1,next_ret-1-colon_pos-1);;
-			value=StripOuterQuotes(value);
-			properties[name]=value;
-			pos=next_ret;
+	std::string_view name;
+	if(text[pos]=='\"'||text[pos]=='\'')
+	{
+		size_t end=text.find(text[pos],pos+1);
+		if(end==std::string_view::npos)
+			return text.size();
+		name=text.substr(pos+1,end-pos-1);
+		pos=text.find_first_not_of(" \t\r\n",end+1);
+		if(pos==std::string_view::npos)
+			return text.size();
+		if(text[pos]!=':')
+			return pos;
+	}
+	else
+	{
+		size_t end=text.find_first_of(":\n{}[]",pos);
+		if(end==std::string_view::npos)
+			return text.size();
+		if(text[end]=='\n')
+			return end+1;
+		if(text[end]=='{'||text[end]=='[')
+			return SkipBlock(text,end);
+		if(text[end]!=':')
+			return std::max(end,pos+1);
+		name=StripOuterWhitespace(text.substr(pos,end-pos));
+		pos=end;
+	}
+	// Step past the colon. A sub-element or array may start on the next line, as TextFileOutput writes them.
+	pos=text.find_first_not_of(" \t\r",pos+1);
+	if(pos!=std::string_view::npos&&text[pos]=='\n')
+	{
+		size_t next=text.find_first_not_of(" \t\r\n",pos);
+		if(next!=std::string_view::npos&&(text[next]=='{'||text[next]=='['))
+			pos=next;
+	}
+	if(pos==std::string_view::npos)
+	{
+		properties[std::string(name)].clear();
+		return text.size();
+	}
+	if(text[pos]=='{')
+		return subElements[std::string(name)].Parse(text,pos+1,'}');
+	if(text[pos]=='[')
+		return ParseArray(arrays[std::string(name)],text,pos+1);
+	// Otherwise the value runs to the end of the line, or to a close brace on the same line.
+	// Values are saved unescaped, so a quoted value only ends at a quote that is followed by the end of the member.
+	size_t end=pos;
+	if(text[pos]=='\"'||text[pos]=='\'')
+	{
+		size_t q=pos;
+		while((q=text.find(text[pos],q+1))!=std::string_view::npos)
+		{
+			end=text.find_first_not_of(" \t\r",q+1);
+			if(end==std::string_view::npos||text[end]=='\n'||text[end]==','||text[end]=='}'||text[end]==']')
+				break;
 		}
-		else
-			break;
+		if(q==std::string_view::npos)
+			end=text.find('\n',pos);
 	}
+	else
+		end=text.find_first_of("\n}]",pos);
+	if(end==std::string_view::npos)
+		end=text.size();
+	std::string_view value=StripOuterWhitespace(text.substr(pos,end-pos));
+	if(value.size()&&value.back()==',')
+		value.remove_suffix(1);
+	properties[std::string(name)]=StripOuterQuotes(value);
+	// Leave a close brace for the caller.
+	if(end<text.size()&&text[end]=='\n')
+		end++;
+	return end;
+}
+
+size_t TextFileInput::Parse(std::string_view text,size_t pos,char close)
+{
+	while(true)
+	{
+		pos=SkipSeparators(text,pos);
+		if(pos>=text.size())
+			return pos;
+		if(text[pos]==close||text[pos]=='}'||text[pos]==']')
+			return pos+1;
+		pos=ParseMember(text,pos);
+	}
+}
+
+void TextFileInput::Load(const std::string &text)
+{
+	Load(std::string_view(text));
+}
+
+void TextFileInput::Load(std::string_view text)
+{
+	// If there are multiple elements we expect to see { and } at the start and end.
+	size_t pos=SkipSeparators(text,0);
+	if(pos<text.size()&&text[pos]=='{')
+		Parse(text,pos+1,'}');
+	else
+		Parse(text,pos,0);
 }
 
 void TextFileInput::SetFileLoader(platform::core::FileLoader *f)
@@ -226,8 +613,13 @@ void TextFileInput::Load(const char *filename_utf8)
 		good=(pointer!=nullptr);
 		if (pointer)
 		{
-			text = (const char*)pointer;
+			// Parse the loaded contents in place, rather than copying them first.
+			if(IsBinary(pointer,bytes))
+				LoadBinary(pointer,bytes);
+			else
+				Load(std::string_view((const char*)pointer));
 			fileLoader->ReleaseFileContents(pointer);
+			return;
 		}
 		else
 			return;
@@ -264,15 +656,152 @@ bool TextFileInput::Good()
 	return good;
 }
 
+bool TextFileInput::IsBinary(const void *data,size_t bytes)
+{
+	return data&&bytes>=sizeof(binaryMagic)&&memcmp(data,binaryMagic,sizeof(binaryMagic))==0;
+}
+
+bool TextFileInput::LoadBinary(const void *data,size_t bytes)
+{
+	if(!IsBinary(data,bytes))
+	{
+		good=false;
+		return false;
+	}
+	BinaryReader r;
+	r.data=(const uint8_t*)data;
+	r.size=bytes;
+	r.pos=sizeof(binaryMagic);
+	uint32_t version=r.U32();
+	if(version!=binaryVersion)
+	{
+		SIMUL_CERR<<"Unsupported binary text file version "<<version<<".\n";
+		good=false;
+		return false;
+	}
+	uint32_t flags=r.U32();
+	if(flags&BINARY_KEY_TABLE)
+	{
+		r.keyTable=true;
+		uint32_t n=r.U32();
+		for(uint32_t i=0;i<n&&r.good;i++)
+			r.keys.push_back(r.String());
+	}
+	good=ReadBinary(r);
+	if(!good)
+		SIMUL_CERR<<"Binary text file is truncated or corrupt.\n";
+	return good;
+}
+
+bool TextFileInput::ReadBinary(BinaryReader &r)
+{
+	uint32_t n=r.U32();
+	for(uint32_t i=0;i<n&&r.good;i++)
+	{
+		std::string name(r.Key());
+		PropertyType type=(PropertyType)r.U8();
+		if(type==PropertyType::STRING)
+		{
+			properties[name]=r.String();
+			continue;
+		}
+		size_t size=ValueSize(type);
+		if(!size)
+			return r.good=false;
+		PropertyValue &v=values[name];
+		v.type=type;
+		r.Read(v.data,size);
+	}
+	n=r.U32();
+	for(uint32_t i=0;i<n&&r.good;i++)
+		subElements[std::string(r.Key())].ReadBinary(r);
+	n=r.U32();
+	for(uint32_t i=0;i<n&&r.good;i++)
+	{
+		Array &array=arrays[std::string(r.Key())];
+		ArrayLayout layout=(ArrayLayout)r.U8();
+		uint32_t count=r.U32();
+		if(layout==ArrayLayout::ELEMENTS)
+		{
+			for(uint32_t j=0;j<count&&r.good;j++)
+			{
+				TextFileInput *e=::new(memoryInterface) TextFileInput;
+				array.push_back(e);
+				e->ReadBinary(r);
+			}
+			continue;
+		}
+		if(layout!=ArrayLayout::RECORDS)
+			return r.good=false;
+		uint32_t fieldCount=r.U32();
+		std::vector<std::string_view> names;
+		std::vector<PropertyType> types;
+		for(uint32_t j=0;j<fieldCount&&r.good;j++)
+		{
+			names.push_back(r.Key());
+			types.push_back((PropertyType)r.U8());
+			if(!ValueSize(types.back()))
+				return r.good=false;
+		}
+		std::vector<size_t> offsets;
+		size_t layoutStride=RecordLayout(types,offsets);
+		uint32_t stride=r.U32();
+		r.Align(8);
+		// Check the count against the data left before allocating anything for it. The writer never makes empty records.
+		if(!r.good||fieldCount==0||stride==0||stride<layoutStride||count>(r.size-r.pos)/stride)
+			return r.good=false;
+		// The records are aligned in the data, so each value is copied straight out.
+		const uint8_t *record=r.data+r.pos;
+		r.pos+=(size_t)count*stride;
+		array.reserve(array.size()+count);
+		for(uint32_t j=0;j<count;j++,record+=stride)
+		{
+			TextFileInput *e=::new(memoryInterface) TextFileInput;
+			array.push_back(e);
+			for(size_t k=0;k<types.size();k++)
+			{
+				PropertyValue &v=e->values[std::string(names[k])];
+				v.type=types[k];
+				memcpy(v.data,record+offsets[k],ValueSize(types[k]));
+			}
+		}
+	}
+	return r.good;
+}
+
+template<typename T> bool TextFileInput::GetValue(const char *name,PropertyType type,T &v)
+{
+	auto i=values.find(name);
+	if(i==values.end())
+		return false;
+	if(i->second.type!=type)
+	{
+		MakeText(name);
+		return false;
+	}
+	static_assert(sizeof(T)<=sizeof(PropertyValue::data),"Value is too large.");
+	memcpy(&v,i->second.data,sizeof(T));
+	return true;
+}
+
+void TextFileInput::MakeText(const char *name)
+{
+	auto i=values.find(name);
+	if(i==values.end()||properties.find(name)!=properties.end())
+		return;
+	properties[name]=FormatValue(i->second);
+}
+
 bool TextFileInput::Has(const char *name) const
 {
-	if(properties.find(name)==properties.end())
+	if(properties.find(name)==properties.end()&&values.find(name)==values.end())
 		return false;
 	return true;
 }
 
 const char *TextFileInput::Get(const char *name,const char *dflt)
 {
+	MakeText(name);
 	if(properties.find(name)==properties.end())
 		return dflt;
 	return properties[name].c_str();
@@ -280,6 +809,9 @@ const char *TextFileInput::Get(const char *name,const char *dflt)
 
 bool TextFileInput::Get(const char *name,bool dflt)
 {
+	uint8_t v;
+	if(GetValue(name,PropertyType::BOOL,v))
+		return v!=0;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	return(strcmp(properties[name].c_str(),"true")==0);
@@ -287,6 +819,9 @@ bool TextFileInput::Get(const char *name,bool dflt)
 
 int TextFileInput::Get(const char *name,int dflt)
 {
+	int32_t v;
+	if(GetValue(name,PropertyType::INT,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	if(_stricmp(properties[name].c_str(),"true")==0)
@@ -298,6 +833,9 @@ int TextFileInput::Get(const char *name,int dflt)
 
 uint TextFileInput::Get(const char* name, uint dflt)
 {
+	uint32_t v;
+	if(GetValue(name,PropertyType::UINT,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	if (_stricmp(properties[name].c_str(), "true") == 0)
@@ -309,6 +847,9 @@ uint TextFileInput::Get(const char* name, uint dflt)
 
 long long TextFileInput::Get(const char* name, long long dflt)
 {
+	int64_t v;
+	if(GetValue(name,PropertyType::INT64,v))
+		return (long long)v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	if (_stricmp(properties[name].c_str(), "true") == 0)
@@ -320,6 +861,9 @@ long long TextFileInput::Get(const char* name, long long dflt)
 
 unsigned long long TextFileInput::Get(const char* name, unsigned long long dflt)
 {
+	uint64_t v;
+	if(GetValue(name,PropertyType::UINT64,v))
+		return (unsigned long long)v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	if (_stricmp(properties[name].c_str(), "true") == 0)
@@ -331,6 +875,9 @@ unsigned long long TextFileInput::Get(const char* name, unsigned long long dflt)
 
 double TextFileInput::Get(const char *name,double dflt)
 {
+	double v;
+	if(GetValue(name,PropertyType::DOUBLE,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 
@@ -351,6 +898,9 @@ double TextFileInput::Get(const char *name,double dflt)
 
 float TextFileInput::Get(const char *name,float dflt)
 {
+	float v;
+	if(GetValue(name,PropertyType::FLOAT,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 
@@ -371,6 +921,9 @@ float TextFileInput::Get(const char *name,float dflt)
 
 uint2 TextFileInput::Get(const char* name, uint2 dflt)
 {
+	uint v[2];
+	if(GetValue(name,PropertyType::UINT2,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	uint val[2];
@@ -389,6 +942,9 @@ uint2 TextFileInput::Get(const char* name, uint2 dflt)
 
 uint3 TextFileInput::Get(const char* name, uint3 dflt)
 {
+	uint v[3];
+	if(GetValue(name,PropertyType::UINT3,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	uint val[3];
@@ -407,6 +963,9 @@ uint3 TextFileInput::Get(const char* name, uint3 dflt)
 
 uint4 TextFileInput::Get(const char* name, uint4 dflt)
 {
+	uint v[4];
+	if(GetValue(name,PropertyType::UINT4,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	uint val[4];
@@ -425,6 +984,9 @@ uint4 TextFileInput::Get(const char* name, uint4 dflt)
 
 int2 TextFileInput::Get(const char* name, int2 dflt)
 {
+	int v[2];
+	if(GetValue(name,PropertyType::INT2,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	int val[2];
@@ -443,6 +1005,9 @@ int2 TextFileInput::Get(const char* name, int2 dflt)
 
 int3 TextFileInput::Get(const char* name, int3 dflt)
 {
+	int v[3];
+	if(GetValue(name,PropertyType::INT3,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	int val[3];
@@ -461,6 +1026,9 @@ int3 TextFileInput::Get(const char* name, int3 dflt)
 
 int4 TextFileInput::Get(const char* name, int4 dflt)
 {
+	int v[4];
+	if(GetValue(name,PropertyType::INT4,v))
+		return v;
 	if (properties.find(name) == properties.end())
 		return dflt;
 	int val[4];
@@ -479,6 +1047,9 @@ int4 TextFileInput::Get(const char* name, int4 dflt)
 
 vec2 TextFileInput::Get(const char *name,vec2 dflt)
 {
+	float v[2];
+	if(GetValue(name,PropertyType::VEC2,v))
+		return (const float *)v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	float val[2];
@@ -508,6 +1079,9 @@ vec2 TextFileInput::Get(const char *name,vec2 dflt)
 
 vec3 TextFileInput::Get(const char *name,vec3 dflt)
 {
+	float v[3];
+	if(GetValue(name,PropertyType::VEC3,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	float val[3];
@@ -537,6 +1111,9 @@ vec3 TextFileInput::Get(const char *name,vec3 dflt)
 
 vec4 TextFileInput::Get(const char *name,vec4 dflt)
 {
+	float v[4];
+	if(GetValue(name,PropertyType::VEC4,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	float val[4];
@@ -566,6 +1143,9 @@ vec4 TextFileInput::Get(const char *name,vec4 dflt)
 
 Quaterniond TextFileInput::Get(const char *name,Quaterniond dflt)
 {
+	double v[4];
+	if(GetValue(name,PropertyType::QUATERNIOND,v))
+		return v;
 	if(properties.find(name)==properties.end())
 		return dflt;
 	double val[4];
@@ -596,15 +1176,28 @@ Quaterniond TextFileInput::Get(const char *name,Quaterniond dflt)
 
 const char *TextFileInput::Get(int propertyIndex)
 {
-	std::map<std::string,std::string>::iterator i=properties.begin();
-	if(propertyIndex>=properties.size())
-		return nullptr;
-	for(int j=0;j<propertyIndex;j++,i++)
+	// The text and binary properties, in name order. A binary property that has been formatted as text is listed once.
+	auto i=properties.begin();
+	auto j=values.begin();
+	while(i!=properties.end()||j!=values.end())
 	{
+		const std::string *name;
+		if(j==values.end()||(i!=properties.end()&&i->first<=j->first))
+		{
+			name=&i->first;
+			if(j!=values.end()&&j->first==i->first)
+				j++;
+			i++;
+		}
+		else
+		{
+			name=&j->first;
+			j++;
+		}
+		if(propertyIndex--==0)
+			return name->c_str();
 	}
-	if(i==properties.end())
-		return nullptr;
-	return i->first.c_str();
+	return nullptr;
 }
 
 TextInput *TextFileInput::GetSubElement(const char *name)
@@ -673,14 +1266,37 @@ void TextFileOutput::Save(const char *filename_utf8)
 {
 	if(!filename_utf8)
 		return;
+	std::string filename=filename_utf8;
+	bool binary=filename.size()>=5&&_stricmp(filename.c_str()+filename.size()-5,".ptxb")==0;
+	std::ios_base::openmode mode=binary?(std::ios::out|std::ios::binary):std::ios::out;
 #ifdef _MSC_VER
-	std::ofstream ofs(platform::core::Utf8ToWString(filename_utf8).c_str());
+	std::ofstream ofs(platform::core::Utf8ToWString(filename_utf8).c_str(),mode);
 #else
-	std::ofstream ofs(filename_utf8);
+	std::ofstream ofs(filename_utf8,mode);
 #endif
 	if(!ofs.good())
 		SIMUL_THROW((std::string("Can't open file for saving: ")+filename_utf8).c_str());
-	Save(ofs,0,true);
+	if(binary)
+		SaveBinary(ofs);
+	else
+		Save(ofs,0,true);
+}
+
+void TextFileOutput::SaveBinary(std::ostream &ofs,bool keyTable)
+{
+	BinaryWriter w(ofs);
+	w.Write(binaryMagic,sizeof(binaryMagic));
+	w.U32(binaryVersion);
+	w.U32(keyTable?BINARY_KEY_TABLE:0);
+	if(keyTable)
+	{
+		CollectKeys(w,*this);
+		w.U32((uint32_t)w.keyList.size());
+		for(const std::string *k:w.keyList)
+			w.String(*k);
+		w.keyTable=true;
+	}
+	WriteElement(w,*this);
 }
 
 std::string TextFileOutput::getText()
@@ -698,7 +1314,9 @@ void TextFileOutput::Save(std::ostream &ofs,int tab,bool bookEnd)
 	tabstr1=tabstr0+"\t";
 	const char *t0=tabstr0.c_str();
 	const char *t1=tabstr1.c_str();
-	if(properties.size()>1||arrays.size()>0||bookEnd)
+	// Only an element with exactly one property, and nothing else, can be read back without braces.
+	bookEnd|=properties.size()!=1||subElements.size()>0||arrays.size()>0;
+	if(bookEnd)
 		write(ofs,core::stringFormat("%s{\n",t0));
 	for(std::map<std::string,std::string>::iterator i=properties.begin();i!=properties.end();i++)
 	{
@@ -709,7 +1327,8 @@ void TextFileOutput::Save(std::ostream &ofs,int tab,bool bookEnd)
 	{
 		write(ofs,core::stringFormat("%s\"%s\":\n",t1,i->first.c_str()));
 		TextFileOutput &s=i->second;
-		s.Save(ofs,tab+1);
+		// The reader only takes a sub-element from the next line if it starts with a brace.
+		s.Save(ofs,tab+1,true);
 	}
 	for(std::map<std::string,Array>::iterator i=arrays.begin();i!=arrays.end();i++)
 	{
@@ -721,7 +1340,7 @@ void TextFileOutput::Save(std::ostream &ofs,int tab,bool bookEnd)
 		}
 		write(ofs,core::stringFormat("%s]\n",t1));
 	}
-	if(properties.size()>1||arrays.size()>0||bookEnd)
+	if(bookEnd)
 		write(ofs,core::stringFormat("%s}\n",t0));
 }
 
@@ -730,94 +1349,118 @@ bool TextFileOutput::Good()
 	return true;
 }
 
+template<typename T> void TextFileOutput::SetValue(const char *name,PropertyType type,const T *v)
+{
+	PropertyValue &p=values[name];
+	p.type=type;
+	memcpy(p.data,v,ValueSize(type));
+	properties[name]=FormatValue(p);
+}
+
 void TextFileOutput::Set(const char *name,const char *value)
 {
 	properties[name]=core::stringFormat("%s",value);
+	values.erase(name);
 }
 
 void TextFileOutput::Set(const char *name,bool value)
 {
-	properties[name]=core::stringFormat("%s",value?"true":"false");
+	uint8_t v=value?1:0;
+	SetValue(name,PropertyType::BOOL,&v);
 }
 
 void TextFileOutput::Set(const char *name,int value)
 {
-	properties[name]=core::stringFormat("%d",value);
+	int32_t v=value;
+	SetValue(name,PropertyType::INT,&v);
 }
 
 void TextFileOutput::Set(const char *name,uint value)
 {
-	properties[name]=core::stringFormat("%u",value);
+	uint32_t v=value;
+	SetValue(name,PropertyType::UINT,&v);
 }
 
 void TextFileOutput::Set(const char* name, long long value)
 {
-	properties[name] = core::stringFormat("%lld", value);
+	int64_t v=value;
+	SetValue(name,PropertyType::INT64,&v);
 }
 
 void TextFileOutput::Set(const char* name, unsigned long long value)
 {
-	properties[name] = core::stringFormat("%llu", value);
+	uint64_t v=value;
+	SetValue(name,PropertyType::UINT64,&v);
 }
 
 void TextFileOutput::Set(const char *name,double value)
 {
-	properties[name]=core::stringFormat("%16.16g",value);
+	SetValue(name,PropertyType::DOUBLE,&value);
 }
 
 void TextFileOutput::Set(const char *name,float value)
 {
-	properties[name]=core::stringFormat("%16.16g",value);
+	SetValue(name,PropertyType::FLOAT,&value);
 }
 
 void TextFileOutput::Set(const char* name, uint2 value)
 {
-	properties[name] = core::stringFormat("%u,%u", value.x, value.y);
+	uint v[]={value.x,value.y};
+	SetValue(name,PropertyType::UINT2,v);
 }
 
 void TextFileOutput::Set(const char* name, uint3 value)
 {
-	properties[name] = core::stringFormat("%u,%u,%u", value.x, value.y, value.z);
+	uint v[]={value.x,value.y,value.z};
+	SetValue(name,PropertyType::UINT3,v);
 }
 
 void TextFileOutput::Set(const char* name, uint4 value)
 {
-	properties[name] = core::stringFormat("%u,%u,%u,%u", value.x, value.y, value.z, value.w);
+	uint v[]={value.x,value.y,value.z,value.w};
+	SetValue(name,PropertyType::UINT4,v);
 }
 
 void TextFileOutput::Set(const char* name, int2 value)
 {
-	properties[name] = core::stringFormat("%d,%d", value.x, value.y);
+	int v[]={value.x,value.y};
+	SetValue(name,PropertyType::INT2,v);
 }
 
 void TextFileOutput::Set(const char *name,int3 value)
 {
-	properties[name]=core::stringFormat("%d,%d,%d",value.x,value.y,value.z);
+	int v[]={value.x,value.y,value.z};
+	SetValue(name,PropertyType::INT3,v);
 }
 
 void TextFileOutput::Set(const char* name, int4 value)
 {
-	properties[name] = core::stringFormat("%d,%d,%d,%d", value.x, value.y, value.z, value.w);
+	int v[]={value.x,value.y,value.z,value.w};
+	SetValue(name,PropertyType::INT4,v);
 }
 
 void TextFileOutput::Set(const char *name,vec2 value)
 {
-	properties[name]=core::stringFormat("%16.16g,%16.16g",value.x,value.y);
+	float v[]={value.x,value.y};
+	SetValue(name,PropertyType::VEC2,v);
 }
 
 void TextFileOutput::Set(const char *name,vec3 value)
 {
-	properties[name]=core::stringFormat("%16.16g,%16.16g,%16.16g",value.x,value.y,value.z);
+	float v[]={value.x,value.y,value.z};
+	SetValue(name,PropertyType::VEC3,v);
 }
 
 void TextFileOutput::Set(const char *name,vec4 value)
 {
-	properties[name]=core::stringFormat("%16.16g,%16.16g,%16.16g,%16.16g",value.x,value.y,value.z,value.w);
+	float v[]={value.x,value.y,value.z,value.w};
+	SetValue(name,PropertyType::VEC4,v);
 }
 
 void TextFileOutput::Set(const char *name,Quaterniond value)
 {
-	properties[name]=core::stringFormat("%16.16g,%16.16g,%16.16g,%16.16g",value.x,value.y,value.z,value.s);
+	double v[]={value.x,value.y,value.z,value.s};
+	SetValue(name,PropertyType::QUATERNIOND,v);
 }
 
 
@@ -5,7 +5,9 @@
 #include "Platform/Core/FileLoader.h"
 #include "Platform/Core/MemoryInterface.h"
 #include <map>
+#include <stdint.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #ifdef _MSC_VER
     #pragma warning(push)
@@ -16,6 +18,20 @@ namespace platform
 {
 	namespace crossplatform
 	{
+		//! The type of a property, as stored in binary files.
+		enum class PropertyType : uint8_t
+		{
+			STRING=0,BOOL,INT,UINT,INT64,UINT64,DOUBLE,FLOAT,UINT2,UINT3,UINT4,INT2,INT3,INT4,VEC2,VEC3,VEC4,QUATERNIOND
+		};
+		//! A property kept in its binary form, so that it can be saved and read back without formatting or parsing text.
+		//! Strings are not stored this way, only in the text properties.
+		struct PropertyValue
+		{
+			PropertyType type=PropertyType::STRING;
+			//! Large enough for a Quaterniond.
+			double data[4];
+		};
+		struct BinaryReader;
 		class TextInput
 		{
 		public:
@@ -126,6 +142,12 @@ namespace platform
 			void SetFileLoader(platform::core::FileLoader *f);
 			void Load(const char *filename);
 			void Load(const std::string &text);
+			//! Parse the text in a single pass. Only the names and values are copied, into the maps below.
+			void Load(std::string_view text);
+			//! Load the binary format written by TextFileOutput::SaveBinary. Load(filename) calls this when it finds the magic number.
+			bool LoadBinary(const void *data,size_t bytes);
+			//! Does the data start with the binary format's magic number?
+			static bool IsBinary(const void *data,size_t bytes);
 			bool Good();
 			//! Is the specified element in the list?
 			virtual bool Has(const char *name) const;
@@ -176,7 +198,19 @@ namespace platform
 			std::map<std::string,std::string> properties;
 			std::map<std::string,TextFileInput> subElements;
 			std::map<std::string,Array> arrays;
+			//! Properties loaded from a binary file. They are formatted into the text properties only if asked for as text, or as another type.
+			std::map<std::string,PropertyValue> values;
 		private:
+			//! Get a binary property of the given type. If it has another type, it's formatted as text for the caller to parse instead.
+			template<typename T> bool GetValue(const char *name,PropertyType type,T &v);
+			//! Format a binary property into the text properties, if there is one and it isn't there already.
+			void MakeText(const char *name);
+			bool ReadBinary(BinaryReader &r);
+			//! Parse members from pos up to the close character or the end of the text. Returns the position after the close.
+			size_t Parse(std::string_view text,size_t pos,char close);
+			//! Parse one "name: value" member, which may be a sub-element or an array. Returns the position after it.
+			size_t ParseMember(std::string_view text,size_t pos);
+			size_t ParseArray(Array &array,std::string_view text,size_t pos);
 			bool good;
 			platform::core::FileLoader *fileLoader;
 			platform::core::MemoryInterface *memoryInterface;
@@ -189,8 +223,12 @@ namespace platform
 			TextFileOutput(platform::core::MemoryInterface *m=NULL);
 			virtual ~TextFileOutput();
 
+			//! Save as text, or in the binary format if the extension is ".ptxb".
 			void Save(const char *filename_utf8);
 			void Save(std::ostream &ofs,int tab=0,bool bookEnd=false);
+			//! Save in the binary format: typed, length-prefixed values, with the names in a table if keyTable is true.
+			//! Arrays whose elements all have the same typed properties are stored as aligned fixed-size records.
+			void SaveBinary(std::ostream &ofs,bool keyTable=true);
 			bool Good();
 			// Name of the specified element
 			void Set(const char *name,const char *value);
@@ -223,7 +261,10 @@ namespace platform
 			std::map<std::string,std::string> properties;
 			std::map<std::string,TextFileOutput> subElements;
 			std::map<std::string,Array> arrays;
+			//! The typed properties in their binary form, for SaveBinary.
+			std::map<std::string,PropertyValue> values;
 		private:
+			template<typename T> void SetValue(const char *name,PropertyType type,const T *v);
 			platform::core::MemoryInterface *memoryInterface;
 		};
 	}
@@ -4,6 +4,7 @@
 #include "Platform/CrossPlatform/DeviceContext.h"
 #include "Platform/CrossPlatform/Macros.h"
 #include <algorithm>
+#include <cstring>
 using namespace platform;
 using namespace crossplatform;
 
@@ -154,6 +155,17 @@ void TextRenderer::RestoreDeviceObjects(crossplatform::RenderPlatform *r)
 		defaultTextHeight=font_texture->length;
 		fontWidth = 0;
 	}
+	glyphAtlas.RestoreDeviceObjects(renderPlatform);
+	if(!glyphAtlas.HasFont())
+		SetFont("Exo2-SemiBold.ttf",defaultTextHeight);
+}
+
+bool TextRenderer::SetFont(const char *filename_utf8,int pixelHeight)
+{
+	if(!renderPlatform)
+		return false;
+	// Size the em so that ascender plus descender fit within the bitmap font's line height.
+	return glyphAtlas.LoadFont(filename_utf8,renderPlatform->GetTexturePathsUtf8(),std::max(1,pixelHeight*4/5));
 }
 
 void TextRenderer::InvalidateDeviceObjects()
@@ -163,6 +175,13 @@ void TextRenderer::InvalidateDeviceObjects()
 		f.second.InvalidateDeviceObjects();
 	}
 	fontChars.clear();
+	for(auto &q:textQuads)
+	{
+		q.second.InvalidateDeviceObjects();
+	}
+	textQuads.clear();
+	textBatches.clear();
+	glyphAtlas.InvalidateDeviceObjects();
 	constantBuffer.InvalidateDeviceObjects();
 	SAFE_DELETE(effect);
 	SAFE_DELETE(font_texture);
@@ -175,14 +194,17 @@ void TextRenderer::InvalidateDeviceObjects()
 
 void TextRenderer::LoadShaders()
 {
-	SAFE_DELETE(effect);
 	if (!renderPlatform)
 		return;
+	renderPlatform->Destroy(effect);
+	effectReloadCount=renderPlatform->GetEffectReloadCount();
 	effect=renderPlatform->CreateEffect("font");
 	backgTech	=effect->GetTechniqueByName("backg");
 	textTech	=effect->GetTechniqueByName("text");
 	textureResource	=effect->GetShaderResource("fontTexture");
 	_fontChars		=effect->GetShaderResource("fontChars");
+	textBatchTech	=effect->GetTechniqueByName("text_batch");
+	_textQuads		=effect->GetShaderResource("textQuads");
 	recompiled = false;
 }
 
@@ -201,7 +223,7 @@ int TextRenderer::GetDefaultTextHeight() const
 int TextRenderer::Render(GraphicsDeviceContext &deviceContext,float x0,float y,float screen_width,float screen_height,const char *txt,const float *clr,const float *bck,bool mirrorY)
 {
 	int max_chars = (int)strnlen(txt, 8192);
-	if (recompiled)
+	if (recompiled||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 	{
 		LoadShaders();
 		recompiled=false;
@@ -307,6 +329,138 @@ int TextRenderer::Render(GraphicsDeviceContext &deviceContext,float x0,float y,f
 	return lines;
 }
 
+int TextRenderer::Queue(GraphicsDeviceContext &deviceContext,float x0,float y,float screen_width,float screen_height,const char *txt,const float *clr,const float *bck,bool mirrorY)
+{
+	float transp[]={0.f,0.f,0.f,0.f};
+	float white[]={1.f,1.f,1.f,1.f};
+	if(!clr)
+		clr=white;
+	if(!bck)
+		bck=transp;
+	TextBatch &batch=textBatches[deviceContext.platform_context];
+	long long frame=renderPlatform->GetFrameNumber();
+	if(batch.frame!=frame)
+	{
+		if(batch.quads.size())
+		{
+			SIMUL_CERR_ONCE<<"TextRenderer: queued text was never flushed; call RenderPlatform::FlushText once per frame.\n";
+			batch.quads.clear();
+		}
+		batch.frame=frame;
+	}
+	const bool useAtlas=glyphAtlas.HasFont();
+	const float ht=float(GetDefaultTextHeight());
+	const float xpixel=2.0f/screen_width;
+	const float ypixel=2.0f/screen_height;
+	const float ysign=mirrorY?-1.0f:1.0f;
+	const float u=1024.f/font_texture->width;
+	const float ytexel=1.0f/GetDefaultTextHeight();
+	// Top of the atlas glyphs relative to the top of the line: centre the font's ascender in the line.
+	const int baseline=std::min(int(ht),glyphAtlas.GetAscender()+std::max(0,(int(ht)-glyphAtlas.GetLineHeight())/2));
+	// Reserve the background quad; its extent is only known once the string has been laid out.
+	size_t backgroundIndex=batch.quads.size();
+	bool drawBackground=bck[3]>0.0f;
+	if(drawBackground)
+		batch.quads.emplace_back();
+	auto AddQuad=[&](float px,float py,float pw,float ph,vec4 texc,const float *c)
+	{
+		TextQuad q;
+		q.rect=vec4(px*xpixel-1.f,ysign*(1.f-(py+ph)*ypixel),pw*xpixel,ysign*ph*ypixel);
+		q.texc=texc;
+		q.colour=vec4(c);
+		batch.quads.push_back(q);
+	};
+	float x=x0;
+	float maxw=0.0f;
+	int lines=1;
+	float line_y=y;
+	for(const char *t=txt;*t!=0;)
+	{
+		uint32_t c=GlyphAtlas::NextCodepoint(t);
+		if(c=='\n')
+		{
+			x=x0;
+			line_y+=ht;
+			lines++;
+			continue;
+		}
+		if(c<32)
+			continue;
+		if(useAtlas)
+		{
+			const GlyphAtlas::Glyph *g=glyphAtlas.GetGlyph(c);
+			if(!g)
+				continue;
+			if(g->pixel_width>0&&g->pixel_height>0)
+			{
+				const vec4 &a=g->texc;
+				AddQuad(x+g->bearing_x,line_y+float(baseline-g->bearing_y),float(g->pixel_width),float(g->pixel_height)
+					,vec4(a.x,1.0f-a.y-a.w,a.z,a.w),clr);
+			}
+			x+=float(g->advance);
+		}
+		else
+		{
+			int idx=(c<127)?int(c)-32:int('?')-32;
+			const FontIndex &fi=fontIndices[idx];
+			if(idx>0)
+				AddQuad(x,line_y-1.0f,float(fi.pixel_width),ht+1.0f,vec4(fi.x*u,0.0f,(fi.w-fi.x)*u,1.0f+ytexel),clr);
+			x+=fi.pixel_width+1;
+		}
+		maxw=std::max(maxw,x-x0);
+	}
+	if(drawBackground)
+	{
+		TextQuad &b=batch.quads[backgroundIndex];
+		b.rect=vec4(x0*xpixel-1.f,ysign*(1.f-(y+ht*lines)*ypixel),maxw*xpixel,ysign*ht*lines*ypixel);
+		b.texc=vec4(0,0,-1.0f,0);
+		b.colour=vec4(bck);
+	}
+	return lines;
+}
+
+void TextRenderer::Flush(GraphicsDeviceContext &deviceContext)
+{
+	auto b=textBatches.find(deviceContext.platform_context);
+	if(b==textBatches.end())
+		return;
+	std::vector<TextQuad> &quads=b->second.quads;
+	if(!quads.size())
+		return;
+	if (recompiled||effectReloadCount!=renderPlatform->GetEffectReloadCount())
+	{
+		LoadShaders();
+		recompiled=false;
+	}
+	if(!textBatchTech)
+	{
+		quads.clear();
+		return;
+	}
+	crossplatform::StructuredBuffer<TextQuad> &sb=textQuads[deviceContext.platform_context];
+	if((int)quads.size()>sb.count)
+		sb.RestoreDeviceObjects(renderPlatform,std::max((int)quads.size(),2*sb.count),false,false,nullptr,"textQuads");
+	TextQuad *dst=sb.GetBuffer(deviceContext);
+	if(dst)
+	{
+		memcpy(dst,quads.data(),quads.size()*sizeof(TextQuad));
+		crossplatform::Texture *tex=font_texture;
+		if(glyphAtlas.HasFont())
+		{
+			glyphAtlas.Update(deviceContext);
+			tex=glyphAtlas.GetTexture();
+		}
+		renderPlatform->SetTexture(deviceContext, textureResource, tex);
+		effect->Apply(deviceContext,textBatchTech,0);
+		renderPlatform->SetVertexBuffers(deviceContext,0,0,nullptr,nullptr);
+		sb.Apply(deviceContext,effect,_textQuads);
+		renderPlatform->Draw(deviceContext,6*(int)quads.size(),0);
+		effect->UnbindTextures(deviceContext);
+		effect->Unapply(deviceContext);
+	}
+	quads.clear();
+}
+
 int TextRenderer::Render(MultiviewGraphicsDeviceContext& deviceContext, float* xs, float* ys, float screen_width, float screen_height, const char* txt, const float* clr, const float* bck, bool mirrorY)
 {
 	bool supportShaderViewID = renderPlatform->GetType() == crossplatform::RenderPlatformType::D3D11 ? false : true;
@@ -315,7 +469,7 @@ int TextRenderer::Render(MultiviewGraphicsDeviceContext& deviceContext, float* x
 
 	int max_chars = (int)strnlen(txt, 8192);
 	
-	if (recompiled)
+	if (recompiled||effectReloadCount!=renderPlatform->GetEffectReloadCount())
 	{
 		LoadShaders();
 		recompiled=false;
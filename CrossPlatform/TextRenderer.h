@@ -5,6 +5,7 @@
 #include "Platform/CrossPlatform/Texture.h"
 #include "Platform/CrossPlatform/RenderPlatform.h"
 #include "Platform/CrossPlatform/Effect.h"
+#include "Platform/CrossPlatform/GlyphAtlas.h"
 #include "Platform/CrossPlatform/Shaders/CppSl.sl"
 #include "Platform/CrossPlatform/Shaders/text_constants.sl"
 
@@ -32,6 +33,14 @@ namespace platform
 			void LoadShaders();
 			int Render(GraphicsDeviceContext &deviceContext,float x,float y,float screen_width,float screen_height,const char *txt,const float *clr=NULL,const float *bck=NULL,bool mirrorY=false);
 			int Render(MultiviewGraphicsDeviceContext &deviceContext,float* xs,float* ys,float screen_width,float screen_height,const char *txt,const float *clr=NULL,const float *bck=NULL,bool mirrorY=false);
+			//! Queue text to be drawn at the next Flush() on this context. Parameters and return value are as for Render().
+			//! Text is decoded as UTF-8; if a TrueType font is loaded, glyphs come from the packed glyph atlas,
+			//! otherwise from the bitmap font, with '?' standing in for characters it lacks.
+			int Queue(GraphicsDeviceContext &deviceContext,float x,float y,float screen_width,float screen_height,const char *txt,const float *clr=NULL,const float *bck=NULL,bool mirrorY=false);
+			//! Draw everything queued on this context with a single draw call. Call with the same render targets bound as the queued text expects.
+			void Flush(GraphicsDeviceContext &deviceContext);
+			//! Use a TrueType/OpenType font from the texture paths for queued text. Requires PLATFORM_USE_FREETYPE. Returns false if the font was not loaded.
+			bool SetFont(const char *filename_utf8,int pixelHeight);
 			int GetDefaultTextHeight() const;
 			struct FontIndex
 			{
@@ -45,14 +54,26 @@ namespace platform
 			crossplatform::Effect						*effect;
 			crossplatform::EffectTechnique				*backgTech;
 			crossplatform::EffectTechnique				*textTech;
+			crossplatform::EffectTechnique				*textBatchTech=nullptr;
 			crossplatform::ShaderResource				textureResource;
 			crossplatform::ShaderResource				_fontChars;
+			crossplatform::ShaderResource				_textQuads;
 			crossplatform::ConstantBuffer<TextConstants>	constantBuffer;
 	
 			std::map<const void*,crossplatform::StructuredBuffer<FontChar>> fontChars;
+			struct TextBatch
+			{
+				std::vector<TextQuad> quads;
+				long long frame=0;
+			};
+			std::map<const void*,TextBatch> textBatches;
+			std::map<const void*,crossplatform::StructuredBuffer<TextQuad>> textQuads;
+			GlyphAtlas glyphAtlas;
 			crossplatform::Texture*			font_texture;
 			crossplatform::RenderPlatform *renderPlatform;
 			bool recompiled=true;
+			//! RenderPlatform::GetEffectReloadCount() when the effect was loaded.
+			uint64_t effectReloadCount=0;
 			int fontWidth = 0;
 			FontIndex * fontIndices = nullptr;
 			int defaultTextHeight=20;
@@ -0,0 +1,147 @@
+#include "Platform/CrossPlatform/TextureCache.h"
+#include "Platform/Core/FileLoader.h"
+#include "Platform/Core/Hash.h"
+#include "Platform/Core/RuntimeError.h"
+#include <cstring>
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	const char textureCacheMagic[4] = {'S', 'T', 'C', 'F'};
+	// Increment when the file layout, the encoder or the mip filters change.
+	const uint32_t textureCacheFileVersion = 1;
+	// All fields are little-endian, as written by every platform we support.
+	struct TextureCacheFileHeader
+	{
+		char		magic[4];
+		uint32_t	fileVersion;
+		uint64_t	sourceHash;
+		uint32_t	requestedFormat;
+		uint32_t	quality;
+		uint32_t	mipFilter;
+		uint32_t	srgb;
+		int32_t		maxMips;
+		uint32_t	format;
+		int32_t		width;
+		int32_t		height;
+		uint32_t	numMips;
+		uint32_t	pad;
+	};
+	static_assert(sizeof(TextureCacheFileHeader) == 56, "TextureCacheFileHeader must have no implicit padding.");
+}
+
+std::string TextureCache::GetCacheFilename(const char *source_filename_utf8)
+{
+	return std::string(source_filename_utf8) + ".texcache";
+}
+
+uint64_t TextureCache::HashSource(const void *data, size_t size)
+{
+	return core::HashBytes(data, size);
+}
+
+bool TextureCache::Write(const char *filename_utf8, const TextureCacheKey &key, const TextureCacheContents &c)
+{
+	TextureCacheFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, textureCacheMagic, 4);
+	header.fileVersion = textureCacheFileVersion;
+	header.sourceHash = key.sourceHash;
+	header.requestedFormat = (uint32_t)key.requestedFormat;
+	header.quality = (uint32_t)key.quality;
+	header.mipFilter = (uint32_t)key.mipSettings.filter;
+	header.srgb = key.mipSettings.srgb ? 1 : 0;
+	header.maxMips = key.mipSettings.maxMips;
+	header.format = (uint32_t)c.format;
+	header.width = c.width;
+	header.height = c.height;
+	header.numMips = (uint32_t)c.mips.size();
+	size_t o = sizeof(header) + sizeof(uint64_t) * c.mips.size();
+	for (const auto &m : c.mips)
+		o += m.size();
+	if (o > 0xFFFFFFFFull)
+	{
+		SIMUL_CERR << "TextureCache: " << filename_utf8 << " would be too large to save.\n";
+		return false;
+	}
+	std::vector<uint8_t> file(o, 0);
+	memcpy(file.data(), &header, sizeof(header));
+	o = sizeof(header);
+	for (const auto &m : c.mips)
+	{
+		uint64_t size = m.size();
+		memcpy(file.data() + o, &size, sizeof(size));
+		o += sizeof(size);
+	}
+	for (const auto &m : c.mips)
+	{
+		if (m.size())
+			memcpy(file.data() + o, m.data(), m.size());
+		o += m.size();
+	}
+	return core::FileLoader::GetFileLoader()->Save(file.data(), (unsigned)file.size(), filename_utf8, false);
+}
+
+bool TextureCache::Read(const char *filename_utf8, const TextureCacheKey &key, TextureCacheContents &contents, std::string *reason)
+{
+	core::FileLoader *fileLoader = core::FileLoader::GetFileLoader();
+	void *fileData = nullptr;
+	unsigned fileSize = 0;
+	auto Fail = [&](const char *r)
+	{
+		if (fileData)
+			fileLoader->ReleaseFileContents(fileData);
+		contents = TextureCacheContents();
+		if (reason)
+			*reason = r;
+		return false;
+	};
+	if (!fileLoader->FileExists(filename_utf8))
+		return Fail("no cache file");
+	fileLoader->AcquireFileContents(fileData, fileSize, filename_utf8, false);
+	if (!fileData || fileSize < sizeof(TextureCacheFileHeader))
+		return Fail("file is too small");
+	const uint8_t *data = (const uint8_t *)fileData;
+	TextureCacheFileHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, textureCacheMagic, 4) != 0)
+		return Fail("not a texture cache file");
+	if (header.fileVersion != textureCacheFileVersion)
+		return Fail("unsupported file version");
+	if (header.sourceHash != key.sourceHash)
+		return Fail("the source file has changed");
+	if (header.requestedFormat != (uint32_t)key.requestedFormat || header.quality != (uint32_t)key.quality
+		|| header.mipFilter != (uint32_t)key.mipSettings.filter || header.srgb != (key.mipSettings.srgb ? 1u : 0u)
+		|| header.maxMips != key.mipSettings.maxMips)
+		return Fail("different import settings");
+	CompressionFormat format = (CompressionFormat)header.format;
+	if (!BlockCompression::IsSupported(format) || header.width <= 0 || header.height <= 0 || header.numMips == 0
+		|| (int)header.numMips > ImagePipeline::CountMips(header.width, header.height))
+		return Fail("bad texture description");
+	size_t o = sizeof(header);
+	if ((uint64_t)header.numMips * sizeof(uint64_t) > fileSize - o)
+		return Fail("truncated data");
+	contents.format = format;
+	contents.width = header.width;
+	contents.height = header.height;
+	contents.mips.resize(header.numMips);
+	// Each mip must be the size its dimensions need, and lie within the file.
+	size_t dataOffset = o + header.numMips * sizeof(uint64_t);
+	for (uint32_t i = 0; i < header.numMips; i++)
+	{
+		uint64_t size;
+		memcpy(&size, data + o + i * sizeof(uint64_t), sizeof(size));
+		int w = ImagePipeline::MipSize(header.width, (int)i);
+		int h = ImagePipeline::MipSize(header.height, (int)i);
+		if (size != BlockCompression::GetCompressedSize(format, w, h))
+			return Fail("bad mip size");
+		if (size > fileSize - dataOffset)
+			return Fail("truncated data");
+		contents.mips[i].assign(data + dataOffset, data + dataOffset + size);
+		dataOffset += (size_t)size;
+	}
+	fileLoader->ReleaseFileContents(fileData);
+	return true;
+}
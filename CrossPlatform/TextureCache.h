@@ -0,0 +1,52 @@
+#pragma once
+#include "Platform/CrossPlatform/BlockCompression.h"
+#include "Platform/CrossPlatform/Export.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		//! What a cache was made from. A cache is only used if every field matches.
+		struct TextureCacheKey
+		{
+			uint64_t sourceHash = 0;	//!< From HashSource() of the encoded file.
+			//! The format asked for, or UNCOMPRESSED if the encoder chose one from the image's channels.
+			CompressionFormat requestedFormat = CompressionFormat::UNCOMPRESSED;
+			CompressionQuality quality = CompressionQuality::NORMAL;
+			MipChainSettings mipSettings;
+		};
+		//! A block-compressed texture and its mips, as TextureCreate::initialData takes them for one layer.
+		struct TextureCacheContents
+		{
+			CompressionFormat format = CompressionFormat::UNCOMPRESSED;
+			int width = 0;
+			int height = 0;
+			std::vector<std::vector<uint8_t>> mips;
+		};
+		//! A binary file holding a texture that BlockCompression encoded, so that later loads can skip decoding,
+		//! filtering and encoding. The file is a header, the size of each mip, and the mips' blocks.
+		class SIMUL_CROSSPLATFORM_EXPORT TextureCache
+		{
+		public:
+			//! The cache for a source file is written next to it.
+			static std::string GetCacheFilename(const char *source_filename_utf8);
+			//! The hash of an encoded source file held in memory, for TextureCacheKey::sourceHash. Never zero.
+			static uint64_t HashSource(const void *data, size_t size);
+			static bool Write(const char *filename_utf8, const TextureCacheKey &key, const TextureCacheContents &contents);
+			//! Read the file, and check that it was made with the same key. On failure, \a reason says why.
+			static bool Read(const char *filename_utf8, const TextureCacheKey &key, TextureCacheContents &contents, std::string *reason = nullptr);
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
@@ -0,0 +1,341 @@
+#include "Platform/CrossPlatform/TextureCapture.h"
+#include "Platform/CrossPlatform/PixelConvert.h"
+#include "Platform/CrossPlatform/RenderPlatform.h"
+#include "Platform/CrossPlatform/Texture.h"
+#include "Platform/Core/RuntimeError.h"
+#include "Platform/Core/StringToWString.h"
+#include "Platform/Core/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// stb_image_write is implemented in RenderPlatform.cpp, in the platform namespace.
+namespace platform
+{
+	#include "Platform/External/stb/stb_image_write.h"
+}
+
+using namespace platform;
+using namespace crossplatform;
+
+namespace
+{
+	bool IsFloatFormat(PixelFormat f)
+	{
+		ComponentType t = PixelConvert::GetLayout(f).type;
+		return t == ComponentType::FLOAT32 || t == ComponentType::FLOAT16;
+	}
+
+	bool WriteFile(const std::string &filename_utf8, const std::vector<uint8_t> &bytes)
+	{
+#ifdef _MSC_VER
+		std::ofstream ofs(platform::core::Utf8ToWString(filename_utf8).c_str(), std::ios::binary);
+#else
+		std::ofstream ofs(filename_utf8, std::ios::binary);
+#endif
+		if (!ofs.good())
+			return false;
+		ofs.write((const char *)bytes.data(), bytes.size());
+		return ofs.good();
+	}
+
+	void PushBigEndian32(std::vector<uint8_t> &out, uint32_t v)
+	{
+		out.push_back(uint8_t(v >> 24));
+		out.push_back(uint8_t(v >> 16));
+		out.push_back(uint8_t(v >> 8));
+		out.push_back(uint8_t(v));
+	}
+
+	// Encode tightly-packed 8-bit RGB or RGBA pixels as QOI, see https://qoiformat.org/qoi-specification.pdf
+	std::vector<uint8_t> EncodeQOI(const uint8_t *pixels, uint32_t width, uint32_t height, uint8_t channels)
+	{
+		std::vector<uint8_t> out;
+		out.reserve(14 + (size_t)width * height * (channels + 1) + 8);
+		const char magic[] = {'q', 'o', 'i', 'f'};
+		out.insert(out.end(), magic, magic + 4);
+		PushBigEndian32(out, width);
+		PushBigEndian32(out, height);
+		out.push_back(channels);
+		out.push_back(0);
+
+		uint8_t index[64][4] = {};
+		uint8_t prev[4] = {0, 0, 0, 255};
+		uint8_t px[4] = {0, 0, 0, 255};
+		int run = 0;
+		const size_t numPixels = (size_t)width * height;
+		for (size_t i = 0; i < numPixels; i++, pixels += channels)
+		{
+			memcpy(px, pixels, channels);
+			if (!memcmp(px, prev, 4))
+			{
+				run++;
+				if (run == 62 || i + 1 == numPixels)
+				{
+					out.push_back(uint8_t(0xc0 | (run - 1)));
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0)
+			{
+				out.push_back(uint8_t(0xc0 | (run - 1)));
+				run = 0;
+			}
+			int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+			if (!memcmp(index[hash], px, 4))
+			{
+				out.push_back(uint8_t(hash));
+			}
+			else
+			{
+				memcpy(index[hash], px, 4);
+				if (px[3] == prev[3])
+				{
+					int8_t vr = int8_t(px[0] - prev[0]);
+					int8_t vg = int8_t(px[1] - prev[1]);
+					int8_t vb = int8_t(px[2] - prev[2]);
+					int8_t vg_r = int8_t(vr - vg);
+					int8_t vg_b = int8_t(vb - vg);
+					if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+					{
+						out.push_back(uint8_t(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+					}
+					else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+					{
+						out.push_back(uint8_t(0x80 | (vg + 32)));
+						out.push_back(uint8_t((vg_r + 8) << 4 | (vg_b + 8)));
+					}
+					else
+					{
+						out.push_back(0xfe);
+						out.insert(out.end(), px, px + 3);
+					}
+				}
+				else
+				{
+					out.push_back(0xff);
+					out.insert(out.end(), px, px + 4);
+				}
+			}
+			memcpy(prev, px, 4);
+		}
+		const uint8_t padding[] = {0, 0, 0, 0, 0, 0, 0, 1};
+		out.insert(out.end(), padding, padding + 8);
+		return out;
+	}
+
+	// Portable Float Map: little-endian floats, rows from bottom to top.
+	std::vector<uint8_t> EncodePFM(const float *pixels, uint32_t width, uint32_t height, uint8_t channels)
+	{
+		std::string header = std::string(channels == 1 ? "Pf\n" : "PF\n") + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n";
+		std::vector<uint8_t> out(header.begin(), header.end());
+		size_t rowBytes = (size_t)width * channels * sizeof(float);
+		size_t start = out.size();
+		out.resize(start + rowBytes * height);
+		for (uint32_t y = 0; y < height; y++)
+			memcpy(out.data() + start + rowBytes * y, pixels + (size_t)(height - 1 - y) * width * channels, rowBytes);
+		return out;
+	}
+}
+
+TextureCapture::TextureCapture()
+{
+}
+
+TextureCapture::~TextureCapture()
+{
+	Clear();
+}
+
+void TextureCapture::SetSettings(const Settings &s)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	settings = s;
+}
+
+TextureCaptureStats TextureCapture::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	TextureCaptureStats s = stats;
+	s.pendingReadbacks = (unsigned)pendingReadbacks.size();
+	return s;
+}
+
+bool TextureCapture::Reserve(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	auto fits = [&]() { return stats.bytesInFlight + bytes <= settings.maxBytesInFlight || stats.bytesInFlight == 0; };
+	if (!fits() && settings.backpressure == Backpressure::WAIT)
+		encodeFinished.wait(lock, [&]() { return fits() || stats.encodesInFlight == 0; });
+	if (!fits())
+	{
+		stats.dropped++;
+		return false;
+	}
+	stats.bytesInFlight += bytes;
+	stats.peakBytesInFlight = std::max(stats.peakBytesInFlight, stats.bytesInFlight);
+	stats.submitted++;
+	return true;
+}
+
+void TextureCapture::Release(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.bytesInFlight -= std::min(bytes, stats.bytesInFlight);
+}
+
+bool TextureCapture::Capture(GraphicsDeviceContext &deviceContext, Texture *texture, const char *filename_utf8, CaptureEncoding encoding, CaptureCallback callback)
+{
+	if (!texture || !filename_utf8 || !deviceContext.renderPlatform)
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pendingReadbacks.size() >= settings.maxPendingReadbacks)
+		{
+			stats.dropped++;
+			return false;
+		}
+	}
+	size_t bytes = (size_t)texture->width * (size_t)texture->length * (size_t)std::max(1, GetByteSize(texture->GetFormat()));
+	if (!Reserve(bytes))
+		return false;
+	std::shared_ptr<TextureReadback> readback = deviceContext.renderPlatform->CreateTextureReadback(deviceContext, texture);
+	if (!readback)
+	{
+		Release(bytes);
+		deviceContext.renderPlatform->SaveTexture(deviceContext, texture, filename_utf8);
+		if (callback)
+			callback(filename_utf8, true);
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	// Account for the real size, including any row padding the API needs.
+	stats.bytesInFlight += readback->GetSize() - std::min(bytes, readback->GetSize());
+	pendingReadbacks.push_back({readback, filename_utf8, encoding, callback});
+	return true;
+}
+
+bool TextureCapture::CaptureData(const char *filename_utf8, int width, int length, PixelFormat format, std::vector<uint8_t> &&data, size_t rowPitch, CaptureEncoding encoding, CaptureCallback callback)
+{
+	if (!filename_utf8 || width <= 0 || length <= 0)
+		return false;
+	if (!rowPitch)
+		rowPitch = (size_t)width * PixelConvert::GetLayout(format).PixelSize();
+	if (data.size() < rowPitch * (size_t)length)
+		return false;
+	if (!Reserve(data.size()))
+		return false;
+	auto shared = std::make_shared<std::vector<uint8_t>>(std::move(data));
+	StartEncode(nullptr, shared, filename_utf8, width, length, format, rowPitch, encoding, callback);
+	return true;
+}
+
+void TextureCapture::Update()
+{
+	std::vector<PendingReadback> ready;
+	std::vector<std::shared_ptr<TextureReadback>> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.swap(finishedReadbacks);
+		for (auto it = pendingReadbacks.begin(); it != pendingReadbacks.end();)
+		{
+			if (it->readback->IsReady())
+			{
+				ready.push_back(std::move(*it));
+				it = pendingReadbacks.erase(it);
+			}
+			else
+				it++;
+		}
+	}
+	// Destroying the readbacks here returns their API resources on the render thread.
+	finished.clear();
+	for (auto &p : ready)
+	{
+		TextureReadback *r = p.readback.get();
+		StartEncode(std::move(p.readback), nullptr, p.filename, r->width, r->length, r->format, r->rowPitch, p.encoding, p.callback);
+	}
+}
+
+void TextureCapture::StartEncode(std::shared_ptr<TextureReadback> readback, std::shared_ptr<std::vector<uint8_t>> data, const std::string &filename
+	, int width, int length, PixelFormat format, size_t rowPitch, CaptureEncoding encoding, CaptureCallback callback)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.encodesInFlight++;
+	}
+	size_t bytes = readback ? readback->GetSize() : data->size();
+	// Map() must be called here on the render thread; the worker only reads the mapped memory.
+	const void *src = readback ? readback->Map() : data->data();
+	core::ThreadPool::Get().Push([this, readback, data, src, filename, width, length, format, rowPitch, encoding, callback, bytes]() mutable
+	{
+		bool ok = src && Encode(filename, width, length, format, src, rowPitch, encoding);
+		if (!ok)
+			SIMUL_CERR << "Failed to save captured texture to " << filename << ".\n";
+		if (callback)
+			callback(filename, ok);
+		std::lock_guard<std::mutex> lock(mutex);
+		// Hand over this job's reference, so that the readback is never destroyed on this thread, even if Update() runs
+		// before the job itself is destroyed.
+		if (readback)
+			finishedReadbacks.push_back(std::move(readback));
+		stats.bytesInFlight -= std::min(bytes, stats.bytesInFlight);
+		stats.encodesInFlight--;
+		if (ok)
+			stats.completed++;
+		else
+			stats.failed++;
+		encodeFinished.notify_all();
+	});
+}
+
+void TextureCapture::WaitForEncodes()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	encodeFinished.wait(lock, [this]() { return stats.encodesInFlight == 0; });
+}
+
+void TextureCapture::Clear()
+{
+	WaitForEncodes();
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto &p : pendingReadbacks)
+	{
+		stats.bytesInFlight -= std::min(p.readback->GetSize(), stats.bytesInFlight);
+		stats.dropped++;
+	}
+	pendingReadbacks.clear();
+	finishedReadbacks.clear();
+}
+
+bool TextureCapture::Encode(const std::string &filename_utf8, int width, int length, PixelFormat format, const void *data, size_t rowPitch, CaptureEncoding encoding)
+{
+	PixelLayout srcLayout = PixelConvert::GetLayout(format);
+	if (!srcLayout.IsValid() || width <= 0 || length <= 0)
+		return false;
+	if (encoding == CaptureEncoding::AUTO)
+		encoding = IsFloatFormat(format) ? CaptureEncoding::PFM : CaptureEncoding::PNG;
+	// Integer textures are saved as a fraction of their range, as in RenderPlatform::SaveTextureDataToDisk().
+	srcLayout.normalized = true;
+	PixelLayout dstLayout;
+	dstLayout.normalized = true;
+	if (encoding == CaptureEncoding::PFM)
+	{
+		dstLayout.type = ComponentType::FLOAT32;
+		dstLayout.channels = srcLayout.channels == 1 ? 1 : 3;
+		std::vector<float> pixels((size_t)width * length * dstLayout.channels);
+		PixelConvert::Convert(srcLayout, data, rowPitch, dstLayout, pixels.data(), 0, width, length, false);
+		return WriteFile(filename_utf8, EncodePFM(pixels.data(), width, length, dstLayout.channels));
+	}
+	dstLayout.type = ComponentType::UINT8;
+	dstLayout.srgb = srcLayout.srgb;
+	// QOI only stores RGB or RGBA.
+	dstLayout.channels = encoding == CaptureEncoding::QOI ? std::max<uint8_t>(3, srcLayout.channels) : srcLayout.channels;
+	std::vector<uint8_t> pixels((size_t)width * length * dstLayout.channels);
+	// Each capture already runs on its own worker, so don't split the conversion further.
+	PixelConvert::Convert(srcLayout, data, rowPitch, dstLayout, pixels.data(), 0, width, length, false);
+	if (encoding == CaptureEncoding::QOI)
+		return WriteFile(filename_utf8, EncodeQOI(pixels.data(), width, length, dstLayout.channels));
+	return stbi_write_png(filename_utf8.c_str(), width, length, dstLayout.channels, pixels.data(), width * dstLayout.channels) == 1;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Platform/CrossPlatform/Export.h"
+#include "Platform/CrossPlatform/PixelFormat.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+	#pragma warning(push)
+	#pragma warning(disable : 4251)
+#endif
+
+namespace platform
+{
+	namespace crossplatform
+	{
+		class Texture;
+		struct GraphicsDeviceContext;
+
+		//! File encodings for captured images.
+		enum class CaptureEncoding : uint8_t
+		{
+			//! PFM for floating-point textures, PNG for everything else.
+			AUTO,
+			//! Deflate-compressed 8-bit, via stb_image_write. Small files but slow to encode.
+			PNG,
+			//! "Quite OK Image" 8-bit lossless format: several times faster to encode than PNG.
+			QOI,
+			//! Uncompressed 32-bit float Portable Float Map, for HDR targets.
+			PFM
+		};
+
+		//! A GPU-to-CPU copy of a texture that completes asynchronously. Created by RenderPlatform::CreateTextureReadback().
+		//! The object is destroyed on the render thread, but Map() may be read from any thread once IsReady() has returned true.
+		struct SIMUL_CROSSPLATFORM_EXPORT TextureReadback
+		{
+			virtual ~TextureReadback() = default;
+			int width = 0;
+			int length = 0;
+			PixelFormat format = PixelFormat::UNKNOWN;
+			size_t rowPitch = 0;
+			//! True once the GPU copy has completed, so Map() won't stall.
+			virtual bool IsReady() const = 0;
+			//! The texel data, rowPitch bytes per row.
+			virtual const void *Map() = 0;
+			size_t GetSize() const
+			{
+				return rowPitch * (size_t)length;
+			}
+		};
+
+		struct TextureCaptureStats
+		{
+			uint64_t submitted = 0;
+			uint64_t completed = 0;
+			uint64_t failed = 0;
+			//! Captures refused because the memory limit was reached.
+			uint64_t dropped = 0;
+			unsigned pendingReadbacks = 0;
+			unsigned encodesInFlight = 0;
+			size_t bytesInFlight = 0;
+			size_t peakBytesInFlight = 0;
+		};
+
+		//! Called on a worker thread when a capture has been written, or has failed.
+		typedef std::function<void(const std::string &filename, bool success)> CaptureCallback;
+
+		/*! A queue that saves textures to disk without stalling the render thread.
+			Capture() records a GPU copy; Update(), called by RenderPlatform::BeginFrame(), polls the copies and hands completed
+			ones to core::ThreadPool::Get() for format conversion and encoding.
+			Memory held by readbacks and encodes is bounded by Settings::maxBytesInFlight.
+		*/
+		class SIMUL_CROSSPLATFORM_EXPORT TextureCapture
+		{
+		public:
+			//! What to do when a new capture would exceed the memory limit.
+			enum class Backpressure : uint8_t
+			{
+				//! Refuse the capture and count it in TextureCaptureStats::dropped.
+				DROP,
+				//! Block until enough encodes have finished. Captures still waiting on the GPU can't be waited for, so these may still drop.
+				WAIT
+			};
+			struct Settings
+			{
+				size_t maxBytesInFlight = 256 * 1024 * 1024;
+				unsigned maxPendingReadbacks = 8;
+				Backpressure backpressure = Backpressure::DROP;
+			};
+			TextureCapture();
+			~TextureCapture();
+			void SetSettings(const Settings &s);
+			const Settings &GetSettings() const
+			{
+				return settings;
+			}
+			//! Queue a texture to be saved. Returns false if the capture was refused or the API has no asynchronous readback;
+			//! in the latter case the texture is saved synchronously with RenderPlatform::SaveTexture() instead.
+			bool Capture(GraphicsDeviceContext &deviceContext, Texture *texture, const char *filename_utf8, CaptureEncoding encoding = CaptureEncoding::AUTO, CaptureCallback callback = nullptr);
+			//! Queue CPU-side texel data to be converted and saved.
+			bool CaptureData(const char *filename_utf8, int width, int length, PixelFormat format, std::vector<uint8_t> &&data, size_t rowPitch = 0, CaptureEncoding encoding = CaptureEncoding::AUTO, CaptureCallback callback = nullptr);
+			//! Poll pending readbacks and start encoding the completed ones. Must be called on the render thread, once per frame.
+			void Update();
+			//! Wait for all started encodes to finish.
+			void WaitForEncodes();
+			//! Wait for encodes and discard readbacks that haven't completed, e.g. before the device is destroyed.
+			void Clear();
+			TextureCaptureStats GetStats() const;
+			//! Convert and write an image synchronously.
+			static bool Encode(const std::string &filename_utf8, int width, int length, PixelFormat format, const void *data, size_t rowPitch, CaptureEncoding encoding);
+
+		private:
+			struct PendingReadback
+			{
+				std::shared_ptr<TextureReadback> readback;
+				std::string filename;
+				CaptureEncoding encoding;
+				CaptureCallback callback;
+			};
+			bool Reserve(size_t bytes);
+			void Release(size_t bytes);
+			void StartEncode(std::shared_ptr<TextureReadback> readback, std::shared_ptr<std::vector<uint8_t>> data, const std::string &filename
+				, int width, int length, PixelFormat format, size_t rowPitch, CaptureEncoding encoding, CaptureCallback callback);
+			Settings settings;
+			std::vector<PendingReadback> pendingReadbacks;
+			// Readbacks whose encodes have finished: released on the render thread in Update().
+			std::vector<std::shared_ptr<TextureReadback>> finishedReadbacks;
+			mutable std::mutex mutex;
+			std::condition_variable encodeFinished;
+			TextureCaptureStats stats;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+	#pragma warning(pop)
+#endif
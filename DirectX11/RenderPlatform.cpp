@@ -361,6 +361,14 @@ void RenderPlatform::DrawIndexed(crossplatform::GraphicsDeviceContext &deviceCon
 	pContext->DrawIndexed(num_indices,start_index,base_vert);
 }
 
+bool RenderPlatform::DrawIndexedInstanced(crossplatform::GraphicsDeviceContext &deviceContext,int num_indices,int num_instances,int start_index,int base_vert)
+{
+	ApplyContextState(deviceContext);
+	ID3D11DeviceContext		*pContext	=deviceContext.asD3D11DeviceContext();
+	pContext->DrawIndexedInstanced(num_indices,num_instances,start_index,base_vert,0);
+	return true;
+}
+
 void RenderPlatform::ApplyDefaultMaterial()
 {
 }
@@ -560,6 +568,7 @@ DXGI_FORMAT RenderPlatform::ToDxgiFormat(crossplatform::PixelFormat p,crossplatf
 		switch (c)
 		{
 		case crossplatform::CompressionFormat::BC4:
+		case crossplatform::CompressionFormat::BC5:
 			return DXGI_FORMAT_BC5_SNORM;
 		default:
 			return DXGI_FORMAT_R8G8_SNORM;
@@ -568,6 +577,7 @@ DXGI_FORMAT RenderPlatform::ToDxgiFormat(crossplatform::PixelFormat p,crossplatf
 		switch (c)
 		{
 		case crossplatform::CompressionFormat::BC4:
+		case crossplatform::CompressionFormat::BC5:
 			return DXGI_FORMAT_BC5_UNORM;
 		default:
 			return DXGI_FORMAT_R8G8_UNORM;
@@ -66,6 +66,8 @@ namespace platform
 			
 			void Draw			(crossplatform::GraphicsDeviceContext &deviceContext,int num_verts,int start_vert);
 			void DrawIndexed	(crossplatform::GraphicsDeviceContext &deviceContext,int num_indices,int start_index=0,int base_vertex=0) override;
+			bool HasInstancedDraws() const override { return true; }
+			bool DrawIndexedInstanced(crossplatform::GraphicsDeviceContext &deviceContext,int num_indices,int num_instances,int start_index=0,int base_vertex=0) override;
 			void DrawQuad		(crossplatform::GraphicsDeviceContext &deviceContext);
 
 			
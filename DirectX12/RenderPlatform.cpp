@@ -1623,6 +1623,15 @@ void RenderPlatform::DrawIndexed(crossplatform::GraphicsDeviceContext &deviceCon
 	commandList->DrawIndexedInstanced(num_indices, 1, start_index, base_vert, 0);
 }
 
+bool RenderPlatform::DrawIndexedInstanced(crossplatform::GraphicsDeviceContext &deviceContext, int num_indices, int num_instances, int start_index, int base_vert)
+{
+	ID3D12GraphicsCommandList *commandList = deviceContext.asD3D12Context();
+
+	ApplyContextState(deviceContext);
+	commandList->DrawIndexedInstanced(num_indices, num_instances, start_index, base_vert, 0);
+	return true;
+}
+
 void RenderPlatform::ApplyDefaultMaterial()
 {
 }
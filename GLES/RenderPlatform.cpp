@@ -312,6 +312,8 @@ GLuint RenderPlatform::ToGLInternalFormat(crossplatform::PixelFormat p)
 		return GL_RG32F;
 	case R_32_FLOAT:
 		return GL_R32F;
+	case RG_16_FLOAT:
+		return GL_RG16F;
 	case R_16_FLOAT:
 		return GL_R16F;
 	case RGBA_8_UNORM:
@@ -415,6 +417,8 @@ GLuint RenderPlatform::ToGLFormat(crossplatform::PixelFormat p)
 		return GL_RGB_INTEGER;
 	case RG_32_FLOAT:
 		return GL_RG;
+	case RG_16_FLOAT:
+		return GL_RG;
 	case R_16_FLOAT:
 		return GL_RED;
 	case R_32_FLOAT:
@@ -463,6 +467,8 @@ int RenderPlatform::FormatCount(crossplatform::PixelFormat p)
 		return 2;
 	case R_32_FLOAT:
 		return 1;
+	case RG_16_FLOAT:
+		return 2;
 	case R_16_FLOAT:
 		return 1;
 	case LUM_32_FLOAT:
@@ -556,6 +562,8 @@ GLenum RenderPlatform::DataType(crossplatform::PixelFormat p)
 		return GL_FLOAT;
 	case R_32_FLOAT:
 		return GL_FLOAT;
+	case RG_16_FLOAT:
+		return GL_HALF_FLOAT;
 	case R_16_FLOAT:
 		return GL_FLOAT;
 	case LUM_32_FLOAT:
@@ -44,6 +44,7 @@ struct ImGui_ImplPlatform_Data
 	Buffer*					pIB = nullptr;
 	bool reload_shaders=false;
 	Effect*					effect = nullptr;
+	uint64_t				effectReloadCount = 0;	// RenderPlatform::GetEffectReloadCount() when the effect was loaded.
 	EffectPass*				effectPass_testDepth=nullptr;
 	EffectPass*				effectPass_noDepth=nullptr;
 	EffectPass*				effectPass_placeIn3D_testDepth=nullptr;
@@ -162,7 +163,7 @@ void ImGui_ImplPlatform_RenderDrawData(GraphicsDeviceContext &deviceContext,ImDr
 	if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
 		return;
 	ImGui_ImplPlatform_Data* bd = ImGui_ImplPlatform_GetBackendData();
-	if(bd->reload_shaders)
+	if(bd->reload_shaders||bd->effectReloadCount!=bd->renderPlatform->GetEffectReloadCount())
 	{
 		ImGui_ImplPlatform_LoadShaders();
 		bd->reload_shaders=false;
@@ -416,7 +417,7 @@ void ImGui_ImplPlatform_RenderDrawData(GraphicsDeviceContext &deviceContext,ImDr
 					subres.mipLevelCount = uint8_t(texture_srv->mip >= 0.f ? 1 : 0xff);
 					subres.baseArrayLayer=uint8_t(texture_srv->slice);
 					subres.arrayLayerCount = uint8_t(0xff);
-					renderPlatform->SetTexture(deviceContext,bd->effect->GetShaderResource("texture0"), (Texture*)texture_srv->texture, subres);
+					renderPlatform->SetTexture(deviceContext,bd->effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("texture0")), (Texture*)texture_srv->texture, subres);
 					renderPlatform->ApplyPass(deviceContext, bd->effectPass_noDepth);
 					bd->pInputLayout->Apply(deviceContext);
 					renderPlatform->DrawIndexed(deviceContext,pcmd->ElemCount, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset);
@@ -448,7 +449,7 @@ void ImGui_ImplPlatform_RenderDrawData(GraphicsDeviceContext &deviceContext,ImDr
 			pass = test_depth ? bd->effectPass_placeIn3D_testDepth : bd->effectPass_placeIn3D_noDepth;
 
 		// now draw it to screen.
-		renderPlatform->SetTexture(deviceContext,bd->effect->GetShaderResource("texture0"),bd->framebufferTexture);
+		renderPlatform->SetTexture(deviceContext,bd->effect->GetShaderResource(PLATFORM_SHADER_RESOURCE("texture0")),bd->framebufferTexture);
 		renderPlatform->ApplyPass(deviceContext, pass);
 		bd->pInputLayout->Apply(deviceContext);
 		renderPlatform->DrawQuad(deviceContext);
@@ -498,7 +499,10 @@ bool	ImGui_ImplPlatform_CreateDeviceObjects()
 		bd->pInputLayout=bd->renderPlatform->CreateLayout(3,local_layout,true);
 	
 	if (!bd->effect)
+	{
 		bd->effect = bd->renderPlatform->CreateEffect("imgui");
+		bd->effectReloadCount = bd->renderPlatform->GetEffectReloadCount();
+	}
 
 	bd->effectPass_testDepth = bd->effect->GetTechniqueByName("layout_in_2d")->GetPass("test_depth");
 	bd->effectPass_noDepth = bd->effect->GetTechniqueByName("layout_in_2d")->GetPass("no_depth");
@@ -553,11 +557,14 @@ void	ImGui_ImplPlatform_LoadShaders()
 	ImGui_ImplPlatform_Data* bd = ImGui_ImplPlatform_GetBackendData();
 	if (!bd)
 		return;
-	delete bd->effect;
-	bd->effect =nullptr;
 	if(!bd->renderPlatform)
+	{
+		SAFE_DELETE(bd->effect);
 		return;
-
+	}
+	// Draws recorded earlier in the frame may still use the old effect.
+	bd->renderPlatform->Destroy(bd->effect);
+	bd->effectReloadCount = bd->renderPlatform->GetEffectReloadCount();
 	bd->effect = bd->renderPlatform->CreateEffect("imgui");
 	bd->effectPass_testDepth = bd->effect->GetTechniqueByName("layout_in_2d")->GetPass("test_depth");
 	bd->effectPass_noDepth = bd->effect->GetTechniqueByName("layout_in_2d")->GetPass("no_depth");
@@ -1,90 +1,256 @@
 #include "Float16.h"
 
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+	#define SIMUL_FLOAT16_X86 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define SIMUL_TARGET_F16C
+	#else
+		#define SIMUL_TARGET_F16C __attribute__((target("f16c")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define SIMUL_FLOAT16_NEON 1
+	#include <arm_neon.h>
+#endif
+
 using namespace platform;
 using namespace math;
 
 //https://gist.github.com/rygorous/2156668
 
-static FP16 float_to_half_fast3_rtne(FP32 f)
+// These are the branch-free forms of float_to_half_fast3_rtne and half_to_float from the gist above:
+// every path is evaluated and the result is selected with masks, so that the bulk loops below
+// have no data-dependent branches and can be auto-vectorised where no intrinsics are available.
+
+static inline uint32_t SelectMask(bool b)
 {
-    FP32 f32infty = { 255 << 23 };
-    FP32 f16max = { (127 + 16) << 23 };
-    FP32 denorm_magic = { ((127 - 15) + (23 - 10) + 1) << 23 };
-    unsigned int sign_mask = 0x80000000u;
-    FP16 o = { 0 };
-
-    unsigned int sign = f.u & sign_mask;
-    f.u ^= sign;
-
-    // NOTE all the integer compares in this function can be safely
-    // compiled into signed compares since all operands are below
-    // 0x80000000. Important if you want fast straight SSE2 code
-    // (since there's no unsigned PCMPGTD).
-
-    if (f.u >= f16max.u) // result is Inf or NaN (all exponent bits set)
-        o.u = (f.u > f32infty.u) ? 0x7e00 : 0x7c00; // NaN->qNaN and Inf->Inf
-    else // (De)normalized number or zero
-    {
-        if (f.u < (113 << 23)) // resulting FP16 is subnormal or zero
-        {
-            // use a magic value to align our 10 mantissa bits at the bottom of
-            // the float. as long as FP addition is round-to-nearest-even this
-            // just works.
-            f.f += denorm_magic.f;
-
-            // and one integer subtract of the bias later, we have our final float!
-            o.u = f.u - denorm_magic.u;
-        }
-        else
-        {
-            unsigned int mant_odd = (f.u >> 13) & 1; // resulting mantissa is odd
-
-            // update exponent, rounding bias part 1
-            f.u += ((15 - 127) << 23) + 0xfff;
-            // rounding bias part 2
-            f.u += mant_odd;
-            // take the bits!
-            o.u = f.u >> 13;
-        }
-    }
+    return 0u - (uint32_t)b;
+}
+
+static inline uint16_t float_to_half_rtne(uint32_t u)
+{
+    const FP32 denorm_magic = { ((127 - 15) + (23 - 10) + 1) << 23 };
+    const uint32_t f32infty = 255 << 23;
+    const uint32_t f16max = (127 + 16) << 23;
+
+    uint32_t sign = u & 0x80000000u;
+    u ^= sign;
 
-    o.u |= sign >> 16;
-    return o;
+    // Inf or NaN (all exponent bits set): NaN->qNaN and Inf->Inf
+    uint32_t inf_nan = 0x7c00u | (SelectMask(u > f32infty) & 0x0200u);
+
+    // resulting FP16 is subnormal or zero: use a magic value to align our 10 mantissa bits at the bottom
+    // of the float. As long as FP addition is round-to-nearest-even this just works.
+    FP32 d;
+    d.u = u;
+    d.f += denorm_magic.f;
+    uint32_t subnormal = d.u - denorm_magic.u;
+
+    // normalized: update exponent and apply the two-part rounding bias.
+    uint32_t mant_odd = (u >> 13) & 1;
+    uint32_t normal = (u + ((15 - 127) << 23) + 0xfff + mant_odd) >> 13;
+
+    uint32_t is_inf_nan = SelectMask(u >= f16max);
+    uint32_t is_subnormal = SelectMask(u < (113 << 23));
+    uint32_t finite = (subnormal & is_subnormal) | (normal & ~is_subnormal);
+    uint32_t o = (inf_nan & is_inf_nan) | (finite & ~is_inf_nan);
+    return (uint16_t)(o | (sign >> 16));
 }
 
-static FP32 half_to_float(FP16 h)
+static inline uint32_t half_to_float(uint32_t h)
 {
-    static const FP32 magic = { 113 << 23 };
-    static const unsigned int shifted_exp = 0x7c00 << 13; // exponent mask after shift
-    FP32 o;
-
-    o.u = (h.u & 0x7fff) << 13;     // exponent/mantissa bits
-    unsigned int exp = shifted_exp & o.u;   // just the exponent
-    o.u += (127 - 15) << 23;        // exponent adjust
-
-    // handle exponent special cases
-    if (exp == shifted_exp) // Inf/NaN?
-        o.u += (128 - 16) << 23;    // extra exp adjust
-    else if (exp == 0) // Zero/Denormal?
-    {
-        o.u += 1 << 23;             // extra exp adjust
-        o.f -= magic.f;             // renormalize
-    }
+    const FP32 magic = { 113 << 23 };
+    const uint32_t shifted_exp = 0x7c00 << 13; // exponent mask after shift
+
+    uint32_t o = (h & 0x7fff) << 13;        // exponent/mantissa bits
+    uint32_t exp = shifted_exp & o;         // just the exponent
+    o += (127 - 15) << 23;                  // exponent adjust
+
+    // Inf/NaN: extra exp adjust
+    o += SelectMask(exp == shifted_exp) & ((128 - 16) << 23);
+
+    // Zero/Denormal: extra exp adjust and renormalize
+    FP32 d;
+    d.u = o + (1 << 23);
+    d.f -= magic.f;
+    uint32_t is_denormal = SelectMask(exp == 0);
+    o = (d.u & is_denormal) | (o & ~is_denormal);
 
-    o.u |= (h.u & 0x8000) << 16;    // sign bit
-    return o;
+    return o | ((h & 0x8000) << 16);        // sign bit
 }
 
 unsigned short platform::math::ToFloat16(float f)
 {
     FP32 fp32;
     fp32.f = f;
-    return float_to_half_fast3_rtne(fp32).u;
+    return float_to_half_rtne(fp32.u);
 }
 
 float platform::math::ToFloat32(unsigned short u)
 {
-    FP16 fp16;
-    fp16.u = u;
-    return half_to_float(fp16).f;
+    FP32 fp32;
+    fp32.u = half_to_float(u);
+    return fp32.f;
+}
+
+static void ToFloat16Scalar(const float *src, uint16_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        FP32 fp32;
+        fp32.f = src[i];
+        dst[i] = float_to_half_rtne(fp32.u);
+    }
+}
+
+static void ToFloat32Scalar(const uint16_t *src, float *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        FP32 fp32;
+        fp32.u = half_to_float(src[i]);
+        dst[i] = fp32.f;
+    }
+}
+
+#if SIMUL_FLOAT16_X86
+static bool CpuHasF16C()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool f16c = (info[2] & (1 << 29)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    // F16C is VEX-encoded, so the OS must also save the YMM state.
+    return f16c && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c") != 0;
+#endif
+}
+
+static const bool hasF16C = CpuHasF16C();
+
+SIMUL_TARGET_F16C static void ToFloat16F16C(const float *src, uint16_t *dst, size_t count)
+{
+    const __m128i sign_mask = _mm_set1_epi16((short)0x8000);
+    const __m128i qnan = _mm_set1_epi16(0x7e00);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 a = _mm_loadu_ps(src + i);
+        __m128 b = _mm_loadu_ps(src + i + 4);
+        __m128i h = _mm_unpacklo_epi64(_mm_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(b, _MM_FROUND_TO_NEAREST_INT));
+        // The hardware keeps NaN payloads; the scalar path always produces the canonical quiet NaN.
+        __m128i nan = _mm_packs_epi32(_mm_castps_si128(_mm_cmpunord_ps(a, a)), _mm_castps_si128(_mm_cmpunord_ps(b, b)));
+        __m128i canonical = _mm_or_si128(_mm_and_si128(h, sign_mask), qnan);
+        h = _mm_or_si128(_mm_and_si128(nan, canonical), _mm_andnot_si128(nan, h));
+        _mm_storeu_si128((__m128i *)(dst + i), h);
+    }
+    ToFloat16Scalar(src + i, dst + i, count - i);
+}
+
+SIMUL_TARGET_F16C static void ToFloat32F16C(const uint16_t *src, float *dst, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i exp_mask = _mm_set1_epi32(0x7c00);
+    const __m128i mant_mask = _mm_set1_epi32(0x3ff);
+    const __m128i sign_mask = _mm_set1_epi32(0x8000);
+    const __m128i f32_inf = _mm_set1_epi32(0x7f800000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i h = _mm_loadl_epi64((const __m128i *)(src + i));
+        __m128i f = _mm_castps_si128(_mm_cvtph_ps(h));
+        // The hardware quietens signalling NaNs; the scalar path passes the payload through unchanged.
+        __m128i h32 = _mm_unpacklo_epi16(h, zero);
+        __m128i inf_nan = _mm_cmpeq_epi32(_mm_and_si128(h32, exp_mask), exp_mask);
+        __m128i exact = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(h32, sign_mask), 16), f32_inf),
+                                     _mm_slli_epi32(_mm_and_si128(h32, mant_mask), 13));
+        f = _mm_or_si128(_mm_and_si128(inf_nan, exact), _mm_andnot_si128(inf_nan, f));
+        _mm_storeu_si128((__m128i *)(dst + i), f);
+    }
+    ToFloat32Scalar(src + i, dst + i, count - i);
+}
+#endif
+
+#if SIMUL_FLOAT16_NEON
+static void ToFloat16Neon(const float *src, uint16_t *dst, size_t count)
+{
+    const uint16x4_t sign_mask = vdup_n_u16(0x8000);
+    const uint16x4_t qnan = vdup_n_u16(0x7e00);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t a = vld1q_f32(src + i);
+        uint16x4_t h = vreinterpret_u16_f16(vcvt_f16_f32(a));
+        // NaN lanes are the ones that don't compare equal to themselves.
+        uint16x4_t nan = vmovn_u32(vmvnq_u32(vceqq_f32(a, a)));
+        uint16x4_t canonical = vorr_u16(vand_u16(h, sign_mask), qnan);
+        vst1_u16(dst + i, vbsl_u16(nan, canonical, h));
+    }
+    ToFloat16Scalar(src + i, dst + i, count - i);
+}
+
+static void ToFloat32Neon(const uint16_t *src, float *dst, size_t count)
+{
+    const uint32x4_t exp_mask = vdupq_n_u32(0x7c00);
+    const uint32x4_t mant_mask = vdupq_n_u32(0x3ff);
+    const uint32x4_t sign_mask = vdupq_n_u32(0x8000);
+    const uint32x4_t f32_inf = vdupq_n_u32(0x7f800000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint16x4_t h = vld1_u16(src + i);
+        uint32x4_t f = vreinterpretq_u32_f32(vcvt_f32_f16(vreinterpret_f16_u16(h)));
+        uint32x4_t h32 = vmovl_u16(h);
+        uint32x4_t inf_nan = vceqq_u32(vandq_u32(h32, exp_mask), exp_mask);
+        uint32x4_t exact = vorrq_u32(vorrq_u32(vshlq_n_u32(vandq_u32(h32, sign_mask), 16), f32_inf),
+                                     vshlq_n_u32(vandq_u32(h32, mant_mask), 13));
+        vst1q_f32(dst + i, vreinterpretq_f32_u32(vbslq_u32(inf_nan, exact, f)));
+    }
+    ToFloat32Scalar(src + i, dst + i, count - i);
+}
+#endif
+
+bool platform::math::HasHardwareFloat16()
+{
+#if SIMUL_FLOAT16_X86
+    return hasF16C;
+#elif SIMUL_FLOAT16_NEON
+    return true;
+#else
+    return false;
+#endif
+}
+
+void platform::math::ToFloat16(const float *src, uint16_t *dst, size_t count)
+{
+#if SIMUL_FLOAT16_X86
+    if (hasF16C)
+    {
+        ToFloat16F16C(src, dst, count);
+        return;
+    }
+#elif SIMUL_FLOAT16_NEON
+    ToFloat16Neon(src, dst, count);
+    return;
+#endif
+    ToFloat16Scalar(src, dst, count);
+}
+
+void platform::math::ToFloat32(const uint16_t *src, float *dst, size_t count)
+{
+#if SIMUL_FLOAT16_X86
+    if (hasF16C)
+    {
+        ToFloat32F16C(src, dst, count);
+        return;
+    }
+#elif SIMUL_FLOAT16_NEON
+    ToFloat32Neon(src, dst, count);
+    return;
+#endif
+    ToFloat32Scalar(src, dst, count);
 }
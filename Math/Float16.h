@@ -1,5 +1,7 @@
 #pragma once
 #include "Export.h"
+#include <cstddef>
+#include <cstdint>
 
 namespace platform
 {
@@ -30,5 +32,13 @@ namespace platform
 
 		extern unsigned short SIMUL_MATH_EXPORT_FN ToFloat16(float f);
 		extern float SIMUL_MATH_EXPORT_FN ToFloat32(unsigned short u);
+
+		//! Convert count floats to half-precision, rounding to nearest even. Uses F16C or NEON where the CPU supports it,
+		//! otherwise a branch-free scalar loop. The results are bit-identical to calling ToFloat16() per value; NaNs become the canonical 0x7e00.
+		extern void SIMUL_MATH_EXPORT_FN ToFloat16(const float *src, uint16_t *dst, size_t count);
+		//! Convert count half-precision values to float. Bit-identical to calling ToFloat32() per value.
+		extern void SIMUL_MATH_EXPORT_FN ToFloat32(const uint16_t *src, float *dst, size_t count);
+		//! True if the bulk conversions will use a hardware path (F16C or NEON) on this CPU.
+		extern bool SIMUL_MATH_EXPORT_FN HasHardwareFloat16();
 	}
-}
\ No newline at end of file
+}
@@ -318,6 +318,8 @@ GLuint RenderPlatform::ToGLInternalFormat(crossplatform::PixelFormat p)
 		return GL_RG32F;
 	case R_32_FLOAT:
 		return GL_R32F;
+	case RG_16_FLOAT:
+		return GL_RG16F;
 	case R_16_FLOAT:
 		return GL_R16F;
 	case LUM_32_FLOAT:
@@ -429,6 +431,8 @@ GLuint RenderPlatform::ToGLFormat(crossplatform::PixelFormat p)
 		return GL_RGB_INTEGER;
 	case RG_32_FLOAT:
 		return GL_RG;
+	case RG_16_FLOAT:
+		return GL_RG;
 	case R_16_FLOAT:
 		return GL_RED;
 	case R_32_FLOAT:
@@ -479,6 +483,8 @@ int RenderPlatform::FormatCount(crossplatform::PixelFormat p)
 		return 2;
 	case R_32_FLOAT:
 		return 1;
+	case RG_16_FLOAT:
+		return 2;
 	case R_16_FLOAT:
 		return 1;
 	case LUM_32_FLOAT:
@@ -586,6 +592,8 @@ GLenum RenderPlatform::DataType(crossplatform::PixelFormat p)
 		return GL_FLOAT;
 	case R_32_FLOAT:
 		return GL_FLOAT;
+	case RG_16_FLOAT:
+		return GL_HALF_FLOAT;
 	case R_16_FLOAT:
         return GL_HALF_FLOAT;
 	case LUM_32_FLOAT:
@@ -32,11 +32,24 @@ void EffectPass::InvalidateDeviceObjects()
 	if (!rp || !vulkanDevice)
 		return;
 
+	// Pre-warm jobs still running would write into this pass, so sleep until the last one signals.
+	{
+		std::unique_lock<std::mutex> lock(m_PrewarmMutex);
+		m_PrewarmsFinished.wait(lock, [this]() { return m_PendingPrewarms == 0; });
+	}
+	for (auto& i : m_Prewarmed)
+		m_RenderPasses[i.first] = i.second;
+	m_Prewarmed.clear();
+	for (auto& i : m_PrewarmDuplicates)
+	{
+		rp->PushToReleaseManager(i.renderPass);
+		rp->PushToReleaseManager(i.pipeline);
+	}
+	m_PrewarmDuplicates.clear();
 	for (auto i : m_RenderPasses)
 	{
 		rp->PushToReleaseManager(i.second.renderPass);
 		rp->PushToReleaseManager(i.second.pipeline);
-		rp->PushToReleaseManager(i.second.pipelineCache);
 	}
 	m_RenderPasses.clear();
 
@@ -438,32 +451,15 @@ void EffectPass::ApplyContextState(crossplatform::DeviceContext& deviceContext,
 	RenderPassPipeline* renderPassPipeline = nullptr;
 	if (c)
 	{
-		const auto& p = m_RenderPasses.find(hashval);
-		if (p == m_RenderPasses.end())
-		{
-			renderPassPipeline = &m_RenderPasses[hashval];
-			InitializePipeline(*graphicsDeviceContext, renderPassPipeline, crossplatform::PixelFormat::UNKNOWN, 0, crossplatform::Topology::UNDEFINED);
-		}
-		else
-			renderPassPipeline = &(m_RenderPasses[hashval]);
+		PipelineDesc desc;
+		desc.numOfSamples = 0;
+		renderPassPipeline = &EnsurePipeline(graphicsDeviceContext, hashval, desc);
 	}
 	else
 	{
-		crossplatform::PixelFormat pixelFormat = crossplatform::PixelFormat::UNKNOWN;
-		int numOfSamples = 1;
-		pixelFormat =  vulkan::RenderPlatform::GetActivePixelFormat(*graphicsDeviceContext);
-		numOfSamples = vulkan::RenderPlatform::GetActiveNumOfSamples(*graphicsDeviceContext);
-		crossplatform::Topology appliedTopology = (cs->topology != crossplatform::Topology::UNDEFINED)?cs->topology:topology;
-
-		hashval = MakeRenderPassHash(pixelFormat, numOfSamples, appliedTopology, cs->currentLayout, blendState, depthStencilState, rasterizerState, multiview);
-		const auto& p = m_RenderPasses.find(hashval);
-		if (p == m_RenderPasses.end())
-		{
-			renderPassPipeline = &m_RenderPasses[hashval];
-			InitializePipeline(*graphicsDeviceContext, renderPassPipeline, pixelFormat, numOfSamples, appliedTopology, blendState, depthStencilState, rasterizerState, multiview);
-		}
-		else
-			renderPassPipeline = &(m_RenderPasses[hashval]);
+		PipelineDesc desc = MakePipelineDesc(*graphicsDeviceContext);
+		hashval = GetHash(desc);
+		renderPassPipeline = &EnsurePipeline(graphicsDeviceContext, hashval, desc);
 //std::cout << "////RenderPass for depth write: " << depthStencilState->desc.depth.write<<"\n";
 		// Now figure out the layout business for the rendertargets:
 		crossplatform::TargetsAndViewport* tv;
@@ -756,16 +752,17 @@ vk::ShaderStageFlags EffectPass::GetShaderFlagsForSlot(int slot, bool(platform::
 	return stageFlags;
 }
 
-void EffectPass::InitializePipeline(crossplatform::GraphicsDeviceContext& deviceContext, RenderPassPipeline* renderPassPipeline, crossplatform::PixelFormat pixelFormat, int numOfSamples,
-	crossplatform::Topology topology, const crossplatform::RenderState* blendState, const crossplatform::RenderState* depthStencilState
-	, const crossplatform::RenderState* rasterizerState, bool multiview)
+void EffectPass::InitializePipeline(crossplatform::GraphicsDeviceContext* deviceContext, RenderPassPipeline* renderPassPipeline, const PipelineDesc& desc)
 {
+	// Called from worker threads when pre-warming, with no deviceContext: nothing here may touch per-frame state.
+	crossplatform::PixelFormat pixelFormat = desc.pixelFormat;
+	int numOfSamples = desc.numOfSamples;
+	crossplatform::Topology topology = desc.topology;
 	vulkan::RenderPlatform *rp = (vulkan::RenderPlatform *)renderPlatform;
 	vk::Device* vulkanDevice = rp->AsVulkanDevice();
-	vk::PipelineCacheCreateInfo pipelineCacheInfo;
-	vk::Result result = vulkanDevice->createPipelineCache(&pipelineCacheInfo, nullptr, &renderPassPipeline->pipelineCache);
-	SIMUL_VK_CHECK(result);
-	SetVulkanName(renderPlatform, renderPassPipeline->pipelineCache, platform::core::QuickFormat("%s EffectPass mPipelineCache", name.c_str()));
+	PipelineCache &pipelineCache = rp->GetPipelineCache();
+	vk::PipelineCreationFeedbackEXT creationFeedback;
+	vk::PipelineCreationFeedbackCreateInfoEXT creationFeedbackInfo;
 
 	vulkan::Shader* v = (vulkan::Shader*)shaders[crossplatform::SHADERTYPE_VERTEX];
 	vulkan::Shader* f = (vulkan::Shader*)shaders[crossplatform::SHADERTYPE_PIXEL];
@@ -778,27 +775,25 @@ void EffectPass::InitializePipeline(crossplatform::GraphicsDeviceContext& device
 		vk::ComputePipelineCreateInfo computePipelineCreateInfo = vk::ComputePipelineCreateInfo()
 			.setLayout(m_PipelineLayout)
 			.setStage(shaderStageInfo);
-		SIMUL_VK_CHECK(vulkanDevice->createComputePipelines(renderPassPipeline->pipelineCache, 1, &computePipelineCreateInfo, nullptr, &renderPassPipeline->pipeline));
-		SetVulkanName(renderPlatform, renderPassPipeline->pipeline, platform::core::QuickFormat("%s EffectPass compute mPipeline", name.c_str()));
+		pipelineCache.PrepareCreateInfo(computePipelineCreateInfo, creationFeedbackInfo, creationFeedback);
+		SIMUL_VK_CHECK(vulkanDevice->createComputePipelines(pipelineCache.GetVulkanPipelineCache(), 1, &computePipelineCreateInfo, nullptr, &renderPassPipeline->pipeline));
+		pipelineCache.RecordCreation(creationFeedback);
+		SetVulkanName(renderPlatform, renderPassPipeline->pipeline, name + " EffectPass compute mPipeline");
 	}
 	else
 	{
-		crossplatform::GraphicsDeviceContext* graphicsDeviceContext = deviceContext.AsGraphicsDeviceContext();
-		crossplatform::TargetsAndViewport* tv;
-		if (graphicsDeviceContext->targetStack.size())
-			tv = graphicsDeviceContext->targetStack.top();
-		else
-			tv = &(graphicsDeviceContext->defaultTargetsAndViewport);
-		int num_RT = tv->num;
+		int num_RT = desc.numRenderTargets;
 
 		bool colour_write = true;
-		bool depth_write = (tv->depthTarget.texture != nullptr && depthStencilState->desc.depth.write);
-		bool depth_read = (tv->depthTarget.texture != nullptr && depthStencilState->desc.depth.test);
+		bool depth_write = (desc.hasDepthTarget && depthStencilState->desc.depth.write);
+		bool depth_read = (desc.hasDepthTarget && depthStencilState->desc.depth.test);
 		crossplatform::PixelFormat depthFormat = (depth_write || depth_read) ? crossplatform::PixelFormat::D_32_FLOAT : crossplatform::PixelFormat::UNKNOWN;
 
-		vulkanRenderPlatform->CreateVulkanRenderpass(deviceContext, renderPassPipeline->renderPass, num_RT, &pixelFormat,
+		// Only multiview render passes read the context, and those are never pre-warmed.
+		crossplatform::GraphicsDeviceContext& renderPassContext = deviceContext ? *deviceContext : renderPlatform->GetImmediateContext();
+		vulkanRenderPlatform->CreateVulkanRenderpass(renderPassContext, renderPassPipeline->renderPass, num_RT, &pixelFormat,
 			depthFormat, depth_read, depth_write, false, numOfSamples, multiview);
-		SetVulkanName(renderPlatform, renderPassPipeline->renderPass, platform::core::QuickFormat("%s EffectPass mRenderPass", name.c_str()));
+		SetVulkanName(renderPlatform, renderPassPipeline->renderPass, name + " EffectPass mRenderPass");
 
 		vk::PipelineShaderStageCreateInfo shaderStageInfo[2] = {
 			vk::PipelineShaderStageCreateInfo().setStage(vk::ShaderStageFlagBits::eVertex).setModule(v->mShader).setPName(v->entryPoint.c_str()),
@@ -879,29 +874,34 @@ void EffectPass::InitializePipeline(crossplatform::GraphicsDeviceContext& device
 		}
 		colorBlendInfo.setAttachmentCount(num_RT).setPAttachments(colorBlendAttachments.data());
 
-		// from the vertex shader's layout:
-		const auto* layout = deviceContext.contextState.currentLayout;
-		if (!layout)
-			layout = &v->layout;
+		// from the bound layout, or failing that the vertex shader's layout:
+		std::vector<std::pair<crossplatform::PixelFormat, int>> layoutDesc = desc.vertexInputs;
+		int layoutStride = desc.layoutStride;
+		if (!desc.hasLayout)
+		{
+			layoutDesc.clear();
+			for (const auto& l : v->layout.GetDesc())
+				layoutDesc.push_back({ l.format, l.alignedByteOffset });
+			layoutStride = v->layout.GetStructSize();
+		}
 		vk::VertexInputAttributeDescription* vertexInputs = nullptr;
-		const auto& layoutDesc = layout->GetDesc();
 		vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
 		vk::VertexInputBindingDescription bindingDescription;
 		if (layoutDesc.size())
 		{
 			bindingDescription.setBinding(0);
-			bindingDescription.setStride(layout->GetStructSize());
+			bindingDescription.setStride(layoutStride);
 			bindingDescription.setInputRate(vk::VertexInputRate::eVertex);
 
 			if (layoutDesc.size())
 				vertexInputs = new vk::VertexInputAttributeDescription[layoutDesc.size()];
 			int slot = 0;
-			for (auto desc : layoutDesc)
+			for (auto l : layoutDesc)
 			{
 				vertexInputs[slot].binding = 0;
 				vertexInputs[slot].location = slot;
-				vertexInputs[slot].format = RenderPlatform::ToVulkanFormat(desc.format);
-				vertexInputs[slot].offset = desc.alignedByteOffset;
+				vertexInputs[slot].format = RenderPlatform::ToVulkanFormat(l.first);
+				vertexInputs[slot].offset = l.second;
 				slot++;
 			}
 			vertexInputInfo.vertexBindingDescriptionCount = 1;
@@ -929,50 +929,139 @@ void EffectPass::InitializePipeline(crossplatform::GraphicsDeviceContext& device
 			.setLayout(m_PipelineLayout)
 			.setRenderPass(renderPassPipeline->renderPass);
 
-		vk::Result res = vulkanDevice->createGraphicsPipelines(renderPassPipeline->pipelineCache, 1, &graphicsPipelineCreateInfo, nullptr, &renderPassPipeline->pipeline);
+		pipelineCache.PrepareCreateInfo(graphicsPipelineCreateInfo, creationFeedbackInfo, creationFeedback);
+		vk::Result res = vulkanDevice->createGraphicsPipelines(pipelineCache.GetVulkanPipelineCache(), 1, &graphicsPipelineCreateInfo, nullptr, &renderPassPipeline->pipeline);
 		if (res != vk::Result::eSuccess)
 		{
 			SIMUL_VK_CHECK(res);
 			std::cerr << "vk::Result=" << platform::vulkan::RenderPlatform::VulkanResultString(res) << std::endl;
 			std::cerr << "Failed to create pipeline." << std::endl;
 		}
-		SetVulkanName(renderPlatform, renderPassPipeline->pipeline, platform::core::QuickFormat("%s EffectPass renderPass Pipeline", name.c_str()));
+		else
+			pipelineCache.RecordCreation(creationFeedback);
+		SetVulkanName(renderPlatform, renderPassPipeline->pipeline, name + " EffectPass renderPass Pipeline");
 		if (vertexInputs)
 			delete[] vertexInputs;
 	}
 }
 
 EffectPass::RenderPassPipeline& EffectPass::GetRenderPassPipeline(crossplatform::GraphicsDeviceContext& deviceContext)
+{
+	PipelineDesc desc = MakePipelineDesc(deviceContext);
+	return EnsurePipeline(&deviceContext, GetHash(desc), desc);
+}
+
+EffectPass::PipelineDesc EffectPass::MakePipelineDesc(crossplatform::GraphicsDeviceContext& deviceContext) const
 {
 	crossplatform::ContextState* cs = &deviceContext.contextState;
-	crossplatform::PixelFormat pixelFormat = vulkan::RenderPlatform::GetActivePixelFormat(deviceContext);
-	int numOfSamples = vulkan::RenderPlatform::GetActiveNumOfSamples(deviceContext);
-	crossplatform::Topology appliedTopology = (cs->topology != crossplatform::Topology::UNDEFINED) ? cs->topology : topology;
+	PipelineDesc desc;
+	desc.pixelFormat = vulkan::RenderPlatform::GetActivePixelFormat(deviceContext);
+	desc.numOfSamples = vulkan::RenderPlatform::GetActiveNumOfSamples(deviceContext);
+	desc.topology = (cs->topology != crossplatform::Topology::UNDEFINED) ? cs->topology : topology;
+	crossplatform::TargetsAndViewport* tv;
+	if (deviceContext.targetStack.size())
+		tv = deviceContext.targetStack.top();
+	else
+		tv = &(deviceContext.defaultTargetsAndViewport);
+	desc.numRenderTargets = tv->num;
+	desc.hasDepthTarget = (tv->depthTarget.texture != nullptr);
+	if (cs->currentLayout)
+	{
+		desc.hasLayout = true;
+		desc.layoutHash = cs->currentLayout->GetHash();
+		desc.layoutStride = cs->currentLayout->GetStructSize();
+		for (const auto& l : cs->currentLayout->GetDesc())
+			desc.vertexInputs.push_back({ l.format, l.alignedByteOffset });
+	}
+	return desc;
+}
 
-	RenderPassHash hashval = MakeRenderPassHash(pixelFormat, numOfSamples, appliedTopology, cs->currentLayout, blendState, depthStencilState, rasterizerState, multiview);
-	const auto& p = m_RenderPasses.find(hashval);
-	if (p == m_RenderPasses.end())
+EffectPass::RenderPassPipeline& EffectPass::EnsurePipeline(crossplatform::GraphicsDeviceContext* deviceContext, RenderPassHash hashval, const PipelineDesc& desc)
+{
+	auto p = m_RenderPasses.find(hashval);
+	if (p != m_RenderPasses.end())
+		return p->second;
 	{
-		InitializePipeline(deviceContext, &m_RenderPasses[hashval], pixelFormat, numOfSamples, appliedTopology, blendState, depthStencilState, rasterizerState, multiview);
+		// A worker thread may already have built it.
+		std::lock_guard<std::mutex> lock(m_PrewarmMutex);
+		auto w = m_Prewarmed.find(hashval);
+		if (w != m_Prewarmed.end())
+		{
+			RenderPassPipeline& r = m_RenderPasses[hashval];
+			r = w->second;
+			m_Prewarmed.erase(w);
+			return r;
+		}
 	}
+	RenderPassPipeline& r = m_RenderPasses[hashval];
+	InitializePipeline(deviceContext, &r, desc);
+	PipelinePrewarmer& prewarmer = ((vulkan::RenderPlatform*)renderPlatform)->GetPipelinePrewarmer();
+	if (prewarmer.IsRecording() && !multiview)
+		prewarmer.Record(this, desc, hashval);
+	return r;
+}
 
-	return m_RenderPasses[hashval];
+bool EffectPass::PreparePrewarm()
+{
+	// Multiview render passes take their view mask from the bound targets, so they can't be built ahead of time.
+	if (multiview || !renderPlatform)
+		return false;
+	if (!m_Initialized)
+		CreateDescriptorPoolAndSetLayoutAndPipelineLayout();
+	std::lock_guard<std::mutex> lock(m_PrewarmMutex);
+	m_PendingPrewarms++;
+	return true;
+}
+
+bool EffectPass::PrewarmPipeline(RenderPassHash hashval, const PipelineDesc& desc)
+{
+	bool created = false;
+	bool exists = false;
+	{
+		std::lock_guard<std::mutex> lock(m_PrewarmMutex);
+		exists = (m_Prewarmed.find(hashval) != m_Prewarmed.end());
+	}
+	if (!exists)
+	{
+		RenderPassPipeline r;
+		InitializePipeline(nullptr, &r, desc);
+		created = (bool)r.pipeline;
+		if (created)
+		{
+			std::lock_guard<std::mutex> lock(m_PrewarmMutex);
+			if (m_Prewarmed.find(hashval) == m_Prewarmed.end())
+				m_Prewarmed[hashval] = r;
+			else
+				m_PrewarmDuplicates.push_back(r);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_PrewarmMutex);
+		if (--m_PendingPrewarms == 0)
+			m_PrewarmsFinished.notify_all();
+	}
+	return created || exists;
+}
+
+RenderPassHash EffectPass::GetHash(const PipelineDesc& desc) const
+{
+	// Compute passes have only the one pipeline.
+	if (shaders[crossplatform::SHADERTYPE_COMPUTE])
+		return 0;
+	return MakeRenderPassHash(desc.pixelFormat, desc.numOfSamples, desc.topology, desc.layoutHash, blendState, depthStencilState, rasterizerState, multiview);
 }
 
 RenderPassHash EffectPass::GetHash(crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology, const crossplatform::Layout* layout)
 {
-	RenderPassHash hashval = MakeRenderPassHash(pixelFormat, numOfSamples, topology, layout, blendState, depthStencilState, rasterizerState, multiview);
+	RenderPassHash hashval = MakeRenderPassHash(pixelFormat, numOfSamples, topology, layout ? layout->GetHash() : 0, blendState, depthStencilState, rasterizerState, multiview);
 	return hashval;
 }
 
-RenderPassHash EffectPass::MakeRenderPassHash(crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology, const crossplatform::Layout* layout,
+RenderPassHash EffectPass::MakeRenderPassHash(crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology, uint64_t layoutHash,
 	const crossplatform::RenderState* blendState, const crossplatform::RenderState* depthStencilState, const crossplatform::RenderState* rasterizerState, bool multiview)
 {
 	unsigned long long hashval = (unsigned long long)pixelFormat * 1000 + (unsigned long long)numOfSamples * 10 + (unsigned long long)topology;
-	if (layout)
-	{
-		hashval += layout->GetHash();
-	}
+	hashval += layoutHash;
 	if (blendState)
 	{
 		hashval += blendState->desc.blend.AlphaToCoverageEnable ? 2048 : 0;
@@ -4,6 +4,9 @@
 #include "Platform/CrossPlatform/Effect.h"
 #include "Platform/Vulkan/Shader.h"
 #include <list>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -22,9 +25,23 @@ namespace platform
 			struct RenderPassPipeline
 			{
 				vk::Pipeline		pipeline;
-				vk::PipelineCache	pipelineCache;
 				vk::RenderPass		renderPass;
 			};
+			//! Everything besides the pass itself that determines a pipeline: enough to rebuild it without a device context.
+			struct PipelineDesc
+			{
+				crossplatform::PixelFormat	pixelFormat = crossplatform::PixelFormat::UNKNOWN;
+				int							numOfSamples = 1;
+				crossplatform::Topology		topology = crossplatform::Topology::UNDEFINED;
+				int							numRenderTargets = 1;
+				bool						hasDepthTarget = false;
+				//! If false, the vertex shader's own layout is used.
+				bool						hasLayout = false;
+				uint64_t					layoutHash = 0;
+				int							layoutStride = 0;
+				//! Format and byte offset of each vertex attribute.
+				std::vector<std::pair<crossplatform::PixelFormat, int>> vertexInputs;
+			};
 
 		public:
 			EffectPass(crossplatform::RenderPlatform* r, crossplatform::Effect* e);
@@ -55,20 +72,24 @@ namespace platform
 
 			vk::ShaderStageFlags GetShaderFlagsForSlot(int slot, bool(platform::crossplatform::Shader::* pfn)(int) const);
 			
-			void InitializePipeline(crossplatform::GraphicsDeviceContext& deviceContext, RenderPassPipeline* renderPassPipeline
-				, crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology
-				, const crossplatform::RenderState* blendState = nullptr
-				, const crossplatform::RenderState* depthStencilState = nullptr
-				, const crossplatform::RenderState* rasterizerState = nullptr
-				, bool multiview = false);
+			//! deviceContext may be null, as it is when pre-warming, for anything but a multiview pass.
+			void InitializePipeline(crossplatform::GraphicsDeviceContext* deviceContext, RenderPassPipeline* renderPassPipeline, const PipelineDesc& desc);
+			//! Find or create the pipeline for hashval, adopting a pre-warmed one if available.
+			RenderPassPipeline& EnsurePipeline(crossplatform::GraphicsDeviceContext* deviceContext, RenderPassHash hashval, const PipelineDesc& desc);
+			PipelineDesc MakePipelineDesc(crossplatform::GraphicsDeviceContext& deviceContext) const;
 
 		public:
 			RenderPassPipeline& GetRenderPassPipeline(crossplatform::GraphicsDeviceContext& deviceContext);
 			RenderPassHash GetHash(crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology, const crossplatform::Layout* layout);
+			RenderPassHash GetHash(const PipelineDesc& desc) const;
+			//! Call on the render thread before queuing PrewarmPipeline() on a worker. Returns false if this pass can't be pre-warmed.
+			bool PreparePrewarm();
+			//! Create a pipeline ahead of use. Safe to call from a worker thread, once per successful PreparePrewarm().
+			bool PrewarmPipeline(RenderPassHash hashval, const PipelineDesc& desc);
 
 		private:
 			static RenderPassHash MakeRenderPassHash(crossplatform::PixelFormat pixelFormat, int numOfSamples, crossplatform::Topology topology
-				, const crossplatform::Layout* layout = nullptr
+				, uint64_t layoutHash = 0
 				, const crossplatform::RenderState* blendState = nullptr
 				, const crossplatform::RenderState* depthStencilState = nullptr
 				, const crossplatform::RenderState* rasterizerState = nullptr
@@ -89,6 +110,13 @@ namespace platform
 			vk::DescriptorSet								m_DescriptorSet;		// The pass's own internal desciptor set.
 			vk::PipelineLayout								m_PipelineLayout;
 			std::map<RenderPassHash, RenderPassPipeline>	m_RenderPasses;
+			//! Pipelines built by worker threads, moved into m_RenderPasses on first use.
+			std::mutex										m_PrewarmMutex;
+			std::map<RenderPassHash, RenderPassPipeline>	m_Prewarmed;
+			std::vector<RenderPassPipeline>					m_PrewarmDuplicates;
+			//! Jobs queued by PreparePrewarm() that haven't finished, guarded by m_PrewarmMutex.
+			int												m_PendingPrewarms = 0;
+			std::condition_variable							m_PrewarmsFinished;
 
 			int64_t											m_LastFrameIndex;
 			size_t											m_InternalFrameIndex;	// incremented internally.
@@ -0,0 +1,230 @@
+#include "Platform/Vulkan/PipelineCache.h"
+#include "Platform/Core/RuntimeError.h"
+#include "Platform/Core/FileLoader.h"
+#include <cstring>
+using namespace platform;
+using namespace vulkan;
+
+namespace
+{
+	const char pipelineCacheMagic[4]={'S','P','C','F'};
+	const uint32_t pipelineCacheFileVersion=1;
+	// The file header. All fields are little-endian, as written by every platform we support.
+	struct PipelineCacheFileHeader
+	{
+		char		magic[4];
+		uint32_t	fileVersion;
+		uint32_t	vendorID;
+		uint32_t	deviceID;
+		uint32_t	driverVersion;
+		uint8_t		pipelineCacheUUID[VK_UUID_SIZE];
+		uint32_t	pad;
+		uint64_t	dataSize;
+		uint64_t	dataHash;
+	};
+	static_assert(sizeof(PipelineCacheFileHeader)==56,"PipelineCacheFileHeader must have no implicit padding.");
+	// The header that Vulkan puts at the start of VK_PIPELINE_CACHE_HEADER_VERSION_ONE data.
+	struct VulkanPipelineCacheHeader
+	{
+		uint32_t	headerSize;
+		uint32_t	headerVersion;
+		uint32_t	vendorID;
+		uint32_t	deviceID;
+		uint8_t		pipelineCacheUUID[VK_UUID_SIZE];
+	};
+	uint64_t Fnv1a64(const uint8_t *data,size_t size)
+	{
+		uint64_t h=0xcbf29ce484222325ULL;
+		for(size_t i=0;i<size;i++)
+		{
+			h^=data[i];
+			h*=0x100000001b3ULL;
+		}
+		return h;
+	}
+}
+
+bool PipelineCacheIdentity::operator==(const PipelineCacheIdentity &i) const
+{
+	return vendorID==i.vendorID&&deviceID==i.deviceID&&driverVersion==i.driverVersion
+		&&memcmp(pipelineCacheUUID,i.pipelineCacheUUID,VK_UUID_SIZE)==0;
+}
+
+PipelineCache::PipelineCache()
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+	InvalidateDeviceObjects();
+}
+
+PipelineCacheIdentity PipelineCache::GetIdentity(const vk::PhysicalDeviceProperties &properties)
+{
+	PipelineCacheIdentity i;
+	i.vendorID=properties.vendorID;
+	i.deviceID=properties.deviceID;
+	i.driverVersion=properties.driverVersion;
+	memcpy(i.pipelineCacheUUID,properties.pipelineCacheUUID.data(),VK_UUID_SIZE);
+	return i;
+}
+
+std::vector<uint8_t> PipelineCache::Serialize(const PipelineCacheIdentity &id,const void *blob,size_t size)
+{
+	PipelineCacheFileHeader header;
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,pipelineCacheMagic,4);
+	header.fileVersion=pipelineCacheFileVersion;
+	header.vendorID=id.vendorID;
+	header.deviceID=id.deviceID;
+	header.driverVersion=id.driverVersion;
+	memcpy(header.pipelineCacheUUID,id.pipelineCacheUUID,VK_UUID_SIZE);
+	header.dataSize=size;
+	header.dataHash=Fnv1a64((const uint8_t*)blob,size);
+	std::vector<uint8_t> file(sizeof(header)+size);
+	memcpy(file.data(),&header,sizeof(header));
+	if(size)
+		memcpy(file.data()+sizeof(header),blob,size);
+	return file;
+}
+
+bool PipelineCache::Deserialize(const PipelineCacheIdentity &id,const void *file,size_t size,std::vector<uint8_t> &blob,std::string *reason)
+{
+	auto Fail=[reason](const char *r)
+	{
+		if(reason)
+			*reason=r;
+		return false;
+	};
+	blob.clear();
+	if(!file||size<sizeof(PipelineCacheFileHeader))
+		return Fail("file is too small");
+	PipelineCacheFileHeader header;
+	memcpy(&header,file,sizeof(header));
+	if(memcmp(header.magic,pipelineCacheMagic,4)!=0)
+		return Fail("not a pipeline cache file");
+	if(header.fileVersion!=pipelineCacheFileVersion)
+		return Fail("unsupported file version");
+	if(header.vendorID!=id.vendorID||header.deviceID!=id.deviceID)
+		return Fail("written for a different device");
+	if(header.driverVersion!=id.driverVersion)
+		return Fail("written by a different driver version");
+	if(memcmp(header.pipelineCacheUUID,id.pipelineCacheUUID,VK_UUID_SIZE)!=0)
+		return Fail("pipeline cache UUID mismatch");
+	if(header.dataSize!=size-sizeof(header))
+		return Fail("truncated data");
+	const uint8_t *data=(const uint8_t*)file+sizeof(header);
+	if(Fnv1a64(data,(size_t)header.dataSize)!=header.dataHash)
+		return Fail("checksum mismatch");
+	// The driver must also reject foreign data, but not every driver does, so check its own header too.
+	if(header.dataSize<sizeof(VulkanPipelineCacheHeader))
+		return Fail("driver data is too small");
+	VulkanPipelineCacheHeader vkHeader;
+	memcpy(&vkHeader,data,sizeof(vkHeader));
+	if(vkHeader.headerSize<sizeof(VulkanPipelineCacheHeader)||vkHeader.headerSize>header.dataSize
+		||vkHeader.headerVersion!=(uint32_t)VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		||vkHeader.vendorID!=id.vendorID||vkHeader.deviceID!=id.deviceID
+		||memcmp(vkHeader.pipelineCacheUUID,id.pipelineCacheUUID,VK_UUID_SIZE)!=0)
+		return Fail("driver data header mismatch");
+	blob.assign(data,data+header.dataSize);
+	return true;
+}
+
+void PipelineCache::RestoreDeviceObjects(vk::Device *d,vk::PhysicalDevice *gpu,const std::string &f,bool creationFeedback)
+{
+	InvalidateDeviceObjects();
+	device=d;
+	filename=f;
+	creationFeedbackSupported=creationFeedback;
+	identity=GetIdentity(gpu->getProperties());
+	hits=misses=unreported=unsaved=0;
+	loadedBytes=savedBytes=0;
+	std::vector<uint8_t> blob;
+	core::FileLoader *fileLoader=core::FileLoader::GetFileLoader();
+	if(filename.length()&&fileLoader->FileExists(filename.c_str()))
+	{
+		void *ptr=nullptr;
+		unsigned bytes=0;
+		fileLoader->AcquireFileContents(ptr,bytes,filename.c_str(),false);
+		std::string reason;
+		if(ptr&&!Deserialize(identity,ptr,bytes,blob,&reason))
+			SIMUL_COUT<<"Discarding pipeline cache "<<filename.c_str()<<": "<<reason.c_str()<<".\n";
+		if(ptr)
+			fileLoader->ReleaseFileContents(ptr);
+	}
+	vk::PipelineCacheCreateInfo pipelineCacheInfo;
+	pipelineCacheInfo.setInitialDataSize(blob.size()).setPInitialData(blob.size()?blob.data():nullptr);
+	vk::Result result=device->createPipelineCache(&pipelineCacheInfo,nullptr,&pipelineCache);
+	if(result!=vk::Result::eSuccess&&blob.size())
+	{
+		// The driver refused the data: start empty rather than fail.
+		pipelineCacheInfo.setInitialDataSize(0).setPInitialData(nullptr);
+		blob.clear();
+		result=device->createPipelineCache(&pipelineCacheInfo,nullptr,&pipelineCache);
+	}
+	SIMUL_VK_CHECK(result);
+	loadedBytes=blob.size();
+}
+
+void PipelineCache::InvalidateDeviceObjects()
+{
+	if(!device)
+		return;
+	Save();
+	if(pipelineCache)
+		device->destroyPipelineCache(pipelineCache,nullptr);
+	pipelineCache=nullptr;
+	device=nullptr;
+}
+
+bool PipelineCache::Save()
+{
+	if(!device||!pipelineCache||!filename.length()||!unsaved)
+		return false;
+	size_t size=0;
+	if(device->getPipelineCacheData(pipelineCache,&size,nullptr)!=vk::Result::eSuccess||!size)
+		return false;
+	std::vector<uint8_t> blob(size);
+	if(device->getPipelineCacheData(pipelineCache,&size,blob.data())!=vk::Result::eSuccess)
+		return false;
+	std::vector<uint8_t> file=Serialize(identity,blob.data(),size);
+	if(!core::FileLoader::GetFileLoader()->Save(file.data(),(unsigned)file.size(),filename.c_str(),false))
+		return false;
+	unsaved=0;
+	savedBytes=file.size();
+	return true;
+}
+
+void PipelineCache::Update(long long frameNumber)
+{
+	if(!saveIntervalFrames||frameNumber-lastSaveFrame<(long long)saveIntervalFrames)
+		return;
+	lastSaveFrame=frameNumber;
+	Save();
+}
+
+void PipelineCache::RecordCreation(const vk::PipelineCreationFeedbackEXT &feedback)
+{
+	if(!(feedback.flags&vk::PipelineCreationFeedbackFlagBitsEXT::eValid))
+		unreported++;
+	else if(feedback.flags&vk::PipelineCreationFeedbackFlagBitsEXT::eApplicationPipelineCacheHit)
+	{
+		// Nothing new for the cache, so no need to save.
+		hits++;
+		return;
+	}
+	else
+		misses++;
+	unsaved++;
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+	PipelineCacheStats s;
+	s.hits=hits;
+	s.misses=misses;
+	s.unreported=unreported;
+	s.loadedBytes=loadedBytes;
+	s.savedBytes=savedBytes;
+	return s;
+}
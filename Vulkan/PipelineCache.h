@@ -0,0 +1,101 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include "Platform/Vulkan/Export.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace vulkan
+	{
+		//! Identifies the device and driver that produced a pipeline cache blob. Data from any other device or driver is discarded on load.
+		struct PipelineCacheIdentity
+		{
+			uint32_t vendorID=0;
+			uint32_t deviceID=0;
+			uint32_t driverVersion=0;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE]={0};
+			bool operator==(const PipelineCacheIdentity &i) const;
+		};
+		struct PipelineCacheStats
+		{
+			uint64_t hits=0;			//!< Pipelines the driver reported as found in the cache.
+			uint64_t misses=0;			//!< Pipelines the driver reported as compiled.
+			uint64_t unreported=0;		//!< Pipelines created without VK_EXT_pipeline_creation_feedback, so neither a hit nor a miss is known.
+			uint64_t loadedBytes=0;		//!< Size of the blob accepted at load, or zero.
+			uint64_t savedBytes=0;		//!< Size of the last blob written.
+		};
+		//! A single device-wide vk::PipelineCache, shared by every EffectPass, that persists across runs.
+		//! The on-disk file wraps the driver's blob in a header carrying the device identity, the driver version
+		//! and a checksum; Serialize and Deserialize work on plain memory so the format can be checked without a device.
+		class SIMUL_VULKAN_EXPORT PipelineCache
+		{
+		public:
+			PipelineCache();
+			~PipelineCache();
+			//! Create the cache, seeding it from \a filename_utf8 if that holds valid data for this device. An empty filename gives a cache that is never saved.
+			void RestoreDeviceObjects(vk::Device *device,vk::PhysicalDevice *gpu,const std::string &filename_utf8,bool creationFeedback);
+			//! Save if the cache has changed, then destroy it.
+			void InvalidateDeviceObjects();
+			//! Save the cache to disk if new pipelines were added since the last save. Returns true if a file was written.
+			bool Save();
+			//! Save at most once every \a frames frames from Update(). Zero, the default, saves only at shutdown.
+			void SetSaveInterval(uint32_t frames)
+			{
+				saveIntervalFrames=frames;
+			}
+			//! Call once per frame to handle periodic saving.
+			void Update(long long frameNumber);
+			vk::PipelineCache GetVulkanPipelineCache() const
+			{
+				return pipelineCache;
+			}
+			//! Chain creation feedback into a pipeline create-info, if supported. \a feedback must outlive the create call.
+			template<typename T> void PrepareCreateInfo(T &createInfo,vk::PipelineCreationFeedbackCreateInfoEXT &feedbackInfo,vk::PipelineCreationFeedbackEXT &feedback) const
+			{
+				if(!creationFeedbackSupported)
+					return;
+				feedbackInfo.setPPipelineCreationFeedback(&feedback);
+				feedbackInfo.setPipelineStageCreationFeedbackCount(0);
+				feedbackInfo.pNext=createInfo.pNext;
+				createInfo.pNext=&feedbackInfo;
+			}
+			//! Count the outcome of a pipeline creation.
+			void RecordCreation(const vk::PipelineCreationFeedbackEXT &feedback);
+			PipelineCacheStats GetStats() const;
+
+			//! Identity of a physical device, as stored in the file header.
+			static PipelineCacheIdentity GetIdentity(const vk::PhysicalDeviceProperties &properties);
+			//! Wrap a driver blob for writing to disk.
+			static std::vector<uint8_t> Serialize(const PipelineCacheIdentity &identity,const void *blob,size_t size);
+			//! Validate file contents against \a identity and extract the driver blob. On failure, returns false and sets \a reason if non-null.
+			static bool Deserialize(const PipelineCacheIdentity &identity,const void *file,size_t size,std::vector<uint8_t> &blob,std::string *reason=nullptr);
+		private:
+			vk::Device						*device=nullptr;
+			vk::PipelineCache				pipelineCache;
+			PipelineCacheIdentity			identity;
+			std::string						filename;
+			bool							creationFeedbackSupported=false;
+			uint32_t						saveIntervalFrames=0;
+			long long						lastSaveFrame=0;
+			std::atomic<uint64_t>			hits={0};
+			std::atomic<uint64_t>			misses={0};
+			std::atomic<uint64_t>			unreported={0};
+			//! Pipelines created since the last save.
+			std::atomic<uint64_t>			unsaved={0};
+			uint64_t						loadedBytes=0;
+			uint64_t						savedBytes=0;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -0,0 +1,223 @@
+#include "Platform/Vulkan/PipelinePrewarmer.h"
+#include "Platform/Vulkan/RenderPlatform.h"
+#include "Platform/Core/RuntimeError.h"
+#include "Platform/Core/StringToWString.h"
+#include "Platform/Core/ThreadPool.h"
+#include <sstream>
+using namespace platform;
+using namespace vulkan;
+
+namespace
+{
+	// Fields are tab-separated, one pipeline per line; lines starting with # are comments.
+	const char *pipelineStateHeader="# Pipeline states v1: effect technique pass hash format samples topology targets depth layout layoutHash stride inputs";
+
+	std::ifstream OpenForReading(const char *filename_utf8)
+	{
+#ifdef _MSC_VER
+		return std::ifstream(platform::core::Utf8ToWString(filename_utf8).c_str());
+#else
+		return std::ifstream(filename_utf8);
+#endif
+	}
+}
+
+PipelinePrewarmer::PipelinePrewarmer()
+{
+}
+
+PipelinePrewarmer::~PipelinePrewarmer()
+{
+	Wait();
+	StopRecording();
+}
+
+std::string PipelinePrewarmer::ToString(const PipelineStateRecord &r)
+{
+	const EffectPass::PipelineDesc &d=r.desc;
+	std::ostringstream s;
+	s<<r.effect<<'\t'<<r.technique<<'\t'<<r.pass<<'\t'<<r.hash
+		<<'\t'<<(int)d.pixelFormat<<'\t'<<d.numOfSamples<<'\t'<<(int)d.topology
+		<<'\t'<<d.numRenderTargets<<'\t'<<(d.hasDepthTarget?1:0)<<'\t'<<(d.hasLayout?1:0)
+		<<'\t'<<d.layoutHash<<'\t'<<d.layoutStride<<'\t'<<d.vertexInputs.size();
+	for(const auto &i:d.vertexInputs)
+		s<<'\t'<<(int)i.first<<'\t'<<i.second;
+	return s.str();
+}
+
+bool PipelinePrewarmer::FromString(const std::string &line,PipelineStateRecord &r)
+{
+	if(!line.length()||line[0]=='#')
+		return false;
+	std::vector<std::string> fields;
+	size_t start=0;
+	while(start<=line.length())
+	{
+		size_t tab=line.find('\t',start);
+		if(tab==std::string::npos)
+			tab=line.length();
+		fields.push_back(line.substr(start,tab-start));
+		start=tab+1;
+	}
+	if(fields.size()<13)
+		return false;
+	try
+	{
+		r.effect=fields[0];
+		r.technique=fields[1];
+		r.pass=fields[2];
+		r.hash=std::stoull(fields[3]);
+		EffectPass::PipelineDesc &d=r.desc;
+		d.pixelFormat=(crossplatform::PixelFormat)std::stoi(fields[4]);
+		d.numOfSamples=std::stoi(fields[5]);
+		d.topology=(crossplatform::Topology)std::stoi(fields[6]);
+		d.numRenderTargets=std::stoi(fields[7]);
+		d.hasDepthTarget=std::stoi(fields[8])!=0;
+		d.hasLayout=std::stoi(fields[9])!=0;
+		d.layoutHash=std::stoull(fields[10]);
+		d.layoutStride=std::stoi(fields[11]);
+		size_t numInputs=(size_t)std::stoul(fields[12]);
+		if(fields.size()!=13+2*numInputs)
+			return false;
+		d.vertexInputs.clear();
+		for(size_t i=0;i<numInputs;i++)
+			d.vertexInputs.push_back({(crossplatform::PixelFormat)std::stoi(fields[13+2*i]),std::stoi(fields[14+2*i])});
+	}
+	catch(...)
+	{
+		return false;
+	}
+	return r.effect.length()&&r.technique.length();
+}
+
+bool PipelinePrewarmer::StartRecording(const char *filename_utf8)
+{
+	std::lock_guard<std::mutex> lock(recordMutex);
+	if(recordFile.is_open())
+		recordFile.close();
+	recorded.clear();
+	// Keep what an earlier run recorded, so that several QA passes accumulate into one file.
+	bool exists=false;
+	{
+		std::ifstream ifs=OpenForReading(filename_utf8);
+		std::string line;
+		while(std::getline(ifs,line))
+		{
+			exists=true;
+			PipelineStateRecord r;
+			if(FromString(line,r))
+				recorded.insert(line);
+		}
+	}
+#ifdef _MSC_VER
+	recordFile.open(platform::core::Utf8ToWString(filename_utf8).c_str(),std::ios::app);
+#else
+	recordFile.open(filename_utf8,std::ios::app);
+#endif
+	if(!recordFile.good())
+	{
+		SIMUL_CERR<<"PipelinePrewarmer: can't open "<<filename_utf8<<" for recording.\n";
+		recordFile.close();
+		return false;
+	}
+	if(!exists)
+		recordFile<<pipelineStateHeader<<"\n";
+	recording=true;
+	return true;
+}
+
+void PipelinePrewarmer::StopRecording()
+{
+	std::lock_guard<std::mutex> lock(recordMutex);
+	recording=false;
+	if(recordFile.is_open())
+		recordFile.close();
+	recorded.clear();
+}
+
+void PipelinePrewarmer::Record(EffectPass *pass,const EffectPass::PipelineDesc &desc,RenderPassHash hash)
+{
+	crossplatform::Effect *effect=pass?pass->GetEffect():nullptr;
+	if(!effect)
+		return;
+	PipelineStateRecord r;
+	r.effect=effect->GetName();
+	r.pass=pass->name;
+	r.hash=hash;
+	r.desc=desc;
+	// Passes don't know their technique, so find it.
+	for(const auto &t:effect->techniques)
+	{
+		for(const auto &p:t.second->passes_by_name)
+		{
+			if(p.second==pass)
+			{
+				r.technique=t.first;
+				if(r.pass.empty())
+					r.pass=p.first;
+				break;
+			}
+		}
+		if(r.technique.length())
+			break;
+	}
+	if(!r.technique.length())
+		return;
+	std::string line=ToString(r);
+	std::lock_guard<std::mutex> lock(recordMutex);
+	if(!recordFile.is_open()||!recorded.insert(line).second)
+		return;
+	// Flush every line: QA runs are as likely as not to end in a crash.
+	recordFile<<line<<std::endl;
+}
+
+uint32_t PipelinePrewarmer::Prewarm(RenderPlatform *renderPlatform,const char *filename_utf8)
+{
+	std::ifstream ifs=OpenForReading(filename_utf8);
+	if(!ifs.good())
+		return 0;
+	uint32_t queued=0;
+	std::string line;
+	while(std::getline(ifs,line))
+	{
+		PipelineStateRecord r;
+		if(!FromString(line,r))
+			continue;
+		crossplatform::Effect *effect=renderPlatform->GetEffect(r.effect.c_str());
+		crossplatform::EffectTechnique *technique=effect?effect->GetTechniqueByName(r.technique.c_str()):nullptr;
+		vulkan::EffectPass *pass=technique?(vulkan::EffectPass*)technique->GetPass(r.pass.c_str()):nullptr;
+		// A different hash means the pass's render states have changed since recording.
+		if(!pass||pass->GetHash(r.desc)!=r.hash||!pass->PreparePrewarm())
+		{
+			skipped++;
+			continue;
+		}
+		total++;
+		queued++;
+		jobs.push_back(core::ThreadPool::Get().Submit([this,pass,r]()
+		{
+			if(pass->PrewarmPipeline(r.hash,r.desc))
+				completed++;
+			else
+				failed++;
+		}));
+	}
+	return queued;
+}
+
+void PipelinePrewarmer::Wait()
+{
+	for(auto &j:jobs)
+		j.wait();
+	jobs.clear();
+}
+
+PipelinePrewarmProgress PipelinePrewarmer::GetProgress() const
+{
+	PipelinePrewarmProgress p;
+	p.total=total;
+	p.completed=completed;
+	p.skipped=skipped;
+	p.failed=failed;
+	return p;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "Platform/Vulkan/Export.h"
+#include "Platform/Vulkan/EffectPass.h"
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace vulkan
+	{
+		class RenderPlatform;
+		//! One pipeline as seen at runtime: the pass that used it, and the state it was built for.
+		struct PipelineStateRecord
+		{
+			std::string effect;
+			std::string technique;
+			std::string pass;
+			RenderPassHash hash=0;
+			EffectPass::PipelineDesc desc;
+		};
+		struct PipelinePrewarmProgress
+		{
+			uint32_t total=0;		//!< Pipelines queued for creation.
+			uint32_t completed=0;	//!< Pipelines created, or found already created.
+			uint32_t skipped=0;		//!< Records whose effect, technique or pass is not loaded, or whose state has changed.
+			uint32_t failed=0;		//!< Pipelines the driver failed to create.
+			bool IsDone() const
+			{
+				return completed+failed>=total;
+			}
+		};
+		//! Records the pipelines that a run creates, and replays such a list on worker threads so that
+		//! a later run creates them before they are first needed, rather than hitching mid-frame.
+		//! Recording is meant for QA runs that cover the content; the resulting file ships with the build.
+		class SIMUL_VULKAN_EXPORT PipelinePrewarmer
+		{
+		public:
+			PipelinePrewarmer();
+			~PipelinePrewarmer();
+			//! Append every newly-created pipeline to \a filename_utf8. Records already in the file are not repeated.
+			bool StartRecording(const char *filename_utf8);
+			void StopRecording();
+			bool IsRecording() const
+			{
+				return recording;
+			}
+			//! Called by EffectPass when it creates a pipeline.
+			void Record(EffectPass *pass,const EffectPass::PipelineDesc &desc,RenderPassHash hash);
+			//! Queue creation of the pipelines listed in \a filename_utf8. Only effects already loaded are warmed;
+			//! call this after loading them. Returns the number of pipelines queued. Call from the render thread.
+			uint32_t Prewarm(RenderPlatform *renderPlatform,const char *filename_utf8);
+			//! Block until all queued pipelines have been created.
+			void Wait();
+			PipelinePrewarmProgress GetProgress() const;
+
+			static std::string ToString(const PipelineStateRecord &record);
+			//! Parse one line of a recording. Returns false for comments and malformed lines.
+			static bool FromString(const std::string &line,PipelineStateRecord &record);
+		private:
+			std::mutex						recordMutex;
+			std::atomic<bool>				recording={false};
+			std::ofstream					recordFile;
+			std::set<std::string>			recorded;
+			std::vector<std::future<void>>	jobs;
+			std::atomic<uint32_t>			total={0};
+			std::atomic<uint32_t>			completed={0};
+			std::atomic<uint32_t>			skipped={0};
+			std::atomic<uint32_t>			failed={0};
+		};
+	}
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
@@ -5,11 +5,8 @@ using namespace platform;
 using namespace vulkan;
 
 
-PlatformConstantBuffer::PlatformConstantBuffer(crossplatform::ResourceUsageFrequency F) : crossplatform::PlatformConstantBuffer(F),
-			mSlots(0)
-			,mMaxAppliesPerFrame(0)
-			,mLastFrameIndex(0)
-			,mCurApplyCount(0)
+PlatformConstantBuffer::PlatformConstantBuffer(crossplatform::ResourceUsageFrequency F) : crossplatform::PlatformConstantBuffer(F)
+			,mLastFrameIndex(-1)
 			,src(0)
 			,size(0)
 	,last_offset(0)
@@ -24,125 +21,95 @@ PlatformConstantBuffer::~PlatformConstantBuffer()
 
 void PlatformConstantBuffer::RestoreDeviceObjects(crossplatform::RenderPlatform* r,size_t sz,void *addr)
 {
+	InvalidateDeviceObjects();
 	renderPlatform = r;
-	if (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE || resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE_PER_FRAME)
-	{
-		//TODO: is this efficient?
-		mBufferSize = (unsigned)sz + 4*kBufferAlign;
-	}
-
-	SIMUL_ASSERT(sz<=mBufferSize);
-	mSlots = unsigned(((sz + size_t(kBufferAlign - 1)) & ~size_t(kBufferAlign - 1)) / size_t(kBufferAlign));
-	SIMUL_ASSERT(mSlots>0);
-	mMaxAppliesPerFrame = mBufferSize / (kBufferAlign * mSlots);
-	SIMUL_ASSERT(mMaxAppliesPerFrame>0);
-
-	vk::BufferCreateInfo buf_info = vk::BufferCreateInfo()
-		.setSize(mBufferSize)
-		.setUsage(vk::BufferUsageFlagBits::eUniformBuffer)
-		.setSharingMode(vk::SharingMode::eExclusive);
-	vulkan::RenderPlatform *vrp = static_cast<vulkan::RenderPlatform*>(renderPlatform);
-	vk::Device *vulkanDevice = vrp->AsVulkanDevice();
-	for (unsigned int i = 0; i < kNumBuffers; i++)
+	size = sz;
+	mSlotSize = unsigned((sz + size_t(kBufferAlign - 1)) & ~size_t(kBufferAlign - 1));
+	SIMUL_ASSERT(mSlotSize>0);
+	if (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE)
 	{
-		vrp->PushToReleaseManager(mBuffers[i], &(mAllocationInfo[i]));
-
-		std::string name = "ConstantBuffer " + std::to_string(i);
-		vrp->CreateVulkanBuffer(mBufferSize, vk::BufferUsageFlagBits::eUniformBuffer, 
+		vulkan::RenderPlatform *vrp = static_cast<vulkan::RenderPlatform*>(renderPlatform);
+		vrp->CreateVulkanBuffer(mSlotSize * kNumBuffers, vk::BufferUsageFlagBits::eUniformBuffer, 
 								vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-								mBuffers[i], mAllocationInfo[i], name.c_str());
-		if(addr)
-		{
-			void *pData = nullptr;
-			vmaMapMemory(mAllocationInfo[i].allocator, mAllocationInfo[i].allocation, &pData);
-			SIMUL_ASSERT(pData != nullptr);
-			memcpy(pData, addr, sz);
-
-			vmaUnmapMemory(mAllocationInfo[i].allocator, mAllocationInfo[i].allocation);
-		}
+								mOnceBuffer, mOnceAllocationInfo, "ConstantBuffer ONCE");
+		vmaMapMemory(mOnceAllocationInfo.allocator, mOnceAllocationInfo.allocation, (void **)&mOnceMapped);
+		SIMUL_ASSERT(mOnceMapped != nullptr);
 	}
-
-	lastBuffer=nullptr;
-	last_offset=0;
-	size=sz;
-	last_offset=0;
+	// Everything else is uploaded through the RenderPlatform's per-frame ring on first apply.
+	src = addr;
+	mPending = (addr != nullptr);
+	lastBuffer = nullptr;
+	last_offset = 0;
+	mOnceIndex = 0;
+	mLastFrameIndex = -1;
 }
 
 void PlatformConstantBuffer::InvalidateDeviceObjects()
 {
 	if(!renderPlatform)
 		return;
-	vk::Device *vulkanDevice = ((vulkan::RenderPlatform *)renderPlatform)->AsVulkanDevice();
 	vulkan::RenderPlatform* r = static_cast<vulkan::RenderPlatform*>(renderPlatform);
-	if(!vulkanDevice)
-		return;
-	for (uint32_t i = 0; i < kNumBuffers; i++)
-	{
-		r->PushToReleaseManager(mBuffers[i], &(mAllocationInfo[i]));
-	}
+	if (mOnceMapped)
+		vmaUnmapMemory(mOnceAllocationInfo.allocator, mOnceAllocationInfo.allocation);
+	mOnceMapped = nullptr;
+	r->PushToReleaseManager(mOnceBuffer, &mOnceAllocationInfo);
+	mOnceBuffer = nullptr;
+	lastBuffer = nullptr;
 	renderPlatform=nullptr;
 }
 
 void PlatformConstantBuffer::Apply(platform::crossplatform::DeviceContext& deviceContext,size_t sz,void* addr)
 {
 	src=addr;
-	//size=sz;
+	mPending=true;
+}
+
+void PlatformConstantBuffer::ApplyOnce()
+{
+	if (!mOnceMapped)
+		return;
+	if (lastBuffer && !changed)
+		return;
+	changed = false;
+	// Each change goes to the next copy, leaving the previous ones intact for frames still in flight.
+	if (lastBuffer)
+		mOnceIndex = (mOnceIndex + 1) % kNumBuffers;
+	last_offset = size_t(mSlotSize) * mOnceIndex;
+	memcpy(mOnceMapped + last_offset, src, size);
+	lastBuffer = &mOnceBuffer;
+	mPending = false;
 }
 
 void PlatformConstantBuffer::ActualApply(crossplatform::DeviceContext &deviceContext) 
 {
-	if(!src)
+	if(!src||!renderPlatform)
 		return;
-	if (!changed)
+	if (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE)
 	{
-		if(resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE && mCurApplyCount > 0)
-			return;
-		if (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE_PER_FRAME && mCurApplyCount > 0)
+		ApplyOnce();
+		return;
+	}
+	// Data uploaded in an earlier frame may since have been overwritten in the ring, so a new frame always uploads.
+	int64_t frameNumber = renderPlatform->GetFrameNumber();
+	if (lastBuffer && mLastFrameIndex == frameNumber)
+	{
+		if (!mPending)
 			return;
-		if (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::FEW_PER_FRAME && mCurApplyCount > 0)
+		if (!changed && (resourceUsageFrequency == crossplatform::ResourceUsageFrequency::ONCE_PER_FRAME
+			|| resourceUsageFrequency == crossplatform::ResourceUsageFrequency::FEW_PER_FRAME))
 			return;
 	}
 	changed=false;
-	bool resetframe=false;
-	vk::Device *vulkanDevice=((vulkan::RenderPlatform*)renderPlatform)->AsVulkanDevice();
-	if (mCurApplyCount >= mMaxAppliesPerFrame)
-	{
-		// This should really be solved by having some kind of pool? Or allocating more space, something like that
-		//SIMUL_BREAK_ONCE("This ConstantBuffer reached its maximum apply count");
-		mBufferSize*=2;
-		RestoreDeviceObjects(renderPlatform,size,nullptr);
-		resetframe=true;
-		//return;
-	}
-
-	auto rPlat = (vulkan::RenderPlatform*)renderPlatform;
-	// If new frame, update current frame index and reset the apply count
-	if (mLastFrameIndex != renderPlatform->GetFrameNumber())
-	{
-		resetframe = true;
-	}
-	if(resetframe)
-	{
-		mLastFrameIndex = renderPlatform->GetFrameNumber();
-		mCurApplyCount = 0;
-		currentFrameIndex++;
-		currentFrameIndex = currentFrameIndex % (kNumBuffers);
-	}
-
-	last_offset = (kBufferAlign * mSlots) * mCurApplyCount;	
-	lastBuffer = &mBuffers[currentFrameIndex];
-	const AllocationInfo &_allocationInfo = mAllocationInfo[currentFrameIndex];
-
-	uint8_t *pData = nullptr;
-	vmaMapMemory(_allocationInfo.allocator, _allocationInfo.allocation, (void **)&pData);
-	if(pData)
-	{
-		memcpy(pData + last_offset, src, size);
-		vmaUnmapMemory(_allocationInfo.allocator, _allocationInfo.allocation);
-	}
-	
-	mCurApplyCount++;
-	src=0;
+	vk::Buffer *buffer = nullptr;
+	size_t offset = 0;
+	void *pData = ((vulkan::RenderPlatform*)renderPlatform)->GetUploadRing().Allocate(size, 0, buffer, offset);
+	if(!pData)
+		return;
+	memcpy(pData, src, size);
+	lastBuffer = buffer;
+	last_offset = offset;
+	mLastFrameIndex = frameNumber;
+	mPending = false;
 }
 
 size_t PlatformConstantBuffer::GetLastOffset()
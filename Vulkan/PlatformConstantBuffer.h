@@ -32,25 +32,25 @@ namespace platform
 			vk::Buffer *GetLastBuffer();
 			size_t GetSize();
 		private:
-			//! Total allocated size for each buffer
-			unsigned						mBufferSize = 1024 * 64 * 8;
-			//! Number of ring buffers
+			//! Buffers used ONCE keep their own memory, as their data must outlive the upload ring's frames.
+			void							ApplyOnce();
+			//! Number of copies of a ONCE buffer, so that a change can't overwrite data the GPU is still reading.
 			static const unsigned			kNumBuffers = (SIMUL_VULKAN_FRAME_LAG+1);
-			unsigned						mSlots;					//number of 256-byte chunks of memory...
-			unsigned						mMaxAppliesPerFrame=0;
+			unsigned						mSlotSize = 0;
+			unsigned						mOnceIndex = 0;
+			vk::Buffer						mOnceBuffer;
+			AllocationInfo					mOnceAllocationInfo;
+			uint8_t							*mOnceMapped = nullptr;
 
 			int64_t							mLastFrameIndex;
-			unsigned						mCurApplyCount;
-
-			vk::Buffer 						mBuffers[kNumBuffers];
-			AllocationInfo					mAllocationInfo[kNumBuffers];
+			//! Set by Apply(), cleared once the data has been uploaded.
+			bool							mPending = false;
 
 			const int kBufferAlign			= 256;
 			void *src;
 			size_t size;
 			size_t last_offset;
 			vk::Buffer *lastBuffer;
-			unsigned char currentFrameIndex = 0;
 		};
 	}
 }
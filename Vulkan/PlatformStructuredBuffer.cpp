@@ -101,6 +101,8 @@ void* PlatformStructuredBuffer::GetBuffer(crossplatform::DeviceContext& deviceCo
 {
 	if (!buffer)
 		buffer = new unsigned char[mTotalSize];
+	// The caller may write through the pointer.
+	mRingDirty = true;
 	return buffer;
 }
 
@@ -138,11 +140,31 @@ void PlatformStructuredBuffer::SetData(crossplatform::DeviceContext& deviceConte
 		if(!buffer)
 			buffer = new unsigned char[mTotalSize];
 		memcpy(buffer,data,mTotalSize);
+		mRingDirty = true;
 	}
 }
 
 void PlatformStructuredBuffer::ActualApply(crossplatform::DeviceContext &deviceContext,bool as_uav) 
 {
+	// CPU-written data that is only read this frame goes through the shared upload ring. Buffers that are read back,
+	// or written once, keep their own memory so that the data outlives the ring's frames.
+	if (!as_uav && buffer && !mCpuRead && bufferUsageHint != crossplatform::ResourceUsageFrequency::ONCE)
+	{
+		// Unchanged data already uploaded this frame is bound again rather than copied.
+		int64_t frameNumber = renderPlatform->GetFrameNumber();
+		if (mLastFromRing && !mRingDirty && mRingFrame == frameNumber)
+			return;
+		void *pData = ((vulkan::RenderPlatform*)renderPlatform)->GetUploadRing().Allocate(mTotalSize, 0, mRingBuffer, mRingOffset);
+		if (pData)
+		{
+			memcpy(pData, buffer, mTotalSize);
+			mLastFromRing = true;
+			mRingDirty = false;
+			mRingFrame = frameNumber;
+			return;
+		}
+	}
+	mLastFromRing = false;
 	vk::Device *vulkanDevice = ((vulkan::RenderPlatform *)renderPlatform)->AsVulkanDevice();
 	if (mCurApplyCount >= mMaxApplyCount)
 	{
@@ -242,6 +264,8 @@ void PlatformStructuredBuffer::InvalidateDeviceObjects()
 	{
 		rPlat->PushToReleaseManager(mReadBuffers[i], &(mReadBufferAllocationInfo[i]));
 	}
+	mLastFromRing=false;
+	mRingBuffer=nullptr;
 	renderPlatform=nullptr;
 	delete [] buffer;
 	buffer=nullptr;
@@ -249,11 +273,15 @@ void PlatformStructuredBuffer::InvalidateDeviceObjects()
 
 size_t PlatformStructuredBuffer::GetLastOffset()
 {
+	if (mLastFromRing)
+		return mRingOffset;
 	return last_offset;
 }
 
 vk::Buffer *PlatformStructuredBuffer::GetLastBuffer()
 {
+	if (mLastFromRing)
+		return mRingBuffer;
 	return &lastBuffer->mBuffer;
 }
 
@@ -80,6 +80,13 @@ namespace platform
 			bool							mCpuRead;
 			void							AddPerFrameBuffer(const void *init_data);
 			uint64_t						mLastFrame;
+			//! Set when the last apply uploaded through the RenderPlatform's upload ring rather than a per-frame buffer.
+			bool							mLastFromRing = false;
+			vk::Buffer						*mRingBuffer = nullptr;
+			size_t							mRingOffset = 0;
+			int64_t							mRingFrame = -1;
+			//! Set when the CPU copy may have changed since it was last uploaded.
+			bool							mRingDirty = true;
 			int	mFrameIndex;
 		};
 	}
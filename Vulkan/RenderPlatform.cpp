@@ -12,6 +12,7 @@
 #include "Platform/Core/DefaultFileLoader.h"
 #include "Platform/CrossPlatform/Macros.h"
 #include "Platform/CrossPlatform/Texture.h"
+#include "Platform/CrossPlatform/TextureCapture.h"
 #include "Platform/Vulkan/Texture.h"
 #include "Platform/Vulkan/DisplaySurface.h"
 #include "DeviceManager.h"
@@ -89,6 +90,14 @@ void RenderPlatform::RestoreDeviceObjects(void *vkDevice_vkInstance_gpu)
 	allocatorCreateInfo.preferredLargeHeapBlockSize = mGPUPreferredBlockSize = 256 * 1048576;
 	SIMUL_VK_CHECK((vk::Result)vmaCreateAllocator(&allocatorCreateInfo, &mGPUAllocator));
 
+	bool creationFeedback=CheckDeviceExtension(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+#ifdef VK_API_VERSION_1_3
+	// Promoted to core in Vulkan 1.3.
+	creationFeedback|=(GetInstanceAPIVersion()>=VK_API_VERSION_1_3&&GetPhysicalDeviceAPIVersion()>=VK_API_VERSION_1_3);
+#endif
+	pipelineCache.RestoreDeviceObjects(vulkanDevice,vulkanGpu,pipelineCacheFilename,creationFeedback);
+	uploadRing.RestoreDeviceObjects(this);
+
 	crossplatform::RenderPlatform::RestoreDeviceObjects(nullptr);
 
 	// Load debug markers PFNs.
@@ -257,6 +266,9 @@ void RenderPlatform::InvalidateDeviceObjects()
 {
 	if (!vulkanDevice)
 		return;
+	// Pipelines still being built on worker threads must finish before the passes go.
+	pipelinePrewarmer.Wait();
+	pipelinePrewarmer.StopRecording();
 	
 	vulkanDevice->waitIdle();
 
@@ -284,7 +296,9 @@ void RenderPlatform::InvalidateDeviceObjects()
 		vulkanDevice->destroyDescriptorPool(mDescriptorPools[g], nullptr);
 	}
 
+	uploadRing.InvalidateDeviceObjects();
 	ClearReleaseManager(true);
+	pipelineCache.InvalidateDeviceObjects();
 
 	vmaDestroyAllocator(mGPUAllocator);
 	vmaDestroyAllocator(mCPUAllocator);
@@ -431,6 +445,8 @@ void RenderPlatform::ClearReleaseManager(bool force)
 				vulkanDevice->destroyDescriptorSetLayout(*(vk::DescriptorSetLayout *)&i, nullptr); break;
 			case vk::ObjectType::eDescriptorPool:
 				vulkanDevice->destroyDescriptorPool(*(vk::DescriptorPool *)&i, nullptr); break;
+			case vk::ObjectType::eEvent:
+				vulkanDevice->destroyEvent(*(vk::Event *)&i, nullptr); break;
 			default:
 				SIMUL_BREAK("Unknown vk::ObjectType of vk::ObjectType::e{} (0x{}) in ReleaseManager.", vk::to_string(it->type), i);
 			}
@@ -451,6 +467,7 @@ void RenderPlatform::BeginFrame()
 	if (frame_started)
 		return;
 	crossplatform::RenderPlatform::BeginFrame();
+	pipelineCache.Update(GetFrameNumber());
 	auto *vulkanDevice=AsVulkanDevice();
 	//vulkanDevice->waitForFences(1, &deviceManagerInternal->fences[frame_index], VK_TRUE, UINT64_MAX);
 	//vulkanDevice->resetFences(1, &deviceManagerInternal->fences[frame_index]);
@@ -1246,6 +1263,8 @@ GLenum RenderPlatform::DataType(crossplatform::PixelFormat p)
 		return GL_FLOAT;
 	case R_32_FLOAT:
 		return GL_FLOAT;
+	case RG_16_FLOAT:
+		return GL_FLOAT;
 	case R_16_FLOAT:
 		return GL_FLOAT;
 	case LUM_32_FLOAT:
@@ -1393,6 +1412,8 @@ vk::Format RenderPlatform::ToVulkanFormat(crossplatform::PixelFormat p,crossplat
 		return vk::Format::eR32G32Sfloat;
 	case R_32_FLOAT:
 		return vk::Format::eR32Sfloat;
+	case RG_16_FLOAT:
+		return vk::Format::eR16G16Sfloat;
 	case R_16_FLOAT:
 		return vk::Format::eR16Sfloat;
 	case LUM_32_FLOAT:
@@ -1408,6 +1429,8 @@ vk::Format RenderPlatform::ToVulkanFormat(crossplatform::PixelFormat p,crossplat
 			return vk::Format::eBc1RgbaUnormBlock;
 		case crossplatform::CompressionFormat::BC3:
 			return vk::Format::eBc3UnormBlock;
+		case crossplatform::CompressionFormat::BC7_M6_OPAQUE_ONLY:
+			return vk::Format::eBc7UnormBlock;
 		default:
 			return vk::Format::eR8G8B8A8Unorm;
 		};
@@ -1432,6 +1455,8 @@ vk::Format RenderPlatform::ToVulkanFormat(crossplatform::PixelFormat p,crossplat
 			return vk::Format::eBc1RgbaSrgbBlock;
 		case crossplatform::CompressionFormat::BC3:
 			return vk::Format::eBc3SrgbBlock;
+		case crossplatform::CompressionFormat::BC7_M6_OPAQUE_ONLY:
+			return vk::Format::eBc7SrgbBlock;
 		default:
 			return vk::Format::eR8G8B8A8Srgb;
 		};
@@ -1442,9 +1467,23 @@ vk::Format RenderPlatform::ToVulkanFormat(crossplatform::PixelFormat p,crossplat
 	case RGB_8_SNORM:
 		return vk::Format::eR8G8B8Snorm;
 	case R_8_UNORM:
-		return vk::Format::eR8Unorm;
+		switch (c)
+		{
+		case crossplatform::CompressionFormat::BC4:
+			return vk::Format::eBc4UnormBlock;
+		default:
+			return vk::Format::eR8Unorm;
+		};
 	case R_8_SNORM:
 		return vk::Format::eR8Snorm;
+	case RG_8_UNORM:
+		switch (c)
+		{
+		case crossplatform::CompressionFormat::BC5:
+			return vk::Format::eBc5UnormBlock;
+		default:
+			return vk::Format::eR8G8Unorm;
+		};
 	case R_32_UINT:
 		return vk::Format::eR32Uint;
 	case RG_32_UINT:
@@ -1569,6 +1608,8 @@ int RenderPlatform::FormatTexelBytes(crossplatform::PixelFormat p)
 		return 8;
 	case R_32_FLOAT:
 		return 4;
+	case RG_16_FLOAT:
+		return 4;
 	case R_16_FLOAT:
 		return 2;
 	case LUM_32_FLOAT:
@@ -1622,6 +1663,8 @@ int RenderPlatform::FormatCount(crossplatform::PixelFormat p)
 		return 2;
 	case R_32_FLOAT:
 		return 1;
+	case RG_16_FLOAT:
+		return 2;
 	case R_16_FLOAT:
 		return 1;
 	case LUM_32_FLOAT:
@@ -1796,6 +1839,81 @@ void RenderPlatform::SaveTexture(crossplatform::GraphicsDeviceContext& deviceCon
 	vulkanDevice->destroyBuffer(imageBuffer, nullptr);
 }
 
+namespace platform::vulkan
+{
+	//! A host-visible buffer that the texture is copied into on the GPU timeline. The command buffer sets an event
+	//! after the copy, so it is ready as soon as the GPU has done the copy, however many frames are in flight.
+	struct TextureReadback : public crossplatform::TextureReadback
+	{
+		RenderPlatform *renderPlatform = nullptr;
+		vk::Buffer buffer;
+		vk::DeviceMemory memory;
+		vk::DeviceSize memorySize = 0;
+		vk::Event event;
+		void *mapped = nullptr;
+		~TextureReadback() override
+		{
+			vk::Device *vulkanDevice = renderPlatform->AsVulkanDevice();
+			if (mapped && vulkanDevice)
+				vulkanDevice->unmapMemory(memory);
+			renderPlatform->PushToReleaseManager(buffer);
+			renderPlatform->PushToReleaseManager(memory);
+			renderPlatform->PushToReleaseManager(event);
+		}
+		bool IsReady() const override
+		{
+			return renderPlatform->AsVulkanDevice()->getEventStatus(event) == vk::Result::eEventSet;
+		}
+		const void *Map() override
+		{
+			if (!mapped)
+				mapped = renderPlatform->AsVulkanDevice()->mapMemory(memory, 0, memorySize, vk::MemoryMapFlags(0));
+			return mapped;
+		}
+	};
+}
+
+std::shared_ptr<crossplatform::TextureReadback> RenderPlatform::CreateTextureReadback(crossplatform::GraphicsDeviceContext& deviceContext, crossplatform::Texture* texture)
+{
+	vk::CommandBuffer* cmdBuffer = (vk::CommandBuffer*)deviceContext.platform_context;
+	if (!cmdBuffer || !texture)
+		return nullptr;
+	crossplatform::PixelFormat format = texture->GetFormat();
+	uint64_t texelSize = static_cast<uint64_t>(crossplatform::GetByteSize(format));
+	if (!texelSize)
+		return nullptr;
+	auto readback = std::make_shared<vulkan::TextureReadback>();
+	readback->renderPlatform = this;
+	readback->width = texture->width;
+	readback->length = texture->length;
+	readback->format = format;
+	readback->rowPitch = texture->width * texelSize;
+
+	vk::BufferCreateInfo bufferCI = vk::BufferCreateInfo(vk::BufferCreateFlags(0), readback->GetSize(), vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive, 0, nullptr);
+	readback->buffer = vulkanDevice->createBuffer(bufferCI);
+	vk::MemoryRequirements memoryRequirements;
+	vulkanDevice->getBufferMemoryRequirements(readback->buffer, &memoryRequirements);
+	vk::MemoryAllocateInfo memoryAI = vk::MemoryAllocateInfo(memoryRequirements.size,
+		FindMemoryType(memoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent));
+	readback->memory = vulkanDevice->allocateMemory(memoryAI);
+	readback->memorySize = memoryAI.allocationSize;
+	vulkanDevice->bindBufferMemory(readback->buffer, readback->memory, 0);
+
+	vulkan::Texture* t = (vulkan::Texture*)texture;
+	t->SetLayout(deviceContext, vk::ImageLayout::eTransferSrcOptimal, { crossplatform::TextureAspectFlags::COLOUR, 0, 1, 0, 1 });
+	vk::BufferImageCopy bic = vk::BufferImageCopy(0, 0, 0,
+		{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+		{ 0, 0, 0 },
+		{ (uint32_t)texture->width, (uint32_t)texture->length, 1 });
+	cmdBuffer->copyImageToBuffer(*t->AsVulkanImage(), vk::ImageLayout::eTransferSrcOptimal, readback->buffer, 1, &bic);
+	// Make the copy visible to the host, then signal that it's done.
+	vk::MemoryBarrier hostBarrier = vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+	cmdBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, vk::DependencyFlags(), 1, &hostBarrier, 0, nullptr, 0, nullptr);
+	readback->event = vulkanDevice->createEvent(vk::EventCreateInfo());
+	cmdBuffer->setEvent(readback->event, vk::PipelineStageFlagBits::eTransfer);
+	return readback;
+}
+
 void RenderPlatform::RestoreColourTextureState(crossplatform::DeviceContext& deviceContext, crossplatform::Texture* tex)
 {
 	if (!tex)
@@ -1916,6 +2034,17 @@ void RenderPlatform::DrawIndexed(crossplatform::GraphicsDeviceContext &deviceCon
 	//EndEvent(deviceContext);
 }
 
+bool RenderPlatform::DrawIndexedInstanced(crossplatform::GraphicsDeviceContext &deviceContext,int num_indices,int num_instances,int start_index,int base_vertex)
+{
+	vk::CommandBuffer* commandBuffer = (vk::CommandBuffer*)deviceContext.platform_context;
+	if (!commandBuffer)
+		return false;
+	if(!ApplyContextState(deviceContext))
+		return false;
+	commandBuffer->drawIndexed(num_indices,num_instances,start_index,base_vertex,0);
+	return true;
+}
+
 void RenderPlatform::GenerateMips(crossplatform::GraphicsDeviceContext& deviceContext, crossplatform::Texture* t, bool wrap, int array_idx)
 {
 	t->GenerateMips(deviceContext);
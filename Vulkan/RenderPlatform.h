@@ -8,6 +8,9 @@
 #include "Platform/CrossPlatform/Texture.h"
 #include "Platform/CrossPlatform/PixelFormat.h"
 #include "Platform/Vulkan/Allocation.h"
+#include "Platform/Vulkan/PipelineCache.h"
+#include "Platform/Vulkan/PipelinePrewarmer.h"
+#include "Platform/Vulkan/UploadRing.h"
 
 #ifdef _MSC_VER
 	#pragma warning(push)
@@ -156,6 +159,8 @@ namespace platform
 			
 			void									Draw(crossplatform::GraphicsDeviceContext& deviceContext, int num_verts, int start_vert) override;
 			void									DrawIndexed(crossplatform::GraphicsDeviceContext& deviceContext, int num_indices, int start_index = 0, int base_vertex = 0) override;
+			bool									HasInstancedDraws() const override { return true; }
+			bool									DrawIndexedInstanced(crossplatform::GraphicsDeviceContext& deviceContext, int num_indices, int num_instances, int start_index = 0, int base_vertex = 0) override;
 			void									DrawQuad(crossplatform::GraphicsDeviceContext& deviceContext) override;
 			void									GenerateMips(crossplatform::GraphicsDeviceContext& deviceContext, crossplatform::Texture* t, bool wrap, int array_idx = -1)override;
 			//! This should be called after a Draw/Dispatch command that uses
@@ -191,6 +196,32 @@ namespace platform
 			void									SetStandardRenderState(crossplatform::DeviceContext& deviceContext, crossplatform::StandardRenderState s)override;
 			void									Resolve(crossplatform::GraphicsDeviceContext &deviceContext,crossplatform::Texture *destination,crossplatform::Texture *source) override;
 			void									SaveTexture(crossplatform::GraphicsDeviceContext&,crossplatform::Texture *texture,const char *lFileNameUtf8) override;
+			std::shared_ptr<crossplatform::TextureReadback> CreateTextureReadback(crossplatform::GraphicsDeviceContext&,crossplatform::Texture *texture) override;
+			//! Set the file that the shared pipeline cache is loaded from and saved to. Call before RestoreDeviceObjects. Empty, the default, keeps the cache in memory only.
+			void SetPipelineCacheFilename(const char *filename_utf8)
+			{
+				pipelineCacheFilename=filename_utf8?filename_utf8:"";
+			}
+			//! The device-wide pipeline cache used by every EffectPass.
+			PipelineCache &GetPipelineCache()
+			{
+				return pipelineCache;
+			}
+			//! The per-frame ring that constant buffers and dynamic buffers upload through.
+			UploadRing &GetUploadRing()
+			{
+				return uploadRing;
+			}
+			//! Usage of the upload ring, including the high-water mark of bytes uploaded in one frame.
+			UploadRingStats GetUploadRingStats() const
+			{
+				return uploadRing.GetStats();
+			}
+			//! Records the pipelines created in a run, and creates recorded ones ahead of use on worker threads.
+			PipelinePrewarmer &GetPipelinePrewarmer()
+			{
+				return pipelinePrewarmer;
+			}
 			void									RestoreColourTextureState(crossplatform::DeviceContext& deviceContext, crossplatform::Texture* tex) override;
 			void									RestoreDepthTextureState(crossplatform::DeviceContext& deviceContext, crossplatform::Texture* tex) override;
 			
@@ -304,6 +335,10 @@ namespace platform
 			vk::PhysicalDevice*								vulkanGpu=nullptr;
 			vk::Device*										vulkanDevice=nullptr;
 			vk::Sampler										vulkanSamplerYcbcr;
+			PipelineCache									pipelineCache;
+			std::string										pipelineCacheFilename;
+			PipelinePrewarmer								pipelinePrewarmer;
+			UploadRing										uploadRing;
 
 			bool											resourcesToBeReleased=false;
 			std::set <ReleaseResourceInfo>					releaseResources;
@@ -5,6 +5,10 @@
 
 #include "Platform/Core/FileLoader.h"
 #include "Platform/Core/StringFunctions.h"
+#include "Platform/Core/ThreadPool.h"
+#include "Platform/CrossPlatform/BlockCompression.h"
+#include "Platform/CrossPlatform/ImagePipeline.h"
+#include "Platform/CrossPlatform/TextureCache.h"
 #include <magic_enum/magic_enum.hpp>
 
 #include <algorithm>
@@ -95,11 +99,13 @@ bool Texture::LoadFromFile(crossplatform::RenderPlatform *r, const char *pFilePa
 	InvalidateDeviceObjects();
 	std::vector<std::string> texture_files;
 	texture_files.push_back(pFilePathUtf8);
-	return LoadTextureArray(r,texture_files,gen_mips?0:1);
+	return LoadTextureArray(r,texture_files,gen_mips);
 }
 
 bool Texture::LoadTextureArray(crossplatform::RenderPlatform *r, const std::vector<std::string> &texture_files, bool gen_mips)
 {
+	if(gen_mips&&r->IsCpuTextureMipsEnabled()&&LoadTextureArrayWithCpuMips(r,texture_files))
+		return true;
 	InvalidateDeviceObjects();
 	renderPlatform= r;
 	PushLoadedTexturesToReleaseManager();
@@ -229,11 +235,9 @@ void Texture::FinishLoading(crossplatform::DeviceContext &deviceContext)
 				int rows = lt.y;
 				if(compressionFormat!=crossplatform::CompressionFormat::UNCOMPRESSED)
 				{
-					// must be at least a block size;
-					if(row_texels<4)
-						row_texels=4;
-					if(rows<4)
-						rows=4;
+					// must be a whole number of blocks;
+					row_texels=(row_texels+3)&~3;
+					rows=(rows+3)&~3;
 				}
 
 				vk::Offset3D offset = { 0, 0, 0 };
@@ -582,8 +586,10 @@ bool Texture::ensureTexture2DSizeAndFormat(crossplatform::RenderPlatform* r, int
 			uint32_t n = CalculateSubresourceIndex(i, 0, 0, mips, 1);
 			LoadedTexture& loadedTexture=mLoadedTextures[i][0];
 			SetTextureData(loadedTexture, (*data)[i].data(), mip_width, mip_length, 1, 0, pixelFormat, compressionFormat);
-			mip_width=(mip_width+1)/2;
-			mip_length=(mip_length+1)/2;
+			// The data is in the upload buffer now, and isn't ours to free.
+			loadedTexture.data=nullptr;
+			mip_width=std::max(1,mip_width/2);
+			mip_length=std::max(1,mip_length/2);
 		}
 		textureUploadComplete=false;
 	}
@@ -683,8 +689,9 @@ bool Texture::ensureTextureArraySizeAndFormat(crossplatform::RenderPlatform* r,
 				uint32_t n = CalculateSubresourceIndex(j, i, 0, mips, totalNum);
 				LoadedTexture& loadedTexture = mLoadedTextures[j][i];
 				SetTextureData(loadedTexture, (*data)[n].data(), mip_width, mip_length, 1, 0, pixelFormat, compressionFormat);
-				mip_width=(mip_width+1)/2;
-				mip_length=(mip_length+1)/2;
+				loadedTexture.data=nullptr;
+				mip_width=std::max(1,mip_width/2);
+				mip_length=std::max(1,mip_length/2);
 			}
 		}
 		textureUploadComplete=false;
@@ -862,7 +869,7 @@ void Texture::copyToMemory(crossplatform::DeviceContext& deviceContext, void* ta
 
 }
 
-void Texture::LoadTextureData(LoadedTexture &lt,const char* path)
+std::string Texture::FindTextureFile(const char* path)
 {
 	const auto & pathsUtf8= renderPlatform->GetTexturePathsUtf8();
 	int index= platform::core::FileLoader::GetFileLoader()->FindIndexInPathStack(path,pathsUtf8);
@@ -880,12 +887,20 @@ void Texture::LoadTextureData(LoadedTexture &lt,const char* path)
 		if (index < -1 || index >= (int)pathsUtf8.size())
 		{
 			SIMUL_CERR<<"Failed to find texture file "<<filenameInUseUtf8<<std::endl;
-			return;
+			return "";
 		}
 		filenameInUseUtf8=file;
 	}
-	if(index<renderPlatform->GetTexturePathsUtf8().size())
-		filenameInUseUtf8=(renderPlatform->GetTexturePathsUtf8()[index]+"/")+filenameInUseUtf8;
+	if(index>=0&&index<(int)pathsUtf8.size())
+		filenameInUseUtf8=(pathsUtf8[index]+"/")+filenameInUseUtf8;
+	return filenameInUseUtf8;
+}
+
+void Texture::LoadTextureData(LoadedTexture &lt,const char* path)
+{
+	std::string filenameInUseUtf8=FindTextureFile(path);
+	if(filenameInUseUtf8.empty())
+		return;
 
 	int x,y,n;
 	void* buffer=nullptr;
@@ -903,6 +918,140 @@ void Texture::LoadTextureData(LoadedTexture &lt,const char* path)
 	SetTextureData(lt,data,x,y,1,n,crossplatform::PixelFormat::RGBA_8_UNORM);
 }
 
+bool Texture::LoadTextureArrayWithCpuMips(crossplatform::RenderPlatform *r, const std::vector<std::string> &texture_files)
+{
+	InvalidateDeviceObjects();
+	renderPlatform= r;
+	PushLoadedTexturesToReleaseManager();
+	ClearLoadedTextures();
+	size_t num=texture_files.size();
+	if(!num)
+		return false;
+	crossplatform::MipChainSettings settings=r->GetCpuTextureMipSettings();
+	settings.maxMips=settings.maxMips>0?std::min(settings.maxMips,16):16;
+	crossplatform::BlockCompressionSettings compressionSettings=r->GetCpuTextureCompressionSettings();
+	crossplatform::CompressionQuality quality=compressionSettings.quality;
+	bool compress=r->IsCpuTextureCompressionEnabled();
+	if(compress)
+	{
+		// Only compress if the GPU can sample every format the encoder might choose.
+		vk::PhysicalDevice *gpu=((vulkan::RenderPlatform*)r)->GetVulkanGPU();
+		for(int channels=3;channels<=4;channels++)
+		{
+			crossplatform::CompressionFormat cf=crossplatform::BlockCompression::ChooseFormat(channels,quality);
+			vk::Format format=vulkan::RenderPlatform::ToVulkanFormat(crossplatform::BlockCompression::GetPixelFormat(cf),cf);
+			if(!(gpu->getFormatProperties(format).optimalTilingFeatures&vk::FormatFeatureFlagBits::eSampledImage))
+				compress=false;
+		}
+	}
+	bool useCache=compress&&r->IsTextureCacheEnabled();
+	// The layers of an array must share a format, so arrays always use the one with alpha.
+	crossplatform::TextureCacheKey key;
+	key.requestedFormat=num>1?crossplatform::BlockCompression::ChooseFormat(4,quality):crossplatform::CompressionFormat::UNCOMPRESSED;
+	key.quality=quality;
+	key.mipSettings=settings;
+	// Files are read on this thread, as a FileLoader need not be thread-safe; decoding and filtering are spread over the thread pool.
+	std::vector<void*> buffers(num,nullptr);
+	std::vector<unsigned> sizes(num,0);
+	std::vector<std::string> cacheFilenames(num);
+	std::vector<crossplatform::TextureCacheKey> keys(num,key);
+	std::vector<crossplatform::TextureCacheContents> compressed(num);
+	std::vector<bool> cached(num,false);
+	for(size_t i=0;i<num;i++)
+	{
+		std::string filenameInUseUtf8=FindTextureFile(texture_files[i].c_str());
+		if(filenameInUseUtf8.empty())
+			continue;
+		core::FileLoader::GetFileLoader()->AcquireFileContents(buffers[i],sizes[i],filenameInUseUtf8.c_str(),false);
+		if(!useCache||!buffers[i])
+			continue;
+		cacheFilenames[i]=crossplatform::TextureCache::GetCacheFilename(filenameInUseUtf8.c_str());
+		keys[i].sourceHash=crossplatform::TextureCache::HashSource(buffers[i],sizes[i]);
+		std::string reason;
+		cached[i]=crossplatform::TextureCache::Read(cacheFilenames[i].c_str(),keys[i],compressed[i],&reason);
+		if(!cached[i]&&core::FileLoader::GetFileLoader()->FileExists(cacheFilenames[i].c_str()))
+			SIMUL_COUT<<"Not using texture cache "<<cacheFilenames[i].c_str()<<": "<<reason.c_str()<<".\n";
+	}
+	std::vector<std::vector<crossplatform::Image>> chains(num);
+	core::ThreadPool::Get().ParallelFor(num,1,[&](size_t begin,size_t end)
+	{
+		for(size_t i=begin;i<end;i++)
+		{
+			if(cached[i])
+				continue;
+			crossplatform::Image image;
+			// There's no three-channel 8-bit format to upload to, so colour always gets an alpha channel.
+			if(!buffers[i]||!crossplatform::ImagePipeline::Decode(buffers[i],sizes[i],image,4))
+				continue;
+			chains[i]=crossplatform::ImagePipeline::BuildMipChain(image,settings);
+			if(!compress)
+				continue;
+			crossplatform::TextureCacheContents &c=compressed[i];
+			c.format=key.requestedFormat;
+			if(c.format==crossplatform::CompressionFormat::UNCOMPRESSED)
+				c.format=crossplatform::BlockCompression::ChooseFormat(crossplatform::ImagePipeline::CountNeededChannels(image),quality);
+			c.width=image.width;
+			c.height=image.height;
+			if(!crossplatform::BlockCompression::CompressMipChain(chains[i],c.format,c.mips,compressionSettings))
+				c=crossplatform::TextureCacheContents();
+			chains[i].clear();
+		}
+	});
+	for(size_t i=0;i<num;i++)
+	{
+		if(buffers[i])
+			core::FileLoader::GetFileLoader()->ReleaseFileContents(buffers[i]);
+		if(useCache&&!cached[i]&&compressed[i].mips.size()&&!crossplatform::TextureCache::Write(cacheFilenames[i].c_str(),keys[i],compressed[i]))
+			SIMUL_COUT<<"Can't write texture cache "<<cacheFilenames[i].c_str()<<".\n";
+	}
+	name = "Texture array ";
+	for(const auto &f:texture_files)
+	{
+		name += f + ",";
+	}
+	auto data=std::make_shared<std::vector<std::vector<uint8_t>>>();
+	int w,l,m;
+	crossplatform::CompressionFormat cf=crossplatform::CompressionFormat::UNCOMPRESSED;
+	crossplatform::PixelFormat pf=crossplatform::PixelFormat::RGBA_8_UNORM;
+	if(compress)
+	{
+		const crossplatform::TextureCacheContents &c0=compressed[0];
+		for(const auto &c:compressed)
+		{
+			if(c.mips.empty()||c.format!=c0.format||c.width!=c0.width||c.height!=c0.height||c.mips.size()!=c0.mips.size())
+				return false;
+		}
+		w=c0.width;
+		l=c0.height;
+		m=(int)c0.mips.size();
+		cf=c0.format;
+		pf=crossplatform::BlockCompression::GetPixelFormat(cf);
+		for(auto &c:compressed)
+		{
+			for(auto &mip:c.mips)
+				data->push_back(std::move(mip));
+		}
+	}
+	else
+	{
+		for(const auto &c:chains)
+		{
+			if(c.empty()||c[0].width!=chains[0][0].width||c[0].height!=chains[0][0].height)
+				return false;
+		}
+		w=chains[0][0].width;
+		l=chains[0][0].height;
+		m=(int)chains[0].size();
+		for(auto &c:chains)
+			crossplatform::ImagePipeline::AppendInitialData(std::move(c),*data);
+	}
+	if(num<=1)
+		ensureTexture2DSizeAndFormat(r,w,l,m,pf,data,false,false,false,1,0,false,vec4(0.f,0.f,0.f,0.f),1.F,0,false,cf);
+	else
+		ensureTextureArraySizeAndFormat(r,w,l,(int)num,m,pf,data,false,false,false,false,cf);
+	return true;
+}
+
 void Texture::SetTextureData(LoadedTexture &lt,const void *data,int x,int y,int z,int n,crossplatform::PixelFormat f,crossplatform::CompressionFormat cf)
 {
 	lt.data=( unsigned char*)data;
@@ -920,7 +1069,9 @@ void Texture::SetTextureData(LoadedTexture &lt,const void *data,int x,int y,int
 	{
 	case crossplatform::CompressionFormat::BC1:
 	case crossplatform::CompressionFormat::BC3:
+	case crossplatform::CompressionFormat::BC4:
 	case crossplatform::CompressionFormat::BC5:
+	case crossplatform::CompressionFormat::BC7_M6_OPAQUE_ONLY:
 	case crossplatform::CompressionFormat::ETC1:
 	case crossplatform::CompressionFormat::ETC2:
 		{
@@ -928,7 +1079,10 @@ void Texture::SetTextureData(LoadedTexture &lt,const void *data,int x,int y,int
 		// of a row of blocks in the case of the compressed.
 			size_t block_width		=std::max(1,(x+3)/4);
 			size_t block_height		=std::max(1,(y+3)/4);
-			size_t block_size_bytes=(bytesPerTexel==4)?16:8;
+			// The size of a BCn block depends on the format, not on the pixel format it's created with.
+			size_t block_size_bytes=crossplatform::BlockCompression::GetBlockBytes(cf);
+			if(!block_size_bytes)
+				block_size_bytes=(bytesPerTexel==4)?16:8;
 			SysMemPitch				= block_size_bytes*block_width;
 			// buffer must be at least one block in size.
 			bufferSize				= std::max(block_size_bytes,SysMemPitch*block_height);
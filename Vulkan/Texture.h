@@ -112,7 +112,11 @@ namespace platform
 			void			InvalidateDeviceObjectsExceptLoaded();
 			bool			IsSame(int w, int h, int d, int arr, int, crossplatform::PixelFormat f, int msaa_samples, bool computable, bool rt, bool ds, bool cb = false);
 
+			//! The full path of a texture file in the render platform's texture paths, or an empty string if it's not found.
+			std::string		FindTextureFile(const char* path);
 			void			LoadTextureData(LoadedTexture& lt, const char* path);
+			//! Load the files with their mips made by the CPU image pipeline, as initial data. Returns false if any can't be loaded.
+			bool			LoadTextureArrayWithCpuMips(crossplatform::RenderPlatform* r, const std::vector<std::string>& texture_files);
 			void			SetTextureData(LoadedTexture& lt, const void* data, int x, int y, int z, int n, crossplatform::PixelFormat f,crossplatform::CompressionFormat c=crossplatform::CompressionFormat::UNCOMPRESSED);
 			
 			void			ClearLoadedTextures();
@@ -0,0 +1,133 @@
+#include "Platform/Vulkan/UploadRing.h"
+#include "Platform/Vulkan/RenderPlatform.h"
+#include "Platform/Core/RuntimeError.h"
+#include <algorithm>
+using namespace platform;
+using namespace vulkan;
+
+UploadRing::UploadRing()
+{
+}
+
+UploadRing::~UploadRing()
+{
+	InvalidateDeviceObjects();
+}
+
+void UploadRing::RestoreDeviceObjects(RenderPlatform *r,size_t p)
+{
+	InvalidateDeviceObjects();
+	std::lock_guard<std::mutex> lock(mutex);
+	renderPlatform=r;
+	pageSize=p;
+	const vk::PhysicalDeviceLimits limits=renderPlatform->GetVulkanGPU()->getProperties().limits;
+	minAlignment=std::max<size_t>({(size_t)limits.minUniformBufferOffsetAlignment,(size_t)limits.minStorageBufferOffsetAlignment,16});
+	stats=UploadRingStats();
+	lastFrameNumber=-1;
+	currentFrame=0;
+	// One page per frame up front; more are added as the content demands.
+	for(unsigned i=0;i<kNumFrames;i++)
+		AddPage(frames[i],pageSize);
+}
+
+void UploadRing::InvalidateDeviceObjects()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!renderPlatform)
+		return;
+	for(unsigned i=0;i<kNumFrames;i++)
+	{
+		for(auto &p:frames[i].pages)
+		{
+			// Unmap now; the GPU may still read the buffer until the release manager frees it.
+			vmaUnmapMemory(p.allocationInfo.allocator,p.allocationInfo.allocation);
+			renderPlatform->PushToReleaseManager(p.buffer,&p.allocationInfo);
+		}
+		frames[i]=Frame();
+	}
+	renderPlatform=nullptr;
+}
+
+bool UploadRing::AddPage(Frame &frame,size_t size)
+{
+	Page page;
+	page.size=size;
+	const vk::BufferUsageFlags usage=vk::BufferUsageFlagBits::eUniformBuffer|vk::BufferUsageFlagBits::eStorageBuffer
+		|vk::BufferUsageFlagBits::eVertexBuffer|vk::BufferUsageFlagBits::eIndexBuffer;
+	std::string name="UploadRing page "+std::to_string(frame.pages.size());
+	if(!renderPlatform->CreateVulkanBuffer(size,usage,vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent
+		,page.buffer,page.allocationInfo,name.c_str()))
+		return false;
+	if(vmaMapMemory(page.allocationInfo.allocator,page.allocationInfo.allocation,(void**)&page.mapped)!=VK_SUCCESS||!page.mapped)
+	{
+		renderPlatform->PushToReleaseManager(page.buffer,&page.allocationInfo);
+		return false;
+	}
+	frame.pages.push_back(page);
+	stats.pageCount++;
+	stats.capacityBytes+=size;
+	return true;
+}
+
+void UploadRing::NextFrame(long long frameNumber)
+{
+	if(lastFrameNumber>=0)
+	{
+		const Frame &done=frames[currentFrame];
+		stats.lastFrameBytes=done.used;
+		stats.lastFrameAllocations=done.allocations;
+		stats.peakFrameBytes=std::max(stats.peakFrameBytes,(uint64_t)done.used);
+		currentFrame=(currentFrame+1)%kNumFrames;
+	}
+	// This frame's pages were last used SIMUL_VULKAN_FRAME_LAG+1 frames ago, so the GPU is done with them.
+	Frame &frame=frames[currentFrame];
+	frame.page=0;
+	frame.offset=0;
+	frame.used=0;
+	frame.allocations=0;
+	lastFrameNumber=frameNumber;
+}
+
+void *UploadRing::Allocate(size_t size,size_t alignment,vk::Buffer *&buffer,size_t &offset)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!renderPlatform||!size)
+		return nullptr;
+	long long frameNumber=renderPlatform->GetFrameNumber();
+	if(frameNumber!=lastFrameNumber)
+		NextFrame(frameNumber);
+	Frame &frame=frames[currentFrame];
+	alignment=std::max(alignment,minAlignment);
+	for(;;)
+	{
+		if(frame.page<frame.pages.size())
+		{
+			Page &page=frame.pages[frame.page];
+			size_t o=((frame.offset+alignment-1)/alignment)*alignment;
+			if(o+size<=page.size)
+			{
+				frame.offset=o+size;
+				frame.used+=size;
+				frame.allocations++;
+				buffer=&page.buffer;
+				offset=o;
+				return page.mapped+o;
+			}
+			frame.page++;
+			frame.offset=0;
+			continue;
+		}
+		if(!AddPage(frame,std::max(pageSize,size)))
+		{
+			SIMUL_CERR_ONCE<<"UploadRing: failed to allocate a page of "<<std::max(pageSize,size)<<" bytes.\n";
+			return nullptr;
+		}
+		stats.growthCount++;
+	}
+}
+
+UploadRingStats UploadRing::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
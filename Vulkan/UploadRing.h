@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include "Platform/Vulkan/Export.h"
+#include "Platform/Vulkan/Allocation.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4251)
+#endif
+
+namespace platform
+{
+	namespace vulkan
+	{
+		class RenderPlatform;
+		struct UploadRingStats
+		{
+			uint64_t lastFrameBytes=0;	//!< Bytes allocated in the last completed frame.
+			uint64_t peakFrameBytes=0;	//!< Most bytes allocated in any one frame.
+			uint64_t capacityBytes=0;	//!< Total size of all pages, over all frames in flight.
+			uint32_t pageCount=0;
+			uint32_t growthCount=0;		//!< Pages added because a frame ran out of room.
+			uint32_t lastFrameAllocations=0;
+		};
+		//! A persistently-mapped, per-frame linear allocator for data the CPU writes once and the GPU reads that frame.
+		//! Each of the SIMUL_VULKAN_FRAME_LAG+1 frames in flight has its own list of pages; a frame that runs out of room
+		//! gets another page, which is kept for re-use, so the ring settles at the size the content needs.
+		//! Allocation is a bump of an offset, so an upload costs one memcpy.
+		class SIMUL_VULKAN_EXPORT UploadRing
+		{
+		public:
+			UploadRing();
+			~UploadRing();
+			void RestoreDeviceObjects(RenderPlatform *renderPlatform,size_t pageSize=4*1024*1024);
+			void InvalidateDeviceObjects();
+			//! Sub-allocate \a size bytes, valid until the end of the current frame. Returns the mapped address to write to,
+			//! and sets the buffer and offset to bind; returns nullptr if no memory could be allocated.
+			//! The offset is aligned to \a alignment and to the device's uniform and storage buffer offset alignments.
+			void *Allocate(size_t size,size_t alignment,vk::Buffer *&buffer,size_t &offset);
+			UploadRingStats GetStats() const;
+		private:
+			struct Page
+			{
+				vk::Buffer		buffer;
+				AllocationInfo	allocationInfo;
+				uint8_t			*mapped=nullptr;
+				size_t			size=0;
+			};
+			struct Frame
+			{
+				// A deque, so that buffer pointers handed out stay valid as pages are added.
+				std::deque<Page>	pages;
+				size_t				page=0;
+				size_t				offset=0;
+				size_t				used=0;
+				uint32_t			allocations=0;
+			};
+			static const unsigned kNumFrames=(SIMUL_VULKAN_FRAME_LAG+1);
+			bool AddPage(Frame &frame,size_t size);
+			void NextFrame(long long frameNumber);
+			RenderPlatform		*renderPlatform=nullptr;
+			Frame				frames[kNumFrames];
+			unsigned			currentFrame=0;
+			long long			lastFrameNumber=-1;
+			size_t				pageSize=0;
+			size_t				minAlignment=256;
+			mutable std::mutex	mutex;
+			UploadRingStats		stats;
+		};
+	}
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif